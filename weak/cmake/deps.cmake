@@ -67,6 +67,9 @@ else()
   find_package(RocksDB CONFIG REQUIRED)
 endif()
 
+# 🦜 : zlib is needed by rocksdb anyway, we also use it to compress p2p msgs.
+find_package(ZLIB REQUIRED)
+
 if (WIN32)
   # manually import the libs
   message("🐸 manually making protobuf on windows")
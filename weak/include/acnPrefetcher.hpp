@@ -0,0 +1,189 @@
+/**
+ * @file acnPrefetcher.hpp
+ * @author Jianer Cong
+ * @brief Load the Acns of a Blk before it's executed.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : The executor reads the Acns one by one (getAcn()), and each read that
+ * misses the memtable and the block cache waits for the disk. But we know
+ * which Acns a Tx will touch (`from`, `to`, or the deployed address) long
+ * before it runs: the primary knows right after the sealer made the
+ * BlkForConsensus, and then the consensus takes a few round trips. So
+ * AcnPrefetcher reads them (with one MultiGet()) on its own thread, decodes
+ * them, and keeps them for the executor.
+ *
+ * 🦜 : And on the other nodes ?
+ *
+ * 🐢 : The BlkExecutor calls prefetchAcnsOf() too, right before it executes
+ * the Blk. Then the first getAcn() waits for the batch instead of doing a
+ * point-read per Tx.
+ *
+ * 🦜 : How does the cache not go stale ?
+ *
+ * 🐢 : Within a Blk, the Txs all read the state as of the previous Blk (the
+ * journals are applied on commit), so a prefetched Acn stays good until a Blk
+ * writes it. We're an IBlkCommittedListener: onBlkCommitted() drops the keys
+ * the Blk wrote. If one of those keys is being read right then (the read may
+ * have seen the old value), the read is not kept.
+ */
+#pragma once
+#include "forPostExec.hpp"
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <unordered_set>
+
+namespace weak{
+
+  class AcnPrefetcher: public virtual IAcnGettable,
+                       public virtual IAcnPrefetchable,
+                       public virtual IBlkCommittedListener{
+  public:
+    IAcnGettable * const base;
+    const size_t max_acns;      // <! the cache is cleared when it has more than this
+    mutable std::atomic<uint64_t> n_hit{0};
+    mutable std::atomic<uint64_t> n_miss{0};
+    std::atomic<uint64_t> n_prefetched{0};
+
+    /**
+     * @param b Where the Acns are read from (usually the WorldStorage).
+     * @param m The max number of Acns kept.
+     */
+    AcnPrefetcher(IAcnGettable * const b, size_t m = 100'000):
+      base(b), max_acns(m), worker(&AcnPrefetcher::run, this){}
+
+    ~AcnPrefetcher(){
+      {
+        std::unique_lock g(this->lock);
+        this->stopping = true;
+        this->pending.clear();  // 🦜 : nobody should wait for the rest
+      }
+      this->has_job.notify_all();
+      this->job_done.notify_all();
+      this->worker.join();
+    }
+
+    /**
+     * @brief The Acns a Tx will (at least) touch: the sender and the callee
+     * (or the deployed address if it's a CREATE). No duplicates.
+     */
+    static vector<evmc::address> acnsTouchedBy(const vector<Tx> & txs) noexcept{
+      vector<evmc::address> o;
+      std::unordered_set<string> seen;
+      auto add = [&](const evmc::address & a){
+        if (seen.insert(addressToString(a)).second)
+          o.push_back(a);
+      };
+      for (const Tx & t : txs){
+        add(t.from);
+        add(evmc::is_zero(t.to) ? Tx::getContractDeployAddress(t) : t.to);
+      }
+      return o;
+    }
+
+    void prefetchAcnsOf(const vector<Tx> & txs) noexcept override{
+      vector<evmc::address> as;
+      {
+        std::unique_lock g(this->lock);
+        if (this->acns.size() > this->max_acns){
+          BOOST_LOG_TRIVIAL(debug) << format("🔥 Prefetched Acns full (%d), clearing") % this->acns.size();
+          this->acns.clear();
+        }
+        for (const evmc::address & a : acnsTouchedBy(txs)){
+          string k = addressToString(a);
+          if (this->acns.contains(k) or this->pending.contains(k)) continue;
+          this->pending.insert(std::move(k));
+          as.push_back(a);
+        }
+        if (as.empty()) return;
+        this->jobs.push_back(std::move(as));
+      }
+      this->has_job.notify_one();
+    }
+
+    /**
+     * @brief Get the Acn, from the prefetched ones if it's there.
+     *
+     * 🐢 : If it's being prefetched, we wait for it instead of reading it
+     * again. A miss goes to the `base` and is not kept.
+     */
+    optional<Acn> getAcn(evmc::address addr) const noexcept override{
+      string k = addressToString(addr);
+      {
+        std::unique_lock g(this->lock);
+        this->job_done.wait(g, [&]{ return not this->pending.contains(k); });
+        auto it = this->acns.find(k);
+        if (it != this->acns.end()){
+          this->n_hit++;
+          return it->second;
+        }
+      }
+      this->n_miss++;
+      return this->base->getAcn(addr);
+    }
+
+    shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+      return this->base->getCode(h);
+    }
+
+    void onBlkCommitted(const ExecBlk & b) noexcept override{
+      std::unique_lock g(this->lock);
+      for (const StateChange * c : lastChangeOfEachKey(b.stateChanges)){
+        this->acns.erase(c->k);
+        if (this->pending.contains(c->k))
+          this->stale.insert(c->k);
+      }
+      BOOST_LOG_TRIVIAL(debug) << format("🔥 Acn prefetch after Blk-%d: " S_GREEN "%d hit" S_NOR ", "
+                                         S_MAGENTA "%d miss" S_NOR ", %d prefetched")
+        % b.number % this->n_hit.load() % this->n_miss.load() % this->n_prefetched.load();
+    }
+
+    /// The number of Acns kept now.
+    size_t size() const noexcept{
+      std::unique_lock g(this->lock);
+      return this->acns.size();
+    }
+
+  private:
+    mutable std::mutex lock;
+    mutable std::condition_variable job_done;
+    std::condition_variable has_job;
+    bool stopping = false;
+    unordered_map<string, optional<Acn>> acns; // <! addressToString(addr) -> Acn ({} ⇒ not there)
+    std::unordered_set<string> pending;        // <! being read by the worker
+    std::unordered_set<string> stale;          // <! pending, but written by a Blk since the read started
+    std::deque<vector<evmc::address>> jobs;
+    std::thread worker;         // <! 🦜 : last, so that the rest is ready when it starts
+
+    void run() noexcept{
+      while (true){
+        vector<evmc::address> as;
+        {
+          std::unique_lock g(this->lock);
+          this->has_job.wait(g, [&]{ return this->stopping or not this->jobs.empty(); });
+          if (this->stopping) return;
+          as = std::move(this->jobs.front());
+          this->jobs.pop_front();
+        }
+
+        vector<optional<Acn>> r = this->base->getManyAcns(as);
+
+        {
+          std::unique_lock g(this->lock);
+          for (size_t i = 0; i < as.size(); i++){
+            string k = addressToString(as[i]);
+            if (not this->pending.erase(k)) continue; // 🦜 : cleared by the dtor
+            if (this->stale.erase(k)) continue;
+            this->acns.insert_or_assign(std::move(k), std::move(r[i]));
+            this->n_prefetched++;
+          }
+        }
+        this->job_done.notify_all();
+      }
+    }
+  };
+}
@@ -0,0 +1,332 @@
+/**
+ * @file binCodec.hpp
+ * @author Jianer Cong
+ * @brief A compact binary layout for the hot types (Tx, Blk, ExecBlk).
+ *
+ * 🦜 : Why not just pb ?
+ *
+ * 🐢 : pb is fine for the Rpc, but on the hot path (a Blk of 10k Txs going
+ * through the consensus, then to the chainDB) it decodes a varint and a tag per
+ * field, makes a std::string per field, and then Tx::fromPb() copies each of
+ * them again into `bytes` and `address`. Here the addresses and hashes are
+ * fixed-width, the rest is length-prefixed, and a reader gets *views* into the
+ * input buffer (TxView, BlkView, ExecBlkView). Only Tx::fromBinView() copies,
+ * once.
+ *
+ * 🦜 : What does it look like ?
+ *
+ * 🐢 : Every message starts with a header of 3 bytes: MAGIC, VERSION and the
+ * Kind. The integers are little-endian, a `blob` is a u32 size and the bytes.
+ *
+ *     Tx      : type u8 | from 20 | to 20 | nonce u64 | timestamp i64
+ *               | data blob | pk_pem blob | signature blob | pk_crt blob
+ *     Txs     : n u32 | n × Tx
+ *     Blk     : number u64 | parentHash 32 | Txs
+ *     ExecBlk : Blk | n u32 | n × (m u32 | m × (flag u8 | k blob | v blob))
+ *               | n' u32 | n' × (ok u8 | type u8 | result blob)
+ *               | has_root u8 | [root 32]
+ *
+ * where the `flag` of a StateChange is one of Change (put, del or delta, see
+ * ExecBlk::acnDelta()).
+ *
+ * 🦜 : And when the layout changes ?
+ *
+ * 🐢 : Bump VERSION. A reader refuses what it doesn't know.
+ *
+ * With WITH_BIN_CODEC, this is what Tx, Blk and ExecBlk::toString() use (see
+ * ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB), otherwise it's only there for
+ * toBinString() and the benchmarks.
+ */
+#pragma once
+#include <evmc/evmc.hpp>
+#include <ethash/hash_types.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace weak::bin{
+  using std::string;
+  using std::string_view;
+  using std::vector;
+  using std::optional;
+
+  constexpr uint8_t MAGIC = 0xb1;
+  constexpr uint8_t VERSION = 1;
+  constexpr size_t HEADER_SIZE = 3;
+
+  enum class Kind: uint8_t {tx = 1, txs = 2, blk = 3, execBlk = 4};
+
+  /// The flag of a StateChange in an ExecBlk.
+  enum class Change: uint8_t {put = 0, del = 1, delta = 2};
+
+  /// Thrown by Reader on a short or malformed input.
+  class Error: public std::runtime_error{
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  class Writer{
+  public:
+    string s;
+
+    explicit Writer(size_t n = 0){ this->s.reserve(n); }
+
+    void header(Kind k){
+      this->u8(MAGIC);
+      this->u8(VERSION);
+      this->u8(static_cast<uint8_t>(k));
+    }
+
+    void u8(uint8_t x){ this->s.push_back(static_cast<char>(x)); }
+    void u32(uint32_t x){ this->le(x); }
+    void u64(uint64_t x){ this->le(x); }
+
+    /// The `bytes` of an address or a hash, as they are.
+    template<typename T>
+    void fixed(const T & a){
+      this->s.append(reinterpret_cast<const char*>(a.bytes), sizeof(a.bytes));
+    }
+
+    void blob(string_view b){
+      if (b.size() > UINT32_MAX) throw Error("blob too large");
+      this->u32(static_cast<uint32_t>(b.size()));
+      this->s.append(b);
+    }
+
+    void blob(const evmc::bytes & b){
+      this->blob(string_view(reinterpret_cast<const char*>(b.data()), b.size()));
+    }
+
+  private:
+    template<typename U>
+    void le(U x){
+      char b[sizeof(U)];
+      for (size_t i = 0; i < sizeof(U); i++, x >>= 8)
+        b[i] = static_cast<char>(x & 0xff);
+      this->s.append(b, sizeof(U));
+    }
+  };
+
+  /**
+   * @brief Read the things written by Writer, throws Error if there isn't
+   * enough input.
+   *
+   * 🦜 : blob() returns a view into the input, so the input must outlive what
+   * was read.
+   */
+  class Reader{
+  public:
+    const string_view s;
+    size_t at = 0;
+
+    explicit Reader(string_view i): s(i){}
+
+    void header(Kind k){
+      if (this->u8() != MAGIC) throw Error("not a bin message");
+      if (uint8_t v = this->u8(); v != VERSION)
+        throw Error("unknown bin version " + std::to_string(v));
+      if (this->u8() != static_cast<uint8_t>(k)) throw Error("unexpected bin kind");
+    }
+
+    uint8_t u8(){ return static_cast<uint8_t>(*this->take(1)); }
+    uint32_t u32(){ return this->le<uint32_t>(); }
+    uint64_t u64(){ return this->le<uint64_t>(); }
+
+    template<typename T>
+    T fixed(){
+      T a;
+      std::memcpy(a.bytes, this->take(sizeof(a.bytes)), sizeof(a.bytes));
+      return a;
+    }
+
+    string_view blob(){
+      uint32_t n = this->u32();
+      return string_view(this->take(n), n);
+    }
+
+    /// A count of things that each take at least `min_size` bytes.
+    uint32_t count(size_t min_size){
+      uint32_t n = this->u32();
+      if (n * min_size > this->s.size() - this->at) throw Error("bad count");
+      return n;
+    }
+
+    void end() const{
+      if (this->at != this->s.size()) throw Error("trailing bytes");
+    }
+
+  private:
+    const char * take(size_t n){
+      if (n > this->s.size() - this->at) throw Error("unexpected end of input");
+      const char * p = this->s.data() + this->at;
+      this->at += n;
+      return p;
+    }
+
+    template<typename U>
+    U le(){
+      const unsigned char * p = reinterpret_cast<const unsigned char*>(this->take(sizeof(U)));
+      U x = 0;
+      for (size_t i = sizeof(U); i-- > 0;)
+        x = (x << 8) | p[i];
+      return x;
+    }
+  };
+
+  inline string_view viewOf(const evmc::bytes & b) noexcept{
+    return string_view(reinterpret_cast<const char*>(b.data()), b.size());
+  }
+
+  /**
+   * @brief A Tx in a buffer. Tx::binView() makes one out of a Tx,
+   * Tx::fromBinView() the reverse.
+   */
+  struct TxView{
+    uint8_t type;
+    evmc::address from;
+    evmc::address to;
+    uint64_t nonce;
+    int64_t timestamp;
+    string_view data;
+    string_view pk_pem;
+    string_view signature;
+    string_view pk_crt;
+
+    static constexpr size_t MIN_SIZE = 1 + 20 + 20 + 8 + 8 + 4 * 4;
+
+    void write(Writer & w) const{
+      w.u8(this->type);
+      w.fixed(this->from);
+      w.fixed(this->to);
+      w.u64(this->nonce);
+      w.u64(static_cast<uint64_t>(this->timestamp));
+      w.blob(this->data);
+      w.blob(this->pk_pem);
+      w.blob(this->signature);
+      w.blob(this->pk_crt);
+    }
+
+    static TxView read(Reader & r){
+      TxView t;
+      t.type = r.u8();
+      t.from = r.fixed<evmc::address>();
+      t.to = r.fixed<evmc::address>();
+      t.nonce = r.u64();
+      t.timestamp = static_cast<int64_t>(r.u64());
+      t.data = r.blob();
+      t.pk_pem = r.blob();
+      t.signature = r.blob();
+      t.pk_crt = r.blob();
+      return t;
+    }
+
+    size_t size() const noexcept{
+      return MIN_SIZE + data.size() + pk_pem.size() + signature.size() + pk_crt.size();
+    }
+  };
+
+  inline vector<TxView> readTxs(Reader & r){
+    vector<TxView> o(r.count(TxView::MIN_SIZE));
+    for (TxView & t : o) t = TxView::read(r);
+    return o;
+  }
+
+  struct BlkView{
+    uint64_t number;
+    ethash::hash256 parentHash;
+    vector<TxView> txs;
+
+    void write(Writer & w) const{
+      w.u64(this->number);
+      w.fixed(this->parentHash);
+      w.u32(static_cast<uint32_t>(this->txs.size()));
+      for (const TxView & t : this->txs) t.write(w);
+    }
+
+    static BlkView read(Reader & r){
+      BlkView b;
+      b.number = r.u64();
+      b.parentHash = r.fixed<ethash::hash256>();
+      b.txs = readTxs(r);
+      return b;
+    }
+  };
+
+  struct StateChangeView{ Change flag; string_view k; string_view v; };
+  struct TxReceiptView{ bool ok; uint8_t type; string_view result; };
+
+  struct ExecBlkView: public BlkView{
+    vector<vector<StateChangeView>> stateChanges;
+    vector<TxReceiptView> txReceipts;
+    optional<ethash::hash256> stateRoot;
+
+    void write(Writer & w) const{
+      BlkView::write(w);
+      w.u32(static_cast<uint32_t>(this->stateChanges.size()));
+      for (const vector<StateChangeView> & j : this->stateChanges){
+        w.u32(static_cast<uint32_t>(j.size()));
+        for (const StateChangeView & c : j){
+          w.u8(static_cast<uint8_t>(c.flag));
+          w.blob(c.k);
+          w.blob(c.v);
+        }
+      }
+      w.u32(static_cast<uint32_t>(this->txReceipts.size()));
+      for (const TxReceiptView & t : this->txReceipts){
+        w.u8(t.ok);
+        w.u8(t.type);
+        w.blob(t.result);
+      }
+      w.u8(bool(this->stateRoot));
+      if (this->stateRoot) w.fixed(this->stateRoot.value());
+    }
+
+    static ExecBlkView read(Reader & r){
+      ExecBlkView b;
+      static_cast<BlkView&>(b) = BlkView::read(r);
+      b.stateChanges.resize(r.count(4));
+      for (vector<StateChangeView> & j : b.stateChanges){
+        j.resize(r.count(1 + 4 + 4));
+        for (StateChangeView & c : j){
+          uint8_t f = r.u8();
+          if (f > static_cast<uint8_t>(Change::delta)) throw Error("bad StateChange flag");
+          c.flag = static_cast<Change>(f);
+          c.k = r.blob();
+          c.v = r.blob();
+        }
+      }
+      b.txReceipts.resize(r.count(1 + 1 + 4));
+      for (TxReceiptView & t : b.txReceipts){
+        t.ok = r.u8();
+        t.type = r.u8();
+        t.result = r.blob();
+      }
+      if (r.u8()) b.stateRoot = r.fixed<ethash::hash256>();
+      return b;
+    }
+  };
+
+  /// Parse a whole message of kind `k` (with its header), throws Error.
+  template<typename V>
+  V parse(string_view s, Kind k){
+    Reader r{s};
+    r.header(k);
+    V v = V::read(r);
+    r.end();
+    return v;
+  }
+
+  /// The Txs in a Kind::txs message, throws Error.
+  inline vector<TxView> parseTxs(string_view s){
+    Reader r{s};
+    r.header(Kind::txs);
+    vector<TxView> v = readTxs(r);
+    r.end();
+    return v;
+  }
+}
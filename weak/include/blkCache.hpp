@@ -0,0 +1,93 @@
+/**
+ * @file blkCache.hpp
+ * @author Jianer Cong
+ * @brief The cache of rendered Blks for the Rpc.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : A committed Blk never changes, but each `/get_blk?n=` used to read the
+ * RocksDB, parse the ExecBlk and serialize it to JSON again. And
+ * `/get_latest_Blk?n=100` does that a hundred times. So we keep the rendered
+ * bodies here, keyed by the Blk number.
+ *
+ * 🦜 : How big can it grow ?
+ *
+ * 🐢 : It's bounded by the total bytes of the bodies. When it's full, the least
+ * recently used Blk goes away. The BlkExecutor also puts each newly committed
+ * Blk in (we're an IBlkCommittedListener), since the newest Blks are the hot
+ * ones.
+ */
+#pragma once
+#include "forPostExec.hpp"
+
+#include <list>
+#include <mutex>
+#include <atomic>
+
+namespace weak{
+  using std::list;
+
+  class BlkCache: public virtual IBlkCommittedListener{
+  public:
+    const size_t max_bytes;
+    std::atomic<uint64_t> n_hit{0};
+    std::atomic<uint64_t> n_miss{0};
+
+    BlkCache(size_t m = 64 << 20 /*64MB*/): max_bytes(m){}
+
+    optional<string> get(uint64_t n) noexcept{
+      std::unique_lock g(this->lock);
+      auto it = this->m.find(n);
+      if (it == this->m.end()){
+        this->n_miss++;
+        return {};
+      }
+      this->n_hit++;
+      // move it to the front
+      this->l.splice(this->l.begin(), this->l, it->second);
+      return it->second->second;
+    }
+
+    void put(uint64_t n, string s) noexcept{
+      if (s.size() > this->max_bytes) return; // 🦜 : too big to be cached
+      std::unique_lock g(this->lock);
+      auto it = this->m.find(n);
+      if (it != this->m.end()){
+        // 🐢 : Blks don't change, so it should be the same thing.
+        this->l.splice(this->l.begin(), this->l, it->second);
+        return;
+      }
+
+      this->bytes += s.size();
+      this->l.emplace_front(n, std::move(s));
+      this->m[n] = this->l.begin();
+
+      while (this->bytes > this->max_bytes){
+        auto & [k, v] = this->l.back();
+        this->bytes -= v.size();
+        this->m.erase(k);
+        this->l.pop_back();
+      }
+    }
+
+    void onBlkCommitted(const ExecBlk & b) noexcept override{
+      this->put(b.number, b.toJsonString());
+    }
+
+    size_t size_in_bytes() noexcept{
+      std::unique_lock g(this->lock);
+      return this->bytes;
+    }
+
+    size_t size() noexcept{
+      std::unique_lock g(this->lock);
+      return this->m.size();
+    }
+
+  private:
+    std::mutex lock;
+    size_t bytes{0};
+    list<tuple<uint64_t,string>> l;  // <! front = most recently used
+    unordered_map<uint64_t, list<tuple<uint64_t,string>>::iterator> m;
+  };
+}
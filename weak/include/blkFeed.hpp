@@ -0,0 +1,318 @@
+/**
+ * @file blkFeed.hpp
+ * @author Jianer Cong
+ * @brief The feed of newly committed Blks, that the long-poll subscribers wait on.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : Clients used to poll `/get_latest_Blk` and `/get_receipt` in tight loops
+ * to see whether their Txs landed. Each poll hits the RocksDB and re-serializes
+ * the ExecBlk to JSON. With this, the client asks once and waits (long-poll),
+ * and the commit path wakes everyone up once per Blk.
+ *
+ * 🦜 : So the work per Blk doesn't depend on how many subscribers there are ?
+ *
+ * 🐢 : Almost. When a Blk is committed, we render the header JSON and the
+ * receipts JSON once, and keep them for the last `max_blks` Blks. The
+ * subscribers just copy the ready-made strings out.
+ *
+ * 🦜 : Why long-poll instead of WebSocket ?
+ *
+ * 🐢 : It works with every HTTP client (curl included) and it goes through the
+ * handlers we already have, so it works on both the TCP and the unix-domain
+ * socket.
+ *
+ * 🦜 : Does a waiting subscriber occupy a thread ?
+ *
+ * 🐢 : <2024-07-29 Mon> Not anymore. A subscriber is parked here as a
+ * callback (see park_for_blks()), and the async server parks its session with
+ * a timer. When a Blk is committed, the callbacks of the ready ones are called,
+ * and the timer calls cancel() if that doesn't happen in time. So the number of
+ * waiters (`max_waiters`) is capped by memory and sockets, not by threads. The
+ * blocking wait_for_blks() and wait_for_receipt() are still there for the
+ * servers that can't park.
+ */
+#pragma once
+#include "forPostExec.hpp"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+
+namespace weak{
+  using std::deque;
+
+  class BlkFeed: public virtual IBlkCommittedListener{
+  public:
+    const size_t max_blks;        // <! how many recent Blks we remember
+    const size_t max_waiters;     // <! how many subscribers can wait at the same time
+
+    /*
+      🦜 : The callback of a parked waiter, called exactly once (without the
+      lock) with the result, see wait_for_blks() and wait_for_receipt().
+     */
+    using reply_t = function<void (optional<string>)>;
+    static constexpr uint64_t NOT_PARKED = 0; // <! the waiter is replied right away
+    static constexpr size_t DEFAULT_MAX_WAITERS = 4096;
+
+    /**
+     * @brief Construct a new BlkFeed
+     *
+     * @param latest The number of the latest Blk on the chain when we start, if any.
+     * @param m The number of recent Blks to remember.
+     * @param w The max number of waiting subscribers.
+     */
+    BlkFeed(optional<uint64_t> latest = {}, size_t m = 64, size_t w = DEFAULT_MAX_WAITERS):
+      max_blks(std::max(m, size_t{1})), max_waiters(w), latest(latest){}
+
+    /**
+     * @brief Reply all the parked waiters as timed out.
+     */
+    ~BlkFeed(){
+      vector<uint64_t> ids;
+      {
+        std::unique_lock g(this->lock);
+        for (auto & [id, w] : this->blk_waiters) ids.push_back(id);
+        for (auto & [id, w] : this->receipt_waiters) ids.push_back(id);
+      }
+      for (uint64_t id : ids) this->cancel(id);
+    }
+
+    void onBlkCommitted(const ExecBlk & b) noexcept override{
+      // 1. render once (outside the lock) --------------------------------------------------
+      json::array hs;
+      vector<tuple<string,string>> rs;
+      rs.reserve(b.txs.size());
+      for (size_t i = 0; i < b.txs.size(); i++){
+        string h = hashToString(b.txs[i].hash());
+        hs.emplace_back(h);
+        if (i < b.txReceipts.size()){
+          json::object o;
+          o["status"] = "committed";
+          o["blkNumber"] = b.number;
+          o["onBlkId"] = i;
+          o["receipt"] = b.txReceipts[i].toJson();
+          rs.emplace_back(h, json::serialize(o));
+        }
+      }
+      json::object o;
+      o["number"] = b.number;
+      o["hash"] = hashToString(b.hash());
+      o["parentHash"] = hashToString(b.parentHash);
+      o["txs_count"] = b.txs.size();
+      o["tx_hashes"] = hs;
+
+      // 2. publish, and take the ready waiters --------------------------------------------------
+      vector<tuple<reply_t,optional<string>>> ready;
+      {
+        std::unique_lock g(this->lock);
+        this->blks.emplace_back(b.number, json::serialize(o));
+        for (auto & [h, r] : rs)
+          this->receipts[h] = r;
+        this->receipts_of.push_back(vector<string>());
+        for (auto & [h, r] : rs)
+          this->receipts_of.back().push_back(std::move(h));
+
+        while (this->blks.size() > this->max_blks){
+          this->blks.pop_front();
+          for (const string & h : this->receipts_of.front())
+            this->receipts.erase(h);
+          this->receipts_of.pop_front();
+        }
+        this->latest = b.number;
+
+        // 🦜 : the waiters after the same Blk get the same string, render it once
+        unordered_map<uint64_t,string> rendered;
+        for (auto it = this->blk_waiters.begin(); it != this->blk_waiters.end();){
+          auto & [after, f] = it->second;
+          if (after and after.value() >= b.number){it++; continue;}
+          uint64_t k = after ? after.value() + 1 : 0;
+          if (not rendered.contains(k)) rendered[k] = this->render_blks(after);
+          ready.emplace_back(std::move(f), rendered[k]);
+          it = this->blk_waiters.erase(it);
+        }
+
+        for (const string & h : this->receipts_of.back()){
+          auto [b0, e0] = this->receipt_ids.equal_range(h);
+          for (auto it = b0; it != e0; it++){
+            auto x = this->receipt_waiters.find(it->second);
+            ready.emplace_back(std::move(std::get<1>(x->second)), this->receipts.at(h));
+            this->receipt_waiters.erase(x);
+          }
+          this->receipt_ids.erase(h);
+        }
+        this->waiters = this->blk_waiters.size() + this->receipt_waiters.size();
+      }
+
+      // 3. reply (outside the lock) --------------------------------------------------
+      for (auto & [f, r] : ready)
+        f(std::move(r));
+    }
+
+    /**
+     * @brief Park a waiter for the Blks after `after`.
+     *
+     * @param after Wait for Blks with number > after. If not given, wait for the next one.
+     * @param f Called with the result (see wait_for_blks()), right away if
+     * there's already such Blk, or when it comes, or by cancel().
+     *
+     * @return The id of the waiter for cancel(), or NOT_PARKED if `f` is
+     * already called. Returns {} (and `f` is not called) if there're too many
+     * waiters.
+     */
+    optional<uint64_t> park_for_blks(optional<uint64_t> after, reply_t f) noexcept{
+      string r;
+      {
+        std::unique_lock g(this->lock);
+        if (not after) after = this->latest;
+        if (not (this->latest and ((not after) or this->latest.value() > after.value()))){
+          if (this->waiters >= this->max_waiters) return {};
+          uint64_t id = this->next_id++;
+          this->blk_waiters.emplace(id, make_tuple(after, std::move(f)));
+          this->waiters++;
+          return id;
+        }
+        r = this->render_blks(after);
+      }
+      f(std::move(r));
+      return NOT_PARKED;
+    }
+
+    /**
+     * @brief Park a waiter for the receipt of the Tx with hash `h` (in hex, as given by hashToString()).
+     *
+     * @param f Called with the receipt (see wait_for_receipt()), or with {} by cancel().
+     *
+     * @return Same as park_for_blks().
+     */
+    optional<uint64_t> park_for_receipt(const string & h, reply_t f) noexcept{
+      string r;
+      {
+        std::unique_lock g(this->lock);
+        auto it = this->receipts.find(h);
+        if (it == this->receipts.end()){
+          if (this->waiters >= this->max_waiters) return {};
+          uint64_t id = this->next_id++;
+          this->receipt_waiters.emplace(id, make_tuple(h, std::move(f)));
+          this->receipt_ids.emplace(h, id);
+          this->waiters++;
+          return id;
+        }
+        r = it->second;
+      }
+      f(std::move(r));
+      return NOT_PARKED;
+    }
+
+    /**
+     * @brief Reply the parked waiter `id` as timed out: the Blks so far (none
+     * if it's still waiting) for park_for_blks(), {} for park_for_receipt().
+     *
+     * @return false if it's not parked (anymore).
+     */
+    bool cancel(uint64_t id) noexcept{
+      reply_t f;
+      optional<string> r;
+      {
+        std::unique_lock g(this->lock);
+        if (auto it = this->blk_waiters.find(id); it != this->blk_waiters.end()){
+          f = std::move(std::get<1>(it->second));
+          r = this->render_blks(std::get<0>(it->second));
+          this->blk_waiters.erase(it);
+        }else if (auto jt = this->receipt_waiters.find(id); jt != this->receipt_waiters.end()){
+          const string & h = std::get<0>(jt->second);
+          auto [b0, e0] = this->receipt_ids.equal_range(h);
+          for (auto x = b0; x != e0; x++)
+            if (x->second == id){
+              this->receipt_ids.erase(x);
+              break;
+            }
+          f = std::move(std::get<1>(jt->second));
+          this->receipt_waiters.erase(jt);
+        }else
+          return false;
+        this->waiters--;
+      }
+      f(std::move(r));
+      return true;
+    }
+
+    /**
+     * @brief Wait for the Blks after `after`, in this thread.
+     *
+     * @param after Wait for Blks with number > after. If not given, wait for the next one.
+     * @param timeout How long to wait at most.
+     *
+     * @return A JSON string like `{"latest":3,"blks":[<header>,..]}`, the
+     * `blks` is empty if timed out. If the client is too far behind, only the
+     * remembered Blks are returned, and the rest can be fetched with `/get_blk`.
+     * Returns {} if there're too many waiters.
+     */
+    optional<string> wait_for_blks(optional<uint64_t> after, std::chrono::milliseconds timeout) noexcept{
+      return this->wait_for([&](reply_t f){return this->park_for_blks(after, std::move(f));}, timeout);
+    }
+
+    /**
+     * @brief Wait for the receipt of the Tx with hash `h` (in hex), in this thread.
+     *
+     * @return The json like `{"status":"committed","blkNumber":1,"onBlkId":0,"receipt":{..}}`,
+     * or {} if timed out or there're too many waiters.
+     */
+    optional<string> wait_for_receipt(const string & h, std::chrono::milliseconds timeout) noexcept{
+      return this->wait_for([&](reply_t f){return this->park_for_receipt(h, std::move(f));}, timeout);
+    }
+
+    size_t n_waiting() const noexcept {return this->waiters.load();}
+
+  private:
+    std::mutex lock;
+    optional<uint64_t> latest;
+    deque<tuple<uint64_t,string>> blks;      // <! (number, header json)
+    deque<vector<string>> receipts_of;        // <! the tx hashes of each remembered Blk, for eviction
+    unordered_map<string,string> receipts;    // <! tx hash hex -> receipt json
+
+    uint64_t next_id = NOT_PARKED + 1;
+    unordered_map<uint64_t,tuple<optional<uint64_t>,reply_t>> blk_waiters; // <! id -> (after, f)
+    unordered_map<uint64_t,tuple<string,reply_t>> receipt_waiters;       // <! id -> (tx hash, f)
+    std::unordered_multimap<string,uint64_t> receipt_ids;                // <! tx hash -> id
+    std::atomic<size_t> waiters{0};
+
+    /**
+     * @brief The reply of the Blks after `after`. Called with the lock held.
+     *
+     * 🦜 : The headers are already JSON, so we just splice them in, instead of
+     * parsing each of them again for each waiter.
+     */
+    string render_blks(optional<uint64_t> after) const noexcept{
+      string o = R"({"latest":)";
+      o += this->latest ? std::to_string(this->latest.value()) : "null";
+      o += R"(,"blks":[)";
+      bool first = true;
+      for (auto & [n, h] : this->blks)
+        if ((not after) or n > after.value()){
+          if (not first) o += ',';
+          o += h;
+          first = false;
+        }
+      o += "]}";
+      return o;
+    }
+
+    /**
+     * @brief Park with `park`, and wait for the reply at most `timeout`.
+     */
+    optional<string> wait_for(function<optional<uint64_t> (reply_t)> park, std::chrono::milliseconds timeout) noexcept{
+      // 🦜 : shared, the reply may come from another thread while we're leaving
+      auto p = std::make_shared<std::promise<optional<string>>>();
+      std::future<optional<string>> r = p->get_future();
+      optional<uint64_t> id = park([p](optional<string> s){p->set_value(std::move(s));});
+      if (not id) return {};
+      if (r.wait_for(timeout) == std::future_status::timeout)
+        this->cancel(id.value());
+      return r.get();
+    }
+  };
+}
@@ -0,0 +1,365 @@
+/**
+ * @file blkLog.hpp
+ * @author Jianer Cong
+ * @brief The append-only log of ExecBlks, in memory-mapped segment files.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : The ExecBlks used to be put in the chainDB at "/blk/<n>". They're the
+ * biggest values there, they're written once and never changed, but RocksDB
+ * still writes each of them to the WAL, then to the memtable, then to L0, and
+ * then rewrites them again and again in the compactions. That's a lot of disk
+ * I/O for nothing.
+ *
+ * 🦜 : So what do we do ?
+ *
+ * 🐢 : We just append them to some files (the segments), one record after
+ * another, and keep an in-memory index: Blk number -> (segment, offset, size).
+ * The segments are memory-mapped, so reading a Blk is reading the page cache,
+ * and `get()` gives a view into the mapping without copying.
+ *
+ * 🦜 : What does a segment look like ?
+ *
+ * 🐢 : It's `seg-<number of its first Blk>.log`, and it holds the records:
+ *
+ *     | number (u64) | size (u32) | checksum (u32) | the ExecBlk (size bytes) |
+ *
+ * The active segment is pre-sized (`segment_bytes`) and mapped once, so
+ * appending is a memcpy. When it's full, a new one is started. On close, the
+ * unused tail is trimmed.
+ *
+ * 🦜 : What if we crash in the middle of an append ?
+ *
+ * 🐢 : The index is rebuilt by scanning the records when the log is opened. The
+ * scan stops at the first record that is not the next Blk, goes beyond the file
+ * or fails the checksum, and whatever comes after is dropped.
+ *
+ * 🦜 : When is it on the disk ?
+ *
+ * 🐢 : The mapping is flushed (msync) every `sync_every` appends and on close.
+ * A crashed process loses nothing (the pages are in the kernel), but a power
+ * loss may lose the last few Blks. That's the same as the chainDB, which doesn't
+ * sync its WAL on each write either.
+ */
+#pragma once
+#include "core.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <mutex>
+#include <shared_mutex>
+#include <charconv> // from_chars
+#include <cstring>  // memcpy
+
+namespace weak{
+  namespace bip = boost::interprocess;
+
+  class BlkLog{
+  public:
+    const filesystem::path dir;
+    const size_t segment_bytes; // <! the size of a new segment (unless a Blk is bigger)
+    const size_t sync_every;    // <! flush the mapping every this many appends
+
+    static constexpr size_t HEADER_SIZE = 16;
+
+    /**
+     * @brief Open (or create) the log in dir `d`.
+     *
+     * @param d The dir of the segments.
+     * @param s The size of a segment.
+     * @param e Flush the mapping every `e` appends. 0 means only on close.
+     */
+    BlkLog(filesystem::path d, size_t s = 64 << 20, size_t e = 16):
+      dir(d), segment_bytes(std::max(s, size_t{4096})), sync_every(e){
+      filesystem::create_directories(this->dir);
+      this->open_segments();
+      BOOST_LOG_TRIVIAL(debug) << format("📜 BlkLog opened at " S_CYAN "%s" S_NOR ": "
+                                         S_CYAN "%d" S_NOR " Blk%s in " S_CYAN "%d" S_NOR " segment%s")
+        % this->dir % this->index.size() % pluralizeOn(this->index.size())
+        % this->segs.size() % pluralizeOn(this->segs.size());
+    }
+
+    ~BlkLog(){
+      std::unique_lock g(this->lock);
+      this->sync_locked();
+      // 🦜 : unmap first, then trim the unused tails
+      vector<tuple<filesystem::path,size_t>> ps;
+      for (auto & s : this->segs)
+        ps.push_back(make_tuple(s->p, s->used));
+      this->segs.clear();
+      for (auto & [p, n] : ps){
+        std::error_code ec;
+        filesystem::resize_file(p, n, ec);
+        if (ec)
+          BOOST_LOG_TRIVIAL(warning) << format("⚠️ Failed to trim %s: %s") % p % ec.message();
+      }
+    }
+
+    /**
+     * @brief Append the Blk `n`.
+     *
+     * `n` should be the next Blk (or anything, if the log is empty). If `n` is
+     * already in the active segment, that Blk and the ones after are dropped
+     * first (e.g. we crashed after appending `n` but before the chainDB knew
+     * about it).
+     *
+     * @return false if `n` can't go in.
+     */
+    bool append(uint64_t n, string_view v) noexcept{
+      std::unique_lock g(this->lock);
+      if (v.size() > std::numeric_limits<uint32_t>::max()) return false;
+
+      if (not this->index.empty()){
+        uint64_t next = this->first_n + this->index.size();
+        if (n > next){
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Can't append Blk %d to the BlkLog, expecting %d" S_NOR) % n % next;
+          return false;
+        }
+        if (n < next and not this->rewind_locked(n))
+          return false;
+      }
+      if (this->index.empty())
+        this->first_n = n;
+
+      try{
+        if (this->segs.empty() or
+            this->segs.back()->used + HEADER_SIZE + v.size() > this->segs.back()->r.get_size())
+          this->new_segment_locked(n, HEADER_SIZE + v.size());
+      }catch (const std::exception & e){
+        BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Failed to start a new segment: %s" S_NOR) % e.what();
+        return false;
+      }
+
+      Segment & s = *(this->segs.back());
+      char * p = static_cast<char*>(s.r.get_address()) + s.used;
+      uint32_t z = static_cast<uint32_t>(v.size());
+      uint32_t c = checksum(v);
+      std::memcpy(p, &n, 8);
+      std::memcpy(p + 8, &z, 4);
+      std::memcpy(p + 12, &c, 4);
+      std::memcpy(p + HEADER_SIZE, v.data(), v.size());
+
+      this->index.push_back(Loc{static_cast<uint32_t>(this->segs.size() - 1), z, s.used + HEADER_SIZE});
+      s.used += HEADER_SIZE + v.size();
+
+      if (this->sync_every > 0 and ++(this->unsynced) >= this->sync_every)
+        this->sync_locked();
+      return true;
+    }
+
+    /**
+     * @brief Get the Blk `n`.
+     *
+     * @return The view into the mapping, valid as long as the log lives (and
+     * `n` is not rewound, see append()). {} if `n` is not here.
+     */
+    optional<string_view> get(uint64_t n) const noexcept{
+      std::shared_lock g(this->lock);
+      if (this->index.empty() or n < this->first_n or n - this->first_n >= this->index.size())
+        return {};
+      const Loc & l = this->index[n - this->first_n];
+      const char * p = static_cast<const char*>(this->segs[l.seg]->r.get_address()) + l.off;
+      return string_view(p, l.size);
+    }
+
+    /// @return the number of the first Blk, {} if empty.
+    optional<uint64_t> first() const noexcept{
+      std::shared_lock g(this->lock);
+      if (this->index.empty()) return {};
+      return this->first_n;
+    }
+
+    /// @return the number of the last Blk, {} if empty.
+    optional<uint64_t> last() const noexcept{
+      std::shared_lock g(this->lock);
+      if (this->index.empty()) return {};
+      return this->first_n + this->index.size() - 1;
+    }
+
+    size_t n_segments() const noexcept{
+      std::shared_lock g(this->lock);
+      return this->segs.size();
+    }
+
+    /**
+     * @brief Flush the appended Blks to the disk.
+     */
+    void sync() noexcept{
+      std::unique_lock g(this->lock);
+      this->sync_locked();
+    }
+
+    static uint32_t checksum(string_view v) noexcept{
+      // 🦜 : FNV-1a, it only needs to catch the torn writes.
+      uint32_t h = 2166136261u;
+      for (char c : v){
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+      }
+      return h;
+    }
+
+    static filesystem::path segmentPath(const filesystem::path & d, uint64_t n){
+      return d / (format("seg-%020d.log") % n).str();
+    }
+
+  private:
+    struct Segment{
+      filesystem::path p;
+      uint64_t first;             // <! the number of its first Blk
+      bip::file_mapping f;
+      bip::mapped_region r;
+      size_t used = 0;            // <! the bytes taken by the records
+      size_t synced = 0;          // <! the bytes flushed
+    };
+    struct Loc{
+      uint32_t seg;
+      uint32_t size;
+      size_t off;
+    };
+
+    mutable std::shared_mutex lock;
+    vector<unique_ptr<Segment>> segs;
+    uint64_t first_n = 0;
+    vector<Loc> index;            // <! index[i] is where the Blk `first_n + i` is
+    size_t unsynced = 0;
+
+    void sync_locked() noexcept{
+      this->unsynced = 0;
+      for (auto & s : this->segs){
+        if (s->synced == s->used) continue;
+        // 🦜 : flush() wants an offset aligned to the page.
+        size_t o = s->synced - s->synced % bip::mapped_region::get_page_size();
+        if (not s->r.flush(o, s->used - o, false /*async*/))
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Failed to flush %s" S_NOR) % s->p;
+        s->synced = s->used;
+      }
+    }
+
+    /**
+     * @brief Map the segment at `p`. If `cap` is given, the file is resized to
+     * it first and mapped writable.
+     */
+    static unique_ptr<Segment> map_segment(filesystem::path p, uint64_t n, optional<size_t> cap = {}){
+      if (cap){
+        if (not filesystem::exists(p))
+          std::ofstream(p, std::ios::binary); // 🦜 : touch
+        filesystem::resize_file(p, cap.value());
+      }
+      auto s = make_unique<Segment>();
+      s->p = p;
+      s->first = n;
+      bip::mode_t m = cap ? bip::read_write : bip::read_only;
+      s->f = bip::file_mapping(p.c_str(), m);
+      s->r = bip::mapped_region(s->f, m);
+      return s;
+    }
+
+    void new_segment_locked(uint64_t n, size_t at_least){
+      this->sync_locked();
+      filesystem::path p = segmentPath(this->dir, n);
+      BOOST_LOG_TRIVIAL(debug) << format("📜 Starting segment " S_CYAN "%s" S_NOR) % p;
+      this->segs.push_back(map_segment(p, n, std::max(this->segment_bytes, at_least)));
+    }
+
+    /**
+     * @brief Drop the Blk `n` and the ones after, if they're in the active segment.
+     */
+    bool rewind_locked(uint64_t n) noexcept{
+      if (n < this->first_n) return false;
+      const Loc & l = this->index[n - this->first_n];
+      if (l.seg + 1 != this->segs.size()){
+        BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Can't rewrite Blk %d in a sealed segment" S_NOR) % n;
+        return false;
+      }
+      BOOST_LOG_TRIVIAL(warning) << format(S_MAGENTA "⚠️ Rewinding the BlkLog to Blk %d" S_NOR) % n;
+      Segment & s = *(this->segs.back());
+      s.used = l.off - HEADER_SIZE;
+      s.synced = std::min(s.synced, s.used);
+      std::memset(static_cast<char*>(s.r.get_address()) + s.used, 0, HEADER_SIZE);
+      this->index.resize(n - this->first_n);
+      return true;
+    }
+
+    /**
+     * @brief Scan the existing segments and rebuild the index.
+     */
+    void open_segments(){
+      // 1. list the segments, the zero-padded names sort as the numbers
+      vector<tuple<uint64_t,filesystem::path>> ps;
+      for (const auto & e : filesystem::directory_iterator(this->dir)){
+        string f = e.path().filename().string();
+        if (not (f.starts_with("seg-") and f.ends_with(".log"))) continue;
+        uint64_t n;
+        auto [ptr, ec] = std::from_chars(f.data() + 4, f.data() + f.size() - 4, n);
+        if (ec != std::errc() or ptr != f.data() + f.size() - 4) continue;
+        ps.push_back(make_tuple(n, e.path()));
+      }
+      std::sort(ps.begin(), ps.end());
+
+      // 2. scan the records
+      bool broken = false;
+      size_t i = 0;
+      for (; i < ps.size() and not broken; i++){
+        auto & [n, p] = ps[i];
+        if (filesystem::file_size(p) == 0) break;
+        unique_ptr<Segment> s = map_segment(p, n);
+        broken = not this->scan(*s);
+        if (s->used == 0) break;  // 🦜 : nothing good in it
+        this->segs.push_back(std::move(s));
+      }
+
+      // 3. drop the ones after a broken record
+      for (; i < ps.size(); i++){
+        BOOST_LOG_TRIVIAL(warning) << format(S_MAGENTA "⚠️ Dropping segment %s after a broken record" S_NOR) % std::get<1>(ps[i]);
+        filesystem::remove(std::get<1>(ps[i]));
+      }
+
+      // 4. reopen the last one for appending: trim what's after the records
+      // (e.g. a torn write) and pre-size it again
+      if (this->segs.empty()) return;
+      Segment & s = *(this->segs.back());
+      filesystem::path p = s.p;
+      uint64_t n = s.first;
+      size_t used = s.used;
+      this->segs.pop_back();
+      filesystem::resize_file(p, used);
+      this->segs.push_back(map_segment(p, n, std::max(this->segment_bytes, used)));
+      this->segs.back()->used = this->segs.back()->synced = used;
+    }
+
+    /**
+     * @brief Index the records of `s`.
+     * @return false if a broken record is found (the zeros after the records are fine).
+     */
+    bool scan(Segment & s){
+      const char * b = static_cast<const char*>(s.r.get_address());
+      size_t z = s.r.get_size();
+      size_t o = 0;
+      uint32_t i_seg = static_cast<uint32_t>(this->segs.size());
+      bool ok = true;
+      while (o + HEADER_SIZE <= z){
+        uint64_t n; uint32_t size, c;
+        std::memcpy(&n, b + o, 8);
+        std::memcpy(&size, b + o + 8, 4);
+        std::memcpy(&c, b + o + 12, 4);
+        if (n == 0 and size == 0 and c == 0) break; // 🦜 : the pre-sized tail
+
+        bool good = o + HEADER_SIZE + size <= z
+          and (this->index.empty() ? n == s.first : n == this->first_n + this->index.size())
+          and checksum(string_view(b + o + HEADER_SIZE, size)) == c;
+        if (not good){
+          BOOST_LOG_TRIVIAL(warning) << format(S_MAGENTA "⚠️ Broken record at %s:%d, the rest is dropped" S_NOR)
+            % s.p % o;
+          ok = false;
+          break;
+        }
+        if (this->index.empty()) this->first_n = n;
+        this->index.push_back(Loc{i_seg, size, o + HEADER_SIZE});
+        o += HEADER_SIZE + size;
+      }
+      s.used = s.synced = o;
+      return ok;
+    }
+  };
+}
@@ -0,0 +1,217 @@
+/**
+ * @file callExecutor.hpp
+ * @author Jianer Cong
+ * @brief The executor of read-only contract calls (`/call` of Rpc).
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : To read something from a contract (e.g. `get()`), the client used to
+ * send a Tx and wait for it to be committed. That costs a Blk, and every node
+ * executes it. With this, the node that receives the call just runs the message
+ * in the EVM against a snapshot of the stateDB, returns the output, and throws
+ * away whatever the message changed.
+ *
+ * 🦜 : Does it disturb the chain ?
+ *
+ * 🐢 : No.
+ *
+ *     1. It reads from a snapshot (IAcnSnapshotable), and it doesn't take any
+ *     lock of the BlkExecutor. <2024-07-19 Fri> 🦜 : If the versions of the state
+ *     (IAcnGettableAt) are given, we read the version of the latest committed
+ *     Blk (or of the asked one) instead, so we never see a half-committed Blk.
+ *
+ *     2. The changes stay in the WeakEvmHost and no journal is made.
+ *
+ *     3. It runs on its own small thread pool, and the number of pending calls is
+ *     capped. So a flood of calls can't starve the Rpc handlers. <2024-07-29 Mon>
+ *     🦜 : The Rpc handler doesn't wait for it either, it hands over a
+ *     callback (see call_async()), and the result is sent from the pool.
+ *
+ *     4. Each call has a gas limit (capped by `max_gas`), which is the step
+ *     limit: an endless loop runs out of gas.
+ *
+ * 🦜 : What can't it do ?
+ *
+ * 🐢 : It only does EVM CALLs. Creating contracts (even from inside a call) is
+ * refused, because EvmweakMsgExecutor::handleCreate() bumps a process-wide
+ * nonce, which would make this node disagree with the others. Python Txs are
+ * not supported either.
+ */
+#pragma once
+#include "evmExecutor.hpp"
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <future>
+#include <atomic>
+
+namespace weak{
+
+  /**
+   * @brief The IEvmMsgExecutable used for the read-only calls: CALLs are passed
+   * to EvmweakMsgExecutor, CREATEs fail.
+   */
+  class ReadOnlyMsgExecutor: public virtual IEvmMsgExecutable{
+  public:
+    evmc::Result execMsg(const evmc_message & msg,
+                         WeakEvmHost &  h) const noexcept override{
+      if (msg.kind >= EVMC_CREATE){
+        BOOST_LOG_TRIVIAL(debug) << format(S_MAGENTA "🚫 CREATE refused in a read-only call" S_NOR);
+        return evmc::Result{EVMC_FAILURE,0,0,nullptr,0};
+      }
+      return EvmweakMsgExecutor::handleCall(msg,h);
+    }
+  };
+
+  struct CallResult{
+    evmc_status_code status;
+    bytes output;
+    int64_t gas_used;
+
+    json::value toJson() const noexcept{
+      json::object o;
+      o["ok"] = (this->status == EVMC_SUCCESS);
+      o["status"] = evmc::to_string(this->status);
+      o["result"] = evmc::hex(this->output);
+      o["gas_used"] = this->gas_used;
+      return o;
+    }
+  };
+
+  class CallExecutor: public virtual IForRpcCallable{
+  public:
+    IAcnSnapshotable * const wrld;
+    IAcnGettableAt * const versions; // <! optional
+    const int64_t max_gas;        // <! the gas (= steps) a call can use at most
+    const size_t max_pending;     // <! the max number of calls queued or running
+
+    std::atomic<uint64_t> n_calls{0};
+    std::atomic<uint64_t> n_rejected{0};
+
+    using done_t = function<void (tuple<optional<CallResult>,string>)>;
+
+    /**
+     * @brief Construct a new CallExecutor
+     *
+     * @param w The world to take snapshots from.
+     * @param n The number of threads that run the calls.
+     * @param g The max gas per call.
+     * @param m The max number of pending calls.
+     * @param v The versions of the state, optional.
+     */
+    CallExecutor(IAcnSnapshotable * const w, size_t n = 2,
+                 int64_t g = 10'000'000, size_t m = 256,
+                 IAcnGettableAt * const v = nullptr):
+      wrld(w), versions(v), max_gas(g), max_pending(m), pool(std::max(n, size_t{1})){
+      BOOST_LOG_TRIVIAL(debug) << format("⚙️ CallExecutor started with " S_CYAN "%d thread%s" S_NOR
+                                         ", max gas = " S_CYAN "%d" S_NOR)
+        % n % pluralizeOn(n) % g;
+    }
+
+    ~CallExecutor(){
+      this->pool.join();
+    }
+
+    /**
+     * @brief Call the contract at `to` with `data`, as `from`, on the pool.
+     *
+     * @param gas The gas limit, capped by `max_gas`. If not given, `max_gas` is used.
+     * @param n Call against the state as of Blk `n`. If not given, the latest.
+     * @param done Called (on the pool, or right away if refused) with (the
+     * result, the error message if no result). There's no result if there're
+     * too many pending calls or the state as of `n` is not kept.
+     */
+    void call_async(const address & from, const address & to, bytes data,
+                    optional<int64_t> gas, optional<uint64_t> n, done_t done) noexcept{
+      if (n and not this->versions){
+        done(make_tuple(optional<CallResult>(), "Calls at a Blk number are not supported."));
+        return;
+      }
+
+      if (++(this->pending) > this->max_pending){
+        this->pending--;
+        this->n_rejected++;
+        done(make_tuple(optional<CallResult>(), "Too many pending calls, please try again later."));
+        return;
+      }
+      this->n_calls++;
+
+      int64_t g = std::min(gas.value_or(this->max_gas), this->max_gas);
+      boost::asio::post(this->pool, [this, from, to, data = std::move(data), g, n, done = std::move(done)](){
+        // 🦜 : the snapshot is taken when the call starts running
+        optional<CallResult> r;
+        shared_ptr<IAcnGettable> s = this->versions ?
+          this->versions->acnsAt(n) : this->wrld->snapshotOfAcns();
+        if (s)
+          r = callOn(s.get(), from, to, data, g);
+        s.reset();
+        this->pending--;
+        if (not r)
+          done(make_tuple(r, (format("The state as of Blk %d is not available.") % n.value_or(0)).str()));
+        else
+          done(make_tuple(r, ""));
+      });
+    }
+
+    /**
+     * @brief The same as call_async(), but waits for the result.
+     */
+    tuple<optional<CallResult>,string> call(const address & from, const address & to, bytes data,
+                                            optional<int64_t> gas = {},
+                                            optional<uint64_t> n = {}) noexcept{
+      auto p = std::make_shared<std::promise<tuple<optional<CallResult>,string>>>();
+      std::future<tuple<optional<CallResult>,string>> f = p->get_future();
+      this->call_async(from, to, std::move(data), gas, n,
+                       [p](tuple<optional<CallResult>,string> r){p->set_value(std::move(r));});
+      return f.get();
+    }
+
+    static tuple<bool,string> forRpc(const tuple<optional<CallResult>,string> & x) noexcept{
+      auto & [r, err] = x;
+      if (not r) return make_tuple(false, err);
+      return make_tuple(true, json::serialize(r.value().toJson()));
+    }
+
+    tuple<bool,string> callForRpc(const address & from, const address & to, bytes data,
+                                  optional<int64_t> gas, optional<uint64_t> n) noexcept override{
+      return forRpc(this->call(from, to, std::move(data), gas, n));
+    }
+
+    void callForRpcAsync(const address & from, const address & to, bytes data,
+                         optional<int64_t> gas, optional<uint64_t> n,
+                         function<void (tuple<bool,string>)> done) noexcept override{
+      this->call_async(from, to, std::move(data), gas, n,
+                       [done = std::move(done)](tuple<optional<CallResult>,string> x){done(forRpc(x));});
+    }
+
+    /**
+     * @brief Run the call on `w` in this thread. The changes are dropped.
+     */
+    static CallResult callOn(IAcnGettable * const w, const address & from, const address & to,
+                             const bytes & data, int64_t gas) noexcept{
+      if (not w->getAcn(to)){
+        BOOST_LOG_TRIVIAL(debug) << format("❌️ code addr %s dosen't exist") % to;
+        return CallResult{EVMC_FAILURE, {}, 0};
+      }
+
+      Tx t;
+      t.from = from;
+      t.to = to;
+      t.data = data;
+
+      ReadOnlyMsgExecutor ex;
+      WeakEvmHost h{w, t, "call", &ex};
+      evmc_message msg = EvmExecutor::txToEvmcMsg(t);
+      msg.gas = gas;
+
+      evmc::Result r = ex.execMsg(msg, h);
+      return CallResult{r.status_code,
+                        bytes{r.output_data, r.output_size},
+                        gas - r.gas_left};
+    }
+
+  private:
+    boost::asio::thread_pool pool;
+    std::atomic<size_t> pending{0};
+  };
+}
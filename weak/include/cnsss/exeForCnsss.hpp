@@ -89,7 +89,7 @@ namespace weak {
     }
 
     virtual string handle_EXECUTE_BLK(string & cmd) noexcept {
-      string arg = cmd.substr(1);
+      string_view arg(cmd.cbegin() + 1, cmd.cend()); // 🦜 : no need to copy it out.
       BOOST_LOG_TRIVIAL(debug) << format("⚙️ Handling " S_CYAN "EXECUTE_BLK()" S_NOR ",data to parse:\n\t"
                                          S_CYAN "%s" S_NOR) % pure::get_data_for_log(arg);
       BlkForConsensus b;
@@ -125,7 +125,7 @@ namespace weak {
      */
     virtual string handle_ADD_TXS(string & cmd) noexcept {
       try{
-        string arg = cmd.substr(1);
+        string_view arg(cmd.cbegin() + 1, cmd.cend());
         BOOST_LOG_TRIVIAL(debug) << format("⚙️ Handling " S_CYAN "ADD_TXS" S_NOR ", data to parse:\n\t"
                                            S_CYAN "%s" S_NOR) % pure::get_data_for_log(arg);
 
@@ -152,8 +152,7 @@ namespace weak {
           BOOST_LOG_TRIVIAL(debug) << format("⚙️ Removing some of the txs. size reduced from "
                                              S_BLUE "%d" S_NOR " to " S_GREEN "%d" S_NOR)
             % n % txs.size();
-          arg = Tx::serialize_from_array(txs);
-          cmd = static_cast<char>(Cmd::ADD_TXS) + arg;
+          cmd = static_cast<char>(Cmd::ADD_TXS) + Tx::serialize_from_array(txs); // 🦜 : `arg` is dangling after this
           // remove bad txs from the cmd.
         }
       }catch(const std::exception & e){
@@ -265,10 +264,11 @@ namespace weak {
 
       Blk b{this->next_blk_number,
             this->previous_hash,
-            txs};
+            std::move(txs)};
 
       auto h1 = b.hash();
-      auto cmd1 = static_cast<char>(Cmd::EXECUTE_BLK) + b.toString();
+      string cmd1 = b.toString();
+      cmd1.insert(cmd1.begin(), static_cast<char>(Cmd::EXECUTE_BLK)); // 🦜 : in place, instead of char + string
       BOOST_LOG_TRIVIAL(debug) << format("Making " S_MAGENTA " EXECUTE_BLK() " S_NOR " cmd for "
                                          S_CYAN " Blk-%d, txs size: %d" S_NOR)
         % b.number % b.txs.size();
@@ -279,7 +279,7 @@ namespace weak {
       // 🦜 : Looks like it's an okay blk, so we update the state.
       this->next_blk_number++;
       this->previous_hash = h1;
-      cmd = cmd1;
+      cmd = std::move(cmd1);
       BOOST_LOG_TRIVIAL(debug) << format("cmd updated to : " S_MAGENTA " %s" S_NOR) % pure::get_data_for_log(cmd);
 
       return "OK";
@@ -205,5 +205,24 @@ namespace weak{
       };
       return json::serialize(jv);
     }
+
+    /**
+     * @brief The info() in pb (hiPb::PoolStatus), for `/get_pool_status_pb`.
+     */
+    string info_pb() noexcept override{
+      hiPb::PoolStatus pb;
+      pb.set_max_txs_per_batch(static_cast<uint64_t>(this->max_txs_per_batch));
+      {
+        std::unique_lock g(this->lock_for_hs); // movable lock
+        for (const hash256 & h : *this->hs)
+          pb.add_hash_history(weak::toByteString<hash256>(h));
+      } // unlocks here
+      {
+        std::unique_lock g(this->lock_for_txs); // movable lock
+        for (const Tx & tx : this->txs)
+          *(pb.add_txs_in_pool()) = tx.toPb();
+      } // unlocks here
+      return pb.SerializeAsString();
+    }
   };
 }
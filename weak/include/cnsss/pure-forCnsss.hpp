@@ -74,8 +74,8 @@ namespace pure {
     virtual bool is_primary() const noexcept=0;
     optional<string> handle_execute(string endpoint, string data)noexcept{
       if (this->is_primary())
-        return handle_execute_for_primary(endpoint,data);
-      return handle_execute_for_sub(endpoint, data);
+        return handle_execute_for_primary(std::move(endpoint),std::move(data));
+      return handle_execute_for_sub(std::move(endpoint), std::move(data));
     };
 
     /**
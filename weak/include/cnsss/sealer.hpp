@@ -31,6 +31,9 @@ namespace weak{
     int wait_s;                 // <! The time interval between sealing.(default
                                 // to 0).
 
+    IAcnPrefetchable * const prefetcher; // <! <2024-07-27 Sat> optional, told the
+                                         // Txs of each sealed Blk.
+
     /**
      * @brief Construct a sealer
      *
@@ -51,15 +54,21 @@ namespace weak{
      * @param s The sealing interval in seconds. So the sealer will check the
      * pool and seal Blk every `s` second(s).
      *
+     * @param p If given, the Acns of the Txs in each sealed Blk are prefetched
+     * while the Blk goes through the consensus (see acnPrefetcher.hpp). The
+     * Txs are taken from `m`, so it should also be an IByHashTxGettable.
+     *
      * @see execManager()
      */
     Sealer(IForSealerBlkPostable * const c,
            IForSealerTxHashesGettable * const m,
            uint64_t n = 0,
            hash256 h = {},
-           int s = 2
+           int s = 2,
+           IAcnPrefetchable * const p = nullptr
            ): mempool(m), consensus(c),next_blk_number(n),previous_hash(h),
-              wait_s(2)         // By default, seal every 2 sec
+              wait_s(2),        // By default, seal every 2 sec
+              prefetcher(p)
     {
       // Start the job
       this->running.test_and_set(); // set the flag to TRUE
@@ -81,6 +90,16 @@ namespace weak{
                         txhs};
       this->previous_hash = b.hash();
 
+      // 🦜 : Start reading the Acns now, the executor will find them there
+      if (this->prefetcher)
+        if (IByHashTxGettable * const p = dynamic_cast<IByHashTxGettable*>(this->mempool)){
+          vector<Tx> txs;
+          for (const hash256 & h : txhs)
+            if (optional<Tx> t = p->getTxByHash(h))
+              txs.push_back(std::move(t.value()));
+          this->prefetcher->prefetchAcnsOf(txs);
+        }
+
       this->consensus->postBlk(b);     // this is a long process
     }
 
@@ -22,6 +22,138 @@ namespace weak {
   class IAcnGettable{
   public:
     virtual optional<Acn> getAcn(evmc::address addr) const noexcept=0;
+
+    /**
+     * @brief Get many Acns in one go.
+     *
+     * <2024-07-27 Sat> 🦜 : This one just calls getAcn() for each, the
+     * WorldStorage batches them with RocksDB's MultiGet().
+     */
+    virtual vector<optional<Acn>> getManyAcns(const vector<evmc::address> & as) const noexcept{
+      vector<optional<Acn>> o;
+      o.reserve(as.size());
+      for (const evmc::address & a : as)
+        o.push_back(this->getAcn(a));
+      return o;
+    }
+
+    /**
+     * @brief Get the code whose hash is `h`, for the Acns that only have the
+     * `code_ref`.
+     *
+     * <2024-07-28 Sun> 🦜 : The WorldStorage keeps the long codes in
+     * `code/<codehash>` and getAcn() doesn't read them, the others keep the
+     * codes in the Acns, so this gives nullptr.
+     */
+    virtual shared_ptr<const bytes> getCode(const hash256 & h) const noexcept{
+      return nullptr;
+    }
+
+    /**
+     * @brief The code of `a` (got by getAcn()), loaded with getCode() if it's
+     * not there yet.
+     *
+     * 🐢 : This is for whoever needs the code itself (e.g. to run it), the
+     * code hash is always there.
+     */
+    bytes_view codeOf(const Acn & a) const noexcept{
+      if (a.code.empty() and a.code_ref and not a.shared_code)
+        a.shared_code = this->getCode(a.code_ref.value());
+      return a.codeView();
+    }
+  };
+
+  /**
+   * @brief Representing a type that can load the Acns that some Txs will touch
+   * before they're executed.
+   *
+   * <2024-07-27 Sat> 🦜 : The Txs of a Blk are known long before the Blk is
+   * executed (e.g. right after the sealer made the BlkForConsensus), so their
+   * Acns can be read while the consensus runs. See acnPrefetcher.hpp.
+   */
+  class IAcnPrefetchable{
+  public:
+    /// Start loading the Acns touched by `txs`, without waiting for them.
+    virtual void prefetchAcnsOf(const vector<Tx> & txs) noexcept = 0;
+  };
+
+  /**
+   * @brief Representing a type that can give a read-only view of the Acns as
+   * they are now.
+   *
+   * 🦜 : The returned view doesn't see the later commits, so a reader (e.g. the
+   * `/call` of Rpc) can take its time without blocking (or being fooled by) the
+   * BlkExecutor.
+   */
+  class IAcnSnapshotable{
+  public:
+    virtual shared_ptr<IAcnGettable> snapshotOfAcns() const = 0;
+  };
+
+  /**
+   * @brief Representing a type that can give the Acns as of a Blk, i.e. right
+   * after the Blk was committed.
+   *
+   * <2024-07-19 Fri> 🦜 : Reads through this never see a half-committed Blk.
+   */
+  class IAcnGettableAt{
+  public:
+    /**
+     * @param n The Blk number. If not given, the latest committed Blk.
+     * @return The read-only view, or nullptr if the state as of `n` is not kept.
+     */
+    virtual shared_ptr<IAcnGettable> acnsAt(optional<uint64_t> n = {}) noexcept = 0;
+
+    optional<Acn> getAcnAt(evmc::address addr, optional<uint64_t> n = {}) noexcept{
+      shared_ptr<IAcnGettable> w = this->acnsAt(n);
+      if (not w) return {};
+      return w->getAcn(addr);
+    }
+  };
+
+  /**
+   * @brief Representing a type that can walk through all the Acns.
+   *
+   * <2024-07-24 Wed> 🦜 : This is for building the StateRoot on start-up.
+   */
+  class IAcnIterable{
+  public:
+    /// Call `f(the key, the Acn)` for each Acn.
+    virtual void forEachAcn(function<void(const string &, const Acn &)> f) const = 0;
+  };
+
+  /**
+   * @brief Representing a type that can save (and reopen) a copy of the
+   * stateDB as of a Blk.
+   *
+   * 🐢 : These are the "checkpoints" that serve the old heights, whose
+   * snapshots are no longer pinned.
+   */
+  class IStateCheckpointable{
+  public:
+    virtual bool checkpointState(uint64_t n) noexcept = 0;
+    virtual bool removeStateCheckpoint(uint64_t n) noexcept = 0;
+    virtual vector<uint64_t> listStateCheckpoints() const noexcept = 0;
+    /// @return the read-only view of the checkpoint, or nullptr if failed.
+    virtual shared_ptr<IAcnGettable> openStateCheckpoint(uint64_t n) const noexcept = 0;
+  };
+
+  /**
+   * @brief Representing a stateDB that may be written without its own log
+   * (WAL), so the state of the latest Blks can be lost in a crash. See
+   * stateCommit.hpp.
+   *
+   * 🐢 : The ExecBlks on the chain can redo the lost writes, so the stateDB
+   * only needs to remember where to start.
+   */
+  class IStateDurable{
+  public:
+    /// The first Blk whose state may be lost (⇒ replayed on start-up), {} if
+    /// nothing can be lost.
+    virtual optional<uint64_t> stateReplayFrom() const noexcept = 0;
+    /// Make the state on disk durable, then record that the replay starts at
+    /// `n` ({} ⇒ nothing to replay any more).
+    virtual bool markStateDurable(optional<uint64_t> n) noexcept = 0;
   };
 
 
@@ -31,6 +163,28 @@ namespace weak {
 
   struct StateChange{bool del=false; string k; string v;};
 
+  /**
+   * @brief The last change of each key in the journals `J`, in the order the
+   * keys first show up.
+   *
+   * <2024-07-26 Fri> 🦜 : A hot Acn touched by 500 Txs of a Blk has 500
+   * changes, but only the last one is the state after the Blk. The changes are
+   * whole values (put or delete), so the earlier ones can just be dropped.
+   */
+  inline vector<const StateChange*> lastChangeOfEachKey(const vector<vector<StateChange>> & J){
+    unordered_map<string_view, size_t> at;
+    vector<const StateChange*> o;
+    for (const vector<StateChange> & j : J)
+      for (const StateChange & c : j){
+        auto [it, fresh] = at.try_emplace(c.k, o.size());
+        if (fresh)
+          o.push_back(&c);
+        else
+          o[it->second] = &c;
+      }
+    return o;
+  }
+
   /**
    * @brief The interface drawn from `IWorldChainStateSettable`.
    *
@@ -39,6 +193,20 @@ namespace weak {
   class IChainDBGettable {
   public:
     virtual optional<string> getFromChainDB(const string k) const =0;
+
+    /**
+     * @brief Get many keys at once. The i-th result is the value of `ks[i]`, if any.
+     *
+     * <2024-07-10 Wed> 🦜 : The default just calls getFromChainDB() one by
+     * one. Storages that can do better (e.g. RocksDB's MultiGet) override it.
+     */
+    virtual vector<optional<string>> getManyFromChainDB(const vector<string> & ks) const{
+      vector<optional<string>> o;
+      o.reserve(ks.size());
+      for (const string & k : ks)
+        o.push_back(this->getFromChainDB(k));
+      return o;
+    }
   };
 
   /**
@@ -64,6 +232,22 @@ namespace weak {
     /// Apply the journal (state changes) to the stateDb, usually it's one
     /// journal per Blk.
     virtual bool applyJournalStateDB(const vector<StateChange> & j)=0;
+
+    /**
+     * @brief Apply the journals of a Blk (one per Tx), in order.
+     *
+     * <2024-07-26 Fri> 🦜 : The implementer should apply them all or nothing
+     * (e.g. in one WriteBatch), so that a crash never leaves half a Blk in
+     * the stateDB. Only the last change of each key matters (see
+     * lastChangeOfEachKey()), so this default one applies those as one
+     * journal.
+     */
+    virtual bool applyJournalsStateDB(const vector<vector<StateChange>> & J){
+      vector<StateChange> j;
+      for (const StateChange * c : lastChangeOfEachKey(J))
+        j.push_back(*c);
+      return this->applyJournalStateDB(j);
+    }
   };
 
   /**
@@ -166,6 +350,11 @@ class ITxExecutable {
   class IForRpc{
   public:
     virtual string info() noexcept=0;
+    /**
+     * @brief The info() in pb. <2024-07-12 Fri> 🦜 : Empty by default, only
+     * the Mempool has it (hiPb::PoolStatus) for now.
+     */
+    virtual string info_pb() noexcept {return "";}
   };
 
   /**
@@ -179,6 +368,33 @@ class ITxExecutable {
     virtual bool addTxs(vector<Tx> && txs) noexcept=0;
   };
 
+  /**
+   * @brief The interface exposed to RPC for read-only contract calls.
+   *
+   * 🦜 : Nothing is changed by the call, see CallExecutor.
+   */
+  class IForRpcCallable{
+  public:
+    /**
+     * @brief Call the contract at `to` with `data`, as `from`.
+     * @param n Call against the state as of Blk `n`. If not given, the latest.
+     * @return (ok, the result in JSON or the error message).
+     */
+    virtual tuple<bool,string> callForRpc(const address & from, const address & to, bytes data,
+                                          optional<int64_t> gas, optional<uint64_t> n) noexcept=0;
+
+    /**
+     * @brief The same as callForRpc(), but the result is given to `done`,
+     * maybe from another thread. <2024-07-29 Mon> 🦜 : The default just calls
+     * callForRpc().
+     */
+    virtual void callForRpcAsync(const address & from, const address & to, bytes data,
+                                 optional<int64_t> gas, optional<uint64_t> n,
+                                 function<void (tuple<bool,string>)> done) noexcept{
+      done(this->callForRpc(from, to, std::move(data), gas, n));
+    }
+  };
+
 
   /**
    * @brief The interface of mempool for LightExeForCnsss.
@@ -52,13 +52,13 @@ namespace weak{
     auto bs = evmc::bytes_view(reinterpret_cast<const uint8_t*>(h.bytes),
                                sizeof(h.bytes));
     // std::basic_string_view()
-    return evmc::hex(bs);
+    return hex::encode(bs);
   }
 
   string addressToString(evmc::address a) noexcept{
     auto bs = evmc::bytes_view(a);
     // in evmc.hpp ln67, evmch gives a convertion to bytes_view from address
-    return evmc::hex(bs);
+    return hex::encode(bs);
     // In fact, we can just use:
     //    string s  = evmc::hex(this->from);
     // But this one is more readable and less C++
@@ -159,7 +159,7 @@ namespace weak{
   void tag_invoke(json::value_from_tag, json::value& v, Acn const& a ){
     v = {
       {"nonce",a.nonce},
-      {"code",evmc::hex(a.code)},
+      {"code",hex::encode(a.codeView())},
       {"codehash",hashToString(a.codehash())}
     };
 
@@ -219,6 +219,10 @@ namespace weak{
       }
       v.as_object()["disk_storage"] = d;
     }
+
+    // <2024-07-22 Mon> the code_ref
+    if (a.code_ref)
+      v.as_object()["code_ref"] = hashToString(a.code_ref.value());
   }
 
   // This helper function deduces the type and assigns the value with the matching key
@@ -246,7 +250,7 @@ namespace weak{
       string c;
       c = value_to<string>(v.at("code"));
 
-      this->code = evmc::from_hex(c).value();
+      this->code = hex::decode(c).value();
       /* Implementation of from_hex:
 
          If the length of string is smaller than the target array copy the bytes
@@ -304,6 +308,13 @@ namespace weak{
           this->disk_storage.push_back(value_to<string>(s));
         }
       }
+
+      // <2024-07-22 Mon> get the code_ref if exists
+      if (o.contains("code_ref")){
+        optional<hash256> h = hex::decode<hash256>(value_to<string>(o.at("code_ref")));
+        if (not h) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid `code_ref`"));
+        this->code_ref = h.value();
+      }
     }catch(std::exception &e){
       BOOST_LOG_TRIVIAL(error) << format("❌️ error parsing json: %s") % e.what();
       return false;
@@ -317,7 +328,10 @@ namespace weak{
   hiPb::Acn Acn::toPb() const {
     hiPb::Acn pb;
     pb.set_nonce(this->nonce);
-    pb.set_code(weak::toString(this->code));
+    // 🦜 : if the code was loaded, it goes with the Acn (like it used to), see
+    // WorldStorage::moveCodeOut()
+    bytes_view c = this->codeView();
+    pb.set_code(reinterpret_cast<const char*>(c.data()), c.size());
 
     /*
       set the
@@ -334,12 +348,16 @@ namespace weak{
       pb.add_disk_storage(s);
     }
 
+    if (this->code_ref)
+      pb.set_code_ref(weak::toByteString<hash256>(this->code_ref.value()));
+
     return pb;
   }
 
   void Acn::fromPb(const hiPb::Acn & pb){
     this->nonce = pb.nonce();
     this->code = weak::bytesFromString(pb.code());
+    this->shared_code.reset();
 
     // parse the storage
     for (int i = 0;i<pb.storage_ks_size();i++){
@@ -352,6 +370,9 @@ namespace weak{
     for (int i = 0;i<pb.disk_storage_size();i++){
       this->disk_storage.push_back(pb.disk_storage(i));
     }
+
+    if (not pb.code_ref().empty())
+      this->code_ref = weak::fromByteString<hash256>(pb.code_ref()); // may throw
   }
 
 
@@ -382,7 +403,6 @@ namespace weak{
 
     // <2024-01-30 Tue>
   void Tx::fromPb(const hiPb::Tx & pb){
-      string s;
       /*
         🦜 : Similar process ad in fromJson0
        */
@@ -390,10 +410,9 @@ namespace weak{
         this->pk_pem = pb.pk_pem();
         this->from = this->getFromFromPkPem();
       }else{
-        // parse the from
-        s = pb.from_addr();
+        // parse the from (🦜 : from the view, no copy)
         // should be 20 bytes
-        this->from = weak::fromByteString<address>(s); // might throw
+        this->from = weak::fromByteString<address>(pb.from_addr()); // might throw
       }
 
       // parse sig if exists
@@ -415,8 +434,7 @@ namespace weak{
       this->type = Tx::typeFromPb(pb.type());
 
       // parse the to
-      s = pb.to_addr();
-      this->to = weak::fromByteString<address>(s); // throws for bad lengths
+      this->to = weak::fromByteString<address>(pb.to_addr()); // throws for bad lengths
     }
 
 
@@ -434,19 +452,19 @@ namespace weak{
       }else{
         // 🦜 : if pk_pem is not given, parse the `from`, otherwise it's ignored.
         s= value_to<string>(o.at("from"));
-        optional<evmc::address> oa = evmc::from_hex<evmc::address>(s);
+        optional<evmc::address> oa = hex::decode<evmc::address>(s);
         if (not oa) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid from = " + s));
         this->from = oa.value();
       }
 
       if (o.contains("signature")){ // parse sig if exists
-        ob = evmc::from_hex(o.at("signature").as_string());
+        ob = hex::decode(o.at("signature").as_string());
         if (not ob) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid `signature` format" + json::serialize(o.at("signature"))));
         this->signature = ob.value();
       }
 
       if (o.contains("pk_crt")){ // parse pk_crt if exists
-        ob = evmc::from_hex(o.at("pk_crt").as_string());
+        ob = hex::decode(o.at("pk_crt").as_string());
         if (not ob) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid `pk_crt` format" + json::serialize(o.at("pk_crt"))));
         this->pk_crt = ob.value();
       }
@@ -479,7 +497,7 @@ namespace weak{
          whatever is stored in the json.)
        */
       if (this->type == Type::evm){
-        ob = evmc::from_hex(s);
+        ob = hex::decode(s);
         if (not ob) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid data = " + s));
         this->data = ob.value();
       }else{
@@ -488,7 +506,7 @@ namespace weak{
 
       s= value_to<string>(o.at("to"));
       // this->from = evmc::literals::parse<address>(f); // 🦜 this do abort (not what we wan)
-      oa = evmc::from_hex<address>(s);
+      oa = hex::decode<address>(s);
       if (not oa) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid to = " + s));
       this->to = oa.value();
 
@@ -539,7 +557,7 @@ namespace weak{
       jv.as_object()["type"] = Tx::typeToString(c.type);
       jv.as_object()["data"] = toString(c.data);
     }else{
-      jv.as_object()["data"] = evmc::hex(c.data);
+      jv.as_object()["data"] = hex::encode(c.data);
     }
 
     // [2024-01-22] 🐢 : Add the optional field if they are given.
@@ -547,10 +565,10 @@ namespace weak{
       jv.as_object()["pk_pem"] = c.pk_pem;
     }
     if (not c.signature.empty()){
-      jv.as_object()["signature"] = evmc::hex(c.signature);
+      jv.as_object()["signature"] = hex::encode(c.signature);
     }
     if (not c.pk_crt.empty()){
-      jv.as_object()["pk_crt"] = evmc::hex(c.pk_crt);
+      jv.as_object()["pk_crt"] = hex::encode(c.pk_crt);
     }
   }
 
@@ -575,7 +593,7 @@ namespace weak{
       // if (not oh) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid hash = " + h));
       // this->hash = oh.value();
 
-      oh = evmc::from_hex<hash256>(p);
+      oh = hex::decode<hash256>(p);
       if (not oh) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid hash = " + h));
       this->parentHash = oh.value();
     }catch (std::exception &e){
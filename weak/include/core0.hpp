@@ -11,6 +11,8 @@
 #include <boost/exception/diagnostic_information.hpp>
 #include ".generated_pb/hi.pb.h"
 #include "pure-common.hpp"
+#include "binCodec.hpp"
+#include "simdHex.hpp"
 #include <boost/log/trivial.hpp> // For BOOST_LOG_TRIVIAL, trace, debug,..,fatal
 #include <boost/format.hpp>
 #include <fstream>
@@ -21,6 +23,8 @@
 #include <intx/intx.hpp>
 #include <memory>
 #include <tuple> // for tuple
+#include <future> // async
+#include <thread>
 #include <ethash/keccak.hpp>
 #include <evmc/evmc.hpp>
 #include <evmc/hex.hpp>
@@ -41,6 +45,8 @@ namespace weak{
   using pure::ISerializable;
   using pure::ISerializableInPb;
   using pure::pluralizeOn;
+  using pure::pbArenaOptions;
+  using pure::PB_ARENA_MIN;
   using std::tuple;
   using std::make_tuple;
   using ethash::hash256;
@@ -76,7 +82,7 @@ namespace weak{
 
   inline string resultToString(const evmc::Result& result){
     bytes o{result.output_data,result.output_size};
-    return evmc::hex(o);
+    return hex::encode(o);
   }
 
   /**
@@ -148,7 +154,7 @@ namespace weak{
   inline bytes bytesFromString(string_view s){
     return bytes(reinterpret_cast<const uint8_t*>(s.data()),s.size());
   }
-  inline string_view toStringView(const bytes & b){
+  inline string_view toStringView(bytes_view b){
     return string_view(reinterpret_cast<const char*>(b.data()),b.size());
   }
   // byte32 <-> string
@@ -216,12 +222,40 @@ namespace weak{
       `disk_storage` differently.
     */
     vector<string> disk_storage;
+    /*
+      <2024-07-22 Mon> 🦜 : The hash of the code, set when the code is not
+      embedded but kept in the content-addressed `code/<codehash>` keyspace of
+      the stateDB. See WorldStorage::applyJournalStateDB().
+    */
+    optional<hash256> code_ref;
+    /*
+      <2024-07-28 Sun> 🦜 : The code behind `code_ref`, once someone needed it
+      (see IAcnGettable::codeOf()). It's shared with the CodeCache, so it's not
+      copied, and an Acn that's only read or written (but not run) never loads
+      it. (mutable because it's a cache: the Acn is the same with or without it.)
+    */
+    mutable shared_ptr<const bytes> shared_code;
+
+    /// The code, or empty if it's behind a `code_ref` that's not loaded.
+    bytes_view codeView() const noexcept{
+      if (code.empty() and shared_code) return *shared_code;
+      return code;
+    }
 
     /// The code hash. Can be a value not related to the actual code.
     hash256 codehash() const noexcept{
+      if (code_ref and code.empty()) return code_ref.value(); // 🦜 : the code is not loaded
       return ethash::keccak256(reinterpret_cast<const uint8_t*>(code.data()), code.size());
     }
 
+    /// Whether `a` and `b` have the same code, without loading it.
+    static bool sameCode(const Acn & a, const Acn & b) noexcept{
+      if (a.code_ref and b.code_ref)
+        return std::equal(std::cbegin(a.code_ref->bytes), std::cend(a.code_ref->bytes),
+                          std::cbegin(b.code_ref->bytes));
+      return a.codeView() == b.codeView();
+    }
+
     // methods
     // --------------------------------------------------
     json::value toJson() const noexcept override;
@@ -376,27 +410,86 @@ namespace weak{
      * [2024-01-23] 🦜 it's used to be a field, now it's a method. 
      */
     hash256 hash() const {
-      // convert nonce to array
-      constexpr auto size = sizeof(uint64_t);
-      uint8_t a[size]{};
-      intx::be::store(a,nonce);
+      uint8_t b[HASH_INPUT_SIZE];
+      this->hashInput(b);
+      // Get the hash(nonce)
+      return  ethash::keccak256(b, HASH_INPUT_SIZE);
+    }
 
-      uint8_t b[size + 20];
-      // std::copy_n(std::begin(f.bytes)
-      //             ,20, std::begin(b));
-      // std::copy_n(std::begin(a),size,std::begin(b)+20);
+    static constexpr size_t HASH_INPUT_SIZE = sizeof(uint64_t) + 20;
 
+    /// What's hashed in hash(): `from | nonce` (big-endian).
+    void hashInput(uint8_t b[HASH_INPUT_SIZE]) const noexcept{
       std::copy_n(this->from.bytes ,20, b);
-      std::copy_n(a,size,b+20);
+      intx::be::unsafe::store(b + 20, this->nonce);
+    }
 
-      // Get the hash(nonce)
-      return  ethash::keccak256(reinterpret_cast<uint8_t*>(b), size + 20);
+    /**
+     * @brief The hashes of `txs[0], ... txs[n-1]` into `o`.
+     *
+     * <2024-07-26 Fri> 🦜 : Same as calling hash() n times, but the Keccaks
+     * are done a few at a time on the SIMD lanes (see
+     * ethash::keccak256_batch()), which is a few times faster for a big Blk.
+     */
+    static void hashes(const Tx * const txs, const size_t n, hash256 * const o) noexcept{
+      vector<uint8_t> b(n * HASH_INPUT_SIZE);
+      vector<const uint8_t*> ps(n);
+      vector<size_t> ss(n, HASH_INPUT_SIZE);
+      for (size_t i = 0; i < n; i++){
+        ps[i] = b.data() + i * HASH_INPUT_SIZE;
+        txs[i].hashInput(b.data() + i * HASH_INPUT_SIZE);
+      }
+      ethash::keccak256_batch(o, ps.data(), ss.data(), n);
+    }
+    // --------------------------------------------------
+    // <2024-07-27 Sat> 🦜 : The binary codec, see binCodec.hpp
+
+    /// A view of this Tx, valid as long as the Tx is alive and unchanged.
+    bin::TxView binView() const noexcept{
+      return bin::TxView{static_cast<uint8_t>(this->type), this->from, this->to,
+                         this->nonce, static_cast<int64_t>(this->timestamp),
+                         bin::viewOf(this->data), this->pk_pem,
+                         bin::viewOf(this->signature), bin::viewOf(this->pk_crt)};
+    }
+
+    /// Copy the Tx out of the view, like fromPb(). Throws on a bad `type`.
+    void fromBinView(const bin::TxView & v){
+      if (v.type > static_cast<uint8_t>(Type::python)) throw bin::Error("bad Tx type");
+      this->type = static_cast<Type>(v.type);
+      this->pk_pem = string(v.pk_pem);
+      this->from = this->pk_pem.empty() ? v.from : this->getFromFromPkPem();
+      this->to = v.to;
+      this->nonce = v.nonce;
+      this->timestamp = static_cast<std::time_t>(v.timestamp);
+      this->data.assign(v.data.begin(), v.data.end());
+      this->signature.assign(v.signature.begin(), v.signature.end());
+      this->pk_crt.assign(v.pk_crt.begin(), v.pk_crt.end());
+    }
+
+    string toBinString() const{
+      bin::TxView v = this->binView();
+      bin::Writer w{bin::HEADER_SIZE + v.size()};
+      w.header(bin::Kind::tx);
+      v.write(w);
+      return std::move(w.s);
     }
+
+    bool fromBinString(string_view s) noexcept{
+      try{
+        this->fromBinView(bin::parse<bin::TxView>(s, bin::Kind::tx));
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(error) << format("❌️ error parsing bin Tx: %s") % e.what();
+        return false;
+      }
+      return true;
+    }
+
     /*
       For now, use UTF8 JSON for serialization. later we can change it to other
       🦜 :<2024-01-30 Tue> now we use protobuf
+      🦜 :<2024-07-27 Sat> or the binary codec (WITH_BIN_CODEC)
      */
-    ADD_TO_FROM_STR_WITH_JSON_OR_PB
+    ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB
     /*
       🐢 defines the to/fromString() methods according to WITH_PROTOBUF, so we
       don't need to write the following...
@@ -516,14 +609,24 @@ namespace weak{
         🦜: In addition to `toString` and `fromString`, here we also need to
         switch these two for Txs
        */
-#ifdef WITH_PROTOBUF
-      hiPb::Txs txs;
-      txs.ParseFromString(string(arg));
+#if WITH_BIN_CODEC
+      vector<bin::TxView> vs = bin::parseTxs(arg); // throws
+      vector<Tx> v(vs.size());
+      for (size_t i = 0; i < vs.size(); i++)
+        v[i].fromBinView(vs[i]);
+      return v;
+#elif defined(WITH_PROTOBUF)
+      // <2024-07-28 Sun> 🦜 : on an Arena that goes with this call, see pbArenaOptions()
+      google::protobuf::Arena arena{pbArenaOptions(arg.size())};
+      hiPb::Txs & txs = *google::protobuf::Arena::CreateMessage<hiPb::Txs>(&arena);
+      // 🦜 : ParseFromArray() reads the view directly, no temporary string.
+      txs.ParseFromArray(arg.data(), static_cast<int>(arg.size()));
       vector<Tx> v;
+      v.reserve(txs.txs_size());
       for (const hiPb::Tx & tx : txs.txs()){
         Tx t;
         t.fromPb(tx);
-        v.push_back(t);
+        v.push_back(std::move(t));
       }
       return v;
 #else
@@ -531,13 +634,27 @@ namespace weak{
       /* 🦜: std:string_view -> json::string_view is
          available in Boost 1.82.0*/
       // json::value v = json::parse(s);
-      json::value v = json::parse(arg); // throw on fail
+      json::monotonic_resource mr{arg.size()}; // 🦜 : the DOM is dropped at once
+      json::value v = json::parse(arg, &mr); // throw on fail
       return value_to<vector<Tx>>(v);
 #endif
 
     }
     static string serialize_from_array(const vector<Tx> & txs){
-#ifdef WITH_PROTOBUF
+#if WITH_BIN_CODEC
+      size_t n = bin::HEADER_SIZE + 4;
+      vector<bin::TxView> vs;
+      vs.reserve(txs.size());
+      for (const Tx & t : txs){
+        vs.push_back(t.binView());
+        n += vs.back().size();
+      }
+      bin::Writer w{n};
+      w.header(bin::Kind::txs);
+      w.u32(static_cast<uint32_t>(vs.size()));
+      for (const bin::TxView & v : vs) v.write(w);
+      return std::move(w.s);
+#elif defined(WITH_PROTOBUF)
       hiPb::Txs pb;
       for (const Tx & t : txs){
         pb.add_txs()->CopyFrom(t.toPb());
@@ -561,15 +678,20 @@ namespace weak{
       try {
         // BOOST_LOG_TRIVIAL(debug) << format("Parsing txs JSON sent from client. %s") % s ;
         // Parse the Json (let it throw)
+
+        /* <2024-07-28 Sun> 🦜 : The whole DOM (and the reply built from it)
+           lives in one monotonic_resource, freed when we return, instead of a
+           malloc() per value. */
+        json::monotonic_resource mr{s.size()};
         #ifdef _WIN32
-        json::value v = json::parse(string(s));
+        json::value v = json::parse(string(s), &mr);
         #else
         /* 🦜: std:string_view -> json::string_view is
            available in Boost 1.82.0, at least for GCC*/
-        json::value v = json::parse(s);
+        json::value v = json::parse(s, &mr);
         #endif
-        // Turning Json into array
-        json::array a = v.as_array();
+        // Turning Json into array (🦜 : moved, so it stays in `mr`)
+        json::array a = std::move(v.as_array());
 
         return Tx::parse_txs_json_for_rpc(move(a), txf);
       }catch (std::exception const & e){
@@ -590,11 +712,12 @@ namespace weak{
      * The exception should be caught by `parse_txs_jsonString_for_rpc()`).
      */
     static optional<tuple<string,vector<Tx>>> parse_txs_json_for_rpc(json::array && a, ITxVerifiable * const txf=nullptr) {
-      json::array os;           // output object
+      json::array os(a.storage()); // output object (🦜 : in the same memory as `a`)
 
       vector<Tx> txs;
+      txs.reserve(a.size());
       for (int i=0;i<a.size();i++){
-        json::object o = a[i].as_object(); // the tx object
+        json::object & o = a[i].as_object(); // the tx object (🦜 : `a` is ours, no copy)
 
         // 🦜 : but we need to add a `timestamp` field for the client, and
         // because this is a required field, so we kinda need to add it here.
@@ -626,7 +749,7 @@ namespace weak{
           continue;
         }
 
-        json::object o0;
+        json::object o0(a.storage());
         o0["hash"] = hashToString(tx.hash());
         if (tx.type != Tx::Type::data and not bool(tx.to)){ // is a CREATE tx
           /* 🦜 : Here we use the helper from evmc.hpp
@@ -643,11 +766,11 @@ namespace weak{
           o0["deployed_address"] = addressToString(Tx::getContractDeployAddress(tx));
         }
 
-        os.emplace_back(o0);
-        txs.push_back(tx);
+        os.emplace_back(std::move(o0));
+        txs.push_back(std::move(tx));
       }
 
-      return make_tuple(json::serialize(os),txs);
+      return make_tuple(json::serialize(os),std::move(txs));
     }
 
 
@@ -684,8 +807,10 @@ namespace weak{
      * message Txs {repeated Tx txs = 1;} // [x]
      */
     static optional<tuple<string,vector<Tx>>> parse_txs_pbString_for_rpc(string_view s, ITxVerifiable * const txf=nullptr) noexcept {
-      hiPb::Txs pb;
-      if (not pb.ParseFromString(string(s))){
+      // <2024-07-28 Sun> 🦜 : the pb lives as long as the request, see pbArenaOptions()
+      google::protobuf::Arena arena{pbArenaOptions(s.size())};
+      hiPb::Txs & pb = *google::protobuf::Arena::CreateMessage<hiPb::Txs>(&arena);
+      if (not pb.ParseFromArray(s.data(), static_cast<int>(s.size()))){
         BOOST_LOG_TRIVIAL(debug) << format("❌️ Error parsing Txs pbString");
         return {};
       }
@@ -703,9 +828,12 @@ namespace weak{
      * The exception should be caught by `parse_txs_pbString_for_rpc()`).
      */
     static optional<tuple<string,vector<Tx>>> parse_txs_pb_for_rpc(const hiPb::Txs & pb, ITxVerifiable * const txf=nullptr) {
-      hiPb::AddTxsReply atx;    // the output object
+      // 🦜 : two small strings per Tx, so an Arena helps here too
+      google::protobuf::Arena arena{pbArenaOptions(size_t{80} * pb.txs_size())};
+      hiPb::AddTxsReply & atx = *google::protobuf::Arena::CreateMessage<hiPb::AddTxsReply>(&arena); // the output object
 
       vector<Tx> txs;
+      txs.reserve(pb.txs_size());
       try{
         for (const hiPb::Tx & tx : pb.txs()){
           Tx t;
@@ -720,21 +848,20 @@ namespace weak{
             continue;
           }
 
-          txs.push_back(t);
-
-          hiPb::AddTxReply atx0;
-          atx0.set_hash(weak::toByteString<hash256>(t.hash()));
+          hiPb::AddTxReply * atx0 = atx.add_txs(); // 🦜 : fill it in place
+          atx0->set_hash(weak::toByteString<hash256>(t.hash()));
           if (t.type != Tx::Type::data and not bool(t.to)){ // is a CREATE tx
-            atx0.set_deployed_addr(weak::toByteString<address>(Tx::getContractDeployAddress(t)));
+            atx0->set_deployed_addr(weak::toByteString<address>(Tx::getContractDeployAddress(t)));
           }
-          atx.add_txs()->CopyFrom(atx0);
+
+          txs.push_back(std::move(t));
         }
       }catch (std::exception const & e){
         BOOST_LOG_TRIVIAL(debug) << format("❌️ Error parsing Txs pbString:\n%s") % boost::diagnostic_information(e);
         return {};
       }
 
-      return make_tuple(atx.SerializeAsString(),txs);
+      return make_tuple(atx.SerializeAsString(),std::move(txs));
     }
 
   };
@@ -755,6 +882,169 @@ namespace weak{
   ADD_FROM_JSON_TAG_INVOKE(Tx);
 
 
+  /**
+   * @brief The binary Merkle tree over a list of hashes (e.g. the Tx hashes of a Blk).
+   *
+   * <2024-07-25 Thu> 🦜 : A leaf is `keccak(0x00 | h)` and a parent is
+   * `keccak(0x01 | left | right)`. If a level has an odd number of nodes, the
+   * last one goes up as it is. The root of an empty list is the zero hash.
+   *
+   * <2024-07-28 Sun> 🐢 : The prefixes keep a node from passing as a leaf (or
+   * the other way around), so a list can't be swapped for the hashes of one of
+   * its levels. But the shape of the tree still depends on the number of leaves
+   * `n`, and the root alone doesn't say what `n` is, so `n` must be committed
+   * next to the root (Blk::hash() does that) and a proof is only as good as the
+   * `n` it's checked with, see verify().
+   */
+  class MerkleTree{
+  public:
+    static constexpr uint8_t LEAF = 0x00;
+    static constexpr uint8_t NODE = 0x01;
+
+    static hash256 hashOfTwo(const hash256 & l, const hash256 & r) noexcept{
+      uint8_t s[65];            // 🦜 : on the stack, so it's thread-safe
+      s[0] = NODE;
+      std::copy_n(std::cbegin(l.bytes),32,s + 1);
+      std::copy_n(std::cbegin(r.bytes),32,s + 33);
+      return ethash::keccak256(s,65);
+    }
+
+    static hash256 hashOfLeaf(const hash256 & h) noexcept{
+      uint8_t s[33];
+      s[0] = LEAF;
+      std::copy_n(std::cbegin(h.bytes),32,s + 1);
+      return ethash::keccak256(s,33);
+    }
+
+    /**
+     * @brief Replace the `n` hashes in `hs` with their leaves.
+     */
+    static void hashLeaves(hash256 * hs, const size_t n) noexcept{
+      static_assert(sizeof(hash256) == 32);
+      vector<uint8_t> buf(n * 33);
+      vector<const uint8_t*> ps(n);
+      vector<size_t> ss(n, 33);
+      for (size_t i = 0; i < n; i++){
+        buf[33 * i] = LEAF;
+        std::copy_n(std::cbegin(hs[i].bytes), 32, buf.data() + 33 * i + 1);
+        ps[i] = buf.data() + 33 * i;
+      }
+      ethash::keccak256_batch(hs, ps.data(), ss.data(), n);
+    }
+
+    /**
+     * @brief Replace the first `n` nodes of a level with the `(n + 1) / 2`
+     * nodes of the level above.
+     *
+     * 🐢 : The pairs are copied after their prefix into one buffer and hashed
+     * in one ethash::keccak256_batch() (65 bytes each, several on the SIMD lanes).
+     */
+    static void hashLevel(vector<hash256> & hs, const size_t n) noexcept{
+      const size_t m = n / 2;
+      vector<uint8_t> buf(m * 65);
+      vector<const uint8_t*> ps(m);
+      vector<size_t> ss(m, 65);
+      for (size_t i = 0; i < m; i++){
+        uint8_t * b = buf.data() + 65 * i;
+        b[0] = NODE;
+        std::copy_n(std::cbegin(hs[2 * i].bytes), 32, b + 1);
+        std::copy_n(std::cbegin(hs[2 * i + 1].bytes), 32, b + 33);
+        ps[i] = b;
+      }
+      ethash::keccak256_batch(hs.data(), ps.data(), ss.data(), m); // 🦜 : only hs[0, m) is written
+      if (n % 2) hs[m] = hs[n - 1];
+    }
+
+    /**
+     * @brief The root above the nodes `hs` (they're already leaves).
+     */
+    static hash256 rootOfNodes(vector<hash256> hs) noexcept{
+      if (hs.empty()) return hash256{};
+      for (size_t n = hs.size(); n > 1; n = (n + 1) / 2)
+        hashLevel(hs, n);
+      return hs[0];
+    }
+
+    /**
+     * @brief The root of the list `hs`.
+     */
+    static hash256 root(vector<hash256> hs) noexcept{
+      hashLeaves(hs.data(), hs.size());
+      return rootOfNodes(std::move(hs));
+    }
+
+    /**
+     * @brief The root of `n` hashes, computed by up to `k` threads. The
+     * hashes `[from, to)` are written by `leaves(from, to, o)` to `o`.
+     *
+     * 🐢 : The list is cut into chunks whose size is a power of 2, so each
+     * chunk is a whole subtree. Each thread computes the leaves and the root
+     * of a chunk, and the roots of the chunks make the top of the tree.
+     */
+    static hash256 rootInParallel(size_t n, std::function<void(size_t, size_t, hash256*)> leaves,
+                                  size_t k = std::max(std::thread::hardware_concurrency(), 1u)) noexcept{
+      size_t c = 1;
+      while (c * k < n) c *= 2;
+      auto chunk = [&](size_t from){
+        vector<hash256> hs(std::min(from + c, n) - from);
+        leaves(from, from + hs.size(), hs.data());
+        return root(std::move(hs));
+      };
+      if (k <= 1 or c >= n) return chunk(0);
+
+      vector<std::future<hash256>> fs;
+      for (size_t from = c; from < n; from += c)
+        fs.push_back(std::async(std::launch::async, chunk, from));
+      vector<hash256> tops{chunk(0)};
+      for (auto & f : fs) tops.push_back(f.get());
+      return rootOfNodes(std::move(tops));
+    }
+
+    /**
+     * @brief The proof of the `i`-th hash: its siblings from the bottom up.
+     */
+    static vector<hash256> proof(vector<hash256> hs, size_t i) noexcept{
+      vector<hash256> o;
+      hashLeaves(hs.data(), hs.size());
+      for (size_t n = hs.size(); n > 1; n = (n + 1) / 2, i /= 2){
+        if (not (i == n - 1 and n % 2)) // 🦜 : the last odd one has no sibling
+          o.push_back(hs[i ^ 1]);
+        hashLevel(hs, n);
+      }
+      return o;
+    }
+
+    /**
+     * @brief The root that the proof `p` gives for `h` as the `i`-th of `n`
+     * hashes, {} if `p` doesn't fit the shape of `n` hashes.
+     */
+    static optional<hash256> rootOfProof(const hash256 & h, size_t i, size_t n, const vector<hash256> & p) noexcept{
+      if (i >= n) return {};
+      hash256 x = hashOfLeaf(h);
+      size_t k = 0;
+      for (; n > 1; n = (n + 1) / 2, i /= 2){
+        if (i == n - 1 and n % 2) continue;
+        if (k >= p.size()) return {};
+        x = (i % 2) ? hashOfTwo(p[k], x) : hashOfTwo(x, p[k]);
+        k++;
+      }
+      if (k != p.size()) return {};
+      return x;
+    }
+
+    /**
+     * @brief Check that `h` is the `i`-th of `n` hashes under `r`.
+     *
+     * 🐢 : This only holds if `n` is the real count. If `n` comes from whoever
+     * made the proof, check it with Blk::verifyTx() instead, which has `n`
+     * committed in the Blk hash.
+     */
+    static bool verify(const hash256 & h, size_t i, size_t n, const vector<hash256> & p, const hash256 & r) noexcept{
+      optional<hash256> x = rootOfProof(h, i, n, p);
+      return x and std::equal(std::cbegin(x.value().bytes), std::cend(x.value().bytes), std::cbegin(r.bytes));
+    }
+  };
+
   class BlkHeader: virtual public IJsonizable {
   public:
     uint64_t number;
@@ -793,17 +1083,17 @@ namespace weak{
       // --------------------------------------------------
       this->number = pb.header().number();
 
-      string s = pb.header().parenthash();   // should be hash256 = 32 bytes
-
+      // should be hash256 = 32 bytes
       // BOOST_ASSERT(s.size() == 32); // throws my_assertion_error
-      this->parentHash = weak::fromByteString<hash256>(s); // may throw
+      this->parentHash = weak::fromByteString<hash256>(pb.header().parenthash()); // may throw
 
       // 2. form the txs part
       // --------------------------------------------------
+      this->txs.reserve(this->txs.size() + pb.txs_size());
       for (const hiPb::Tx & tx : pb.txs()){
         Tx t;
         t.fromPb(tx);          // may throw
-        this->txs.push_back(t);
+        this->txs.push_back(std::move(t));
       }
     }
 
@@ -835,30 +1125,111 @@ namespace weak{
      */
     Blk(const uint64_t n,const hash256 p,vector<Tx> t):
       BlkHeader(n,p),
-      txs(t)
+      txs(std::move(t))
     {
       BOOST_LOG_TRIVIAL(info) << format("Making block-%d,\n\tparentHash=%s,\n\ttx size=%d")
         % number % hashToString(parentHash) % txs.size();
     }
 
+    /*
+      <2024-07-25 Thu> 🦜 : The hash is `keccak(parentHash | txRoot | n_txs)`,
+      where txRoot is the root of the MerkleTree over the Tx hashes and n_txs
+      is the number of Txs (8 bytes, big-endian). (It used to be a chain of
+      hashes, Tx by Tx.) So a Tx can be proved to be in a Blk with a
+      MerkleTree::proof(), see verifyTx() and `/get_tx_proof` of Rpc.
+
+      <2024-07-28 Sun> 🐢 : n_txs is in there because the root alone doesn't
+      fix the shape of the tree.
+     */
     hash256 hash() const noexcept override {
-      // Calculate hash based on the hashes of txs
-      // TODO: 🦜 For now, we use serial hash, later should be changed to Merkle tree.
-      hash256 h = this->parentHash;
-      static uint8_t s[64];     // a buffer for hashing
-      for (const Tx& tx : this->txs){
-        // BOOST_LOG_TRIVIAL(debug) << format("Hashing for tx-%d") % tx.nonce;
-        std::copy_n(std::cbegin(tx.hash().bytes),32,s);
-        std::copy_n(std::cbegin(h.bytes),32,s + 32);
-        // s[:32] = tx.hash; s[32:] = h
-        h = ethash::keccak256(reinterpret_cast<uint8_t*>(s),64);
-        // BOOST_LOG_TRIVIAL(debug) << format("Now hash is %s") % hashToString(h);
-      }
-      return h;
+      return hashOf(this->parentHash, this->txRoot(), this->txs.size());
+    }
+
+    static hash256 hashOf(const hash256 & p, const hash256 & r, const uint64_t n) noexcept{
+      uint8_t s[72];
+      std::copy_n(std::cbegin(p.bytes),32,s);
+      std::copy_n(std::cbegin(r.bytes),32,s + 32);
+      for (int i = 0; i < 8; i++)
+        s[64 + i] = static_cast<uint8_t>(n >> (8 * (7 - i)));
+      return ethash::keccak256(s,72);
+    }
+
+    /**
+     * @brief Check that `h` is the `i`-th of the `n` Txs of the Blk whose hash
+     * is `b` and whose parent is `p`.
+     *
+     * 🦜 : This is what a light client does with what `/get_tx_proof` gives.
+     * Only `b` needs to be trusted: `n` and `p` are checked by it.
+     */
+    static bool verifyTx(const hash256 & h, size_t i, uint64_t n, const vector<hash256> & proof,
+                         const hash256 & p, const hash256 & b) noexcept{
+      optional<hash256> r = MerkleTree::rootOfProof(h, i, n, proof);
+      if (not r) return false;
+      hash256 x = hashOf(p, r.value(), n);
+      return std::equal(std::cbegin(x.bytes), std::cend(x.bytes), std::cbegin(b.bytes));
+    }
+
+    /// The root of the MerkleTree over the Tx hashes.
+    hash256 txRoot() const noexcept {
+      // 🐢 : A Tx hash is cheap, so only the big Blks are worth the threads.
+      if (this->txs.size() < PARALLEL_HASH_MIN)
+        return MerkleTree::root(this->txHashes());
+      return MerkleTree::rootInParallel(this->txs.size(),
+                                        [this](size_t from, size_t to, hash256 * o){
+                                          Tx::hashes(this->txs.data() + from, to - from, o);
+                                        });
     }
 
+    /// The hashes of all the Txs, in order.
+    vector<hash256> txHashes() const noexcept {
+      vector<hash256> hs(this->txs.size());
+      Tx::hashes(this->txs.data(), this->txs.size(), hs.data());
+      return hs;
+    }
+
+    static constexpr size_t PARALLEL_HASH_MIN = 4096;
+
     vector<Tx> txs;
-    ADD_TO_FROM_STR_WITH_JSON_OR_PB
+
+    // <2024-07-27 Sat> 🦜 : The binary codec, see binCodec.hpp
+
+    /// A view of this Blk, valid as long as the Blk is alive and unchanged.
+    bin::BlkView binView() const{
+      bin::BlkView v{this->number, this->parentHash, {}};
+      v.txs.reserve(this->txs.size());
+      for (const Tx & t : this->txs) v.txs.push_back(t.binView());
+      return v;
+    }
+
+    void fromBinView(const bin::BlkView & v){
+      this->number = v.number;
+      this->parentHash = v.parentHash;
+      this->txs.resize(v.txs.size());
+      for (size_t i = 0; i < v.txs.size(); i++)
+        this->txs[i].fromBinView(v.txs[i]);
+    }
+
+    string toBinString() const{
+      bin::BlkView v = this->binView();
+      size_t n = bin::HEADER_SIZE + 8 + 32 + 4;
+      for (const bin::TxView & t : v.txs) n += t.size();
+      bin::Writer w{n};
+      w.header(bin::Kind::blk);
+      v.write(w);
+      return std::move(w.s);
+    }
+
+    bool fromBinString(string_view s) noexcept{
+      try{
+        this->fromBinView(bin::parse<bin::BlkView>(s, bin::Kind::blk));
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(error) << format("❌️ error parsing bin Blk: %s") % e.what();
+        return false;
+      }
+      return true;
+    }
+
+    ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB
 
     json::value toJson() const noexcept override ;
     bool fromJson(const json::value &v) noexcept override ;
@@ -230,6 +230,7 @@ namespace weak{
         }
 
         Acn a = ao.value();
+        w->codeOf(a);           // 🦜 : load the code, if it's behind a code_ref
         auto [ao1, res] = invokePyContract(a, invoke, t);
         if (not ao1) {
           return make_tuple(vector<StateChange>{}, res);
@@ -344,7 +345,7 @@ namespace weak{
         }
 
         // 5. invoke the method
-        json::object r = invokePyMethod(invoke, weak::toStringView(a.code), abi, t, storage);
+        json::object r = invokePyMethod(invoke, weak::toStringView(a.codeView()), abi, t, storage);
         if (r.contains("quit")) {
           BOOST_LOG_TRIVIAL(info) <<  msg0 << r["quit"].as_string() << msg;
           return {};
@@ -111,6 +111,19 @@ namespace weak {
                                         S_CYAN "tx-%d" S_NOR) % t.nonce;
     };
 
+    /**
+     * @brief The code of the Acn `a` (it must be in `this->accounts`).
+     *
+     * <2024-07-28 Sun> 🦜 : The Acns from the WorldStorage may come without
+     * their code (only the `code_ref`), it's loaded here, the first time it's
+     * needed, and shared (not copied) from then on.
+     */
+    bytes_view codeOf(const address & a) const noexcept{
+      const Acn & acn = this->accounts.at(a);
+      if (not this->readOnlyWorldState) return acn.codeView();
+      return this->readOnlyWorldState->codeOf(acn);
+    }
+
     // <! The evmc_message executor. @see WeakEvmHost()
     IEvmMsgExecutable const * const msgExe;
     string name;                // <! The name of the host, mostly cosmetic
@@ -261,7 +274,7 @@ namespace weak {
         return 0;
 
       // const auto& code = accounts[a].code;
-      const auto& code = accounts.at(a).code;
+      bytes_view code = this->codeOf(a);
 
       if (code_offset >= code.size()) return 0;
 
@@ -369,7 +382,7 @@ namespace weak {
       if (!accounts.contains(a)) return 0;
       // C++ is not that flexible to accept the following:
       // return accounts[a].code.size();
-      return accounts.at(a).code.size();
+      return this->codeOf(a).size();
     }
     /// Get the account's code hash (EVMC host method).
     bytes32 get_code_hash(const address& a) const noexcept override{
@@ -509,7 +522,7 @@ namespace weak {
       if (not h.accounts.contains(a))
         h.tryAddAcnFromWorldState(a,true /*must success*/);
 
-      bytes_view code = h.accounts.at(a).code;
+      bytes_view code = h.codeOf(a);
       //         = h.accounts[a].code
       BOOST_LOG_TRIVIAL(debug) << format("Got: \n\t" S_CYAN
                                          "contract code size: %d \n\t"
@@ -21,6 +21,10 @@ namespace weak{
    *      3. append them in two vectors `txReceipts` and `stateChanges`
    *      4. use these to make the executed blk and return.
    *
+   *   If there's a `prefetcher`, it's given the Txs first, so that the Acns
+   *   they touch are read in one batch. (It should also be the
+   *   `readOnlyWorld`.)
+   *
    * For commitBlk():
    *   for each tx in ExecBlk:
    *      3. It makes a `TxOnBlkInfo` for this tx, and store it in chaindb with key = "/tx/<tx.hash>"
@@ -30,6 +34,15 @@ namespace weak{
    *   Also, it saves the block number in chaindb with key =
    *   "/other/blk_number".
    *
+   *   Each Tx and its receipt are also saved on their own at
+   *   "/txdata/<hash>" and "/receipt/<hash>" for the Rpc.
+   *
+   *   If there's a `stateRoot`, the journals are applied to it too, and the
+   *   new root is saved in the ExecBlk.
+   *
+   *   Finally, it tells the `committedListeners` (e.g. the BlkFeed that the
+   *   subscribers wait on) that the Blk is on the chain.
+   *
    */
   class BlkExecutor: public virtual IBlkExecutable{
   public:
@@ -38,6 +51,9 @@ namespace weak{
     ITxExecutable* const txExecutor;
     IAcnGettable* const readOnlyWorld;
     ITxVerifiable * const txVerifier;
+    vector<IBlkCommittedListener*> committedListeners; // <! notified once per committed Blk
+    IStateRootUpdatable * stateRoot = nullptr;          // <! optional, updated once per committed Blk
+    IAcnPrefetchable * prefetcher = nullptr;            // <! optional, told the Txs before they're executed
 
     BlkExecutor(IWorldChainStateSettable* const w,
                 ITxExecutable* const e,
@@ -56,6 +72,10 @@ namespace weak{
       if (this->txVerifier)
         this->txVerifier->filterTxs(b.txs);
 
+      // <2024-07-27 Sat> 🦜 : Read the Acns in one batch (if not already), see acnPrefetcher.hpp
+      if (this->prefetcher)
+        this->prefetcher->prefetchAcnsOf(b.txs);
+
       // The results
       vector<vector<StateChange>> J;
       vector<TxReceipt> R;
@@ -93,27 +113,63 @@ namespace weak{
 
         // Save the TxOnBlkInfo
         // k = (format("/tx/%s") % hashToString(tx.hash)).str();
-        k = "/tx/" + hashToString(tx.hash());
+        string h = hashToString(tx.hash());
+        k = "/tx/" + h;
         ok = world->setInChainDB(k, bi.toString());
+        if (not ok){
+          BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Error setting chaindb k=%s" S_NOR) % k;
+          return false;
+        }
 
-
-        // Apply the journal
-        ok = world->applyJournalStateDB(b.stateChanges[i]);
-        if(not ok){
-          BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Error applying journal of tx-%d at location %d" S_NOR) %
-            tx.nonce % i;
+        /*
+          <2024-07-05 Fri> 🦜 : Also save the Tx and its receipt on their own,
+          so that `/get_tx` and `/get_receipt` are just a point-read instead
+          of loading (and parsing) the whole ExecBlk.
+
+          🐢 : Note that the keys must not start with "/tx/", which is scanned
+          on start-up to collect the hashes of the Txs on chain.
+        */
+        k = "/txdata/" + h;
+        ok = world->setInChainDB(k, tx.toString());
+        if (ok and i < b.txReceipts.size()){
+          k = "/receipt/" + h;
+          ok = world->setInChainDB(k, b.txReceipts[i].toString());
+        }
+        if (not ok){
+          BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Error setting chaindb k=%s" S_NOR) % k;
           return false;
         }
       }
 
+      /*
+        <2024-07-24 Wed> 🦜 : Update the state root and put it in the Blk. If
+        the Blk already has one (e.g. made by another node), it should be the
+        same as ours.
+       */
+      const ExecBlk * eb = &b;
+      optional<ExecBlk> b1;
+      if (this->stateRoot){
+        hash256 r = this->stateRoot->updateStateRoot(b.stateChanges);
+        if (b.stateRoot and b.stateRoot.value() != r)
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ State root mismatch at Blk-%d: the Blk says %s, we have %s" S_NOR)
+            % b.number % hashToString(b.stateRoot.value()) % hashToString(r);
+        b1 = b;
+        b1->stateRoot = r;
+        eb = &(b1.value());
+      }
+
       // save the (executed) blk
       /*
         🦜 : So, as long as we have all the "ExecBlk", everything can replay * 3
+
+        <2024-07-28 Sun> 🦜 : The Blk goes on the chain before its state is
+        written, so the stateDB is never ahead of the chain (see
+        stateCommit.hpp and WorldStorage::ChainSyncer).
        */
       // k = (format("/blk/%d") % b.number).str();
       string bn = lexical_cast<string>(b.number);
       k = "/blk/" + bn;
-      ok = world->setInChainDB(k,b.toString());
+      ok = world->setInChainDB(k,eb->toString());
       if (not ok){
         BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Error setting chaindb k=%s" S_NOR) % k;
         return false;
@@ -125,6 +181,21 @@ namespace weak{
         return false;
       }
 
+      /*
+        Apply the journals
+
+        <2024-07-26 Fri> 🦜 : All the Txs of the Blk at once, so that the
+        stateDB never has half a Blk (see stateCommit.hpp).
+       */
+      ok = world->applyJournalsStateDB(b.stateChanges);
+      if(not ok){
+        BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Error applying the journals of Blk-%d" S_NOR) % b.number;
+        return false;
+      }
+
+      for (IBlkCommittedListener * l : this->committedListeners)
+        l->onBlkCommitted(*eb);
+
       return true;
     }
     // ExecBlk executeBlk(const Blk & )
@@ -22,7 +22,7 @@ namespace weak{
     // serialization should be purely for debugging purposes, so we can't just
     // store a.v here, instead, we should store the hex
 #if defined(WITH_PROTOBUF)
-    v.as_object()["v"] = evmc::hex(weak::bytesFromString(a.v));
+    v.as_object()["v"] = hex::encode(a.v);
     #else
     v.as_object()["v"] = a.v;
 #endif
@@ -38,7 +38,7 @@ namespace weak{
     // <2024-03-26 Tue> 🦜 : If we are using protobuf, we should use hex for v,
     // because Acn is serialized to pb.
 #if defined(WITH_PROTOBUF)
-    a.v = weak::toString(evmc::from_hex(value_to<string>(v.at("v"))).value());
+    a.v = weak::toString(hex::decode(value_to<string>(v.at("v"))).value());
 #else
     a.v = value_to<string>(v.at("v"));
 #endif
@@ -100,7 +100,7 @@ namespace weak{
             this->result = weak::bytesFromString(json::serialize(o));
           }else{
             string s = value_to<string>(v.at("result"));
-            this->result = evmc::from_hex(s).value();
+            this->result = hex::decode(s).value();
           }
         }
       }catch(std::exception &e){
@@ -153,7 +153,7 @@ namespace weak{
       BOOST_ASSERT(o.contains("log"));
       result = o["result"];
     }else{                      // 🦜 : Otherwise, we convert it to hex
-      result = evmc::hex(c.result);
+      result = hex::encode(c.result);
     }
 
     jv = {
@@ -276,6 +276,20 @@ namespace weak{
   public:
     vector<vector<StateChange>> stateChanges;
     vector<TxReceipt> txReceipts;
+    /*
+      <2024-07-24 Wed> 🦜 : The root of the state (see stateRoot.hpp) right
+      after this Blk, set by the BlkExecutor when it commits. It's not part of
+      the Blk hash, because the Blk is agreed on before it's executed.
+     */
+    optional<hash256> stateRoot;
+    /*
+      <2024-07-28 Sun> 🐢 : The Acn deltas of the stateChanges (see
+      acnDelta()): `[i][j]` is the one of stateChanges[i][j], {} if it goes
+      whole. They're worked out by toPb0() and toBinString() on each call
+      (see acnDeltasOf()), not kept: the stateChanges are public and can be
+      changed in place, and kept ones would go stale.
+     */
+    using AcnDeltas = vector<vector<optional<string>>>;
     ExecBlk() = default;
     // TODO: 🦜 add move()  magic here
     ExecBlk(Blk b,
@@ -296,6 +310,49 @@ namespace weak{
                                 );
     }
 
+    /**
+     * @brief Work out the Acn deltas of `J`.
+     *
+     * 🦜 : Only the Acns of the keys that change again are parsed, and each of
+     * them once: it's the `c` of one change and the `p` of the next one.
+     */
+    static AcnDeltas acnDeltasOf(const vector<vector<StateChange>> & J) noexcept{
+      struct Last{
+        const StateChange * sc;
+        optional<Acn> a;        // <! parsed `sc->v`, if it has been
+        bool parsed = false;
+      };
+      auto parse = [](const string & v){
+        Acn a;
+        return a.fromString(v) ? optional<Acn>(std::move(a)) : optional<Acn>();
+      };
+
+      AcnDeltas o(J.size());
+      unordered_map<string_view, Last> last;
+      for (size_t i = 0; i < J.size(); i++){
+        o[i].resize(J[i].size());
+        for (size_t j = 0; j < J[i].size(); j++){
+          const StateChange & sc = J[i][j];
+          auto it = last.find(sc.k);
+          if (it == last.end()){
+            last.emplace(sc.k, Last{&sc});
+            continue;
+          }
+          Last & l = it->second;
+          if (sc.del or l.sc->del){
+            l = Last{&sc};
+            continue;
+          }
+          if (not l.parsed) l.a = parse(l.sc->v);
+          optional<Acn> b = parse(sc.v);
+          if (l.a and b)
+            o[i][j] = acnDelta(l.a.value(), b.value(), sc.v.size());
+          l = Last{&sc, std::move(b), true};
+        }
+      }
+      return o;
+    }
+
     json::value toJson() const noexcept override {return json::value_from(*this);};
     bool fromJson(const json::value &v) noexcept override {
 
@@ -311,6 +368,10 @@ namespace weak{
         BOOST_LOG_TRIVIAL(info) << format("Parsing txReceipts");
         this->txReceipts = value_to<vector<TxReceipt>>(v.at("txReceipts"));
         // boost::json knows about vector
+        if (v.as_object().contains("stateRoot")){
+          this->stateRoot = hex::decode<hash256>(value_to<string>(v.at("stateRoot")));
+          if (not this->stateRoot) BOOST_THROW_EXCEPTION(std::runtime_error("Invalid `stateRoot`"));
+        }
 
       }catch (std::exception &e){
         BOOST_LOG_TRIVIAL(error) << format("❌️ error parsing json: %s") % e.what();
@@ -321,7 +382,12 @@ namespace weak{
       return true;
     };
 
-    hiPb::ExecBlk toPb0() const {
+    /**
+     * @param with_deltas Whether an Acn changed again in the Blk goes as a
+     * delta. That's for us (the chainDB, the consensus); the clients of the
+     * Rpc get whole Acns, see toRpcPbString().
+     */
+    hiPb::ExecBlk toPb0(bool with_deltas = true) const {
       hiPb::ExecBlk pb;
       pb.mutable_blk()->CopyFrom(Blk::toPb());
 /*
@@ -331,38 +397,107 @@ namespace weak{
  */
 
       // add stateChanges
-      for (auto & j : this->stateChanges){
+      // <2024-07-26 Fri> 🦜 : an Acn changed again in the Blk goes as a delta
+      const AcnDeltas ds = with_deltas ? acnDeltasOf(this->stateChanges) : AcnDeltas{};
+      for (size_t i = 0; i < this->stateChanges.size(); i++){
         hiPb::StateChanges * psc = pb.add_statechanges();
-        for (auto & sc : j){
+        for (size_t j = 0; j < this->stateChanges[i].size(); j++){
+          const StateChange & sc = this->stateChanges[i][j];
           hiPb::StateChange * psc0 = psc->add_changes();
           psc0->set_del(sc.del);
           psc0->set_k(sc.k);
-          psc0->set_v(sc.v);
+          if (with_deltas and ds[i][j]){
+            psc0->set_v(ds[i][j].value());
+            psc0->set_delta(true);
+          }else
+            psc0->set_v(sc.v);
         }
       }
       // add txReceipts
       for (auto & r : this->txReceipts){
         pb.add_txreceipts()->CopyFrom(r.toPb());
       }
+      if (this->stateRoot)
+        pb.set_stateroot(weak::toByteString<hash256>(this->stateRoot.value()));
       return pb;
     }
 
     void fromPb0(const hiPb::ExecBlk & pb) {
       Blk::fromPb(pb.blk());
       // stateChanges
+      unordered_map<string, string> last; // <! the latest (whole) value of each key
+      this->stateChanges.reserve(pb.statechanges_size());
       for (auto & scs : pb.statechanges()){
         vector<StateChange> scv;
+        scv.reserve(scs.changes_size());
         for (auto & sc : scs.changes()){
           scv.push_back(StateChange{sc.del(),sc.k(),sc.v()});
+          if (sc.delta()){
+            auto it = last.find(sc.k());
+            optional<string> v;
+            if (it != last.end()) v = applyAcnDelta(it->second, sc.v());
+            if (not v)
+              BOOST_THROW_EXCEPTION(std::runtime_error("Invalid Acn delta for " + sc.k()));
+            scv.back().v = std::move(v.value());
+          }
+          last.insert_or_assign(sc.k(), scv.back().v);
         }
-        this->stateChanges.push_back(scv);
+        this->stateChanges.push_back(std::move(scv));
       }
       // txReceipts
+      this->txReceipts.reserve(pb.txreceipts_size());
       for (auto & r : pb.txreceipts()){
         TxReceipt tr;
         tr.fromPb(r);
-        this->txReceipts.push_back(tr);
+        this->txReceipts.push_back(std::move(tr));
       }
+      if (not pb.stateroot().empty())
+        this->stateRoot = weak::fromByteString<hash256>(pb.stateroot()); // may throw
+    }
+
+    /**
+     * @brief The Acn `c` as a delta on `p`: only the nonce and the storage
+     * slots that are new or changed.
+     *
+     * <2024-07-26 Fri> 🦜 : A hot contract called by many Txs of a Blk has a
+     * journal entry (the whole Acn) per Tx, but usually only a few slots
+     * change each time. So in the pb form of the ExecBlk (what's saved and
+     * sent), all but the first are deltas. In RAM, they're all whole Acns.
+     *
+     * @return {} if `c` is not just `p` with a new nonce and some slots set
+     * (e.g. a slot removed, the code changed), or the delta is not smaller.
+     */
+    static optional<string> acnDelta(const string & p, const string & c) noexcept{
+      Acn a, b;
+      if (not a.fromString(p) or not b.fromString(c)) return {};
+      return acnDelta(a, b, c.size());
+    }
+
+    /// acnDelta() of the parsed `a` and `b`, `n` is the size of `b` serialized.
+    static optional<string> acnDelta(const Acn & a, const Acn & b, size_t n) noexcept{
+      if ((not Acn::sameCode(a, b)) or a.disk_storage != b.disk_storage)
+        return {};
+
+      Acn d{b.nonce, bytes{}};
+      for (const auto & [k, v] : a.storage)
+        if (not b.storage.contains(k)) return {};
+      for (const auto & [k, v] : b.storage)
+        if (auto it = a.storage.find(k); it == a.storage.end() or it->second != v)
+          d.storage[k] = v;
+
+      string s = d.toString();
+      if (s.size() >= n) return {};
+      return s;
+    }
+
+    /// The reverse of acnDelta().
+    static optional<string> applyAcnDelta(const string & p, const string & d) noexcept{
+      Acn a, x;
+      if (not a.fromString(p) or not x.fromString(d)) return {};
+      a.nonce = x.nonce;
+      for (const auto & [k, v] : x.storage)
+        a.storage[k] = v;
+      return a.toString();
     }
 
     /*
@@ -371,8 +506,17 @@ namespace weak{
       ADD_TO_FROM_STR_WITH_JSON_OR_PB works... ⚠️
      */
     bool fromPbString(string_view s) noexcept {
+      // <2024-07-28 Sun> 🦜 : a big one on an Arena, see pbArenaOptions()
+      if (s.size() >= PB_ARENA_MIN){
+        google::protobuf::Arena arena{pbArenaOptions(s.size())};
+        return this->fromPbString(s, *google::protobuf::Arena::CreateMessage<hiPb::ExecBlk>(&arena));
+      }
       hiPb::ExecBlk pb;
-      if (!pb.ParseFromString(string(s))){
+      return this->fromPbString(s, pb);
+    }
+
+    bool fromPbString(string_view s, hiPb::ExecBlk & pb) noexcept {
+      if (!pb.ParseFromArray(s.data(), static_cast<int>(s.size()))){
         BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ error parsing pb" S_NOR);
         return false;
       }
@@ -390,10 +534,93 @@ namespace weak{
       return this->toPb0().SerializeAsString();
     }
 
+    /**
+     * @brief The pb for the clients of the Rpc (`/get_blk_pb` and co.).
+     *
+     * <2024-07-28 Sun> 🦜 : Every StateChange has the whole value there (the
+     * `delta` flag is never set), like it was before the deltas. The deltas
+     * are only in what we store and send to each other.
+     */
+    string toRpcPbString() const {
+      return this->toPb0(false /*with_deltas*/).SerializeAsString();
+    }
+
     // <2024-02-01 Thu>
     // --------------------------------------------------
 
-    ADD_TO_FROM_STR_WITH_JSON_OR_PB
+    /**
+     * @brief The binary form (see binCodec.hpp), with the same Acn deltas as
+     * toPb0().
+     */
+    string toBinString() const{
+      bin::ExecBlkView v;
+      static_cast<bin::BlkView&>(v) = Blk::binView();
+      size_t n = bin::HEADER_SIZE + 8 + 32 + 4 + 4 + 4 + 1 + 32;
+      for (const bin::TxView & t : v.txs) n += t.size();
+
+      const AcnDeltas ds = acnDeltasOf(this->stateChanges); // <! 🦜 : viewed by `v`, so kept till the end
+      v.stateChanges.reserve(this->stateChanges.size());
+      for (size_t i = 0; i < this->stateChanges.size(); i++){
+        vector<bin::StateChangeView> & cs = v.stateChanges.emplace_back();
+        n += 4;
+        for (size_t j = 0; j < this->stateChanges[i].size(); j++){
+          const StateChange & sc = this->stateChanges[i][j];
+          const optional<string> & d = ds[i][j];
+          bin::StateChangeView c{sc.del ? bin::Change::del : bin::Change::put, sc.k, sc.v};
+          if (d) c = {bin::Change::delta, sc.k, d.value()};
+          n += 1 + 4 + c.k.size() + 4 + c.v.size();
+          cs.push_back(c);
+        }
+      }
+      for (const TxReceipt & r : this->txReceipts){
+        v.txReceipts.push_back({r.ok, static_cast<uint8_t>(r.type), bin::viewOf(r.result)});
+        n += 1 + 1 + 4 + r.result.size();
+      }
+      v.stateRoot = this->stateRoot;
+
+      bin::Writer w{n};
+      w.header(bin::Kind::execBlk);
+      v.write(w);
+      return std::move(w.s);
+    }
+
+    bool fromBinString(string_view s) noexcept{
+      try{
+        bin::ExecBlkView v = bin::parse<bin::ExecBlkView>(s, bin::Kind::execBlk);
+        Blk::fromBinView(v);
+        unordered_map<string_view, string> last; // <! the latest (whole) value of each key
+        this->stateChanges.resize(v.stateChanges.size());
+        for (size_t i = 0; i < v.stateChanges.size(); i++)
+          for (const bin::StateChangeView & c : v.stateChanges[i]){
+            StateChange sc{c.flag == bin::Change::del, string(c.k), string(c.v)};
+            if (c.flag == bin::Change::delta){
+              auto it = last.find(c.k);
+              optional<string> a;
+              if (it != last.end()) a = applyAcnDelta(it->second, sc.v);
+              if (not a)
+                BOOST_THROW_EXCEPTION(std::runtime_error("Invalid Acn delta for " + sc.k));
+              sc.v = std::move(a.value());
+            }
+            last.insert_or_assign(c.k, sc.v);
+            this->stateChanges[i].push_back(std::move(sc));
+          }
+        this->txReceipts.resize(v.txReceipts.size());
+        for (size_t i = 0; i < v.txReceipts.size(); i++){
+          const bin::TxReceiptView & r = v.txReceipts[i];
+          if (r.type > static_cast<uint8_t>(Tx::Type::python)) throw bin::Error("bad TxReceipt type");
+          this->txReceipts[i].ok = r.ok;
+          this->txReceipts[i].type = static_cast<Tx::Type>(r.type);
+          this->txReceipts[i].result.assign(r.result.begin(), r.result.end());
+        }
+        this->stateRoot = v.stateRoot;
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(error) << format("❌️ error parsing bin ExecBlk: %s") % e.what();
+        return false;
+      }
+      return true;
+    }
+
+    ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB
   };
 
   // json functions for ExecBlk
@@ -408,6 +635,8 @@ namespace weak{
     jv.as_object().emplace("stateChanges",json::value_from(c.stateChanges));
     BOOST_LOG_TRIVIAL(debug) << format("Adding txReceipts");
     jv.as_object().emplace("txReceipts",json::value_from(c.txReceipts));
+    if (c.stateRoot)
+      jv.as_object().emplace("stateRoot",hashToString(c.stateRoot.value()));
   };
 
   ADD_FROM_JSON_TAG_INVOKE(ExecBlk);
@@ -425,4 +654,30 @@ namespace weak{
     virtual bool commitBlk(const ExecBlk & b) noexcept = 0;
   };
 
+  /**
+   * @brief The interface of something that wants to know when a Blk is
+   * committed.
+   *
+   * 🦜 : The committer calls onBlkCommitted() once per Blk, after it's on the
+   * chain. The implementer should be quick, because the commit path is
+   * waiting.
+   */
+  class IBlkCommittedListener {
+  public:
+    virtual void onBlkCommitted(const ExecBlk & b) noexcept = 0;
+  };
+
+  /**
+   * @brief The interface of something that keeps a commitment (root hash) of
+   * the world state, see stateRoot.hpp.
+   *
+   * 🦜 : The committer calls updateStateRoot() once per Blk, after the
+   * journals are applied and before the Blk is saved, so that the root goes
+   * in the ExecBlk.
+   */
+  class IStateRootUpdatable {
+  public:
+    virtual hash256 updateStateRoot(const vector<vector<StateChange>> & J) noexcept = 0;
+  };
+
 }
@@ -13,11 +13,19 @@
 
 #include "net/pure-httpNetAsstn.hpp"
 #include "net/pure-udpNetAsstn.hpp"
+#include "net/pure-compressingMsgMgr.hpp"
 
 #include "div2Executor.hpp"
 #include "txVerifier.hpp"       // <2024-04-07 Sun> 🦜 : We need this to respond to the `--tx-mode-serious` option.
 
 #include "execManager.hpp"
+#include "blkFeed.hpp"
+#include "blkCache.hpp"
+#include "callExecutor.hpp"
+#include "stateVersions.hpp"
+#include "stateRoot.hpp"
+#include "stateCommit.hpp"
+#include "acnPrefetcher.hpp"
 #include "cnsss/mempool.hpp"
 #include "cnsss/exeForCnsss.hpp"
 
@@ -327,6 +335,7 @@ namespace weak{
 
       {
         struct {
+          unique_ptr<::pure::AdmissionController> admission; // 🦜 : first in, last out. It should outlive the servers.
           unique_ptr<::pure::WeakAsyncTcpHttpServer> s_tcp;
 #if defined(__unix__)
           unique_ptr<::pure::WeakAsyncUnixHttpServer> s_unix;
@@ -338,13 +347,20 @@ namespace weak{
         srv.stk = make_unique<::pure::MultiStackHttpServer>();
 
         // 🦜 : add tcp
-        srv.s_tcp = make_unique<::pure::WeakAsyncTcpHttpServer>(boost::numeric_cast<uint16_t>(o.port));
+        int n_acceptors = o.http_acceptors > 0 ? o.http_acceptors :
+          static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        srv.s_tcp = make_unique<::pure::WeakAsyncTcpHttpServer>(boost::numeric_cast<uint16_t>(o.port),
+                                                                std::max(o.http_io_threads, n_acceptors),
+                                                                n_acceptors,
+                                                                o.http_handler_threads);
         srv.stk->srvs.push_back(dynamic_cast<::pure::IHttpServable *>(srv.s_tcp.get()));
         // ::pure::WeakAsyncHttpServer srv{boost::numeric_cast<uint16_t>(o.port)}; // throw bad_cast
 
 #if defined(__unix__)           // 🦜 : Add unix socket if we are on unix
         if (o.unix_socket != ""){
-          srv.s_unix = make_unique<::pure::WeakAsyncUnixHttpServer>(o.unix_socket);
+          srv.s_unix = make_unique<::pure::WeakAsyncUnixHttpServer>(o.unix_socket,
+                                                                    o.http_io_threads,
+                                                                    o.http_handler_threads);
           srv.stk->srvs.push_back(dynamic_cast<::pure::IHttpServable *>(srv.s_unix.get()));
         }
 #endif
@@ -352,6 +368,17 @@ namespace weak{
         // make the pointer
         srv.iHttpServable = dynamic_cast<::pure::IHttpServable*>(srv.stk.get());
 
+        // 🦜 : put the ingestion path behind the admission control
+        srv.admission = make_unique<::pure::AdmissionController>(boost::numeric_cast<size_t>(o.rpc_max_in_flight),
+                                                                 o.rpc_rate_per_client,
+                                                                 o.rpc_burst_per_client);
+        srv.iHttpServable->guardPost("/add_txs",srv.admission.get());
+        srv.iHttpServable->guardPost("/add_txs_pb",srv.admission.get());
+        srv.iHttpServable->listenToGet("/get_admission_status",
+                                       [&srv](string, uint16_t, optional<unordered_map<string,string>>){
+                                         return make_tuple(true, srv.admission->info());
+                                       });
+
         // std::this_thread::sleep_for(std::chrono::seconds(1)); // wait until its up
         /* 🦜 : I doubt that.^^^ */
         {
@@ -365,6 +392,9 @@ namespace weak{
             IChainDBGettable2* iChainDBGettable2;
             IWorldChainStateSettable* iWorldChainStateSettable;
             IAcnGettable* iAcnGettable;
+            IAcnSnapshotable* iAcnSnapshotable;
+            IStateCheckpointable* iStateCheckpointable = nullptr; // <! only the rocksDB has it
+            IAcnIterable* iAcnIterable;
           } w;
 
           if (o.data_dir == ""){
@@ -376,15 +406,37 @@ namespace weak{
             w.iChainDBGettable = dynamic_cast<IChainDBGettable*>(&(*w.ram));
             w.iWorldChainStateSettable = dynamic_cast<IWorldChainStateSettable*>(&(*w.ram));
             w.iAcnGettable = dynamic_cast<IAcnGettable*>(&(*w.ram));
+            w.iAcnSnapshotable = dynamic_cast<IAcnSnapshotable*>(&(*w.ram));
+            w.iAcnIterable = dynamic_cast<IAcnIterable*>(&(*w.ram));
           }else{
             BOOST_LOG_TRIVIAL(info) << format("Starting rocksDB at data-dir = " S_CYAN "%s" S_NOR ) % o.data_dir;
-            w.db = make_unique<WorldStorage>(o.data_dir);
+            optional<StorageProfile> profile = StorageProfile::fromName(o.storage_profile);
+            if (not profile)
+              BOOST_THROW_EXCEPTION(std::runtime_error((format("Unknown storage profile '%s', it should be one of "
+                                                               "'default', 'write-heavy', 'read-heavy', 'low-memory'")
+                                                        % o.storage_profile).str()));
+            profile->statistics = o.storage_stats == "yes";
+            profile->state_wal = o.state_group_commit <= 0;
+            w.db = make_unique<WorldStorage>(o.data_dir, o.blk_log == "yes",
+                                             boost::numeric_cast<size_t>(std::max(o.blk_log_sync_every, 0)),
+                                             profile.value());
+            // <2024-07-26 Fri> 🦜 : redo the state lost in a crash (if any), see stateCommit.hpp
+            StateGroupCommitter::replay(dynamic_cast<IStateDurable*>(&(*w.db)),
+                                        dynamic_cast<IWorldChainStateSettable*>(&(*w.db)),
+                                        not profile->state_wal);
+            srv.iHttpServable->listenToGet("/get_storage_stats",
+                                           [&w](string, uint16_t, optional<unordered_map<string,string>>){
+                                             return make_tuple(true, json::serialize(w.db->stats()));
+                                           });
 
             // prepare the interfaces
             w.iChainDBGettable2 = dynamic_cast<IChainDBGettable2*>(&(*w.db));
             w.iChainDBGettable = dynamic_cast<IChainDBGettable*>(&(*w.db));
             w.iWorldChainStateSettable = dynamic_cast<IWorldChainStateSettable*>(&(*w.db));
             w.iAcnGettable = dynamic_cast<IAcnGettable*>(&(*w.db));
+            w.iAcnSnapshotable = dynamic_cast<IAcnSnapshotable*>(&(*w.db));
+            w.iStateCheckpointable = dynamic_cast<IStateCheckpointable*>(&(*w.db));
+            w.iAcnIterable = dynamic_cast<IAcnIterable*>(&(*w.db));
             /*implicitly calls filesystem::path(string)*/
           };
 
@@ -424,6 +476,63 @@ namespace weak{
           // ::pure::ICnsssPrimaryBased cnsss;
           Mempool pool{move(txhs),o.txs_per_blk};
 
+          // <2024-07-02 Tue> 🦜 : The feed for the long-poll subscribers, fed by the BlkExecutor
+          // <2024-07-29 Mon> 🦜 : The waiters are parked without a thread, so there can be thousands of them.
+          BlkFeed feed{fresh_start ? optional<uint64_t>() : optional<uint64_t>(boost::numeric_cast<uint64_t>(*latest_blk_num)),
+                       64,
+                       BlkFeed::DEFAULT_MAX_WAITERS};
+          unique_ptr<BlkCache> blk_cache;
+          if (o.rpc_blk_cache_mb > 0)
+            blk_cache = make_unique<BlkCache>(boost::numeric_cast<size_t>(o.rpc_blk_cache_mb) << 20);
+          // <2024-07-19 Fri> 🦜 : The state as of each recent Blk (and the checkpoints), fed by the BlkExecutor
+          // <2024-07-28 Sun> 🦜 : Only with rocksDB, whose snapshots are cheap. The RAM mode reads the latest state live.
+          unique_ptr<StateVersions> versions;
+          unique_ptr<LiveAcns> live_acns;
+          IAcnGettableAt * acns_at;
+          if (w.db){
+            versions = make_unique<StateVersions>(w.iAcnSnapshotable, w.iChainDBGettable,
+                                                  fresh_start ? optional<uint64_t>() : optional<uint64_t>(boost::numeric_cast<uint64_t>(*latest_blk_num)),
+                                                  boost::numeric_cast<size_t>(o.state_recent_versions),
+                                                  w.iStateCheckpointable,
+                                                  boost::numeric_cast<uint64_t>(o.state_checkpoint_every),
+                                                  boost::numeric_cast<size_t>(o.state_max_checkpoints));
+            acns_at = versions.get();
+          }else{
+            live_acns = make_unique<LiveAcns>(w.iAcnGettable);
+            acns_at = live_acns.get();
+          }
+          // <2024-07-17 Wed> 🦜 : The read-only contract calls (`/call`), they read snapshots of the stateDB
+          // <2024-07-29 Mon> 🦜 : The calls run on their own pool and are replied from there, so they
+          // don't hold the HTTP handler threads.
+          unique_ptr<CallExecutor> caller;
+          if (o.rpc_call_threads > 0)
+            caller = make_unique<CallExecutor>(w.iAcnSnapshotable,
+                                               boost::numeric_cast<size_t>(o.rpc_call_threads),
+                                               o.rpc_call_gas,
+                                               256 /*max pending*/,
+                                               versions.get() /*RAM mode: a copy-on-write snapshot per call*/);
+
+          // <2024-07-26 Fri> 🦜 : The group commit of the stateDB (without WAL), fed by the BlkExecutor
+          unique_ptr<StateGroupCommitter> group_commit;
+          if (w.db and o.state_group_commit > 0)
+            group_commit = make_unique<StateGroupCommitter>(dynamic_cast<IStateDurable*>(&(*w.db)),
+                                                            boost::numeric_cast<uint64_t>(o.state_group_commit));
+
+          // <2024-07-27 Sat> 🦜 : The Acns read ahead for the BlkExecutor (and the sealer), fed by the BlkExecutor
+          unique_ptr<AcnPrefetcher> prefetcher;
+          IAcnGettable * acns_for_exe = w.iAcnGettable;
+          if (w.db and o.state_prefetch == "yes"){
+            prefetcher = make_unique<AcnPrefetcher>(w.iAcnGettable);
+            acns_for_exe = dynamic_cast<IAcnGettable*>(prefetcher.get());
+          }
+
+          // <2024-07-24 Wed> 🦜 : The state root, updated by the BlkExecutor
+          unique_ptr<StateRoot> state_root;
+          if (o.state_root == "yes"){
+            state_root = make_unique<StateRoot>();
+            state_root->rebuild(w.iAcnIterable);
+          }
+
           // 4.1.1.2
           struct {
             unique_ptr<ExeAndPartners> normal;
@@ -452,7 +561,7 @@ namespace weak{
               if (fresh_start){
                 BOOST_LOG_TRIVIAL(info) << format("\t⚙️ Starting [fresh-start] " S_CYAN "`light exe`" S_NOR " for cnsss");
                 exe.light = make_unique<LightExeAndPartners>(w.iWorldChainStateSettable,
-                                                             w.iAcnGettable,
+                                                             acns_for_exe,
                                                              txf.iTxVerifiable,
                                                              dynamic_cast<IForLightExeTxWashable*>(&pool)
                                                              );
@@ -460,7 +569,7 @@ namespace weak{
                 BOOST_LOG_TRIVIAL(info) << format("\t⚙️ Starting [persisted] " S_CYAN "`light exe`" S_NOR
                                                   " for cnsss, current chain size: " S_CYAN " %d " S_NOR) % (*latest_blk_hash);
                 exe.light = make_unique<LightExeAndPartners>(w.iWorldChainStateSettable,
-                                                             w.iAcnGettable,
+                                                             acns_for_exe,
                                                              txf.iTxVerifiable,
                                                              dynamic_cast<IForLightExeTxWashable*>(&pool),
                                                              boost::numeric_cast<uint64_t>(*latest_blk_num) + 1,
@@ -468,14 +577,32 @@ namespace weak{
                                                              );
               }
               exe.iForConsensusExecutable = dynamic_cast<::pure::IForConsensusExecutable*>(&(*(exe.light->exe)));
+              exe.light->blk_exe->committedListeners.push_back(&feed);
+              if (versions) exe.light->blk_exe->committedListeners.push_back(versions.get());
+              if (blk_cache) exe.light->blk_exe->committedListeners.push_back(blk_cache.get());
+              if (group_commit) exe.light->blk_exe->committedListeners.push_back(group_commit.get());
+              exe.light->blk_exe->stateRoot = state_root.get();
+              if (prefetcher){
+                exe.light->blk_exe->prefetcher = prefetcher.get();
+                exe.light->blk_exe->committedListeners.push_back(prefetcher.get());
+              }
             }else{
               BOOST_LOG_TRIVIAL(info) << format("\t⚙️ Starting " S_CYAN "`normal exe`" S_NOR " for cnsss");
               exe.normal = make_unique<ExeAndPartners>(w.iWorldChainStateSettable,
-                                                       w.iAcnGettable,
+                                                       acns_for_exe,
                                                        dynamic_cast<IPoolSettable*>(&pool),
                                                        txf.iTxVerifiable);
 
               exe.iForConsensusExecutable = dynamic_cast<::pure::IForConsensusExecutable*>(&(*(exe.normal->exe)));
+              exe.normal->blk_exe->committedListeners.push_back(&feed);
+              if (versions) exe.normal->blk_exe->committedListeners.push_back(versions.get());
+              if (blk_cache) exe.normal->blk_exe->committedListeners.push_back(blk_cache.get());
+              if (group_commit) exe.normal->blk_exe->committedListeners.push_back(group_commit.get());
+              exe.normal->blk_exe->stateRoot = state_root.get();
+              if (prefetcher){
+                exe.normal->blk_exe->prefetcher = prefetcher.get();
+                exe.normal->blk_exe->committedListeners.push_back(prefetcher.get());
+              }
             }
           }
 
@@ -488,6 +615,7 @@ namespace weak{
             struct {
               shared_ptr<::pure::NaiveMsgMgr> naive;
               shared_ptr<::pure::SslMsgMgr> ssl;
+              shared_ptr<::pure::CompressingMsgMgr> compressing;
               ::pure::IMsgManageable * iMsgManageable;
             } msg_mgr;
 
@@ -507,6 +635,21 @@ namespace weak{
               msg_mgr.iMsgManageable = dynamic_cast<::pure::IMsgManageable*>(&(*msg_mgr.ssl));
             }
 
+            if (o.net_compress != "no"){
+              // 🦜 : wrap whatever msg mgr we have, so the payload is compressed before signing.
+              size_t th = boost::lexical_cast<size_t>(o.net_compress); // throw bad_lexical_cast
+              string dict = o.net_compress_dict.empty() ? "" : read_file(o.net_compress_dict);
+              BOOST_LOG_TRIVIAL(info) << format("\t⚙️ Compressing p2p payloads larger than " S_CYAN "%d" S_NOR
+                                                " bytes, dictionary size: " S_CYAN "%d" S_NOR) % th % dict.size();
+              msg_mgr.compressing = make_shared<::pure::CompressingMsgMgr>(msg_mgr.iMsgManageable, th, dict);
+              msg_mgr.iMsgManageable = dynamic_cast<::pure::IMsgManageable*>(&(*msg_mgr.compressing));
+              // <2024-07-28 Sun> 🦜 : the ratio and the CPU it costs, see CompressionStats
+              srv.iHttpServable->listenToGet("/get_net_compression_stats",
+                                             [c = msg_mgr.compressing](string, uint16_t, optional<unordered_map<string,string>>){
+                                               return make_tuple(true, c->stats.toJsonString());
+                                             });
+            }
+
             struct {
               unique_ptr<IPBasedHttpNetAsstn> http;
               unique_ptr<IPBasedUdpNetAsstn> udp;
@@ -648,12 +791,15 @@ namespace weak{
                   BOOST_LOG_TRIVIAL(info) << format("⚙️ Starting " S_CYAN "sealer" S_NOR);
                   if (fresh_start){
                     sl = make_unique<Sealer>(dynamic_cast<IForSealerBlkPostable*>(&cnsss_asstn),
-                                             dynamic_cast<IForSealerTxHashesGettable*>(&pool));
+                                             dynamic_cast<IForSealerTxHashesGettable*>(&pool),
+                                             0, hash256{}, 2,
+                                             prefetcher.get());
                   }else{
                     sl = make_unique<Sealer>(dynamic_cast<IForSealerBlkPostable*>(&cnsss_asstn),
                                              dynamic_cast<IForSealerTxHashesGettable*>(&pool),
                                              boost::numeric_cast<uint64_t>(*latest_blk_num) + 1,
-                                             *latest_blk_hash);
+                                             *latest_blk_hash, 2,
+                                             prefetcher.get());
                   }
                 }
 
@@ -666,7 +812,11 @@ namespace weak{
                     dynamic_cast<IForRpcTxsAddable*>(&cnsss_asstn),
                     w.iChainDBGettable,
                     dynamic_cast<IForRpc*>(&pool),
-                    txf.iTxVerifiable
+                    txf.iTxVerifiable,
+                    &feed,
+                    blk_cache.get(),
+                    caller.get(),
+                    acns_at
                   };
 
                   namespace trivial = boost::log::trivial;
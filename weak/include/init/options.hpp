@@ -71,6 +71,30 @@ namespace weak{
 
     string tx_mode_serious;
 
+    int http_io_threads = 4;
+    int http_acceptors = 1;
+    int http_handler_threads = 4;
+
+    int rpc_max_in_flight = 64;
+    double rpc_rate_per_client = 0;
+    double rpc_burst_per_client = 0;
+    int rpc_blk_cache_mb = 64;
+    int rpc_call_threads = 2;
+    int64_t rpc_call_gas = 10'000'000;
+    int state_recent_versions = 128;
+    int state_checkpoint_every = 0;
+    int state_max_checkpoints = 8;
+    string blk_log{"no"};
+    string state_root{"no"};
+    int blk_log_sync_every = 16;
+    string storage_profile{"default"};
+    string storage_stats{"no"};
+    int state_group_commit = 0;
+    string state_prefetch{"yes"};
+
+    string net_compress{"no"};
+    string net_compress_dict;
+
     tuple<options_description,options_description,
           program_options::positional_options_description
           > define_options(){
@@ -159,6 +183,70 @@ This list represents the others, so do not specify the current node in this list
          "the node is considered to be a `newcomer` and it will send request to the existing "
          "nodes to try to get in."
          )
+        ("http-io-threads", program_options::value<int>(&(this->http_io_threads))->default_value(4),
+         "The number of io threads of the HTTP server (for the tcp and unix socket each).")
+        ("http-acceptors", program_options::value<int>(&(this->http_acceptors))->default_value(1),
+         "The number of acceptors bound to the HTTP port with SO_REUSEPORT, each with its own io_context. "
+         "Set to 0 to use one per core. (Ignored where SO_REUSEPORT is unavailable)")
+        ("http-handler-threads", program_options::value<int>(&(this->http_handler_threads))->default_value(4),
+         "The number of threads running the HTTP handlers (e.g. /add_txs), so that slow handlers "
+         "don't block the io threads. Set to 0 to run the handlers on the io threads.")
+        ("rpc-max-in-flight", program_options::value<int>(&(this->rpc_max_in_flight))->default_value(64),
+         "The max number of /add_txs(_pb) requests handled at the same time. More are rejected "
+         "with 503 and Retry-After. Set to 0 for unbounded.")
+        ("rpc-rate-per-client", program_options::value<double>(&(this->rpc_rate_per_client))->default_value(0),
+         "The number of /add_txs(_pb) requests per second a client (address or unix uid) can make. More are "
+         "rejected with 429 and Retry-After. Set to 0 (default) for unlimited.")
+        ("rpc-burst-per-client", program_options::value<double>(&(this->rpc_burst_per_client))->default_value(0),
+         "The burst allowed for --rpc-rate-per-client. Defaults to the rate.")
+        ("rpc-blk-cache-mb", program_options::value<int>(&(this->rpc_blk_cache_mb))->default_value(64),
+         "The size (in MB) of the cache of rendered Blks served by /get_blk and /get_latest_Blk. "
+         "Set to 0 to disable.")
+        ("rpc-call-threads", program_options::value<int>(&(this->rpc_call_threads))->default_value(2),
+         "The number of threads running the read-only contract calls (`/call`). The calls are replied from "
+         "there, without holding an HTTP handler thread. Set to 0 to disable `/call`.")
+        ("rpc-call-gas", program_options::value<int64_t>(&(this->rpc_call_gas))->default_value(10'000'000),
+         "The max gas a read-only contract call (`/call`) can use.")
+        ("state-recent-versions", program_options::value<int>(&(this->state_recent_versions))->default_value(128),
+         "The number of recent Blks whose state (snapshot) is kept for reads at a Blk number (e.g. `/call` with `n`). "
+         "Only works with --data-dir.")
+        ("state-checkpoint-every", program_options::value<int>(&(this->state_checkpoint_every))->default_value(0),
+         "Save a checkpoint of the stateDB every given number of Blks, so that the older states can be read too. "
+         "Set to 0 (default) to disable. Only works with --data-dir.")
+        ("state-max-checkpoints", program_options::value<int>(&(this->state_max_checkpoints))->default_value(8),
+         "The max number of stateDB checkpoints to keep, the oldest ones are removed.")
+        ("state-root", program_options::value<string>(&(this->state_root))->implicit_value("yes"),
+         "Keep a Merkle root of the state and put it in each executed Blk (`stateRoot`), so that the nodes "
+         "can compare their states. The tree is built from the stateDB on start-up. Default value: 'no'.")
+        ("blk-log", program_options::value<string>(&(this->blk_log))->implicit_value("yes"),
+         "Put the executed Blks in an append-only, memory-mapped log (<data-dir>/blkLog) instead of the chainDB. "
+         "The Blks already in the chainDB are moved there on the first start. Only works with --data-dir. "
+         "Default value: 'no'.")
+        ("blk-log-sync-every", program_options::value<int>(&(this->blk_log_sync_every))->default_value(16),
+         "Flush the Blk log to the disk every given number of Blks (it's also flushed on exit). "
+         "Set to 0 to flush only on exit.")
+        ("storage-profile", program_options::value<string>(&(this->storage_profile))->default_value("default"),
+         "How the rocksdbs are tuned (block cache, compression, filters, background jobs, rate limit), one of "
+         "'default', 'write-heavy', 'read-heavy' and 'low-memory'. Only works with --data-dir.")
+        ("storage-stats", program_options::value<string>(&(this->storage_stats))->implicit_value("yes"),
+         "Collect the rocksdb statistics (tickers), they're shown by `/get_storage_stats` with the other "
+         "rocksdb properties. It costs a few percent. Only works with --data-dir. Default value: 'no'.")
+        ("state-group-commit", program_options::value<int>(&(this->state_group_commit))->default_value(0),
+         "Write the stateDB without its WAL and make it durable every given number of Blks. After a crash, "
+         "the state of the Blks since then is replayed from the chain on start-up. "
+         "Set to 0 (default) to keep the WAL. Only works with --data-dir.")
+        ("state-prefetch", program_options::value<string>(&(this->state_prefetch))->implicit_value("yes"),
+         "Read the Acns that the Txs of a Blk will touch in one batch (MultiGet) before the Blk is executed; "
+         "on the primary this starts as soon as the sealer made the Blk. Set to 'no' to read them one by one "
+         "during the execution. Only works with --data-dir. Default value: 'yes'.")
+        ("net-compress", program_options::value<string>(&(this->net_compress))->implicit_value("256"),
+         "Compress the p2p payloads (e.g. Blks sent by light-exe) that are larger than the given number of bytes. "
+         "Set to 'no' (default) to disable. All nodes in the cluster should agree on this. "
+         "The ratio and the CPU it costs are at GET /get_net_compression_stats.")
+        ("net-compress-dict", program_options::value<string>(&(this->net_compress_dict)),
+         "Path to a preset dictionary for --net-compress. It can be trained with\n"
+         "    wch toolbox train-net-dict <out-dict.bin> <sample1> <sample2> ...\n"
+         "All nodes should use the same dictionary.")
         ("without-crypto", program_options::value<string>(&(this->without_crypto))->implicit_value("yes"),
          "When set to 'no', Enable all those crypto stuff about CA, key pair, "
          "peer validation, etc. Otherwise, we skip any of those, and all arguments starting with 'crypto' are ignored."
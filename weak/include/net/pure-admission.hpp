@@ -0,0 +1,191 @@
+/**
+ * @file pure-admission.hpp
+ * @author Jianer Cong
+ * @brief Admission control for the HTTP server.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : `/add_txs` pushes the Txs right into the consensus. If a client sends a
+ * burst, the primary gets flooded and everyone else waits. So before a guarded
+ * handler is called, we ask the AdmissionController, who checks two things:
+ *
+ *     1. Whether there're too many guarded requests queued or being handled
+ *     right now (the bounded ingress queue). If so ⇒ 503, come back later.
+ *
+ *     2. Whether this client has used up its tokens (the per-client token
+ *     bucket). If so ⇒ 429, come back later.
+ *
+ * Both rejections are cheap and come with a `Retry-After`. A request rejected
+ * with 503 doesn't cost the client a token.
+ *
+ * 🦜 : What is a "client" ?
+ *
+ * 🐢 : For TCP it's the remote address (without port), for unix-domain
+ * sockets it's the uid of the peer. The server figures it out.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <cmath>
+#include <boost/json.hpp>
+
+namespace pure{
+  using std::string;
+  using std::tuple;
+  using std::make_tuple;
+  using std::atomic;
+  using std::unordered_map;
+
+  /**
+   * @brief A classic token bucket.
+   *
+   * It holds at most `burst` tokens, and refills `rate` tokens per second.
+   */
+  class TokenBucket{
+  public:
+    using clock = std::chrono::steady_clock;
+    double tokens;
+    clock::time_point last;
+
+    TokenBucket(double burst, clock::time_point now = clock::now()):
+      tokens(burst), last(now){}
+
+    /**
+     * @brief Try to take one token.
+     *
+     * @return (ok, seconds to wait until a token is available)
+     */
+    tuple<bool,double> try_take(double rate, double burst, clock::time_point now = clock::now()) noexcept{
+      double dt = std::chrono::duration<double>(now - this->last).count();
+      this->last = now;
+      this->tokens = std::min(burst, this->tokens + dt * rate);
+      if (this->tokens >= 1.0){
+        this->tokens -= 1.0;
+        return make_tuple(true, 0.0);
+      }
+      return make_tuple(false, rate > 0 ? (1.0 - this->tokens) / rate : 1.0);
+    }
+  };
+
+  /**
+   * @brief The admission controller shared by the guarded targets.
+   */
+  class AdmissionController{
+  public:
+    enum class Verdict {ADMITTED, RATE_LIMITED /*429*/, OVERLOADED /*503*/};
+
+    const size_t max_in_flight;   // <! 0 means unbounded
+    const double rate;            // <! per-client requests per second, 0 means unlimited
+    const double burst;           // <! per-client bucket size
+
+    // counters --------------------------------------------------
+    atomic<uint64_t> in_flight{0};
+    atomic<uint64_t> peak_in_flight{0};
+    atomic<uint64_t> n_admitted{0};
+    atomic<uint64_t> n_rejected_rate{0};
+    atomic<uint64_t> n_rejected_full{0};
+
+    /**
+     * @brief Construct an AdmissionController
+     *
+     * @param m The max number of guarded requests handled at the same time.
+     * @param r The number of requests per second a client can make.
+     * @param b The burst a client can make. (defaults to `r`)
+     */
+    AdmissionController(size_t m = 64, double r = 0, double b = 0):
+      max_in_flight(m), rate(r), burst(b > 0 ? b : std::max(r, 1.0)){}
+
+    /**
+     * @brief The RAII handle of an admitted request. It frees the slot when
+     * destructed.
+     */
+    class Ticket{
+      AdmissionController * c;
+    public:
+      Ticket(AdmissionController * cc = nullptr): c(cc){}
+      Ticket(const Ticket &) = delete;
+      Ticket(Ticket && o) noexcept : c(o.c) {o.c = nullptr;}
+      Ticket & operator=(Ticket && o) noexcept{
+        if (this != &o){
+          if (c) c->in_flight--;
+          c = o.c; o.c = nullptr;
+        }
+        return *this;
+      }
+      ~Ticket(){ if (c) c->in_flight--; }
+    };
+
+    /**
+     * @brief Try to admit a request from `client`.
+     *
+     * @return (verdict, retry-after in seconds). If admitted, the returned
+     * Ticket should be kept until the request is handled.
+     */
+    tuple<Verdict,uint32_t,Ticket> try_admit(const string & client) noexcept{
+      // 1. global in-flight (🦜 : first, so that a 503 doesn't take a token)
+      uint64_t n = ++(this->in_flight);
+      if (this->max_in_flight > 0 and n > this->max_in_flight){
+        this->in_flight--;
+        this->n_rejected_full++;
+        return make_tuple(Verdict::OVERLOADED, 1u, Ticket{});
+      }
+
+      // 2. per-client rate
+      if (this->rate > 0){
+        std::unique_lock g(this->lock_for_buckets);
+        auto now = TokenBucket::clock::now();
+        this->maybe_forget_idle_clients(now);
+        auto it = this->buckets.try_emplace(client, this->burst, now).first;
+        auto [ok, wait] = it->second.try_take(this->rate, this->burst, now);
+        if (not ok){
+          this->in_flight--;
+          this->n_rejected_rate++;
+          return make_tuple(Verdict::RATE_LIMITED, static_cast<uint32_t>(std::ceil(wait)), Ticket{});
+        }
+      }
+
+      uint64_t p = this->peak_in_flight.load();
+      while (n > p and not this->peak_in_flight.compare_exchange_weak(p, n)){}
+      this->n_admitted++;
+      return make_tuple(Verdict::ADMITTED, 0u, Ticket{this});
+    }
+
+    string info() noexcept{
+      boost::json::object o;
+      o["in_flight"] = this->in_flight.load();
+      o["peak_in_flight"] = this->peak_in_flight.load();
+      o["max_in_flight"] = this->max_in_flight;
+      o["n_admitted"] = this->n_admitted.load();
+      o["n_rejected_rate"] = this->n_rejected_rate.load();
+      o["n_rejected_full"] = this->n_rejected_full.load();
+      {
+        std::unique_lock g(this->lock_for_buckets);
+        o["n_clients"] = this->buckets.size();
+      }
+      return boost::json::serialize(o);
+    }
+
+  private:
+    std::mutex lock_for_buckets;
+    unordered_map<string,TokenBucket> buckets;
+    TokenBucket::clock::time_point last_sweep = TokenBucket::clock::now();
+
+    /*
+      🦜 : A client idle long enough has a full bucket anyway, so we can forget
+      it. Otherwise the map grows with every address that ever talked to us.
+     */
+    void maybe_forget_idle_clients(TokenBucket::clock::time_point now) noexcept{
+      if (now - this->last_sweep < std::chrono::seconds(60)) return;
+      this->last_sweep = now;
+      double full_after = this->burst / this->rate;
+      std::erase_if(this->buckets, [&](const auto & kv){
+        return std::chrono::duration<double>(now - kv.second.last).count() > full_after;
+      });
+    }
+  };
+}
@@ -0,0 +1,350 @@
+/**
+ * @file pure-compressingMsgMgr.hpp
+ * @author Jianer Cong
+ * @brief A msg manager that compresses the payload before handing it to
+ * another msg manager.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : When light-exe is used, the primary broadcasts the whole serialized Blk
+ * (with every Tx in it), and Rbft sends it three times (execute, confirm,
+ * commit). The calldata in our Txs are pretty repetitive, so they compress
+ * well. Between datacenters, bandwidth is usually more precious than CPU.
+ *
+ * 🦜 : So where do we put the compression ?
+ *
+ * 🐢 : Both IPBasedHttpNetAsstn and IPBasedUdpNetAsstn hand their payload to
+ * an IMsgManageable before sending and after receiving. So we just wrap the
+ * msg manager: compress and then let the inner one sign, and when receiving,
+ * let the inner one verify and then we decompress. The signature therefore
+ * covers the compressed bytes, and the net asstns don't need to change at all.
+ *
+ * 🦜 : What about "negotiating per peer" ?
+ *
+ * 🐢 : IMsgManageable doesn't know who the msg is sent to, so instead every
+ * frame describes itself: a raw frame and a compressed frame can be mixed
+ * freely, and each msg is decoded independently. This means a node can turn
+ * compression on/off (or change the threshold/dictionary) without breaking
+ * its peers, as long as all of them speak this frame format (i.e. all wrap
+ * their msg manager with this).
+ *
+ * The frame looks like:
+ *
+ *     <payload> 'R'                                              (raw)
+ *     <zlib stream> <dict-id : 4 bytes BE> <raw-size : 4 bytes BE> 'Z'
+ *
+ * where dict-id is the adler32 of the preset dictionary (0 for no dictionary).
+ *
+ * <2024-07-28 Sun> 🐢 : The tag (and the header) goes at the end, so that a raw
+ * frame is just the payload with one more byte: push_back() on the way out and
+ * pop_back() on the way in, the payload is never copied.
+ *
+ * 🦜 : Why zlib instead of zstd or lz4 ?
+ *
+ * 🐢 : zlib is already a dependency of RocksDB on every platform we build on
+ * (vcpkg included), and it supports preset dictionaries, which is the part
+ * that matters for our small, similar-looking msgs. The frame has a tag byte,
+ * so we can add another codec later.
+ */
+
+#pragma once
+#include "pure-netAsstn.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <zlib.h>
+
+namespace pure{
+  using std::atomic;
+
+  /**
+   * @brief Counters about how much we compressed and how much CPU it cost.
+   *
+   * 🦜 : All of these are monotonic, so one can take two snapshots and
+   * compute the rates.
+   */
+  struct CompressionStats{
+    atomic<uint64_t> n_sent{0};              // <! number of msgs prepared
+    atomic<uint64_t> n_compressed{0};        // <! ... of which compressed
+    atomic<uint64_t> bytes_raw_out{0};       // <! payload bytes before compression
+    atomic<uint64_t> bytes_wire_out{0};      // <! payload bytes after compression (frame included)
+    atomic<uint64_t> n_received{0};          // <! number of msgs opened
+    atomic<uint64_t> bytes_wire_in{0};
+    atomic<uint64_t> bytes_raw_in{0};
+    atomic<uint64_t> ns_compress{0};         // <! CPU time spent in deflate
+    atomic<uint64_t> ns_decompress{0};       // <! CPU time spent in inflate
+
+    /**
+     * @brief The ratio `raw / wire` for outgoing payloads. (>1 means we saved bandwidth)
+     */
+    double ratio() const noexcept{
+      uint64_t w = bytes_wire_out.load();
+      return w == 0 ? 1.0 : static_cast<double>(bytes_raw_out.load()) / static_cast<double>(w);
+    }
+
+    /**
+     * @brief The CPU cost: ns spent in deflate per raw byte sent. (All the
+     * bytes count, so the small msgs sent raw make it cheaper, as they should.)
+     */
+    double ns_per_byte_out() const noexcept{
+      uint64_t r = bytes_raw_out.load();
+      return r == 0 ? 0.0 : static_cast<double>(ns_compress.load()) / static_cast<double>(r);
+    }
+
+    /// ns spent in inflate per raw byte received.
+    double ns_per_byte_in() const noexcept{
+      uint64_t r = bytes_raw_in.load();
+      return r == 0 ? 0.0 : static_cast<double>(ns_decompress.load()) / static_cast<double>(r);
+    }
+
+    string toJsonString() const noexcept{
+      json::object o;
+      o["n_sent"] = n_sent.load();
+      o["n_compressed"] = n_compressed.load();
+      o["bytes_raw_out"] = bytes_raw_out.load();
+      o["bytes_wire_out"] = bytes_wire_out.load();
+      o["n_received"] = n_received.load();
+      o["bytes_wire_in"] = bytes_wire_in.load();
+      o["bytes_raw_in"] = bytes_raw_in.load();
+      o["ns_compress"] = ns_compress.load();
+      o["ns_decompress"] = ns_decompress.load();
+      o["ratio"] = ratio();
+      o["ns_per_byte_out"] = ns_per_byte_out();
+      o["ns_per_byte_in"] = ns_per_byte_in();
+      return json::serialize(o);
+    }
+  };
+
+  /**
+   * @brief The msg manager that compresses the payload and delegates signing
+   * to another msg manager.
+   */
+  class CompressingMsgMgr: public virtual IMsgManageable{
+  public:
+    static constexpr char RAW_TAG = 'R';
+    static constexpr char ZLIB_TAG = 'Z';
+    static constexpr size_t HEADER_SIZE = 1 + 4 + 4;
+    /*
+      🦜 : Refuse to inflate anything claiming to be larger than this. Otherwise
+      a peer can ask us to allocate 4GB with a 9-byte msg.
+     */
+    static constexpr uint32_t MAX_RAW_SIZE = 256 * 1024 * 1024;
+
+    IMsgManageable * const inner;
+    const size_t threshold;       // <! payloads smaller than this are sent raw
+    const int level;              // <! the zlib level
+    mutable CompressionStats stats;
+
+    /**
+     * @brief Construct a new CompressingMsgMgr
+     *
+     * @param m The inner msg manager, which does the actual signing.
+     * @param th Payloads shorter than this are not compressed.
+     * @param d The preset dictionary, can be empty. See `train_dict()`.
+     * @param lvl The zlib compression level (1-9).
+     */
+    CompressingMsgMgr(IMsgManageable * const m, size_t th = 256, string d = "",
+                      int lvl = Z_DEFAULT_COMPRESSION):
+      inner(m), threshold(th), level(lvl), dict(std::move(d)) {
+      if (m == nullptr)
+        BOOST_THROW_EXCEPTION(std::runtime_error("CompressingMsgMgr needs an inner msg manager."));
+      if (not this->dict.empty()){
+        this->dict_id = adler32(adler32(0L, Z_NULL, 0),
+                                reinterpret_cast<const Bytef*>(this->dict.data()),
+                                static_cast<uInt>(this->dict.size()));
+      }
+    }
+
+    ~CompressingMsgMgr(){
+      BOOST_LOG_TRIVIAL(debug) << format("👋 " S_MAGENTA "CompressingMsgMgr" S_NOR " closing, stats: %s")
+        % this->stats.toJsonString();
+    }
+
+    string prepare_msg(string && data) const noexcept override{
+      return this->inner->prepare_msg(this->compress(std::move(data)));
+    }
+
+    optional<tuple<string,string>> tear_msg_open(string_view msg) const noexcept override{
+      optional<tuple<string,string>> r = this->inner->tear_msg_open(msg);
+      if (not r) return {};
+      auto & [from, data] = r.value();
+      optional<string> d = this->decompress(std::move(data));
+      if (not d){
+        BOOST_LOG_TRIVIAL(error) << format("❌️ Failed to decompress msg from " S_RED "%s" S_NOR) % from;
+        return {};
+      }
+      data = std::move(d.value());
+      return r;
+    }
+
+    string my_endpoint() const noexcept override{
+      return this->inner->my_endpoint();
+    }
+
+    /**
+     * @brief Frame (and maybe compress) a payload.
+     *
+     * 🦜 : If the compressed result is not smaller, we send it raw.
+     */
+    string compress(string && data) const noexcept{
+      this->stats.n_sent++;
+      this->stats.bytes_raw_out += data.size();
+
+      if (data.size() >= this->threshold and data.size() <= MAX_RAW_SIZE){
+        auto t0 = std::chrono::steady_clock::now();
+        optional<string> z = this->deflate_this(data);
+        this->stats.ns_compress += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                                       std::chrono::steady_clock::now() - t0).count();
+        if (z and z.value().size() < data.size() + 1){
+          this->stats.n_compressed++;
+          this->stats.bytes_wire_out += z.value().size();
+          return std::move(z.value());
+        }
+      }
+
+      data.push_back(RAW_TAG);
+      this->stats.bytes_wire_out += data.size();
+      return std::move(data);
+    }
+
+    /**
+     * @brief Unframe (and maybe decompress) a payload.
+     */
+    optional<string> decompress(string && s) const noexcept{
+      if (s.empty()) return {};
+      this->stats.n_received++;
+      this->stats.bytes_wire_in += s.size();
+
+      if (s.back() == RAW_TAG){
+        s.pop_back();
+        this->stats.bytes_raw_in += s.size();
+        return std::move(s);
+      }
+
+      if (s.back() != ZLIB_TAG or s.size() < HEADER_SIZE) return {};
+
+      auto t0 = std::chrono::steady_clock::now();
+      optional<string> r = this->inflate_this(s);
+      this->stats.ns_decompress += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                                       std::chrono::steady_clock::now() - t0).count();
+      if (r) this->stats.bytes_raw_in += r.value().size();
+      return r;
+    }
+
+    /**
+     * @brief Train a preset dictionary from some sample payloads.
+     *
+     * @param samples Some typical payloads (e.g. serialized Blks).
+     * @param max_size The size of dictionary, zlib can use at most 32KB of it.
+     *
+     * 🐢 : zlib doesn't ship a trainer, so we do a simple one: cut the samples
+     * into fixed-size chunks, count them, and keep the most popular ones. zlib
+     * prefers the most common strings at the end of the dictionary (they are
+     * closer, so cheaper to refer to), so we lay them out in ascending count.
+     *
+     * All nodes should use the same dictionary, otherwise the msg would be
+     * rejected (the dict-id won't match).
+     */
+    static string train_dict(const vector<string> & samples, size_t max_size = 32 * 1024,
+                             size_t chunk = 16){
+      std::map<string,uint64_t> cnt;
+      for (const string & s : samples)
+        for (size_t i = 0; i + chunk <= s.size(); i += chunk)
+          cnt[s.substr(i, chunk)]++;
+
+      vector<tuple<uint64_t,string>> v;
+      v.reserve(cnt.size());
+      for (auto & [k,c] : cnt)
+        if (c > 1) v.emplace_back(c, k); // 🦜 : seen only once is not worth it
+      std::sort(v.begin(), v.end(), [](const auto & a, const auto & b){
+        return std::get<0>(a) > std::get<0>(b);
+      });
+
+      if (v.size() * chunk > max_size) v.resize(max_size / chunk);
+      string d;
+      d.reserve(v.size() * chunk);
+      for (auto it = v.rbegin(); it != v.rend(); it++)
+        d += std::get<1>(*it);
+      return d;
+    }
+
+  private:
+    string dict;
+    uLong dict_id = 0;
+
+    static void put_u32(string & o, uint32_t x){
+      for (int i = 3; i >= 0; i--) o += static_cast<char>((x >> (8 * i)) & 0xff);
+    }
+    static uint32_t get_u32(string_view s){
+      uint32_t x = 0;
+      for (int i = 0; i < 4; i++) x = (x << 8) | static_cast<uint8_t>(s[i]);
+      return x;
+    }
+
+    optional<string> deflate_this(string_view data) const noexcept{
+      z_stream zs{};
+      if (deflateInit(&zs, this->level) != Z_OK) return {};
+      if (not this->dict.empty() and
+          deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(this->dict.data()),
+                               static_cast<uInt>(this->dict.size())) != Z_OK){
+        deflateEnd(&zs);
+        return {};
+      }
+
+      string o;
+      uLong bound = deflateBound(&zs, static_cast<uLong>(data.size()));
+      o.resize(bound + HEADER_SIZE);
+
+      zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+      zs.avail_in = static_cast<uInt>(data.size());
+      zs.next_out = reinterpret_cast<Bytef*>(o.data());
+      zs.avail_out = static_cast<uInt>(bound);
+      int r = deflate(&zs, Z_FINISH);
+      size_t n = zs.total_out;
+      deflateEnd(&zs);
+      if (r != Z_STREAM_END) return {};
+      o.resize(n);
+      put_u32(o, static_cast<uint32_t>(this->dict_id));
+      put_u32(o, static_cast<uint32_t>(data.size()));
+      o += ZLIB_TAG;
+      return o;
+    }
+
+    optional<string> inflate_this(string_view s) const noexcept{
+      const size_t z = s.size() - HEADER_SIZE; // <! the size of the zlib stream
+      uint32_t did = get_u32(s.substr(z, 4));
+      uint32_t n = get_u32(s.substr(z + 4, 4));
+      if (n > MAX_RAW_SIZE) return {};
+      if (did != 0 and did != static_cast<uint32_t>(this->dict_id)){
+        BOOST_LOG_TRIVIAL(error) << format("❌️ Unknown compression dictionary " S_RED "%x" S_NOR
+                                           ", are all nodes using the same dictionary?") % did;
+        return {};
+      }
+
+      string o(n, '\0');
+      z_stream zs{};
+      if (inflateInit(&zs) != Z_OK) return {};
+      zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(s.data()));
+      zs.avail_in = static_cast<uInt>(z);
+      zs.next_out = reinterpret_cast<Bytef*>(o.data());
+      zs.avail_out = n;
+
+      int r = inflate(&zs, Z_FINISH);
+      if (r == Z_NEED_DICT){
+        if (this->dict.empty() or
+            inflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(this->dict.data()),
+                                 static_cast<uInt>(this->dict.size())) != Z_OK){
+          inflateEnd(&zs);
+          return {};
+        }
+        r = inflate(&zs, Z_FINISH);
+      }
+      size_t got = zs.total_out;
+      inflateEnd(&zs);
+      if (r != Z_STREAM_END or got != n) return {};
+      return o;
+    }
+  };                            // class CompressingMsgMgr
+}
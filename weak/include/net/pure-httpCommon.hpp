@@ -22,10 +22,13 @@
 #include <boost/beast/version.hpp>
 #include <boost/config.hpp>
 #include <boost/log/trivial.hpp>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <mutex>                // std::mutex
 #include <optional>
 #include <string>
@@ -35,6 +38,8 @@
 #include <vector>
 #include<tuple> // for tuple
 
+#include "pure-admission.hpp"
+
 
 namespace pure{
 
@@ -46,6 +51,7 @@ namespace pure{
   using std::function;
   using std::make_tuple;
   using std::optional;
+  using std::shared_ptr;
   using std::tuple;
   using std::unordered_map;
 
@@ -62,6 +68,30 @@ namespace pure{
   using std::string_view;
   using std::string;
 
+  /**
+   * @brief The reply of a deferred handler.
+   *
+   * 🦜 : The handler keeps it, and calls reply() once it has the body, from
+   * whatever thread. Only the first reply counts.
+   */
+  class IDeferredReply{
+  public:
+    /**
+     * @brief Send the response.
+     *
+     * @return false if it's already replied (e.g. by the timeout).
+     */
+    virtual bool reply(tuple<bool,string> r) noexcept=0;
+
+    /**
+     * @brief If not replied within `t`, call `f`, which should reply.
+     *
+     * 🐢 : Call it before the handler returns.
+     */
+    virtual void expires_after(std::chrono::milliseconds t, function<void()> f) noexcept=0;
+    virtual ~IDeferredReply(){};
+  };
+
   /**
    * @brief The interface of an HTTP server
    */
@@ -82,6 +112,59 @@ namespace pure{
     virtual void listenToGet(string k, getHandler_t f)noexcept=0;
     virtual int removeFromPost(string k) noexcept=0;
     virtual void listenToPost(string k, postHandler_t f) noexcept=0;
+
+    /**
+     * @brief Put the POST target `k` behind an admission controller.
+     *
+     * 🦜 : Requests to `k` that are not admitted will be rejected with 429/503
+     * before reaching the handler. The default does nothing.
+     */
+    virtual void guardPost(string /*k*/, AdmissionController * /*a*/) noexcept {};
+
+    /*
+      <2024-07-15 Mon> 🦜 : A streaming GET handler writes its body piece by
+      piece with the given `write` (which returns false if the client is gone),
+      and returns false if it failed halfway. The async server sends each piece
+      as a chunk (Transfer-Encoding: chunked) as soon as it's written, so the
+      body never sits in memory as a whole.
+
+      <2024-07-28 Sun> 🦜 : The header is sent with the first piece. So if the
+      handler fails before writing anything (e.g. a bad query param), the
+      client gets a 400 with the returned error message instead of a cut 200.
+     */
+    using chunkWriter_t = function<bool (string_view)>;
+    using streamHandler_t = function<tuple<bool,string> (string, uint16_t,
+                                           optional<unordered_map<string,string>>, // the query param
+                                           const chunkWriter_t & // the writer
+                                           )>;
+    /**
+     * @brief Listen to a GET target with a streaming handler. The default does nothing.
+     */
+    virtual void listenToGetStream(string /*k*/, streamHandler_t /*f*/) noexcept {};
+
+    /*
+      <2024-07-29 Mon> 🦜 : A deferred handler doesn't return the body, it
+      keeps the Reply and fills it later (e.g. a long-poll subscriber is replied
+      when a Blk is committed). Meanwhile no thread waits on it: the async
+      server parks the session with a timer.
+     */
+    using deferredGetHandler_t = function<void (string, uint16_t,
+                                                optional<unordered_map<string,string>>, // the query param
+                                                shared_ptr<IDeferredReply> // the reply
+                                                )>;
+    /**
+     * @brief Listen to a GET target with a deferred handler. The default does nothing.
+     */
+    virtual void listenToGetDeferred(string /*k*/, deferredGetHandler_t /*f*/) noexcept {};
+
+    using deferredPostHandler_t = function<void (string, uint16_t,
+                                                 string, // the body
+                                                 shared_ptr<IDeferredReply> // the reply
+                                                 )>;
+    /**
+     * @brief Listen to a POST target with a deferred handler. The default does nothing.
+     */
+    virtual void listenToPostDeferred(string /*k*/, deferredPostHandler_t /*f*/) noexcept {};
   };                            // class IHttpServable
 
   /**
@@ -145,9 +228,11 @@ namespace pure{
      * @param req The request to handle
      * @param a The client address
      * @param p The client port
+     * @param admitted Whether admit() has already been called (and passed) by
+     * the caller, who keeps the Ticket.
      */
     response<http::string_body>
-    handle_request(request<http::string_body>&& req, string a, uint16_t p){
+    handle_request(request<http::string_body>&& req, string a, uint16_t p, bool admitted = false){
       // Returns a bad request response
       auto const bad_request =
         [&req](beast::string_view why){
@@ -160,18 +245,6 @@ namespace pure{
           return res;
         };
 
-      // Returns a server error response
-      auto const server_error =
-        [&req](beast::string_view what, http::status r = http::status::internal_server_error){
-          response<http::string_body> res{r,req.version()};
-          res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-          res.set(http::field::content_type, "text/html");
-          res.keep_alive(req.keep_alive());
-          res.body() = "An error occurred: '" + std::string(what) + "'";
-          res.prepare_payload();
-          return res;
-        };
-
       // 1.log --------------------------------------------------
       BOOST_LOG_TRIVIAL(debug) << format("Start handling");
       BOOST_LOG_TRIVIAL(debug) << format("Handling request\n\tmethod: %s\n\ttarget: %s\n\tcontent type: %s\n\tFrom: %s:%d")
@@ -186,50 +259,275 @@ namespace pure{
         🦜 : Since we have already shown the body in POST, so we don't need to show it twice.
        */
 
-      // 2. make Response --------------------------------------------------
-      response<http::string_body> res;
-
       // 3. dispatch --------------------------------------------------
       // if( req.method() != http::verb::get) &&
       //     req.method() != http::verb::post)
       //   return bad_request("Unknown HTTP-method");
 
+      // 2.1 admission --------------------------------------------------
+      AdmissionController::Ticket ticket; // 🦜 : held until the handler returns
+      if (not admitted)
+        if (auto r = this->admit(req, a, ticket))
+          return std::move(r.value());
+
+      // 2.2 content negotiation --------------------------------------------------
+      /*
+        <2024-07-12 Fri> 🦜 : If a GET client says `Accept: application/x-protobuf`
+        and there's a "<target>_pb" handler, we use that one. So `GET /get_tx?hash=..`
+        with that header is the same as `GET /get_tx_pb?hash=..`.
+       */
+      string target{req.target()};
+      bool is_pb;
+      {
+        size_t n = std::min(target.find('?'), target.size());
+        is_pb = string_view(target).substr(0, n).ends_with("_pb");
+        if ((not is_pb) and req.method() == http::verb::get and
+            string_view(req[http::field::accept]).find("application/x-protobuf") != string_view::npos){
+          std::unique_lock g(this->lockForGetLisnMap);
+          if (this->getLisnMap.contains(target.substr(0, n) + "_pb")){
+            target.insert(n, "_pb");
+            is_pb = true;
+          }
+        }
+      }
+
       bool ok; string body;
       if (req.method() == http::verb::get){
-        std::tie(ok,body) = getGetResponseBody(req.target(),a,p);
+        if (auto dh = this->getDeferredHandler(target)){
+          /*
+            <2024-07-29 Mon> 🦜 : A deferred handler reached here (e.g. the
+            sync server), so we just wait for its reply.
+           */
+          auto & [f, q] = dh.value();
+          std::tie(ok, body) = BlockingReply::run([&](shared_ptr<IDeferredReply> r){f(a, p, q, r);});
+        }else if (auto sh = this->getStreamHandler(target)){
+          /*
+            🦜 : A streaming handler reached here (e.g. the server can't stream),
+            so we just collect the chunks.
+           */
+          auto & [f, q] = sh.value();
+          string err;
+          std::tie(ok, err) = f(a, p, q, [&body](string_view c){ body.append(c); return true;});
+          if (not ok) body = err.empty() ? "streaming handler failed" : err;
+        }else
+          std::tie(ok,body) = getGetResponseBody(target,a,p);
       }else if (req.method() == http::verb::post){
-        std::tie(ok,body) = getPostResponseBody(req.target(),a,p,req.body());
+        if (auto f = this->getDeferredPostHandler(target))
+          std::tie(ok, body) = BlockingReply::run([&](shared_ptr<IDeferredReply> r){f(a, p, req.body(), r);});
+        else
+          std::tie(ok,body) = getPostResponseBody(target,a,p,req.body());
       }else{
         return bad_request("Unknown method");
       }
 
+      return response_of(req, ok, std::move(body), is_pb);
+    }
+
+    /**
+     * @brief Make the response of `req` from what the handler returned.
+     *
+     * @param ok Whether the handler succeeded.
+     * @param body The body if ok, otherwise the error message.
+     * @param is_pb Whether the body is protobuf.
+     */
+    static response<http::string_body> response_of(const request<http::string_body> & req,
+                                                   bool ok, string body, bool is_pb){
+      response<http::string_body> res;
       if (not ok){
         if (body == "NOT FOUND")
-          return server_error((format("target >>%s<< is not found") % req.target()).str(),
+          return server_error(req, (format("target >>%s<< is not found") % req.target()).str(),
                               http::status::not_found); // 404
         else
-          return server_error(body);
+          return server_error(req, body);
       }
 
       // Got valid body
       BOOST_LOG_TRIVIAL(debug) << format("Returning body " S_CYAN "%s" S_NOR) %
-        (req.target().ends_with("_pb") ? "<pb string of size " + std::to_string(body.size()) + ">" : body);
-
-      res.body() = body;
+        (is_pb ? "<pb string of size " + std::to_string(body.size()) + ">" : body);
 
       res.version(11);   // HTTP/1.1
       res.set(http::field::server, "Beast");
       res.result(http::status::ok);
       res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-      res.set(http::field::content_type, "application/json");
+      res.set(http::field::content_type, is_pb ? "application/x-protobuf" : "application/json");
+      res.set(http::field::vary, "Accept");
       res.keep_alive(req.keep_alive());
 
+      /*
+        <2024-07-08 Mon> 🦜 : For GET, we tag the body, so that a client that
+        already has it (e.g. a committed Blk, which never changes) gets a 304
+        without the body.
+      */
+      if (req.method() == http::verb::get){
+        string tag = etag_of(body);
+        res.set(http::field::etag, tag);
+        if (none_match(string(req[http::field::if_none_match]), tag)){
+          res.result(http::status::not_modified);
+          res.prepare_payload();
+          return res;
+        }
+      }
+
+      res.body() = std::move(body);
+
+      res.prepare_payload();
+      return res;
+    }
+
+    // Returns a server error response
+    static response<http::string_body> server_error(const request<http::string_body> & req,
+                                                    beast::string_view what,
+                                                    http::status r = http::status::internal_server_error){
+      response<http::string_body> res{r,req.version()};
+      res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+      res.set(http::field::content_type, "text/html");
+      res.keep_alive(req.keep_alive());
+      res.body() = "An error occurred: '" + std::string(what) + "'";
       res.prepare_payload();
       return res;
     }
 
+    /**
+     * @brief The reply of a deferred handler that is waited for by the calling thread.
+     */
+    class BlockingReply: public virtual IDeferredReply{
+    public:
+      bool reply(tuple<bool,string> r) noexcept override{
+        if (this->replied.exchange(true)) return false;
+        this->p.set_value(std::move(r));
+        return true;
+      }
+
+      void expires_after(std::chrono::milliseconds t, function<void()> f) noexcept override{
+        std::unique_lock g(this->lock);
+        this->timeout = make_tuple(t, f);
+      }
+
+      /**
+       * @brief Run the deferred handler `h` (given the reply) and wait for its reply.
+       */
+      static tuple<bool,string> run(function<void(shared_ptr<IDeferredReply>)> h){
+        auto r = std::make_shared<BlockingReply>();
+        std::future<tuple<bool,string>> x = r->p.get_future();
+        h(r);
+        optional<tuple<std::chrono::milliseconds,function<void()>>> t;
+        {
+          std::unique_lock g(r->lock);
+          t = std::move(r->timeout); // 🦜 : `f` may hold `r`, so don't keep it there
+          r->timeout.reset();
+        }
+        if (t and x.wait_for(std::get<0>(t.value())) == std::future_status::timeout)
+          std::get<1>(t.value())();
+        return x.get();
+      }
+    private:
+      std::atomic<bool> replied{false};
+      std::promise<tuple<bool,string>> p;
+      std::mutex lock;
+      optional<tuple<std::chrono::milliseconds,function<void()>>> timeout;
+    };
+
+    /**
+     * @brief Ask the admission controller of `req`'s target (if it's guarded)
+     * whether `req` can be handled.
+     *
+     * <2024-07-28 Sun> 🦜 : The async server calls this on the io thread,
+     * before the request is queued on the handler pool, so the queued requests
+     * are counted too, and a 503 doesn't wait in the queue.
+     *
+     * @param a The client address (the key of the rate limit).
+     * @param t Gets the Ticket if admitted. Keep it until the request is handled.
+     * @return The 429/503 response if rejected.
+     */
+    optional<response<http::string_body>> admit(const request<http::string_body> & req, const string & a,
+                                                AdmissionController::Ticket & t){
+      if (req.method() != http::verb::post) return {};
+      AdmissionController * adm = nullptr;
+      {
+        std::unique_lock g(this->lockForGuardMap);
+        if (this->guardMap.empty()) return {}; // 🦜 : the usual case
+        auto it = this->guardMap.find(string(req.target()));
+        if (it != this->guardMap.end()) adm = it->second;
+      }
+      if (not adm) return {};
+
+      // Returns a fast rejection
+      auto const rejected =
+        [&req](http::status r, uint32_t retry_after, beast::string_view why){
+          response<http::string_body> res{r, req.version()};
+          res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+          res.set(http::field::content_type, "application/json");
+          res.set(http::field::retry_after, std::to_string(retry_after));
+          res.keep_alive(req.keep_alive());
+          res.body() = (format(R"({"error":"%s","retry_after":%d})") % why % retry_after).str();
+          res.prepare_payload();
+          return res;
+        };
+
+      auto [v, retry_after, t0] = adm->try_admit(a);
+      if (v == AdmissionController::Verdict::RATE_LIMITED){
+        BOOST_LOG_TRIVIAL(debug) << format("⚠️ Rate-limited client " S_MAGENTA "%s" S_NOR) % a;
+        return rejected(http::status::too_many_requests, retry_after, "too many requests"); // 429
+      }
+      if (v == AdmissionController::Verdict::OVERLOADED){
+        BOOST_LOG_TRIVIAL(debug) << format("⚠️ Ingress full, rejecting client " S_MAGENTA "%s" S_NOR) % a;
+        return rejected(http::status::service_unavailable, retry_after, "server busy"); // 503
+      }
+      t = std::move(t0);
+      return {};
+    }
+
+    /**
+     * @brief The (strong) ETag of a body: the quoted hex of its 64-bit FNV-1a.
+     *
+     * 🦜 : It's not a cryptographic hash, but it only needs to tell whether the
+     * client's copy is the same, and it's fast.
+     */
+    static string etag_of(string_view s) noexcept{
+      uint64_t h = 0xcbf29ce484222325ULL;
+      for (unsigned char c : s){
+        h ^= c;
+        h *= 0x100000001b3ULL;
+      }
+      return (format("\"%016x\"") % h).str();
+    }
+
+    /**
+     * @brief Does the `If-None-Match` header `h` match the entity-tag `tag` ?
+     *
+     * <2024-07-28 Sun> 🦜 : Per RFC 9110 (13.1.2), `h` is `*` or a
+     * comma-separated list of tags, and the comparison is weak: `W/"x"`
+     * matches `"x"`.
+     */
+    static bool none_match(string_view h, string_view tag) noexcept{
+      auto trim = [](string_view x){
+        while ((not x.empty()) and (x.front() == ' ' or x.front() == '\t')) x.remove_prefix(1);
+        while ((not x.empty()) and (x.back() == ' ' or x.back() == '\t')) x.remove_suffix(1);
+        return x;
+      };
+      if (tag.starts_with("W/")) tag.remove_prefix(2);
+      h = trim(h);
+      if (h == "*") return true;
+      while (not h.empty()){
+        size_t i = h.find(',');
+        string_view t = trim(h.substr(0, i));
+        if (t.starts_with("W/")) t.remove_prefix(2);
+        if (t == tag) return true;
+        if (i == string_view::npos) break;
+        h.remove_prefix(i + 1);
+      }
+      return false;
+    }
+
     mutable std::mutex lockForPostLisnMap; // the mutex is mutable (m-m rule)
     mutable std::mutex lockForGetLisnMap; // the mutex is mutable (m-m rule)
+    mutable std::mutex lockForGuardMap;
+    unordered_map<string,AdmissionController*> guardMap;
+    mutable std::mutex lockForStreamLisnMap;
+    unordered_map<string,streamHandler_t> streamLisnMap;
+    mutable std::mutex lockForDeferredLisnMap;
+    unordered_map<string,deferredGetHandler_t> deferredLisnMap;
+    unordered_map<string,deferredPostHandler_t> deferredPostLisnMap;
     postMap_t postLisnMap;
     getMap_t getLisnMap;
 
@@ -241,6 +539,71 @@ namespace pure{
       this->getLisnMap[k] = f;
     }
 
+    void guardPost(string k, AdmissionController * a) noexcept override{
+      std::unique_lock g(this->lockForGuardMap);
+      this->guardMap[k] = a;
+    }
+
+    void listenToGetStream(string k, streamHandler_t f) noexcept override{
+      std::unique_lock g(this->lockForStreamLisnMap);
+      this->streamLisnMap[k] = f;
+    }
+
+    /**
+     * @brief Find the streaming handler of a GET target (e.g. "/export_blks?from=1").
+     *
+     * @return The handler and the parsed query param, if there's one.
+     */
+    optional<tuple<streamHandler_t,optional<unordered_map<string,string>>>> getStreamHandler(string target){
+      streamHandler_t f;
+      {
+        std::unique_lock g(this->lockForStreamLisnMap);
+        if (this->streamLisnMap.empty()) return {}; // 🦜 : the usual case
+        auto it = this->streamLisnMap.find(target.substr(0, target.find('?')));
+        if (it == this->streamLisnMap.end()) return {};
+        f = it->second;
+      }
+      optional<unordered_map<string,string>> q = parse_query_param(target /*trimmed here*/);
+      return make_tuple(f, std::move(q));
+    }
+
+    void listenToGetDeferred(string k, deferredGetHandler_t f) noexcept override{
+      std::unique_lock g(this->lockForDeferredLisnMap);
+      this->deferredLisnMap[k] = f;
+    }
+
+    /**
+     * @brief Find the deferred handler of a GET target (e.g. "/subscribe_blks?after=1").
+     *
+     * @return The handler and the parsed query param, if there's one.
+     */
+    optional<tuple<deferredGetHandler_t,optional<unordered_map<string,string>>>> getDeferredHandler(string target){
+      deferredGetHandler_t f;
+      {
+        std::unique_lock g(this->lockForDeferredLisnMap);
+        if (this->deferredLisnMap.empty()) return {}; // 🦜 : the usual case
+        auto it = this->deferredLisnMap.find(target.substr(0, target.find('?')));
+        if (it == this->deferredLisnMap.end()) return {};
+        f = it->second;
+      }
+      optional<unordered_map<string,string>> q = parse_query_param(target /*trimmed here*/);
+      return make_tuple(f, std::move(q));
+    }
+
+    void listenToPostDeferred(string k, deferredPostHandler_t f) noexcept override{
+      std::unique_lock g(this->lockForDeferredLisnMap);
+      this->deferredPostLisnMap[k] = f;
+    }
+
+    /**
+     * @brief Find the deferred handler of a POST target, if there's one.
+     */
+    deferredPostHandler_t getDeferredPostHandler(const string & target){
+      std::unique_lock g(this->lockForDeferredLisnMap);
+      auto it = this->deferredPostLisnMap.find(target);
+      return it == this->deferredPostLisnMap.end() ? deferredPostHandler_t() : it->second;
+    }
+
     int removeFromPost(string k) noexcept override{
       std::unique_lock g(this->lockForPostLisnMap);
       return this->postLisnMap.erase(k);
@@ -343,6 +706,26 @@ namespace pure{
         srv->listenToPost(k,f);
     }
 
+    void guardPost(string k, AdmissionController * a) noexcept override{
+      for (auto & srv : srvs)
+        srv->guardPost(k,a);
+    }
+
+    void listenToGetStream(string k, streamHandler_t f) noexcept override{
+      for (auto & srv : srvs)
+        srv->listenToGetStream(k,f);
+    }
+
+    void listenToGetDeferred(string k, deferredGetHandler_t f) noexcept override{
+      for (auto & srv : srvs)
+        srv->listenToGetDeferred(k,f);
+    }
+
+    void listenToPostDeferred(string k, deferredPostHandler_t f) noexcept override{
+      for (auto & srv : srvs)
+        srv->listenToPostDeferred(k,f);
+    }
+
     int removeFromPost(string k) noexcept override{
       int n = 0;
       for (auto & srv : srvs)
@@ -143,14 +143,15 @@ namespace pure{
         if (not r0)
           return make_tuple(false,"❌️ Error unpacking msg. Maybe the msg is ill-formed or"
                             "or the signature verification is failed.");
-        const auto [from,data] = r0.value();
+        auto & [from,data] = r0.value();
 
         BOOST_LOG_TRIVIAL(debug) << format("\tmsg unpacked, from=" S_BLUE "%s" S_NOR ",data=" S_GREEN "%s" S_NOR) % from % get_data_for_log(data);
 
-        optional<string> r = h(from,data);
+        optional<string> r = h(std::move(from),std::move(data));
         /*
-             🐢 : Data copied here from string_view into string, because cnsss
-             may modify the data and resend it.
+             🐢 : Data copied only once here (in tear_msg_open()) from
+             string_view into string, because cnsss may modify the data and
+             resend it. After that it's moved all the way down.
          */
 
         if (r)
@@ -122,8 +122,8 @@ namespace pure{
   class SignedData : public virtual ISerializable{
   public:
     SignedData() = default;
-    SignedData( string f, string s="",string d=""): from(f),sig(s),data(d){
-      if (f.empty())
+    SignedData( string f, string s="",string d=""): from(std::move(f)),sig(std::move(s)),data(std::move(d)){
+      if (this->from.empty())
         BOOST_THROW_EXCEPTION(std::runtime_error("SignedData.from cannot be empty."));
     }
     string from;
@@ -175,33 +175,28 @@ namespace pure{
       uint8_t l1 = bit_cast<uint8_t>(*(it++)) + 1; // f.size()
       // BOOST_LOG_TRIVIAL(debug) << format("l1 = %d") % static_cast<int>(l1);
 
-      // s1.clear();
-      s1.reserve(l1);
-
-      for (int i = 0;i < l1;i++){
-        s1 += *(it++);
-        // BOOST_LOG_TRIVIAL(debug) << format("Now from=%s,i=%d") % s1 % i;
-      }
+      /*
+        🦜 : Copy each field in one go. (This used to append char by char,
+        which is slow for the `data`, that can be a whole Blk.)
+       */
+      if (static_cast<size_t>(s.end() - it) < l1) return {};
+      s1.assign(it, it + l1);
+      it += l1;
 
       if (it == s.end()){
         // BOOST_LOG_TRIVIAL(trace) << "No more data to parse";
-        return make_tuple(s1,s2,s3);
+        return make_tuple(std::move(s1),std::move(s2),std::move(s3));
       }
 
       uint8_t l2 = bit_cast<uint8_t>(*(it++));
-      s2.reserve(l2);
-      for (int i = 0;i < l2;i++){
-        s2 += *(it++);
-        // BOOST_LOG_TRIVIAL(debug) << format("Now sig=%s,i=%d") % this->sig % i;
-      }
+      if (static_cast<size_t>(s.end() - it) < l2) return {};
+      s2.assign(it, it + l2);
+      it += l2;
 
-      if (it == s.end()) return make_tuple(s1,s2,s3);  // no more data to parse
-      s3.reserve(s.size() - l1 - l2);
-      while (it != s.end()){
-        s3 += *(it++);
-      }
+      if (it == s.end()) return make_tuple(std::move(s1),std::move(s2),std::move(s3));  // no more data to parse
+      s3.assign(it, s.end());
 
-      return make_tuple(s1,s2,s3);  // no more data to parse
+      return make_tuple(std::move(s1),std::move(s2),std::move(s3));  // no more data to parse
     }
     static string serialize_3_strs(string_view s1, string_view s2,string_view s3) noexcept {
       string s;
@@ -237,7 +232,8 @@ namespace pure{
      */
     NaiveMsgMgr(string eep): ep(eep){}
     string prepare_msg(string && data)const noexcept override{
-      return SignedData(this->ep,"",data).toString();
+      // 🦜 : No need to build a SignedData, that would copy the data once more.
+      return SignedData::serialize_3_strs(this->ep,"",data);
     }
 
     optional<tuple<string,string>> tear_msg_open(string_view msg)const noexcept override {
@@ -245,7 +241,7 @@ namespace pure{
       SignedData d;
       if (not d.fromString(msg))
         return {};
-      return make_tuple(d.from,d.data);
+      return make_tuple(std::move(d.from),std::move(d.data));
     }
 
     string my_endpoint()const noexcept override{
@@ -412,7 +408,7 @@ namespace pure{
 
       string sig = SslMsgMgr::do_sign(this->my_secret_key.get(),data);
 
-      return SignedData(this->my_endpoint(),sig,data).toString();
+      return SignedData::serialize_3_strs(this->my_endpoint(),sig,data);
     }
 
     optional<tuple<string,string>> tear_msg_open(string_view msg)const noexcept override {
@@ -455,7 +451,7 @@ namespace pure{
         return {};
       }
 
-      return make_tuple(d.from,d.data);
+      return make_tuple(std::move(d.from),std::move(d.data));
     }
 
     string my_endpoint()const noexcept override{
@@ -118,7 +118,7 @@ namespace pure{
           return ;
         }
 
-        const auto [from,data] = r0.value();
+        auto & [from,data] = r0.value();
         BOOST_LOG_TRIVIAL(debug) << format("\tmsg unpacked, from=" S_BLUE "%s" S_NOR ",data=" S_GREEN "%s" S_NOR) % from % get_data_for_log(data);
         /*🦜 : Do we need to launch a thread to handle it ?
 
@@ -130,7 +130,7 @@ namespace pure{
 
           🦜 : In short, we can just call:
         */
-        f(from,data);
+        f(std::move(from),std::move(data));
       };
     }
 
@@ -14,6 +14,16 @@
  * there're two usable classes `WeakAsyncUnixHttpServer` and
  * `WeakAsyncTcpHttpServer`, and they are supposed to be stacked using
  * `MultiStackHttpServer`.
+ *
+ * [Update on 2024-06-03] 🦜 : The TCP server can now be sharded: there can be
+ * several acceptors bound to the same port (with SO_REUSEPORT), each one on its
+ * own io_context, so the kernel spreads the connections among them. Also, the
+ * handlers can be run on a separate `handler pool`, so a slow handler (e.g.
+ * `/add_txs` waiting for the consensus) won't occupy the io threads.
+ *
+ * [Update on 2024-07-29] 🦜 : A deferred handler (e.g. a long-poll subscriber,
+ * or `/call` running on its own pool) doesn't occupy any thread while it waits: the session is parked
+ * with its timer, and is woken up by whoever replies.
  */
 #pragma once
 
@@ -24,13 +34,21 @@
 // #include <boost/beast/version.hpp>
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_future.hpp>
 #include <filesystem>
 #include <memory>
+#include <type_traits>
 
 // 🦜 : if unix, we try to add the unix_domain_socket
 #ifdef __unix__
 #include <boost/asio/local/stream_protocol.hpp>
 #endif
+#if defined(__linux__)
+#include <sys/socket.h>         // for SO_PEERCRED
+#endif
 namespace pure{
 
   using std::unique_ptr;
@@ -59,13 +77,44 @@ namespace pure{
       http::message_generator handle_request(http::request<Body, http::basic_fields<Allocator>>&& req){
         // make Response --------------------------------------------------
         /*
-          🦜 : Here we use our old code
+          🦜 : Here we use our old code. The admission is done in on_read().
          */
-        return this->srv->handle_request(std::move(req),"<mock-client>",1234);
+        return this->srv->handle_request(std::move(req),this->client_addr,this->client_port,
+                                         true /*admitted*/);
       } // handle_request
 
+      /**
+       * @brief Figure out who is on the other side.
+       *
+       * 🐢 : For TCP, it's the remote address. For unix-domain socket, there's
+       * no address, so we use the uid of the peer process (where the OS tells
+       * us). This is used as the key of the per-client rate limit.
+       */
+      void identify_client() noexcept{
+        beast::error_code ec;
+        if constexpr (std::is_same_v<socket_t, tcp::socket>){
+          auto e = stream_.socket().remote_endpoint(ec);
+          if (not ec){
+            this->client_addr = e.address().to_string();
+            this->client_port = e.port();
+          }
+        }
+#if defined(__linux__)
+        else {
+          struct ucred cr;
+          socklen_t l = sizeof(cr);
+          if (getsockopt(stream_.socket().native_handle(), SOL_SOCKET, SO_PEERCRED, &cr, &l) == 0)
+            this->client_addr = "uid:" + std::to_string(cr.uid);
+        }
+#endif
+      }
+
+      string client_addr{"<unknown-client>"};
+      uint16_t client_port{0};
+
       // beast::tcp_stream
       stream_t stream_;
+      asio::steady_timer timer_; // <! the timeout of a parked (deferred) request
       beast::flat_buffer buffer_;
       // http::request<http::string_body> req_;
       unique_ptr<http::request_parser<http::string_body>> parser;
@@ -76,9 +125,10 @@ namespace pure{
       WeakAsyncHttpServerBase * const srv;
       // session(WeakAsyncHttpServerBase * const ssrv, tcp::socket&& socket)
       session(WeakAsyncHttpServerBase * const ssrv, socket_t&& socket)
-        : stream_(std::move(socket)),srv(ssrv){
+        : stream_(std::move(socket)),timer_(stream_.get_executor()),srv(ssrv){
         BOOST_LOG_TRIVIAL(debug) <<  "Session started";
         this->parser = new_parser();
+        this->identify_client();
       }
 
       static unique_ptr<http::request_parser<http::string_body>> new_parser(){
@@ -144,7 +194,95 @@ namespace pure{
           http::request<http::string_body> req = this->parser->release();
           this->parser = new_parser();
 
-          send_response(handle_request(std::move(req))); // 🦜 : this->parser.release() here to get the Message<>
+          /*
+            <2024-07-29 Mon> 🦜 : The deferred GETs (e.g. the long-poll
+            subscribers) are parked with our timer, no thread waits for them.
+           */
+          if (req.method() == http::verb::get){
+            auto dh = this->srv->getDeferredHandler(string(req.target()));
+            if (dh){
+              this->defer(std::move(req),
+                          [self = this->shared_from_this(), dh = std::move(dh.value())](shared_ptr<IDeferredReply> r){
+                            auto & [f, q] = dh;
+                            f(self->client_addr, self->client_port, q, r);
+                          });
+              return;
+            }
+          }
+
+          /*
+            <2024-07-15 Mon> 🦜 : The streaming GETs go their own way.
+
+            <2024-07-28 Sun> 🦜 : Only with a handler pool: stream_response()
+            waits for its writes, which are done by the io threads. Without a
+            pool, handle_request() collects the chunks instead.
+           */
+          if (req.method() == http::verb::get and this->srv->handler_pool){
+            auto sh = this->srv->getStreamHandler(string(req.target()));
+            if (sh){
+              auto job = [self = this->shared_from_this(), req = std::move(req), sh = std::move(sh.value())]() mutable {
+                bool keep_alive = self->stream_response(req, sh);
+                asio::dispatch(self->stream_.get_executor(), [self, keep_alive](){
+                  if (keep_alive) self->do_read();
+                  else self->do_close();
+                });
+              };
+              asio::post(*(this->srv->handler_pool), std::move(job));
+              return;
+            }
+          }
+
+          /*
+            <2024-07-28 Sun> 🦜 : Admit it here, on the io thread, before it's
+            queued. The Ticket is held until the handler returns, so the
+            requests waiting in the queue count as in flight too, and a
+            rejection is sent right away.
+           */
+          AdmissionController::Ticket ticket;
+          if (auto r = this->srv->admit(req, this->client_addr, ticket)){
+            send_response(std::move(r.value()));
+            return;
+          }
+
+          // <2024-07-29 Mon> 🦜 : The deferred POSTs (e.g. `/call`), the Ticket is held until replied.
+          if (req.method() == http::verb::post){
+            if (auto f = this->srv->getDeferredPostHandler(string(req.target()))){
+              string b = std::move(req.body());
+              this->defer(std::move(req),
+                          [self = this->shared_from_this(), f, b = std::move(b)](shared_ptr<IDeferredReply> r) mutable {
+                            f(self->client_addr, self->client_port, std::move(b), r);
+                          },
+                          std::move(ticket));
+              return;
+            }
+          }
+
+          if (not this->srv->handler_pool){
+            send_response(handle_request(std::move(req))); // 🦜 : this->parser.release() here to get the Message<>
+            return;
+          }
+
+          /*
+            🐢 : Hand the request to the handler pool, and when the response
+            is ready, come back to our strand to write it. The io thread is
+            free as soon as we return from here.
+           */
+          asio::post(*(this->srv->handler_pool),
+                     [self = this->shared_from_this(), req = std::move(req),
+                      ticket = std::move(ticket)]() mutable {
+                       try {
+                         http::message_generator msg = [&](){
+                           AdmissionController::Ticket t = std::move(ticket); // 🦜 : freed when handled
+                           return self->handle_request(std::move(req));
+                         }();
+                         asio::dispatch(self->stream_.get_executor(),
+                                        [self, msg = std::move(msg)]() mutable {
+                                          self->send_response(std::move(msg));
+                                        });
+                       } catch (std::exception & e){
+                         BOOST_LOG_TRIVIAL(error) << S_RED "❌️ failed " S_NOR "to handle request: " << e.what();
+                       }
+                     });
         } catch (std::exception & e){
           BOOST_LOG_TRIVIAL(error) << S_RED "❌️ failed " S_NOR "to read request: " << e.what();
         }
@@ -153,6 +291,13 @@ namespace pure{
       void send_response(http::message_generator&& msg){
         bool keep_alive = msg.keep_alive();
 
+        /*
+          🦜 : The timeout set in do_read() is still ticking, if the handler
+          took long (e.g. waiting on the consensus), the write would fail right
+          away. So give the write its own budget.
+         */
+        stream_.expires_after(std::chrono::seconds(30));
+
         // Write the response
         beast::async_write(
                            stream_,
@@ -160,6 +305,202 @@ namespace pure{
                            beast::bind_front_handler(&session::on_write, this->shared_from_this(), keep_alive));
       }
 
+      /**
+       * @brief The reply of a deferred handler, sent on our strand.
+       *
+       * 🐢 : It only has a weak_ptr to the session. The session is kept alive
+       * by the wait on its `timer_`, so a parked session goes away with the
+       * io_context, even if the reply is still kept by the handler.
+       */
+      class deferred_reply: public virtual IDeferredReply,
+                            public std::enable_shared_from_this<deferred_reply>{
+      public:
+        std::weak_ptr<session> ss;
+        http::request<http::string_body> req;
+        const bool is_pb;
+        std::atomic<bool> replied{false};
+        AdmissionController::Ticket ticket; // <! held until replied
+
+        deferred_reply(std::weak_ptr<session> s, http::request<http::string_body> && r,
+                       AdmissionController::Ticket && t):
+          ss(s), req(std::move(r)),
+          is_pb(string_view(req.target().data(), req.target().size()).substr(0, req.target().find('?')).ends_with("_pb")),
+          ticket(std::move(t)){}
+
+        bool reply(tuple<bool,string> r) noexcept override{
+          if (this->replied.exchange(true)) return false;
+          AdmissionController::Ticket t = std::move(this->ticket); // 🦜 : freed when replied
+          auto s = this->ss.lock();
+          if (not s) return true; // 🦜 : the server is closing
+          asio::dispatch(s->stream_.get_executor(),
+                         [s, me = this->shared_from_this(), r = std::move(r)]() mutable {
+                           s->timer_.cancel();
+                           auto & [ok, body] = r;
+                           s->send_response(WeakHttpServerBase::response_of(me->req, ok, std::move(body), me->is_pb));
+                         });
+          return true;
+        }
+
+        void expires_after(std::chrono::milliseconds t, function<void()> f) noexcept override{
+          auto s = this->ss.lock();
+          if (not s) return;
+          asio::dispatch(s->stream_.get_executor(),
+                         [s, me = this->shared_from_this(), t, f = std::move(f)]() mutable {
+                           if (not me->replied) s->park(me, t, std::move(f));
+                         });
+        }
+      };
+
+      /// How long a deferred handler can take, if it doesn't say.
+      static constexpr std::chrono::seconds DEFERRED_TIMEOUT{60};
+
+      /**
+       * @brief (Re)arm the timer of the parked reply `r`. If it's not replied
+       * within `t`, call `f`, and reply with an error if `f` didn't.
+       *
+       * 🐢 : Must run on our strand.
+       */
+      void park(shared_ptr<deferred_reply> r, std::chrono::milliseconds t, function<void()> f){
+        this->timer_.expires_after(t);
+        this->timer_.async_wait([self = this->shared_from_this(), r, f = std::move(f)](beast::error_code ec){
+          if (ec or r->replied) return; // 🦜 : cancelled or replied
+          if (f) f();
+          r->reply(make_tuple(false, "timed out"));
+        });
+      }
+
+      /**
+       * @brief Run a deferred handler (given the reply) with `h`, and leave
+       * the session parked until it replies.
+       *
+       * 🦜 : The handler is run on the handler pool if there's one (it may
+       * read the DB before deciding to wait), and it should return quickly.
+       *
+       * @param t The admission Ticket, kept until replied.
+       */
+      void defer(http::request<http::string_body> && req,
+                 function<void (shared_ptr<IDeferredReply>)> h,
+                 AdmissionController::Ticket && t = {}){
+        auto r = std::make_shared<deferred_reply>(this->weak_from_this(), std::move(req), std::move(t));
+        this->park(r, DEFERRED_TIMEOUT, {});
+
+        auto job = [r, h = std::move(h)](){
+          try {
+            h(r);
+          }catch (std::exception & e){
+            BOOST_LOG_TRIVIAL(error) << S_RED "❌️ failed " S_NOR "in deferred handler: " << e.what();
+            r->reply(make_tuple(false, "deferred handler failed"));
+          }
+        };
+        if (this->srv->handler_pool)
+          asio::post(*(this->srv->handler_pool), std::move(job));
+        else
+          job();
+      }
+
+      /// How long the client has to take each chunk (or the header).
+      static constexpr std::chrono::seconds CHUNK_TIMEOUT{30};
+
+      /**
+       * @brief Start an async write with `initiate` (given asio::use_future),
+       * and wait for it, CHUNK_TIMEOUT at most.
+       *
+       * 🐢 : A client that doesn't read would block a sync write forever, and
+       * the thread with it. The async one has the stream's timer, which
+       * closes the socket when it's due.
+       */
+      template<typename F>
+      bool write_within(F initiate, beast::error_code & ec){
+        this->stream_.expires_after(CHUNK_TIMEOUT);
+        try {
+          initiate().get();
+        }catch (boost::system::system_error & e){
+          ec = e.code();
+        }
+        this->stream_.expires_never();
+        if (ec)
+          BOOST_LOG_TRIVIAL(debug) << format("⚠️ failed to stream to %s: %s") % this->client_addr % ec.message();
+        return not ec;
+      }
+
+      /**
+       * @brief Run a streaming handler, and send what it writes as chunks.
+       *
+       * 🐢 : This blocks (it waits for each write), so it must run on the
+       * handler pool, never on an io thread. No other operation is pending on
+       * the stream meanwhile, since we don't read the next request until this
+       * one is done.
+       *
+       * 🦜 : The header goes with the first chunk. If the handler fails before
+       * that, the client gets a 400 with the error. If it fails halfway, we
+       * close the connection without the last chunk, so that the client can
+       * tell the body is cut (and resume).
+       *
+       * @return whether we should keep the connection alive.
+       */
+      bool stream_response(const http::request<http::string_body> & req,
+                           tuple<streamHandler_t,optional<unordered_map<string,string>>> & sh){
+        auto & [f, q] = sh;
+        beast::error_code ec;
+
+        http::response<http::empty_body> res{http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type,
+                string_view(req.target()).substr(0, req.target().find('?')).ends_with("_pb") ?
+                "application/x-protobuf" : "application/x-ndjson");
+        res.chunked(true);
+        res.keep_alive(req.keep_alive());
+        http::response_serializer<http::empty_body> sr{res};
+
+        bool started = false;   // <! whether the header is sent
+        auto start = [this, &sr, &ec, &started]() -> bool{
+          if (started) return not ec;
+          started = true;
+          return this->write_within([&](){
+            return http::async_write_header(this->stream_, sr, asio::use_future);
+          }, ec);
+        };
+
+        auto write = [this, &ec, &start](string_view c) -> bool{
+          if (c.empty()) return not ec;
+          if (not start()) return false;
+          return this->write_within([&](){
+            return asio::async_write(this->stream_, http::make_chunk(asio::buffer(c.data(), c.size())),
+                                     asio::use_future);
+          }, ec);
+        };
+
+        bool ok = false;
+        string err{"streaming handler failed"};
+        try {
+          string e;
+          std::tie(ok, e) = f(this->client_addr, this->client_port, q, write);
+          if (not e.empty()) err = std::move(e);
+        }catch (std::exception & e){
+          BOOST_LOG_TRIVIAL(error) << S_RED "❌️ failed " S_NOR "in streaming handler: " << e.what();
+        }
+        if (ec) return false;
+
+        if ((not ok) and (not started)){
+          // 🦜 : nothing sent yet, so we can still say what's wrong
+          http::response<http::string_body> r{http::status::bad_request, req.version()};
+          r.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+          r.set(http::field::content_type, "text/html");
+          r.keep_alive(req.keep_alive());
+          r.body() = std::move(err);
+          r.prepare_payload();
+          return this->write_within([&](){
+            return http::async_write(this->stream_, r, asio::use_future);
+          }, ec) and req.keep_alive();
+        }
+        if (not ok) return false;
+
+        if (not start()) return false; // 🦜 : an empty body
+        return this->write_within([&](){
+          return asio::async_write(this->stream_, http::make_chunk_last(), asio::use_future);
+        }, ec) and req.keep_alive();
+      }
+
       void on_write(
                     bool keep_alive,
                     beast::error_code ec,
@@ -206,9 +547,17 @@ namespace pure{
       acceptor_t acceptor_;
       WeakAsyncHttpServerBase * const srv;
     public:
+      /**
+       * @brief Construct a listener
+       *
+       * @param reuse_port Whether to set SO_REUSEPORT, this allows several
+       * listeners bind to the same port, and the kernel will load-balance the
+       * connections among them.
+       */
       listener(WeakAsyncHttpServerBase * const ssrv,
                asio::io_context& ioc,
-               endpoint_t endpoint
+               endpoint_t endpoint,
+               bool reuse_port = false
                ) : ioc_(ioc) , acceptor_(asio::make_strand(ioc)), srv(ssrv){
         BOOST_LOG_TRIVIAL(debug) <<  "listener started";
         beast::error_code ec;
@@ -225,6 +574,17 @@ namespace pure{
           fail(ec, "failed in set_option");
         }
 
+#if defined(SO_REUSEPORT)
+        if (reuse_port){
+          acceptor_.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+          if(ec){
+            fail(ec, "failed to set SO_REUSEPORT");
+          }
+        }
+#else
+        boost::ignore_unused(reuse_port);
+#endif
+
         // Bind to the server address
         acceptor_.bind(endpoint, ec);
         if(ec){
@@ -269,44 +629,78 @@ namespace pure{
     };                            // class listener
     //------------------------------------------------------------------------------
 
-    std::unique_ptr<asio::io_context> ioc;
+    /*
+      🐢 : One io_context per acceptor shard. Usually there's only one shard,
+      but for TCP we can have more (see `WeakAsyncTcpHttpServer`).
+     */
+    vector<std::unique_ptr<asio::io_context>> iocs;
     vector<std::jthread> * all_threads;
-    std::shared_ptr<listener> lstn;
+    vector<std::shared_ptr<listener>> lstns;
     int n_threads;
+    /*
+      🐢 : If set, the handlers are run here instead of on the io threads.
+     */
+    std::unique_ptr<asio::thread_pool> handler_pool;
+
+    static constexpr bool can_reuse_port(){
+#if defined(SO_REUSEPORT)
+      return true;
+#else
+      return false;
+#endif
+    }
 
-    // WeakAsyncHttpServerBase(unsigned short port = 7777, const int threads = 4){
-    WeakAsyncHttpServerBase(const int threads = 4):
-      n_threads(threads) {
+    /**
+     * @brief Construct the server base
+     *
+     * @param threads The total number of io threads, they are spread among the shards.
+     * @param n_shards The number of io_contexts (one per acceptor).
+     * @param handler_threads The size of the handler pool. If 0, the handlers
+     * are run on the io threads (the old behaviour).
+     */
+    WeakAsyncHttpServerBase(const int threads = 4, const int n_shards = 1, const int handler_threads = 0):
+      n_threads(std::max(threads, std::max(n_shards, 1))) {
       /*
         🦜 : Usually you don't wanna set threads to be 1.... It does block
         sometimes. And set it to something like 2 usually will work...
        */
 
-      // BOOST_LOG_TRIVIAL(debug) <<  "🐸 acceptor start listening on port " << port;
       // The io_context is required for all I/O
-      this->ioc = std::make_unique<asio::io_context>(threads);
-      // Create and launch a listening port
+      const int n = std::max(n_shards, 1);
+      for (int i = 0; i < n; i++)
+        this->iocs.push_back(std::make_unique<asio::io_context>(std::max(this->n_threads / n, 1)));
 
+      if (handler_threads > 0)
+        this->handler_pool = std::make_unique<asio::thread_pool>(handler_threads);
     }
 
     bool run_called = false;
     void run(){
       this->run_called = true;
-      // Run the I/O service on the requested number of threads
+      // Run the I/O services on the requested number of threads, round-robin among the shards.
       this->all_threads = new vector<std::jthread>();
       this->all_threads->reserve(n_threads);
-      for(auto i = n_threads; i > 0; --i)
-        this->all_threads->emplace_back([this] {this->ioc->run();});
+      for(auto i = n_threads; i > 0; --i){
+        asio::io_context * c = this->iocs[i % this->iocs.size()].get();
+        this->all_threads->emplace_back([c] {c->run();});
+      }
     }
 
     virtual ~WeakAsyncHttpServerBase(){
       BOOST_LOG_TRIVIAL(debug) << "👋🐸 Server closed";
+      if (this->handler_pool){
+        // 🦜 : wait for the running handlers first, they might still post to the iocs.
+        this->handler_pool->stop();
+        this->handler_pool->join();
+      }
       if (this->run_called){
         // 🦜 : we need to stop it only if it's running, otherwise we got
         // memory-access-violation, the worst kind of error.
-        this->ioc->stop();
+        for (auto & c : this->iocs)
+          c->stop();
         // BOOST_LOG_TRIVIAL(debug) <<  "👋🐸 ioc stopped";
         this->all_threads->clear(); // join them all
+        delete this->all_threads;
         // BOOST_LOG_TRIVIAL(debug) <<  "👋🐸 all threads joined";
       }
     }
@@ -318,13 +712,32 @@ namespace pure{
                                                                             /*endpoint_t*/ tcp::endpoint
                                                                             >{
   public:
-    WeakAsyncTcpHttpServer(unsigned short port = 7777, const int threads = 4):
-      WeakAsyncHttpServerBase(threads){
-      BOOST_LOG_TRIVIAL(debug) <<  S_GREEN "\t🐸 TCP acceptor" S_NOR " starts listening on port " S_GREEN << port << S_NOR;
+    /**
+     * @brief Start a TCP server
+     *
+     * @param port The port to listen
+     * @param threads The total number of io threads
+     * @param acceptors The number of acceptors bound to `port` (each with its
+     * own io_context). More than one requires SO_REUSEPORT, otherwise we fall
+     * back to one.
+     * @param handler_threads The size of the handler pool, 0 means running the
+     * handlers on the io threads.
+     */
+    WeakAsyncTcpHttpServer(unsigned short port = 7777, const int threads = 4,
+                           const int acceptors = 1, const int handler_threads = 0):
+      WeakAsyncHttpServerBase(threads, can_reuse_port() ? acceptors : 1, handler_threads){
+      BOOST_LOG_TRIVIAL(debug) <<  S_GREEN "\t🐸 TCP acceptor" S_NOR " starts listening on port " S_GREEN << port << S_NOR
+                               << format(" with %d acceptor(s), %d io thread(s) and %d handler thread(s)")
+        % this->iocs.size() % this->n_threads % handler_threads;
+      if (acceptors > 1 and not can_reuse_port())
+        BOOST_LOG_TRIVIAL(warning) << "⚠️ SO_REUSEPORT is not supported on this platform, using only one acceptor";
+
       auto const address = asio::ip::make_address("0.0.0.0");
-      this->lstn = std::make_shared<listener>(this,*ioc, tcp::endpoint{address, port});
-      // this->lstn = std::make_shared<listener>(this,*ioc, unix_domain::stream_protocol::endpoint{"/tmp/hi.sock"});
-      this->lstn->run();
+      for (auto & c : this->iocs){
+        this->lstns.push_back(std::make_shared<listener>(this,*c, tcp::endpoint{address, port},
+                                                         this->iocs.size() > 1 /*reuse_port*/));
+        this->lstns.back()->run();
+      }
       this->run();
     }
     // virtual ~WeakAsyncTcpHttpServer(){
@@ -348,8 +761,8 @@ namespace pure{
                                                                               >{
   public:
     path pp;
-    WeakAsyncUnixHttpServer(path p = "/tmp/hi.sock", const int threads = 4):
-      WeakAsyncHttpServerBase(threads), pp(p){
+    WeakAsyncUnixHttpServer(path p = "/tmp/hi.sock", const int threads = 4, const int handler_threads = 0):
+      WeakAsyncHttpServerBase(threads, 1 /*🦜 : one socket file, one acceptor*/, handler_threads), pp(p){
       BOOST_LOG_TRIVIAL(debug) <<  S_GREEN "\t🐸 Unix-domain socket acceptor" S_NOR " starts listening on  " S_GREEN << p << S_NOR;
 
       // remove the file if it exists
@@ -358,8 +771,8 @@ namespace pure{
         std::filesystem::remove(p);
       }
 
-      this->lstn = std::make_shared<listener>(this,*ioc, unix_domain::stream_protocol::endpoint{p.string()});
-      this->lstn->run();
+      this->lstns.push_back(std::make_shared<listener>(this,*(this->iocs[0]), unix_domain::stream_protocol::endpoint{p.string()}));
+      this->lstns.back()->run();
       this->run();
     }
 
@@ -38,6 +38,11 @@ using std::string_view;
 using std::string;
 
 #include <filesystem>
+
+#if defined (WITH_PROTOBUF)
+#include <google/protobuf/arena.h>
+#endif
+
 namespace pure{
 
   using std::vector;
@@ -86,6 +91,31 @@ namespace pure{
 
   namespace json = boost::json;
   using json::value_to;
+
+#if defined (WITH_PROTOBUF)
+  /**
+   * @brief The options of a pb Arena for parsing an input of `n` bytes.
+   *
+   * <2024-07-28 Sun> 🦜 : Without an Arena, parsing a Blk of 10k Txs makes a
+   * heap node for every message and every string field (~10 per Tx), and then
+   * frees them one by one. On an Arena, they're carved out of a few big blocks
+   * (the first one sized after the input) and freed all at once when the Arena
+   * goes. Only the long strings are still malloc()ed.
+   *
+   * 🐢 : An Arena has a cost of its own (the first block), which small inputs
+   * (an Acn, a Tx) don't win back. So only those of at least PB_ARENA_MIN
+   * bytes are parsed on one, see ISerializableInPb::fromPbString().
+   */
+  constexpr size_t PB_ARENA_MIN = 4096;
+
+  inline google::protobuf::ArenaOptions pbArenaOptions(size_t n) noexcept{
+    google::protobuf::ArenaOptions o;
+    o.start_block_size = std::clamp<size_t>(n * 2, 256, size_t{64} << 20);
+    o.max_block_size = std::max<size_t>(o.start_block_size, size_t{8} << 20);
+    return o;
+  }
+#endif
+
   /**
    * @brief Representing a Jsonizable type. Client only need to implement two methods
    * fromJson() and toJson(), then it will get two methods for Json string.
@@ -155,8 +185,22 @@ namespace pure{
     virtual T toPb() const = 0;
 
     bool fromPbString(string_view s) noexcept{
+#if defined (WITH_PROTOBUF)
+      // 🦜 : the pb only lives for this call, see pbArenaOptions()
+      if (s.size() >= PB_ARENA_MIN){
+        google::protobuf::Arena arena{pbArenaOptions(s.size())};
+        return this->fromPbString(s, *google::protobuf::Arena::CreateMessage<T>(&arena));
+      }
+#endif
       T pb;
-      if (!pb.ParseFromString(string(s))){
+      return this->fromPbString(s, pb);
+    }
+
+    /**
+     * @brief Parse `s` into `pb`, then fromPb() it.
+     */
+    bool fromPbString(string_view s, T & pb) noexcept{
+      if (!pb.ParseFromArray(s.data(), static_cast<int>(s.size()))){
         BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ error parsing pb" S_NOR);
         return false;
       }
@@ -287,3 +331,22 @@ void boost::assertion_failed(char const * expr, char const * function, char cons
     return IJsonizable::fromJsonString(s);          \
   }
 #endif
+
+/**
+ * @brief ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB
+ *
+ *   <2024-07-27 Sat> 🦜 : The same, for the types that also have the binary
+ *   codec (toBinString() and fromBinString(), see binCodec.hpp): Tx, Blk and
+ *   ExecBlk. With WITH_BIN_CODEC, they're what toString() and fromString() use.
+ */
+#if WITH_BIN_CODEC
+#define ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB         \
+  string toString() const noexcept override {       \
+    return this->toBinString();                     \
+  }                                                 \
+  bool fromString(string_view s) noexcept override{ \
+    return this->fromBinString(s);                  \
+  }
+#else
+#define ADD_TO_FROM_STR_WITH_BIN_JSON_OR_PB ADD_TO_FROM_STR_WITH_JSON_OR_PB
+#endif
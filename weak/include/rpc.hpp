@@ -8,6 +8,8 @@
 #include "core.hpp"
 #include "net/pure-httpCommon.hpp"
 #include "forPostExec.hpp"
+#include "blkFeed.hpp"
+#include "blkCache.hpp"
 
 
 
@@ -29,8 +31,33 @@ namespace weak{
     using postHandler_t = function<tuple<bool,string> (string_view)>;
     using getHandler_t = function<tuple<bool,string> (optional<unordered_map<string,string>> // the query param
                                                       )>;
+    using chunkWriter_t = function<bool (string_view)>;
+    using streamHandler_t = function<tuple<bool,string> (optional<unordered_map<string,string>>, // the query param
+                                           const chunkWriter_t & // the writer
+                                           )>;
   virtual bool listenToPost(string target,postHandler_t h)noexcept=0;
   virtual bool listenToGet(string target,getHandler_t h)noexcept=0;
+    /**
+     * @brief Listen with a streaming GET handler. <2024-07-15 Mon> 🦜 : Not
+     * every server can stream, so the default says no.
+     */
+    virtual bool listenToGetStream(string /*target*/,streamHandler_t /*h*/)noexcept {return false;}
+
+    using IDeferredReply = ::pure::IDeferredReply;
+    using deferredGetHandler_t = function<void (optional<unordered_map<string,string>>, // the query param
+                                                shared_ptr<IDeferredReply> // the reply
+                                                )>;
+    /**
+     * @brief Listen with a deferred GET handler, which replies later (see
+     * IDeferredReply). <2024-07-29 Mon> 🦜 : The default says no, then the
+     * blocking handler is used.
+     */
+    virtual bool listenToGetDeferred(string /*target*/,deferredGetHandler_t /*h*/)noexcept {return false;}
+
+    using deferredPostHandler_t = function<void (string, // the body
+                                                 shared_ptr<IDeferredReply> // the reply
+                                                 )>;
+    virtual bool listenToPostDeferred(string /*target*/,deferredPostHandler_t /*h*/)noexcept {return false;}
   };
 
   /**
@@ -45,6 +72,13 @@ namespace weak{
    *   + GET /get_pool_status
    *   + GET /get_receipt
    *   + GET /get_node_status
+   *   + GET /get_latest_Blk_pb, /get_blk_pb, /get_receipt_pb, /get_tx_pb, /get_pool_status_pb
+   *   + POST /get_receipts, /get_txs, /get_blks (and the `_pb` versions)
+   *   + GET /export_blks, /export_blks_pb (streaming)
+   *   + GET /subscribe_blks       (long-poll, only if a BlkFeed is given)
+   *   + GET /subscribe_receipt    (long-poll, only if a BlkFeed is given)
+   *   + POST /call                (read-only contract call, only if an IForRpcCallable is given)
+   *   + GET /get_acn, /get_storage (only if an IAcnGettableAt is given)
    */
   class Rpc {
   public:
@@ -53,13 +87,40 @@ namespace weak{
     IForRpc * const pool;         // <! The pool state
     IChainDBGettable * const wrld; // <! The world
     ITxVerifiable * const verifier; // <! The verifier
+    BlkFeed * const feed;           // <! The feed of committed Blks, for the subscribers
+    BlkCache * const blk_cache;     // <! The rendered Blks, optional
+    IForRpcCallable * const caller; // <! The read-only contract caller, optional
+    IAcnGettableAt * const acns;    // <! The Acns (as of a Blk), optional
+
+    /*
+      🦜 : How long can a subscriber wait at most ? We keep it below the usual
+      30s idle-timeout of proxies (and of our own server).
+     */
+    static constexpr uint64_t MAX_WAIT_MS = 25'000;
+    static constexpr uint64_t DEFAULT_WAIT_MS = 10'000;
+
+    static constexpr size_t MAX_BATCH = 1024; // <! max number of keys in a batched get
+    static constexpr uint64_t EXPORT_PAGE = 64;     // <! Blks read (and sent) at a time by /export_blks
+    /*
+      <2024-07-28 Sun> 🦜 : max number of Blks in one /get_blks. A Blk can be
+      big and the whole reply is built in memory, so it's a page of
+      /export_blks, which streams. Use that one for a range.
+     */
+    static constexpr size_t MAX_BLK_BATCH = EXPORT_PAGE;
+    static constexpr uint64_t MAX_EXPORT = 10'000;  // <! max Blks sent by one /export_blks
+    static constexpr size_t DEFAULT_STORAGE_PAGE = 100; // <! slots returned by /get_storage by default
+    static constexpr size_t MAX_STORAGE_PAGE = 1000;    // <! max slots returned by one /get_storage
 
     Rpc(IForRpcNetworkable * const n,
         IForRpcTxsAddable * const c,
         IChainDBGettable * const w=nullptr,
         IForRpc * const p =nullptr,
-        ITxVerifiable * const v = nullptr
-        ): cnsss(c), srv(n), pool(p), wrld(w), verifier(v){
+        ITxVerifiable * const v = nullptr,
+        BlkFeed * const f = nullptr,
+        BlkCache * const bc = nullptr,
+        IForRpcCallable * const ce = nullptr,
+        IAcnGettableAt * const a = nullptr
+        ): cnsss(c), srv(n), pool(p), wrld(w), verifier(v), feed(f), blk_cache(bc), caller(ce), acns(a){
 
       if (w == nullptr)
         BOOST_LOG_TRIVIAL(warning) << format( "⚠️ Warining: no " S_MAGENTA "IChainDBGettable" S_NOR " passed to rpc. Should be in unit-test");
@@ -75,6 +136,399 @@ namespace weak{
       n->listenToGet("/get_node_status",bind(&Rpc::handle_get_node_status,this,_1));
       n->listenToGet("/get_tx",bind(&Rpc::handle_get_tx,this,_1));
       n->listenToGet("/get_blk",bind(&Rpc::handle_get_Blk,this,_1));
+      n->listenToGet("/get_tx_proof",bind(&Rpc::handle_get_tx_proof,this,_1));
+      // <2024-07-12 Fri> 🦜 : the pb versions of the getters, also used for
+      // `Accept: application/x-protobuf` (see WeakHttpServerBase::handle_request())
+      n->listenToGet("/get_latest_Blk_pb",bind(&Rpc::handle_get_latest_Blk_pb,this,_1));
+      n->listenToGet("/get_blk_pb",bind(&Rpc::handle_get_Blk_pb,this,_1));
+      n->listenToGet("/get_receipt_pb",bind(&Rpc::handle_get_receipt_pb,this,_1));
+      n->listenToGet("/get_tx_pb",bind(&Rpc::handle_get_tx_pb,this,_1));
+      n->listenToGet("/get_pool_status_pb",bind(&Rpc::handle_get_pool_status_pb,this,_1));
+
+      // <2024-07-10 Wed> 🦜 : the batched getters
+      n->listenToPost("/get_receipts",bind(&Rpc::handle_get_receipts,this,_1));
+      n->listenToPost("/get_receipts_pb",bind(&Rpc::handle_get_receipts_pb,this,_1));
+      n->listenToPost("/get_txs",bind(&Rpc::handle_get_txs,this,_1));
+      n->listenToPost("/get_txs_pb",bind(&Rpc::handle_get_txs_pb,this,_1));
+      n->listenToPost("/get_blks",bind(&Rpc::handle_get_blks,this,_1));
+      n->listenToPost("/get_blks_pb",bind(&Rpc::handle_get_blks_pb,this,_1));
+
+      // <2024-07-15 Mon> 🦜 : the streaming export
+      n->listenToGetStream("/export_blks",bind(&Rpc::handle_export_blks,this,_1,_2));
+      n->listenToGetStream("/export_blks_pb",bind(&Rpc::handle_export_blks_pb,this,_1,_2));
+
+      if (f){
+        // <2024-07-29 Mon> 🦜 : parked without a thread if the server can, otherwise blocking
+        if (not n->listenToGetDeferred("/subscribe_blks",bind(&Rpc::handle_subscribe_blks_deferred,this,_1,_2)))
+          n->listenToGet("/subscribe_blks",bind(&Rpc::handle_subscribe_blks,this,_1));
+        if (not n->listenToGetDeferred("/subscribe_receipt",bind(&Rpc::handle_subscribe_receipt_deferred,this,_1,_2)))
+          n->listenToGet("/subscribe_receipt",bind(&Rpc::handle_subscribe_receipt,this,_1));
+      }
+
+      if (ce){
+        // <2024-07-29 Mon> 🦜 : replied from the CallExecutor's pool if the server can
+        if (not n->listenToPostDeferred("/call",bind(&Rpc::handle_call_deferred,this,_1,_2)))
+          n->listenToPost("/call",bind(&Rpc::handle_call,this,_1));
+      }
+
+      if (a){
+        n->listenToGet("/get_acn",bind(&Rpc::handle_get_acn,this,_1));
+        n->listenToGet("/get_storage",bind(&Rpc::handle_get_storage,this,_1));
+      }
+    }
+
+    /**
+     * @brief Get the Acn at `addr` (as of Blk `n`, optional).
+     *
+     * @return (the Acn, error msg if no Acn)
+     */
+    tuple<optional<Acn>,string> get_acn_at(const optional<unordered_map<string,string>> & q, const string & what,
+                                           bool with_code = false){
+      optional<Acn> emp;
+      if ((not q) or (not q.value().contains("addr")))
+        return make_tuple(emp, "Error: `" + what + "` should be used with query parameter `addr=<address>`\n");
+      optional<address> a = evmc::from_hex<address>(q.value().at("addr"));
+      if (not a)
+        return make_tuple(emp, "Error: `addr` " + q.value().at("addr") + " is ill-formed");
+
+      auto [ok, rN, err_msg] = parse_optional_n(q);
+      if (not ok) return make_tuple(emp, err_msg);
+
+      shared_ptr<IAcnGettable> w = this->acns->acnsAt(rN ? optional<uint64_t>(rN.value()) : optional<uint64_t>());
+      if (not w)
+        return make_tuple(emp, (format("Error: the state as of Blk %d is not available") % rN.value_or(0)).str());
+      optional<Acn> r = w->getAcn(a.value());
+      if (not r)
+        return make_tuple(emp, "Error: Acn " + q.value().at("addr") + " not found");
+      if (with_code) w->codeOf(r.value()); // 🦜 : while `w` is still here
+      return make_tuple(r, "");
+    }
+
+    /**
+     * @brief Get the summary of an Acn.
+     *
+     *     curl 'http://localhost:7777/get_acn?addr=<address>&n=<Blk number>'
+     *
+     * The result is like
+     * `{"nonce":0,"codehash":"..","code_size":1234,"storage_size":3,"disk_storage_size":0}`.
+     *
+     * 🐢 : The code and the storage are not included, they can be big. Use
+     * `/get_storage` for the storage.
+     */
+    tuple<bool,string> handle_get_acn(optional<unordered_map<string,string>> query_param){
+      auto [r, err_msg] = get_acn_at(query_param, "/get_acn", true /*with code*/);
+      if (not r) return make_tuple(false, err_msg);
+      const Acn & a = r.value();
+      json::object o;
+      o["nonce"] = a.nonce;
+      o["codehash"] = hashToString(a.codehash());
+      o["code_size"] = a.codeView().size();
+      o["storage_size"] = a.storage.size();
+      o["disk_storage_size"] = a.disk_storage.size();
+      return make_tuple(true, json::serialize(o));
+    }
+
+    /**
+     * @brief Page through the storage slots of an Acn, ordered by the slot.
+     *
+     *     curl 'http://localhost:7777/get_storage?addr=<address>&from=<slot>&limit=100&n=<Blk number>'
+     *
+     * returns the slots >= `from` (at most `limit`, capped by MAX_STORAGE_PAGE) like
+     *
+     *     {"slots":[{"k":"00..01","v":"00..7b"},..],"next":"00..05"}
+     *
+     * The client should pass `next` as the next `from`, it's null on the last
+     * page.
+     */
+    tuple<bool,string> handle_get_storage(optional<unordered_map<string,string>> query_param){
+      auto [r, err_msg] = get_acn_at(query_param, "/get_storage");
+      if (not r) return make_tuple(false, err_msg);
+      const unordered_map<string,string> & q = query_param.value();
+
+      bytes32 from{};
+      if (q.contains("from")){
+        optional<bytes32> f = evmc::from_hex<bytes32>(q.at("from"));
+        if (not f) return make_tuple(false, "Error: `from` " + q.at("from") + " is ill-formed");
+        from = f.value();
+      }
+
+      size_t limit = DEFAULT_STORAGE_PAGE;
+      if (q.contains("limit")){
+        auto [rL, err_msg1] = parse_positive_int(q.at("limit"));
+        if (not rL) return make_tuple(false, err_msg1);
+        limit = std::min(static_cast<size_t>(rL.value()), MAX_STORAGE_PAGE);
+      }
+
+      auto [slots, next] = page_of_storage(r.value().storage, from, limit);
+      json::array a;
+      for (const auto & [k, v] : slots)
+        a.emplace_back(json::object{{"k", evmc::hex(k)}, {"v", evmc::hex(v)}});
+      json::object o;
+      o["slots"] = a;
+      o["next"] = next ? json::value(evmc::hex(next.value())) : json::value(nullptr);
+      return make_tuple(true, json::serialize(o));
+    }
+
+    /**
+     * @brief Get the slots >= `from`, at most `limit` of them, in order.
+     *
+     * @return (the slots, the slot that starts the next page if any)
+     *
+     * 🦜 : We only sort what we return, so a page costs O(S + limit log limit)
+     * for a storage of size S.
+     */
+    static tuple<vector<tuple<bytes32,bytes32>>,optional<bytes32>>
+    page_of_storage(const unordered_map<bytes32,bytes32> & s, const bytes32 & from, size_t limit) noexcept{
+      vector<tuple<bytes32,bytes32>> v;
+      for (const auto & [k, x] : s)
+        if (not (k < from)) v.emplace_back(k, x);
+
+      auto by_k = [](const tuple<bytes32,bytes32> & l, const tuple<bytes32,bytes32> & r){
+        return std::get<0>(l) < std::get<0>(r);
+      };
+      optional<bytes32> next;
+      if (v.size() > limit){
+        std::nth_element(v.begin(), v.begin() + limit, v.end(), by_k);
+        next = std::get<0>(v[limit]);
+        v.resize(limit);
+      }
+      std::sort(v.begin(), v.end(), by_k);
+      return make_tuple(v, next);
+    }
+
+    /**
+     * @brief Call a contract without making a Tx (read-only).
+     *
+     * For example:
+     *
+     *     curl http://localhost:7777/call -d '{"from":"01","to":"<contract addr>","data":"6d4ce63c","gas":100000}'
+     *
+     * `from` and `gas` are optional. <2024-07-19 Fri> 🦜 : Also `"n":<Blk number>`
+     * calls against the state as of that Blk (if still kept). The result is like
+     * `{"ok":true,"status":"success","result":"<output hex>","gas_used":2404}`.
+     *
+     * 🐢 : The call runs against a snapshot of the stateDB, and whatever it
+     * changes is dropped. See CallExecutor.
+     */
+    tuple<bool,string> handle_call(string_view data){
+      auto [c, err_msg] = parse_call(data);
+      if (not c) return make_tuple(false, err_msg);
+      auto & [from, to, input, gas, n] = c.value();
+      return this->caller->callForRpc(from, to, std::move(input), gas, n);
+    }
+
+    /**
+     * @brief The same as handle_call(), but `reply` is filled by the
+     * IForRpcCallable (e.g. from the pool of the CallExecutor).
+     */
+    void handle_call_deferred(string data, shared_ptr<::pure::IDeferredReply> reply){
+      auto [c, err_msg] = parse_call(data);
+      if (not c){
+        reply->reply(make_tuple(false, err_msg));
+        return;
+      }
+      auto & [from, to, input, gas, n] = c.value();
+      this->caller->callForRpcAsync(from, to, std::move(input), gas, n,
+                                    [reply](tuple<bool,string> r){reply->reply(std::move(r));});
+    }
+
+    using call_t = tuple<address,address,bytes,optional<int64_t>,optional<uint64_t>>; // <! (from, to, data, gas, n)
+
+    /**
+     * @brief Parse the body of `/call`.
+     *
+     * @return (the call, error msg if ill-formed)
+     */
+    static tuple<optional<call_t>,string> parse_call(string_view data) noexcept{
+      address from, to;
+      bytes input;
+      optional<int64_t> gas;
+      optional<uint64_t> n;
+      try{
+        json::object o = json::parse(data).as_object();
+        if (o.contains("from")){
+          optional<address> a = evmc::from_hex<address>(json::value_to<string>(o.at("from")));
+          if (not a) return make_tuple(optional<call_t>(), "Error: `from` is ill-formed");
+          from = a.value();
+        }
+
+        optional<address> a = evmc::from_hex<address>(json::value_to<string>(o.at("to")));
+        if ((not a) or evmc::is_zero(a.value()))
+          return make_tuple(optional<call_t>(), "Error: `to` should be the address of a contract");
+        to = a.value();
+
+        if (o.contains("data")){
+          optional<bytes> b = evmc::from_hex(json::value_to<string>(o.at("data")));
+          if (not b) return make_tuple(optional<call_t>(), "Error: `data` is ill-formed");
+          input = b.value();
+        }
+
+        if (o.contains("gas")){
+          gas = json::value_to<int64_t>(o.at("gas"));
+          if (gas.value() <= 0) return make_tuple(optional<call_t>(), "Error: `gas` should be positive");
+        }
+
+        if (o.contains("n"))
+          n = json::value_to<uint64_t>(o.at("n"));
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(debug) << format("❌️ Error parsing call: %s") % e.what();
+        return make_tuple(optional<call_t>(), R"(Expecting a JSON like {"to":"<contract addr>","data":"<hex>"})");
+      }
+
+      return make_tuple(optional<call_t>(make_tuple(from, to, std::move(input), gas, n)), "");
+    }
+
+    /**
+     * @brief Parse the `timeout` (in ms) query param, clamped to MAX_WAIT_MS.
+     */
+    static std::chrono::milliseconds parse_timeout(const optional<unordered_map<string,string>> & q) noexcept{
+      uint64_t t = DEFAULT_WAIT_MS;
+      if (q and q.value().contains("timeout")){
+        optional<int> r;
+        std::tie(r, std::ignore) = parse_positive_int(q.value().at("timeout"));
+        if (r) t = static_cast<uint64_t>(r.value());
+      }
+      return std::chrono::milliseconds(std::min(t, MAX_WAIT_MS));
+    }
+
+    /**
+     * @brief Parse the `after` query param of /subscribe_blks.
+     *
+     * @return (ok, after, error msg if not ok)
+     */
+    static tuple<bool,optional<uint64_t>,string> parse_after(const optional<unordered_map<string,string>> & q) noexcept{
+      if (not (q and q.value().contains("after")))
+        return make_tuple(true, optional<uint64_t>(), "");
+      auto [r, err_msg] = parse_positive_int(q.value().at("after"));
+      if (not r) return make_tuple(false, optional<uint64_t>(), err_msg);
+      return make_tuple(true, optional<uint64_t>(static_cast<uint64_t>(r.value())), "");
+    }
+
+    /**
+     * @brief Wait for new Blks (long-poll).
+     *
+     * For example:
+     *
+     *     curl 'http://localhost:7777/subscribe_blks?after=3&timeout=20000'
+     *
+     * will return as soon as there's a Blk with number > 3 (or after 20s). The
+     * result is like `{"latest":4,"blks":[{"number":4,"hash":..,"tx_hashes":[..]}]}`.
+     * Without `after`, it waits for the next Blk. The client should use the
+     * returned `latest` as the next `after`.
+     *
+     * 🐢 : This one blocks the thread, the server uses
+     * handle_subscribe_blks_deferred() if it can.
+     */
+    tuple<bool,string> handle_subscribe_blks(optional<unordered_map<string,string>> query_param){
+      auto [ok, after, err_msg] = parse_after(query_param);
+      if (not ok) return make_tuple(false, err_msg);
+
+      optional<string> r = this->feed->wait_for_blks(after, parse_timeout(query_param));
+      if (not r)
+        return make_tuple(false, "Too many subscribers, please try again later.");
+      return make_tuple(true, r.value());
+    }
+
+    /**
+     * @brief The same as handle_subscribe_blks(), but the waiter is parked in
+     * the BlkFeed, and `reply` is filled when a Blk comes (or timed out).
+     */
+    void handle_subscribe_blks_deferred(optional<unordered_map<string,string>> query_param,
+                                        shared_ptr<::pure::IDeferredReply> reply){
+      auto [ok, after, err_msg] = parse_after(query_param);
+      if (not ok){
+        reply->reply(make_tuple(false, err_msg));
+        return;
+      }
+
+      optional<uint64_t> id = this->feed->park_for_blks(after, [reply](optional<string> r){
+        reply->reply(make_tuple(true, r.value()));
+      });
+      if (not id)
+        reply->reply(make_tuple(false, "Too many subscribers, please try again later."));
+      else if (id.value() != BlkFeed::NOT_PARKED)
+        reply->expires_after(parse_timeout(query_param),
+                             [f = this->feed, i = id.value()](){f->cancel(i);});
+    }
+
+    /**
+     * @brief The part of /subscribe_receipt before waiting.
+     *
+     * @param h Gets the Tx hash, normalized as the keys of the BlkFeed: no
+     * `0x`, lower case.
+     *
+     * @return The reply if it doesn't need to wait (a bad request or the Tx is
+     * already on the chain).
+     */
+    optional<tuple<bool,string>> subscribe_receipt_now(const optional<unordered_map<string,string>> & query_param,
+                                                       string & h){
+      if ((not query_param) or (not query_param.value().contains("hash")))
+        return make_tuple(false,
+                          "Error: `/subscribe_receipt` should be used with query parameter `hash=<Tx hash>`\n"
+                          );
+      optional<hash256> x = evmc::from_hex<hash256>(query_param.value().at("hash"));
+      if (not x)
+        return make_tuple(false, "Error: `hash` " + query_param.value().at("hash") + " is ill-formed");
+      h = hashToString(x.value());
+
+      // 1. already on the chain ?
+      if (this->wrld){
+        auto [info, err_msg] = get_txOnBlkInfo(this->wrld, h);
+        if (info){
+          auto [ok, s] = get_receipt(this->wrld, h);
+          if (not ok) return make_tuple(false, s);
+          return make_tuple(true, (format(R"({"status":"committed","blkNumber":%d,"onBlkId":%d,"receipt":%s})")
+                                   % info.value().blkNumber % info.value().onBlkId % s).str());
+        }
+      }
+      return {};
+    }
+
+    /**
+     * @brief Wait for the receipt of a Tx (long-poll).
+     *
+     *     curl 'http://localhost:7777/subscribe_receipt?hash=<Tx hash>&timeout=20000'
+     *
+     * 🐢 : If the Tx is already on the chain, it returns right away. Otherwise it
+     * waits until it's committed or timed out, returning one of
+     *
+     *     {"status":"committed","blkNumber":1,"onBlkId":0,"receipt":{..}}
+     *     {"status":"pending"}
+     */
+    tuple<bool,string> handle_subscribe_receipt(optional<unordered_map<string,string>> query_param){
+      string h;
+      if (auto r = this->subscribe_receipt_now(query_param, h))
+        return r.value();
+
+      // 2. wait for it
+      if (this->feed->n_waiting() >= this->feed->max_waiters)
+        return make_tuple(false, "Too many subscribers, please try again later.");
+      optional<string> r = this->feed->wait_for_receipt(h, parse_timeout(query_param));
+      if (not r)
+        return make_tuple(true, R"({"status":"pending"})");
+      return make_tuple(true, r.value());
+    }
+
+    /**
+     * @brief The same as handle_subscribe_receipt(), but the waiter is parked
+     * in the BlkFeed.
+     */
+    void handle_subscribe_receipt_deferred(optional<unordered_map<string,string>> query_param,
+                                           shared_ptr<::pure::IDeferredReply> reply){
+      string h;
+      if (auto r = this->subscribe_receipt_now(query_param, h)){
+        reply->reply(r.value());
+        return;
+      }
+
+      optional<uint64_t> id = this->feed->park_for_receipt(h, [reply](optional<string> r){
+        reply->reply(make_tuple(true, r ? r.value() : string(R"({"status":"pending"})")));
+      });
+      if (not id)
+        reply->reply(make_tuple(false, "Too many subscribers, please try again later."));
+      else if (id.value() != BlkFeed::NOT_PARKED)
+        reply->expires_after(parse_timeout(query_param),
+                             [f = this->feed, i = id.value()](){f->cancel(i);});
     }
 
 
@@ -104,7 +558,7 @@ namespace weak{
      */
     tuple<bool,string>  handle_get_Blk(optional<unordered_map<string,string>> query_param){
       if (not query_param or (not query_param.value().contains("n")))
-        return get_latest_Blk(this->wrld);
+        return get_latest_Blk(this->wrld, 1, this->blk_cache);
 
       // 1. parse n
       string ns = query_param.value().at("n");
@@ -116,10 +570,10 @@ namespace weak{
       }
 
       // 2. get the nth Blk
-      auto [rb, err_msg1] =  get_Blk_from_chain(this->wrld,rN.value());
+      auto [rb, err_msg1] =  get_Blk_json(this->wrld,rN.value(),this->blk_cache);
       if (not rb)
         return make_tuple(false,err_msg1);
-      return make_tuple(true,rb.value().toJsonString());
+      return make_tuple(true,std::move(rb.value()));
     }
 
     /**
@@ -146,7 +600,7 @@ namespace weak{
         return make_tuple(false, err_msg);
       }
 
-      return get_latest_Blk(this->wrld,rN.value());
+      return get_latest_Blk(this->wrld,rN.value(),this->blk_cache);
     }
 
     /**
@@ -168,8 +622,12 @@ namespace weak{
      *    4. get the `M - i` th Blk, stored at "/blk/<blk.number>" deserialize it ⇒ Bi
      *
      *    5. a.push_back(Bi.toJsonString())`
+     *
+     * <2024-07-08 Mon> 🦜 : If `c` is given, the rendered Blks are taken from
+     * (and put into) it, and the array is joined as strings, so a cached Blk is
+     * never parsed again.
      */
-    static tuple<bool,string> get_latest_Blk(IChainDBGettable * const w, int N = 1) noexcept {
+    static tuple<bool,string> get_latest_Blk(IChainDBGettable * const w, int N = 1, BlkCache * const c = nullptr) noexcept {
       json::array a;
       if (N==0)
         return make_tuple(true, json::serialize(a)); // user wants none
@@ -192,16 +650,37 @@ namespace weak{
       }
 
       // 3.
+      string o{"["};
       for (int i=0;i<N;i++){    // do N times
         int bn = M - i;
-        auto [rb, err_msg] = get_Blk_from_chain(w,bn);
+        auto [rb, err_msg] = get_Blk_json(w,bn,c);
         if (not rb)
           return make_tuple(false,err_msg);
 
-        a.emplace_back(rb.value().toJson());
+        if (i > 0) o += ',';
+        o += rb.value();
       }
+      o += ']';
 
-      return make_tuple(true, json::serialize(a)); // empty chain
+      return make_tuple(true, std::move(o));
+    }
+
+    /**
+     * @brief Get the bn-th Blk on the chain as JSON, via the cache `c` if given.
+     */
+    static tuple<optional<string>,string> get_Blk_json(IChainDBGettable * const w, int bn, BlkCache * const c = nullptr) noexcept {
+      if (c){
+        optional<string> r = c->get(static_cast<uint64_t>(bn));
+        if (r) return make_tuple(std::move(r), "OK");
+      }
+
+      auto [rb, err_msg] = get_Blk_from_chain(w,bn);
+      if (not rb)
+        return make_tuple(optional<string>(), err_msg);
+
+      string s = rb.value().toJsonString();
+      if (c) c->put(static_cast<uint64_t>(bn), s);
+      return make_tuple(optional<string>(std::move(s)), "OK");
     }
 
     /**
@@ -281,7 +760,16 @@ namespace weak{
      *
      * @param h The hex of hash
      */
-    static tuple<bool,string> get_re  ceipt(IChainDBGettable * const w, const string & h){
+    static tuple<bool,string> get_receipt(IChainDBGettable * const w, const string & h){
+      // 0. the direct index (written by BlkExecutor::commitBlk() since <2024-07-05 Fri>)
+      if (evmc::from_hex<hash256>(h)){
+        optional<string> o = w->getFromChainDB("/receipt/" + h);
+        TxReceipt tr;
+        if (o and tr.fromString(o.value()))
+          return make_tuple(true, tr.toJsonString());
+      }
+
+      // 🦜 : Not there ? Maybe the chain is older than the index, go the long way.
       // 1-2. get the TxOnBlkInfo
       auto [info0, err_msg] = get_txOnBlkInfo(w,h);
       if (not info0)
@@ -301,6 +789,14 @@ namespace weak{
     }
 
     static tuple<bool,string> get_tx(IChainDBGettable * const w, const string & h){
+      // 0. the direct index
+      if (evmc::from_hex<hash256>(h)){
+        optional<string> o = w->getFromChainDB("/txdata/" + h);
+        Tx tx;
+        if (o and tx.fromString(o.value()))
+          return make_tuple(true, tx.toJsonString());
+      }
+
       // 1. get the TxOnBlkInfo
       auto [info0, err_msg] = get_txOnBlkInfo(w,h);
       if (not info0)
@@ -328,7 +824,9 @@ namespace weak{
      */
     tuple<bool,string>  handle_get_receipt(optional<unordered_map<string,string>> query_param){
       /*
-        🦜 : To get the receipt of a particular Tx. We need to do the following:
+        🦜 : To get the receipt of a particular Tx, we first try the direct
+        index at "/receipt/<hash>". If it's not there (chains written before the
+        index existed), we need to do the following:
 
         1. Use the hash to fetch the `TxOnBlkInfo`. If the TxOnBlkInfo is not
         found, the Tx is not committed on the chain(yet). This should be stored at "/tx/<hash>"
@@ -371,6 +869,583 @@ namespace weak{
 
     }
 
+    /**
+     * @brief Get the Merkle proof that a Tx is in its Blk.
+     *
+     *     curl 'http://localhost:7777/get_tx_proof?hash=<Tx hash>'
+     *
+     * <2024-07-25 Thu> 🦜 : With this, a light client that knows the Blk hash
+     * can check a Tx without getting the Blk:
+     *
+     *     1. fold the `proof` from `txHash` as the `index`-th of `n_txs`
+     *     leaves (see MerkleTree::rootOfProof()) ⇒ it should be `txRoot`.
+     *
+     *     2. keccak(parentHash | txRoot | n_txs) should be `blkHash`.
+     *
+     * 🐢 : Both are done by Blk::verifyTx(). The client should check it against
+     * the `blkHash` it knows, not the one here, because `n_txs` is only as good
+     * as that.
+     */
+    tuple<bool,string>  handle_get_tx_proof(optional<unordered_map<string,string>> query_param){
+      if ((not query_param) or (not query_param.value().contains("hash")))
+        return make_tuple(false,
+                          "Error: `/get_tx_proof` should be used with query parameter `hash=<Tx hash>`\n"
+                          "For example: http://localhost:7777/get_tx_proof?hash=3d9a5bdd62ff8f12aab28cdb1c091918c5ede28c91c09e8f16a68a7c33add70e"
+                          );
+      return get_tx_proof(this->wrld, query_param.value()["hash"]);
+    }
+
+    static tuple<bool,string> get_tx_proof(IChainDBGettable * const w, const string & h){
+      // 1. get the TxOnBlkInfo
+      auto [info0, err_msg] = get_txOnBlkInfo(w,h);
+      if (not info0)
+        return make_tuple(false,err_msg);
+      TxOnBlkInfo info = info0.value();
+
+      // 2. get the Blk
+      auto [b0, err_msg1] = get_Blk_from_chain(w,info.blkNumber);
+      if (not b0)
+        return make_tuple(false,err_msg1);
+      const ExecBlk & b = b0.value();
+      if (info.onBlkId >= b.txs.size())
+        return make_tuple(false, (format("Data corruption Error: Blk-%d has no Tx-%d") % b.number % info.onBlkId).str());
+
+      // 3. make the proof
+      vector<hash256> hs = b.txHashes();
+      size_t i = info.onBlkId;
+
+      json::array p;
+      for (const hash256 & x : MerkleTree::proof(hs, i))
+        p.emplace_back(hashToString(x));
+
+      json::object o;
+      o["blkNumber"] = b.number;
+      o["index"] = i;
+      o["n_txs"] = hs.size();
+      o["txHash"] = hashToString(hs[i]);
+      o["proof"] = std::move(p);
+      hash256 r = MerkleTree::root(std::move(hs));
+      o["txRoot"] = hashToString(r);
+      o["parentHash"] = hashToString(b.parentHash);
+      o["blkHash"] = hashToString(Blk::hashOf(b.parentHash, r, b.txs.size()));
+      return make_tuple(true, json::serialize(o));
+    }
+
+    // {{{ streaming export
+    /**
+     * @brief Stream a range of Blks.
+     *
+     *     curl 'http://localhost:7777/export_blks?from=100&to=200'
+     *
+     * sends Blk-100 to Blk-200 (inclusive) as newline-delimited JSON (one
+     * ExecBlk per line), and `/export_blks_pb` sends them as length-delimited
+     * hiPb::ExecBlk (varint length + bytes, like protobuf's writeDelimitedTo()).
+     *
+     * `to` defaults to the latest Blk, and at most `limit` (default and max
+     * MAX_EXPORT) Blks are sent each time. The cursor is the Blk number itself:
+     * to resume (or go on), ask again with `from=<last number received + 1>`.
+     *
+     * 🐢 : The Blks are read EXPORT_PAGE at a time (with one
+     * getManyFromChainDB()), and each page is written as soon as it's ready.
+     * So the memory is bounded by a page, no matter how long the range is.
+     *
+     * 🦜 : Why not a RocksDB iterator ?
+     *
+     * 🐢 : The keys are "/blk/<number in decimal>", which are not in the order
+     * of the numbers (e.g. "/blk/10" < "/blk/9"), so we walk the numbers.
+     *
+     * @return (false, error message) if failed. If that's before anything is
+     * written (e.g. a bad query param), the client gets a 400, otherwise the
+     * body is cut.
+     */
+    tuple<bool,string> export_blks(optional<unordered_map<string,string>> query_param,
+                                   const IForRpcNetworkable::chunkWriter_t & write, bool in_pb){
+      // 1. parse the range (🦜 : before writing anything)
+      auto get_n = [&](const string & k) -> tuple<optional<uint64_t>,string>{
+        if ((not query_param) or (not query_param.value().contains(k)))
+          return make_tuple(optional<uint64_t>(), "");
+        auto [r, err_msg] = parse_positive_int(query_param.value().at(k));
+        if (not r){
+          BOOST_LOG_TRIVIAL(debug) << format("❌️ /export_blks: %s") % err_msg;
+          return make_tuple(optional<uint64_t>(), "Error: `" + k + "`: " + err_msg);
+        }
+        return make_tuple(optional<uint64_t>(static_cast<uint64_t>(r.value())), "");
+      };
+      auto [from, err0] = get_n("from");
+      auto [to, err1] = get_n("to");
+      auto [limit, err2] = get_n("limit");
+      for (const string & err : {err0, err1, err2})
+        if (not err.empty()) return make_tuple(false, err);
+
+      optional<string> r = this->wrld->getFromChainDB("/other/blk_number");
+      if (not r) return make_tuple(true, "");     // empty chain
+      auto [rM, err_msg] = parse_positive_int(r.value());
+      if (not rM) return make_tuple(false, "Data corruption Error: bad /other/blk_number");
+
+      uint64_t b = from.value_or(0);
+      uint64_t e = std::min(to.value_or(UINT64_MAX), static_cast<uint64_t>(rM.value()));
+      uint64_t l = std::min(limit.value_or(MAX_EXPORT), MAX_EXPORT);
+      if (b > e or l == 0) return make_tuple(true, ""); // nothing to send
+      e = std::min(e, b + l - 1);
+
+      // 2. page by page
+      for (uint64_t p = b; p <= e; p += EXPORT_PAGE){
+        uint64_t q = std::min(e, p + EXPORT_PAGE - 1);
+        vector<string> ks;
+        for (uint64_t n = p; n <= q; n++)
+          ks.push_back("/blk/" + lexical_cast<string>(n));
+        vector<optional<string>> vs = this->wrld->getManyFromChainDB(ks);
+
+        string o;
+        for (size_t i = 0; i < vs.size(); i++){
+          if (not vs[i]){
+            BOOST_LOG_TRIVIAL(error) << format("❌️ Data corruption Error: failed to get %s on chainDB") % ks[i];
+            return make_tuple(false, "Data corruption Error: failed to get " + ks[i] + " on chainDB");
+          }
+
+          if (in_pb){
+            optional<string> x = stored_to_pbString<ExecBlk>(std::move(vs[i].value()));
+            if (not x) return make_tuple(false, "Failed to convert " + ks[i] + " to pb");
+            append_varint(o, x.value().size()); // 🦜 : varint length, then the bytes
+            o += x.value();
+          }else{
+            /*
+              🐢 : We read the cache but don't fill it, the history being
+              exported would just push out the hot Blks.
+             */
+            optional<string> x = this->blk_cache ? this->blk_cache->get(p + i) : optional<string>();
+            if (not x){
+              ExecBlk bk;
+              if (not bk.fromString(vs[i].value())) return make_tuple(false, "Failed to parse " + ks[i]);
+              x = bk.toJsonString();
+            }
+            o += x.value();
+            o += '\n';
+          }
+        }
+
+        if (not write(o)){
+          BOOST_LOG_TRIVIAL(debug) << format("⚠️ /export_blks: client gone at Blk-%d") % p;
+          return make_tuple(false, "client gone");
+        }
+      }
+      return make_tuple(true, "");
+    }
+
+    tuple<bool,string> handle_export_blks(optional<unordered_map<string,string>> query_param,
+                                          const IForRpcNetworkable::chunkWriter_t & write){
+      return this->export_blks(std::move(query_param), write, false);
+    }
+
+    tuple<bool,string> handle_export_blks_pb(optional<unordered_map<string,string>> query_param,
+                                             const IForRpcNetworkable::chunkWriter_t & write){
+      return this->export_blks(std::move(query_param), write, true);
+    }
+    // }}}
+
+    // {{{ pb getters
+    /*
+      <2024-07-12 Fri> 🦜 : These return the same things as their JSON
+      siblings, but in hi.proto, so the client doesn't need to un-hex every
+      hash and address.
+
+      🐢 : When built WITH_PROTOBUF, what's on the chainDB is already pb, so we
+      just send the stored bytes without parsing them. (Unless it's built
+      WITH_BIN_CODEC, then the Txs and Blks are converted.)
+     */
+
+    /**
+     * @brief Append `v` as the length-delimited field `field` of a pb message.
+     *
+     * 🦜 : This is how we make an `ExecBlks` out of the stored `ExecBlk`s
+     * without parsing them: a repeated message field is just the
+     * (tag,length,bytes) of each item.
+     */
+    static void append_pb_field(string & o, uint32_t field, string_view v){
+      append_varint(o, (static_cast<uint64_t>(field) << 3) | 2 /*wire type: LEN*/);
+      append_varint(o, v.size());
+      o.append(v);
+    }
+
+    static void append_varint(string & o, uint64_t x){
+      while (x >= 0x80){
+        o += static_cast<char>((x & 0x7f) | 0x80);
+        x >>= 7;
+      }
+      o += static_cast<char>(x);
+    }
+
+    /**
+     * @brief Turn what's stored on chainDB into pb string.
+     */
+    template<typename T>
+    static optional<string> stored_to_pbString(string && v){
+      /*
+        <2024-07-28 Sun> 🐢 : An ExecBlk is stored with Acn deltas, which the
+        clients don't get (see ExecBlk::toRpcPbString()), so it's always
+        re-encoded.
+       */
+      if constexpr (std::is_same_v<T, ExecBlk>){
+        ExecBlk b;
+        if (not b.fromString(v)) return {};
+        return b.toRpcPbString();
+      }else{
+#if defined(WITH_PROTOBUF)
+        // 🦜 : except the Txs and Blks stored in bin
+        if constexpr (not (WITH_BIN_CODEC and (std::is_base_of_v<Tx, T> or std::is_base_of_v<Blk, T>)))
+          return std::move(v);
+#endif
+        T t;
+        if (not t.fromString(v)) return {};
+        return t.toPbString();
+      }
+    }
+
+    /**
+     * @brief Get the bn-th Blk as pb string (hiPb::ExecBlk).
+     */
+    static tuple<optional<string>,string> get_Blk_pbString(IChainDBGettable * const w, int bn) noexcept{
+      optional<string> r = w->getFromChainDB("/blk/" + lexical_cast<string>(bn));
+      if (not r)
+        return make_tuple(optional<string>(),
+                          (format("Data corruption Error: failed to get  /blk/%d on chainDB") % bn).str());
+      optional<string> o = stored_to_pbString<ExecBlk>(std::move(r.value()));
+      if (not o)
+        return make_tuple(o, (format("Data corruption Error: /blk/%d on chainDB doesn't deserialize to Blk") % bn).str());
+      return make_tuple(o, "OK");
+    }
+
+    /**
+     * @brief The pb version of get_latest_Blk(), returns hiPb::ExecBlks.
+     */
+    static tuple<bool,string> get_latest_Blk_pb(IChainDBGettable * const w, int N = 1) noexcept{
+      string o;
+      if (N == 0)
+        return make_tuple(true, o); // user wants none
+      if (N < 0)
+        return make_tuple(false, (format("You cannot get latest <negative number=%d> Blks") % N).str());
+
+      optional<string> r = w->getFromChainDB("/other/blk_number");
+      if (not r)
+        return make_tuple(true, o); // empty chain
+      auto [rM,err_msg] = parse_positive_int(r.value());
+      if (not rM) return make_tuple(false,err_msg);
+      int M = rM.value();
+      N = std::min(N, M + 1);
+
+      for (int i=0;i<N;i++){
+        auto [rb, err_msg1] = get_Blk_pbString(w, M - i);
+        if (not rb) return make_tuple(false, err_msg1);
+        append_pb_field(o, 1 /*ExecBlks.blks*/, rb.value());
+      }
+      return make_tuple(true, std::move(o));
+    }
+
+    /**
+     * @brief Parse the optional positive "n" in query param. Returns (ok,n,err_msg).
+     */
+    static tuple<bool,optional<int>,string> parse_optional_n(const optional<unordered_map<string,string>> & q){
+      if (not q or (not q.value().contains("n")))
+        return make_tuple(true, optional<int>(), "");
+      auto [rN,err_msg] = parse_positive_int(q.value().at("n"));
+      return make_tuple(bool(rN), rN, err_msg);
+    }
+
+    tuple<bool,string> handle_get_latest_Blk_pb(optional<unordered_map<string,string>> query_param){
+      auto [ok, rN, err_msg] = parse_optional_n(query_param);
+      if (not ok) return make_tuple(false, err_msg);
+      return get_latest_Blk_pb(this->wrld, rN ? rN.value() : 1);
+    }
+
+    /**
+     * @brief `/get_blk_pb?n=3` returns the hiPb::ExecBlk. Without `n`, it
+     * returns hiPb::ExecBlks with the latest Blk (just like `/get_blk`).
+     */
+    tuple<bool,string> handle_get_Blk_pb(optional<unordered_map<string,string>> query_param){
+      auto [ok, rN, err_msg] = parse_optional_n(query_param);
+      if (not ok) return make_tuple(false, err_msg);
+      if (not rN) return get_latest_Blk_pb(this->wrld);
+
+      auto [rb, err_msg1] = get_Blk_pbString(this->wrld, rN.value());
+      if (not rb) return make_tuple(false, err_msg1);
+      return make_tuple(true, std::move(rb.value()));
+    }
+
+    /**
+     * @brief Get the hiPb::TxReceipt or hiPb::Tx of a hash.
+     */
+    template<typename T>
+    tuple<bool,string> get_one_by_hash_pb(optional<unordered_map<string,string>> query_param,
+                                          const string & prefix, const string & what){
+      if ((not query_param) or (not query_param.value().contains("hash")))
+        return make_tuple(false, "Error: `" + what + "` should be used with query parameter `hash=<Tx hash>`\n");
+      string h = query_param.value().at("hash");
+      if (not evmc::from_hex<hash256>(h))
+        return make_tuple(false, "Error: `hash` " + h + " is ill-formed");
+
+      // 1. the direct index, as it is
+      optional<string> r = this->wrld->getFromChainDB(prefix + h);
+      if (r){
+        optional<string> o = stored_to_pbString<T>(std::move(r.value()));
+        if (o) return make_tuple(true, std::move(o.value()));
+      }
+
+      // 2. the long way
+      vector<optional<T>> v = this->get_many_by_hash<T>({h}, prefix);
+      if (not v[0])
+        return make_tuple(false, "Error: `hash` " + h + " does not (yet) exist on the chain.");
+      return make_tuple(true, v[0].value().toPbString());
+    }
+
+    tuple<bool,string> handle_get_receipt_pb(optional<unordered_map<string,string>> query_param){
+      return get_one_by_hash_pb<TxReceipt>(query_param, "/receipt/", "/get_receipt_pb");
+    }
+
+    tuple<bool,string> handle_get_tx_pb(optional<unordered_map<string,string>> query_param){
+      return get_one_by_hash_pb<Tx>(query_param, "/txdata/", "/get_tx_pb");
+    }
+
+    tuple<bool,string> handle_get_pool_status_pb(optional<unordered_map<string,string>> /*query_param*/){
+      return make_tuple(true, this->pool->info_pb());
+    }
+    // }}}
+
+    // {{{ batched getters
+    /*
+      <2024-07-10 Wed> 🦜 : Indexers used to call `/get_receipt` thousands of
+      times per second, one request (and one storage read) per hash. These take
+      a list of keys and answer them with one request and one
+      getManyFromChainDB() (i.e. RocksDB's MultiGet).
+
+      🐢 : The i-th item of the reply always answers the i-th key, a missing
+      item is `null` in JSON (or an unset field in pb).
+     */
+
+    /**
+     * @brief Get the Txs and receipts of the given hashes (in hex).
+     *
+     * 🦜 : This reads the direct index written by commitBlk(), and falls back
+     * to the long way (via the ExecBlk) for the ones not indexed.
+     *
+     * <2024-07-28 Sun> 🐢 : The long way is batched too: the TxOnBlkInfos are
+     * read in one go, and then each Blk is loaded (and parsed) once, with one
+     * get_many_blks(), no matter how many of its Txs are asked.
+     */
+    template<typename T>
+    vector<optional<T>> get_many_by_hash(const vector<string> & hs,
+                                         const string & prefix /* "/receipt/" or "/txdata/" */){
+      vector<string> ks;
+      ks.reserve(hs.size());
+      for (const string & h : hs)
+        ks.push_back(evmc::from_hex<hash256>(h) ? prefix + h : string{});
+
+      vector<optional<string>> vs = this->wrld->getManyFromChainDB(ks);
+      vector<optional<T>> o(hs.size());
+      vector<size_t> is;        // <! the ones not indexed
+      vector<string> ks1;
+      for (size_t i = 0; i < hs.size(); i++){
+        if (ks[i].empty()) continue; // ill-formed hash
+        T t;
+        if (vs[i] and t.fromString(vs[i].value())){
+          o[i] = std::move(t);
+          continue;
+        }
+        is.push_back(i);
+        ks1.push_back("/tx/" + hs[i]);
+      }
+      if (is.empty()) return o;
+
+      // 🦜 : not indexed, go the long way
+      vector<optional<string>> vs1 = this->wrld->getManyFromChainDB(ks1);
+      vector<optional<TxOnBlkInfo>> infos(is.size());
+      vector<uint64_t> ns;
+      for (size_t j = 0; j < is.size(); j++){
+        TxOnBlkInfo info;
+        if (vs1[j] and info.fromString(vs1[j].value())){
+          infos[j] = info;
+          ns.push_back(info.blkNumber);
+        }
+      }
+      std::sort(ns.begin(), ns.end());
+      ns.erase(std::unique(ns.begin(), ns.end()), ns.end());
+      vector<optional<ExecBlk>> bs = this->get_many_blks(ns);
+
+      for (size_t j = 0; j < is.size(); j++){
+        if (not infos[j]) continue;
+        const TxOnBlkInfo & info = infos[j].value();
+        const optional<ExecBlk> & b = bs[std::lower_bound(ns.begin(), ns.end(), info.blkNumber) - ns.begin()];
+        if (not b) continue;
+        if constexpr (std::is_same_v<T,TxReceipt>){
+          if (info.onBlkId < b.value().txReceipts.size())
+            o[is[j]] = b.value().txReceipts[info.onBlkId];
+        }else{
+          if (info.onBlkId < b.value().txs.size())
+            o[is[j]] = b.value().txs[info.onBlkId];
+        }
+      }
+      return o;
+    }
+
+    /**
+     * @brief Get the Blks of the given numbers, in one getManyFromChainDB().
+     *
+     * 🦜 : Not via the BlkCache: it keeps the rendered JSON, and parsing that
+     * back to an ExecBlk costs more than parsing the stored one.
+     */
+    vector<optional<ExecBlk>> get_many_blks(const vector<uint64_t> & ns){
+      vector<string> ks;
+      ks.reserve(ns.size());
+      for (uint64_t n : ns)
+        ks.push_back("/blk/" + lexical_cast<string>(n));
+
+      vector<optional<string>> vs = this->wrld->getManyFromChainDB(ks);
+      vector<optional<ExecBlk>> o(ns.size());
+      for (size_t i = 0; i < ns.size(); i++){
+        ExecBlk b;
+        if (vs[i] and b.fromString(vs[i].value()))
+          o[i] = std::move(b);
+      }
+      return o;
+    }
+
+    /**
+     * @brief Join the JSON strings into an array, `null` for the missing ones.
+     */
+    template<typename T, typename F>
+    static string join_json_array(const vector<optional<T>> & v, F to_json){
+      string o{"["};
+      for (size_t i = 0; i < v.size(); i++){
+        if (i > 0) o += ',';
+        o += v[i] ? to_json(v[i].value()) : "null";
+      }
+      o += ']';
+      return o;
+    }
+
+    /**
+     * @brief Parse the JSON array of hashes (in hex), like `["3d9a..","8909.."]`.
+     */
+    static optional<vector<string>> parse_hashes_json(string_view data) noexcept{
+      try{
+        vector<string> hs = json::value_to<vector<string>>(json::parse(data));
+        if (hs.size() > MAX_BATCH) return {};
+        return hs;
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(debug) << format("❌️ Error parsing hashes: %s") % e.what();
+        return {};
+      }
+    }
+
+    static optional<vector<string>> parse_hashes_pb(string_view data) noexcept{
+      hiPb::TxHashes pb;
+      if (not pb.ParseFromArray(data.data(), static_cast<int>(data.size())) or
+          pb.hashes_size() > static_cast<int>(MAX_BATCH))
+        return {};
+      vector<string> hs;
+      hs.reserve(pb.hashes_size());
+      for (const string & h : pb.hashes())
+        hs.push_back(evmc::hex(weak::bytesFromString(h)));
+      return hs;
+    }
+
+    /**
+     * @brief Get many receipts at once.
+     *
+     *     curl http://localhost:7777/get_receipts -d '["3d9a..","8909.."]'
+     *
+     * @return The JSON array of receipts.
+     */
+    tuple<bool,string> handle_get_receipts(string_view data){
+      optional<vector<string>> hs = parse_hashes_json(data);
+      if (not hs)
+        return make_tuple(false, (format("Expecting a JSON array of at most %d Tx hashes") % MAX_BATCH).str());
+      auto v = this->get_many_by_hash<TxReceipt>(hs.value(), "/receipt/");
+      return make_tuple(true, join_json_array(v, [](const TxReceipt & r){return r.toJsonString();}));
+    }
+
+    tuple<bool,string> handle_get_txs(string_view data){
+      optional<vector<string>> hs = parse_hashes_json(data);
+      if (not hs)
+        return make_tuple(false, (format("Expecting a JSON array of at most %d Tx hashes") % MAX_BATCH).str());
+      auto v = this->get_many_by_hash<Tx>(hs.value(), "/txdata/");
+      return make_tuple(true, join_json_array(v, [](const Tx & t){return t.toJsonString();}));
+    }
+
+    /**
+     * @brief Get many Blks at once, at most MAX_BLK_BATCH.
+     *
+     *     curl http://localhost:7777/get_blks -d '[0,1,2]'
+     */
+    tuple<bool,string> handle_get_blks(string_view data){
+      optional<vector<uint64_t>> ns0;
+      try{
+        ns0 = json::value_to<vector<uint64_t>>(json::parse(data));
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(debug) << format("❌️ Error parsing Blk numbers: %s") % e.what();
+      }
+      if ((not ns0) or ns0.value().size() > MAX_BLK_BATCH)
+        return make_tuple(false, (format("Expecting a JSON array of at most %d Blk numbers "
+                                         "(use /export_blks for more)") % MAX_BLK_BATCH).str());
+      const vector<uint64_t> & ns = ns0.value();
+
+      // 🦜 : Cached ones are already rendered, only get the rest.
+      vector<optional<string>> o(ns.size());
+      vector<uint64_t> ns1;
+      vector<size_t> is1;
+      for (size_t i = 0; i < ns.size(); i++){
+        if (this->blk_cache) o[i] = this->blk_cache->get(ns[i]);
+        if (not o[i]){ ns1.push_back(ns[i]); is1.push_back(i);}
+      }
+
+      vector<optional<ExecBlk>> bs = this->get_many_blks(ns1);
+      for (size_t j = 0; j < bs.size(); j++){
+        if (not bs[j]) continue;
+        o[is1[j]] = bs[j].value().toJsonString();
+        if (this->blk_cache) this->blk_cache->put(ns1[j], o[is1[j]].value());
+      }
+      return make_tuple(true, join_json_array(o, [](const string & x){return x;}));
+    }
+
+    tuple<bool,string> handle_get_receipts_pb(string_view data){
+      optional<vector<string>> hs = parse_hashes_pb(data);
+      if (not hs)
+        return make_tuple(false, (format("Expecting a pb TxHashes of at most %d hashes") % MAX_BATCH).str());
+      hiPb::TxReceiptsReply pb;
+      for (auto & r : this->get_many_by_hash<TxReceipt>(hs.value(), "/receipt/")){
+        hiPb::TxReceiptOrNot * x = pb.add_receipts();
+        if (r) *(x->mutable_receipt()) = r.value().toPb();
+      }
+      return make_tuple(true, pb.SerializeAsString());
+    }
+
+    tuple<bool,string> handle_get_txs_pb(string_view data){
+      optional<vector<string>> hs = parse_hashes_pb(data);
+      if (not hs)
+        return make_tuple(false, (format("Expecting a pb TxHashes of at most %d hashes") % MAX_BATCH).str());
+      hiPb::TxsReply pb;
+      for (auto & t : this->get_many_by_hash<Tx>(hs.value(), "/txdata/")){
+        hiPb::TxOrNot * x = pb.add_txs();
+        if (t) *(x->mutable_tx()) = t.value().toPb();
+      }
+      return make_tuple(true, pb.SerializeAsString());
+    }
+
+    tuple<bool,string> handle_get_blks_pb(string_view data){
+      hiPb::BlkNumbers in;
+      if (not in.ParseFromArray(data.data(), static_cast<int>(data.size())) or
+          in.numbers_size() > static_cast<int>(MAX_BLK_BATCH))
+        return make_tuple(false, (format("Expecting a pb BlkNumbers of at most %d numbers "
+                                         "(use /export_blks_pb for more)") % MAX_BLK_BATCH).str());
+
+      hiPb::ExecBlksReply pb;
+      for (auto & b : this->get_many_blks(vector<uint64_t>(in.numbers().begin(), in.numbers().end()))){
+        hiPb::ExecBlkOrNot * x = pb.add_blks();
+        if (b) *(x->mutable_blk()) = b.value().toPb0(false /*with_deltas*/);
+      }
+      return make_tuple(true, pb.SerializeAsString());
+    }
+    // }}}
+
     /**
      * @brief query the pool status
      *
@@ -475,7 +1550,7 @@ namespace weak{
       if (not r)
         return make_tuple(false,"Invalid input JSON format.");
 
-      auto [s, txs] = r.value();
+      auto [s, txs] = std::move(r.value()); // 🦜 : not a copy of the 10k Txs
       return add_txs_and_return_this(s,std::move(txs));
       // bool ok = this->cnsss->addTxs(move(txs));
       // if (not ok)
@@ -504,7 +1579,7 @@ namespace weak{
       optional<tuple<string,vector<Tx>>> r = Tx::parse_txs_pbString_for_rpc(data, this->verifier);
       if (not r)
         return make_tuple(false,"Invalid input Pb format.");
-      auto [s, txs] = r.value();
+      auto [s, txs] = std::move(r.value());
       return add_txs_and_return_this(s,std::move(txs));
     }
   };
@@ -531,6 +1606,32 @@ namespace weak{
                         });
       return true;
     }
+    bool listenToGetStream(string target,streamHandler_t h)noexcept override{
+      this->srv->listenToGetStream(target,
+                        [h](string /*addr*/, uint16_t /*port*/,
+                            optional<unordered_map<string,string>> qparam,
+                            const ::pure::IHttpServable::chunkWriter_t & w) -> tuple<bool,string> {
+                          return h(qparam, w);
+                        });
+      return true;
+    }
+    bool listenToPostDeferred(string target,deferredPostHandler_t h)noexcept override{
+      this->srv->listenToPostDeferred(target,
+                        [h](string /*addr*/, uint16_t /*port*/, string data,
+                            shared_ptr<IDeferredReply> r){
+                          h(std::move(data), r);
+                        });
+      return true;
+    }
+    bool listenToGetDeferred(string target,deferredGetHandler_t h)noexcept override{
+      this->srv->listenToGetDeferred(target,
+                        [h](string /*addr*/, uint16_t /*port*/,
+                            optional<unordered_map<string,string>> qparam,
+                            shared_ptr<IDeferredReply> r){
+                          h(qparam, r);
+                        });
+      return true;
+    }
     bool listenToGet(string target,getHandler_t h)noexcept override{
       this->srv->listenToGet(target,
                         [h](string /*addr*/, uint16_t /*port*/,
@@ -0,0 +1,244 @@
+/**
+ * @file simdHex.hpp
+ * @author Jianer Cong
+ * @brief Hex encode/decode, 16 or 32 bytes at a time.
+ *
+ * 🦜 : Why not just evmc::hex() and evmc::from_hex() ?
+ *
+ * 🐢 : They do a byte at a time, evmc::hex() even makes a std::string per
+ * byte. That's fine for an address, but in JSON every hash, address, calldata
+ * and state-change value goes through them, so on /get_blk or /add_txs of a big
+ * Blk they show up near the top of the profile.
+ *
+ * 🦜 : So what's here ?
+ *
+ * 🐢 : The same thing, with pshufb (SSSE3) and its 256-bit version (AVX2). The
+ * one to use is picked once at start-up with __builtin_cpu_supports(), the
+ * tail (and the whole thing on MSVC or non-x86) is done by the scalar loop.
+ *
+ * The string forms (encode(), decode() and decode<T>()) behave exactly like
+ * evmc::hex(), evmc::from_hex() and evmc::from_hex<T>(): lower case out, any
+ * case in, an optional "0x" prefix, and decode<T>() pads short inputs with
+ * zeros on the left.
+ */
+#pragma once
+#include <evmc/hex.hpp>
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WEAK_HEX_X86 1
+#include <immintrin.h>
+#endif
+
+namespace weak::hex{
+  using std::string;
+  using std::string_view;
+  using std::optional;
+  using evmc::bytes;
+  using evmc::bytes_view;
+
+  /// Encode `n` bytes into `2n` lower-case hex chars.
+  using encode_fn = void (*)(const uint8_t * in, size_t n, char * out);
+  /// Decode `2n` hex chars into `n` bytes, false if any char is not hex.
+  using decode_fn = bool (*)(const char * in, size_t n, uint8_t * out);
+
+  namespace scalar{
+    inline void encode(const uint8_t * in, size_t n, char * out){
+      static constexpr char d[] = "0123456789abcdef";
+      for (size_t i = 0; i < n; i++){
+        out[2 * i] = d[in[i] >> 4];
+        out[2 * i + 1] = d[in[i] & 0xf];
+      }
+    }
+
+    /// -1 if not a hex digit.
+    inline int nibble(char c){
+      if (c >= '0' and c <= '9') return c - '0';
+      c |= 0x20;                // 🦜 : 'A' -> 'a'
+      if (c >= 'a' and c <= 'f') return c - 'a' + 10;
+      return -1;
+    }
+
+    inline bool decode(const char * in, size_t n, uint8_t * out){
+      for (size_t i = 0; i < n; i++){
+        int h = nibble(in[2 * i]), l = nibble(in[2 * i + 1]);
+        if ((h | l) < 0) return false;
+        out[i] = static_cast<uint8_t>((h << 4) | l);
+      }
+      return true;
+    }
+  }
+
+#if defined(WEAK_HEX_X86)
+  /*
+    🦜 : Each nibble indexes "0123456789abcdef" with pshufb. For decoding, a
+    char c is a digit if c - '0' <= 9 and a letter if (c | 0x20) - 'a' <= 5
+    (unsigned). Then maddubs() makes `16 * hi + lo` of each pair.
+   */
+  namespace ssse3{
+    __attribute__((target("ssse3")))
+    inline void encode(const uint8_t * in, size_t n, char * out){
+      const __m128i digits = _mm_setr_epi8('0','1','2','3','4','5','6','7',
+                                           '8','9','a','b','c','d','e','f');
+      const __m128i mask = _mm_set1_epi8(0x0f);
+      size_t i = 0;
+      for (; i + 16 <= n; i += 16){
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i h = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+        __m128i l = _mm_shuffle_epi8(digits, _mm_and_si128(x, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(h, l));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(h, l));
+      }
+      scalar::encode(in + i, n - i, out + 2 * i);
+    }
+
+    /// The nibbles of 16 chars, `ok` is cleared if any isn't hex.
+    __attribute__((target("ssse3")))
+    inline __m128i nibbles(__m128i c, bool & ok){
+      __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+      __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+      __m128i is_d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+      __m128i is_a = _mm_cmpeq_epi8(_mm_min_epu8(a, _mm_set1_epi8(5)), a);
+      ok &= _mm_movemask_epi8(_mm_or_si128(is_d, is_a)) == 0xffff;
+      return _mm_or_si128(_mm_and_si128(is_d, d),
+                          _mm_and_si128(is_a, _mm_add_epi8(a, _mm_set1_epi8(10))));
+    }
+
+    __attribute__((target("ssse3")))
+    inline bool decode(const char * in, size_t n, uint8_t * out){
+      const __m128i w = _mm_set1_epi16(0x0110); // <! (16, 1) for each pair
+      bool ok = true;
+      size_t i = 0;
+      for (; i + 16 <= n; i += 16){
+        __m128i a = nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)), ok);
+        __m128i b = nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 16)), ok);
+        __m128i x = _mm_packus_epi16(_mm_maddubs_epi16(a, w), _mm_maddubs_epi16(b, w));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+      }
+      return ok and scalar::decode(in + 2 * i, n - i, out + i);
+    }
+  }
+
+  /*
+    🦜 : Same as ssse3, but unpack/pack work within each 128-bit lane, so the
+    halves need to be put back in order.
+   */
+  namespace avx2{
+    __attribute__((target("avx2")))
+    inline void encode(const uint8_t * in, size_t n, char * out){
+      const __m256i digits = _mm256_setr_epi8('0','1','2','3','4','5','6','7',
+                                              '8','9','a','b','c','d','e','f',
+                                              '0','1','2','3','4','5','6','7',
+                                              '8','9','a','b','c','d','e','f');
+      const __m256i mask = _mm256_set1_epi8(0x0f);
+      size_t i = 0;
+      for (; i + 32 <= n; i += 32){
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i h = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+        __m256i l = _mm256_shuffle_epi8(digits, _mm256_and_si256(x, mask));
+        __m256i lo = _mm256_unpacklo_epi8(h, l); // <! bytes 0-7 | 16-23
+        __m256i hi = _mm256_unpackhi_epi8(h, l); // <! bytes 8-15 | 24-31
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i),
+                            _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+      }
+      ssse3::encode(in + i, n - i, out + 2 * i);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i nibbles(__m256i c, bool & ok){
+      __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+      __m256i a = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+      __m256i is_d = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+      __m256i is_a = _mm256_cmpeq_epi8(_mm256_min_epu8(a, _mm256_set1_epi8(5)), a);
+      ok &= _mm256_movemask_epi8(_mm256_or_si256(is_d, is_a)) == -1;
+      return _mm256_or_si256(_mm256_and_si256(is_d, d),
+                             _mm256_and_si256(is_a, _mm256_add_epi8(a, _mm256_set1_epi8(10))));
+    }
+
+    __attribute__((target("avx2")))
+    inline bool decode(const char * in, size_t n, uint8_t * out){
+      const __m256i w = _mm256_set1_epi16(0x0110);
+      bool ok = true;
+      size_t i = 0;
+      for (; i + 32 <= n; i += 32){
+        __m256i a = nibbles(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i)), ok);
+        __m256i b = nibbles(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i + 32)), ok);
+        __m256i x = _mm256_packus_epi16(_mm256_maddubs_epi16(a, w), _mm256_maddubs_epi16(b, w));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_permute4x64_epi64(x, 0xd8)); // <! a.0 b.0 a.1 b.1 -> a b
+      }
+      return ok and ssse3::decode(in + 2 * i, n - i, out + i);
+    }
+  }
+#endif
+
+  struct Impl{
+    const char * name;          // <! "avx2", "ssse3" or "scalar"
+    encode_fn encode;
+    decode_fn decode;
+  };
+
+  /// The implementation for this CPU, picked on the first call.
+  inline const Impl & impl() noexcept{
+#if defined(WEAK_HEX_X86)
+    static const Impl i = __builtin_cpu_supports("avx2") ? Impl{"avx2", avx2::encode, avx2::decode} :
+      __builtin_cpu_supports("ssse3") ? Impl{"ssse3", ssse3::encode, ssse3::decode} :
+      Impl{"scalar", scalar::encode, scalar::decode};
+#else
+    static const Impl i{"scalar", scalar::encode, scalar::decode};
+#endif
+    return i;
+  }
+
+  inline void encodeTo(const uint8_t * in, size_t n, char * out) noexcept{
+    impl().encode(in, n, out);
+  }
+
+  inline bool decodeTo(const char * in, size_t n, uint8_t * out) noexcept{
+    return impl().decode(in, n, out);
+  }
+
+  /// Same as evmc::hex().
+  inline string encode(bytes_view b){
+    string s(b.size() * 2, '\0');
+    encodeTo(b.data(), b.size(), s.data());
+    return s;
+  }
+
+  /// The hex of the bytes in a std::string (e.g. a StateChange value).
+  inline string encode(string_view b){
+    return encode(bytes_view(reinterpret_cast<const uint8_t*>(b.data()), b.size()));
+  }
+
+  inline string_view dropPrefix(string_view s) noexcept{
+    if (s.size() >= 2 and s[0] == '0' and s[1] == 'x') s.remove_prefix(2);
+    return s;
+  }
+
+  /// Same as evmc::from_hex(), {} on a bad char or an odd length.
+  inline optional<bytes> decode(string_view s){
+    s = dropPrefix(s);
+    if (s.size() % 2) return {};
+    bytes b(s.size() / 2, uint8_t{0});
+    if (not decodeTo(s.data(), b.size(), b.data())) return {};
+    return b;
+  }
+
+  /// Same as evmc::from_hex<T>(): a short input is padded with zeros on the left.
+  template<typename T>
+  optional<T> decode(string_view s) noexcept{
+    s = dropPrefix(s);
+    T r{};
+    constexpr size_t N = sizeof(r.bytes);
+    if (s.size() % 2 or s.size() / 2 > N) return {};
+    if (not decodeTo(s.data(), s.size() / 2, r.bytes + N - s.size() / 2)) return {};
+    return r;
+  }
+}
@@ -0,0 +1,95 @@
+/**
+ * @file stateCommit.hpp
+ * @author Jianer Cong
+ * @brief The group commit of the stateDB, with the chain as its log.
+ *
+ * 🦜 : Why would we turn off the WAL of the stateDB ?
+ *
+ * 🐢 : Because every state write is already on the chain: each ExecBlk keeps
+ * the journals of its Txs (ExecBlk::stateChanges), and the chainDB has its own
+ * WAL. Writing the same thing to the WAL of the stateDB is paying twice. So
+ * with `--state-group-commit <k>` the stateDB is written without WAL, and
+ * every `k` Blks StateGroupCommitter makes it durable (flushes the memtables,
+ * syncs the chainDB) and moves the mark `/other/state_replay_from` forward.
+ *
+ * 🦜 : And if we crash between two marks ?
+ *
+ * 🐢 : Then the stateDB lost (at most) the Blks from the mark on, but they're
+ * all on the chain. On start-up, replay() applies their journals again, from
+ * the mark up to `/other/blk_number`. Redoing a journal is harmless (they're
+ * puts and deletes of whole Acns), and a Blk is applied in one WriteBatch
+ * (IWorldChainStateSettable::applyJournalsStateDB()), so the stateDB never
+ * has half a Blk.
+ *
+ * 🦜 : What if I turn the WAL back on ?
+ *
+ * 🐢 : The replay still runs once (if there's a mark), then the mark is
+ * removed.
+ */
+#pragma once
+#include "forPostExec.hpp"
+#include <boost/lexical_cast.hpp>
+
+namespace weak{
+
+  class StateGroupCommitter: public virtual IBlkCommittedListener{
+  public:
+    IStateDurable * const durable;
+    const uint64_t every;       // <! make the state durable every this many Blks
+
+    /**
+     * @param d The stateDB.
+     * @param k The number of Blks per group.
+     */
+    StateGroupCommitter(IStateDurable * d, uint64_t k):
+      durable(d), every(std::max(k, uint64_t{1})),
+      from(d->stateReplayFrom().value_or(0)){}
+
+    void onBlkCommitted(const ExecBlk & b) noexcept override{
+      if (b.number + 1 < this->from + this->every) return;
+      if (this->durable->markStateDurable(b.number + 1))
+        this->from = b.number + 1;
+    }
+
+    /**
+     * @brief Apply the journals of the Blks from the mark up to the latest one
+     * again (see the top of this file).
+     *
+     * @param d The stateDB.
+     * @param w The chain and the stateDB.
+     * @param keep_mark Whether the stateDB is still written without WAL. If
+     * not, the mark is removed after the replay.
+     *
+     * @return the number of Blks replayed. Throws if a Blk can't be read.
+     */
+    static uint64_t replay(IStateDurable * const d, IWorldChainStateSettable * const w, bool keep_mark){
+      optional<uint64_t> from = d->stateReplayFrom();
+      if (not from) return 0;
+
+      optional<uint64_t> to;
+      if (optional<string> s = w->getFromChainDB("/other/blk_number"))
+        to = boost::lexical_cast<uint64_t>(s.value());
+
+      uint64_t n = 0;
+      for (uint64_t i = from.value(); to and i <= to.value(); i++, n++){
+        optional<string> v = w->getFromChainDB("/blk/" + std::to_string(i));
+        ExecBlk b;
+        if (not v or not b.fromString(v.value()))
+          BOOST_THROW_EXCEPTION(std::runtime_error((format("Data corruption Error: can't read Blk-%d to replay the state") % i).str()));
+        if (not w->applyJournalsStateDB(b.stateChanges))
+          BOOST_THROW_EXCEPTION(std::runtime_error((format("Failed to replay the state of Blk-%d") % i).str()));
+      }
+
+      if (keep_mark)
+        d->markStateDurable(to ? to.value() + 1 : from.value());
+      else
+        d->markStateDurable({});
+      BOOST_LOG_TRIVIAL(info) << format("🔁 Replayed the state of " S_CYAN "%d" S_NOR " Blk%s from Blk-%d")
+        % n % pluralizeOn(n) % from.value();
+      return n;
+    }
+
+  private:
+    uint64_t from;              // <! the current mark
+  };
+}
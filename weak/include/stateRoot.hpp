@@ -0,0 +1,256 @@
+/**
+ * @file stateRoot.hpp
+ * @author Jianer Cong
+ * @brief The root hash (commitment) of the world state, kept up to date Blk by Blk.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : Two nodes couldn't tell whether they have the same state without
+ * comparing the whole stateDB. With this, each ExecBlk carries the root of the
+ * state right after it (ExecBlk::stateRoot), so comparing the states is
+ * comparing two hashes.
+ *
+ * 🦜 : What's the structure ?
+ *
+ * 🐢 : A fixed-depth binary Merkle tree over `2^depth` buckets. An Acn goes to
+ * the bucket given by the hash of its key. Each Acn is a leaf with the hash
+ *
+ *     keccak(key | nonce | codehash | the storage, sorted by key | the disk_storage)
+ *
+ * , a bucket's hash is the hash of its leaves (sorted by key), and an internal
+ * node is the hash of its two children. An empty bucket (or an internal node
+ * with two empty children) is the zero hash. The leaves and all the internal
+ * nodes are cached in RAM.
+ *
+ * 🦜 : Why is the leaf not just the hash of the value in the StateChange ?
+ *
+ * 🐢 : Because the same Acn can be stored differently (json or pb, the code
+ * inline or in `code/<codehash>`, see WorldStorage::moveCodeOut()). The leaf
+ * only depends on what the Acn is, so the nodes agree however they store it.
+ *
+ * 🦜 : How much does a Blk cost ?
+ *
+ * 🐢 : Only the buckets touched by the Blk are rehashed (in parallel, on the
+ * `pool`), then only their paths up to the root, so it's about
+ * `(#changed Acns) * (leaf hash) + (#dirty buckets) * depth` hashes. See
+ * `bench_update_vs_blk_size` in test-stateRoot.cpp.
+ *
+ * 🦜 : What about a restart ?
+ *
+ * 🐢 : Nothing is saved. rebuild() walks all the Acns (IAcnIterable) on
+ * start-up.
+ */
+#pragma once
+#include "forPostExec.hpp"
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <latch>
+#include <numeric> // iota
+#include <map>
+#include <set>
+#include <mutex>
+
+namespace weak{
+
+  class StateRoot: public virtual IStateRootUpdatable{
+  public:
+    const unsigned depth;
+
+    /**
+     * @brief Construct a new StateRoot for an empty state.
+     *
+     * @param n The number of threads that hash the buckets.
+     * @param d The depth of the tree, there're `2^d` buckets.
+     */
+    StateRoot(size_t n = 2, unsigned d = 12):
+      depth(std::clamp(d, 1u, 24u)),
+      leaves(size_t{1} << depth),
+      nodes(size_t{2} << depth),
+      pool(std::max(n, size_t{1})){}
+
+    ~StateRoot(){
+      this->pool.join();
+    }
+
+    hash256 root() const noexcept{
+      std::unique_lock g(this->lock);
+      return this->nodes[1];
+    }
+
+    /**
+     * @brief Build the tree from all the Acns in `w`.
+     */
+    void rebuild(const IAcnIterable * const w){
+      std::unique_lock g(this->lock);
+      for (auto & l : this->leaves) l.clear();
+      size_t n = 0;
+      w->forEachAcn([&](const string & k, const Acn & a){
+        this->leaves[this->bucketOf(k)][k] = leafHash(k, a);
+        n++;
+      });
+
+      vector<size_t> all(this->leaves.size());
+      std::iota(all.begin(), all.end(), 0);
+      this->rehash_locked(all);
+      BOOST_LOG_TRIVIAL(info) << format("🌲 StateRoot built from " S_CYAN "%d" S_NOR " Acn%s: " S_CYAN "%s" S_NOR)
+        % n % pluralizeOn(n) % hashToString(this->nodes[1]);
+    }
+
+    /**
+     * @brief Apply the journals of a Blk and return the new root.
+     */
+    hash256 updateStateRoot(const vector<vector<StateChange>> & J) noexcept override{
+      std::unique_lock g(this->lock);
+
+      // 1. the last change of each key wins
+      // 2. group them by the buckets
+      std::map<size_t, vector<const StateChange*>> dirty;
+      for (const StateChange * c : lastChangeOfEachKey(J))
+        dirty[this->bucketOf(c->k)].push_back(c);
+
+      // 3. update the leaves of each dirty bucket (one task per bucket)
+      vector<size_t> is;
+      std::latch done{static_cast<std::ptrdiff_t>(dirty.size())};
+      for (auto & [i, cs] : dirty){
+        is.push_back(i);
+        boost::asio::post(this->pool, [this, i, &cs, &done](){
+          std::map<string,hash256> & l = this->leaves[i];
+          for (const StateChange * c : cs){
+            Acn a;
+            if (c->del or not a.fromString(c->v))
+              l.erase(c->k);
+            else
+              l[c->k] = leafHash(c->k, a);
+          }
+          done.count_down();
+        });
+      }
+      done.wait();
+
+      // 4. rehash the dirty buckets and their paths
+      this->rehash_locked(is);
+      return this->nodes[1];
+    }
+
+    size_t bucketOf(string_view k) const noexcept{
+      hash256 h = ethash::keccak256(reinterpret_cast<const uint8_t*>(k.data()), k.size());
+      uint32_t x = (uint32_t{h.bytes[0]} << 24) | (uint32_t{h.bytes[1]} << 16) |
+        (uint32_t{h.bytes[2]} << 8) | uint32_t{h.bytes[3]};
+      return x & ((uint32_t{1} << this->depth) - 1);
+    }
+
+    static hash256 leafHash(const string & k, const Acn & a) noexcept{
+      string s = k;
+      appendU64(s, a.nonce);
+
+      hash256 c = a.codehash();
+      s.append(reinterpret_cast<const char*>(c.bytes), 32);
+
+      vector<std::pair<bytes32,bytes32>> st(a.storage.begin(), a.storage.end());
+      std::sort(st.begin(), st.end());
+      for (auto & [sk, sv] : st){
+        s.append(reinterpret_cast<const char*>(sk.bytes), 32);
+        s.append(reinterpret_cast<const char*>(sv.bytes), 32);
+      }
+
+      for (const string & d : a.disk_storage){
+        appendU64(s, d.size());
+        s += d;
+      }
+      return ethash::keccak256(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+
+  private:
+    mutable std::mutex lock;
+    vector<std::map<string,hash256>> leaves; // <! bucket -> (key -> leaf hash)
+    vector<hash256> nodes;      // <! nodes[1] is the root, nodes[2i] and nodes[2i+1] are the children of nodes[i]
+    boost::asio::thread_pool pool;
+
+    /// Append `x` in big-endian.
+    static void appendU64(string & s, uint64_t x) noexcept{
+      for (int i = 7; i >= 0; i--)
+        s.push_back(static_cast<char>((x >> (8 * i)) & 0xff));
+    }
+
+    static bool isZero(const hash256 & h) noexcept{
+      return std::all_of(std::begin(h.bytes), std::end(h.bytes), [](uint8_t b){return b == 0;});
+    }
+
+    /**
+     * @brief Set `nodes[at[i]]` to the Keccak of `ps[i]` (`ss[i]` bytes).
+     *
+     * <2024-07-26 Fri> 🐢 : All the hashes of a step go in one
+     * ethash::keccak256_batch(), so they're done a few at a time on the SIMD
+     * lanes.
+     */
+    void hashInto(const vector<size_t> & at, const vector<const uint8_t*> & ps,
+                  const vector<size_t> & ss) noexcept{
+      vector<hash256> hs(at.size());
+      ethash::keccak256_batch(hs.data(), ps.data(), ss.data(), at.size());
+      for (size_t i = 0; i < at.size(); i++)
+        this->nodes[at[i]] = hs[i];
+    }
+
+    /**
+     * @brief Rehash the buckets `is` (in parallel) and then the nodes above them.
+     */
+    void rehash_locked(const vector<size_t> & is){
+      const size_t base = size_t{1} << this->depth;
+
+      // 🐢 : a task for a few buckets, not one for each
+      const size_t per_task = 64;
+      std::latch done{static_cast<std::ptrdiff_t>((is.size() + per_task - 1) / per_task)};
+      for (size_t j = 0; j < is.size(); j += per_task){
+        boost::asio::post(this->pool, [this, j, base, &is, &done](){
+          // 🦜 : a bucket's hash is the hash of its leaf hashes, one after another
+          vector<string> bs;
+          vector<size_t> at;
+          for (size_t x = j; x < std::min(j + per_task, is.size()); x++){
+            const std::map<string,hash256> & l = this->leaves[is[x]];
+            if (l.empty()){
+              this->nodes[base + is[x]] = hash256{};
+              continue;
+            }
+            string & s = bs.emplace_back();
+            s.reserve(l.size() * 32);
+            for (auto & [_, h] : l)
+              s.append(reinterpret_cast<const char*>(h.bytes), 32);
+            at.push_back(base + is[x]);
+          }
+
+          vector<const uint8_t*> ps;
+          vector<size_t> ss;
+          for (const string & s : bs){
+            ps.push_back(reinterpret_cast<const uint8_t*>(s.data()));
+            ss.push_back(s.size());
+          }
+          this->hashInto(at, ps, ss);
+          done.count_down();
+        });
+      }
+      done.wait();
+
+      // 🐢 : then level by level, the two children of a node are next to each
+      // other in `nodes`.
+      std::set<size_t> up;
+      for (size_t i : is) up.insert((base + i) / 2);
+      while (not up.empty()){
+        std::set<size_t> next;
+        vector<size_t> at;
+        vector<const uint8_t*> ps;
+        for (size_t i : up){
+          if (isZero(this->nodes[2 * i]) and isZero(this->nodes[2 * i + 1]))
+            this->nodes[i] = hash256{};
+          else{
+            at.push_back(i);
+            ps.push_back(this->nodes[2 * i].bytes);
+          }
+          if (i > 1) next.insert(i / 2);
+        }
+        this->hashInto(at, ps, vector<size_t>(at.size(), 64));
+        up = std::move(next);
+      }
+    }
+  };
+}
@@ -0,0 +1,231 @@
+/**
+ * @file stateVersions.hpp
+ * @author Jianer Cong
+ * @brief The versions of the world state, one per committed Blk.
+ *
+ * 🦜 : Why do we need this ?
+ *
+ * 🐢 : `BlkExecutor::commitBlk()` applies the journals Tx by Tx, so whoever
+ * reads the live stateDB (e.g. `/call`) in the middle of it sees a
+ * half-committed Blk. Also, there's no way to ask "what was the state as of Blk
+ * N ?".
+ *
+ * 🦜 : So what's a version ?
+ *
+ * 🐢 : A read-only view of the Acns right after a Blk was committed. We're an
+ * IBlkCommittedListener, and we're told after the whole Blk is applied, so
+ * that's the right moment to take a snapshot (IAcnSnapshotable). We pin the
+ * snapshots of the recent `max_recent` Blks. They're cheap for RocksDB, but a
+ * pinned snapshot keeps the overwritten values from being compacted away, so
+ * we don't keep them forever.
+ *
+ * 🦜 : What about the older heights ?
+ *
+ * 🐢 : If a IStateCheckpointable is given, every `checkpoint_every` Blks we
+ * save a checkpoint (a copy) of the stateDB. To read as of Blk N, we open the
+ * latest checkpoint C <= N and replay the journals of the Blks C+1..N (they're
+ * in the ExecBlks on the chainDB) on top of it. Only the newest
+ * `max_checkpoints` checkpoints are kept.
+ *
+ * <2024-07-28 Sun> 🦜 : What about the RAM mode ?
+ *
+ * 🐢 : There a snapshot keeps a copy of each Acn changed while it's alive
+ * (<2024-07-29 Mon> it used to copy the whole stateDB), so pinning one per Blk
+ * is still too much. The RAM mode uses LiveAcns instead: only the latest state,
+ * read from the live store. (InRamWorldStorage applies a Blk's journals under
+ * one lock, so that's still never a half-committed Blk.)
+ */
+#pragma once
+#include "forPostExec.hpp"
+
+#include <map>
+#include <mutex>
+
+namespace weak{
+
+  /**
+   * @brief The Acns of `base` with some journals applied on top.
+   */
+  class OverlaidAcns: public virtual IAcnGettable{
+  public:
+    shared_ptr<IAcnGettable> base;
+    unordered_map<string,optional<string>> overlay; // <! address hex -> Acn string, {} = deleted
+
+    OverlaidAcns(shared_ptr<IAcnGettable> b): base(b){}
+
+    void apply(const vector<StateChange> & j) noexcept{
+      for (const StateChange & c : j)
+        this->overlay.insert_or_assign(c.k, c.del ? optional<string>() : optional<string>(c.v));
+    }
+
+    optional<Acn> getAcn(evmc::address addr) const noexcept override{
+      auto it = this->overlay.find(addressToString(addr));
+      if (it == this->overlay.end())
+        return this->base->getAcn(addr);
+      if (not it->second) return {};
+      Acn a;
+      if (not a.fromString(it->second.value())) return {};
+      return a;
+    }
+
+    /*
+      🐢 : The codes are never removed from `code/..`, so the base has all of
+      them, except the ones that came with the journals (an Acn deployed after
+      the base was taken). Those are in the overlay with their code.
+     */
+    shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+      if (shared_ptr<const bytes> c = this->base->getCode(h)) return c;
+      for (const auto & [k, v] : this->overlay){
+        Acn a;
+        if (v and a.fromString(v.value()) and (not a.code.empty())){
+          hash256 x = a.codehash();
+          if (std::equal(std::cbegin(x.bytes), std::cend(x.bytes), std::cbegin(h.bytes)))
+            return make_shared<const bytes>(std::move(a.code));
+        }
+      }
+      return nullptr;
+    }
+  };
+
+  class StateVersions: public virtual IBlkCommittedListener,
+                       public virtual IAcnGettableAt{
+  public:
+    IAcnSnapshotable * const wrld;
+    IChainDBGettable * const chain;     // <! where the ExecBlks are, for the replay
+    IStateCheckpointable * const cp;    // <! optional
+    const size_t max_recent;
+    const uint64_t checkpoint_every;    // <! 0 means no checkpoints
+    const size_t max_checkpoints;
+
+    /**
+     * @brief Construct a new StateVersions
+     *
+     * @param w The world to take snapshots from.
+     * @param c The chainDB that holds the ExecBlks.
+     * @param latest The number of the latest Blk on chain, if any. Its version
+     * is pinned right away.
+     * @param r The number of recent versions to pin.
+     * @param p The checkpointer, optional.
+     * @param e Make a checkpoint every `e` Blks.
+     * @param m The max number of checkpoints to keep.
+     */
+    StateVersions(IAcnSnapshotable * const w, IChainDBGettable * const c,
+                  optional<uint64_t> latest = {}, size_t r = 128,
+                  IStateCheckpointable * const p = nullptr, uint64_t e = 0, size_t m = 8):
+      wrld(w), chain(c), cp(p), max_recent(std::max(r, size_t{1})),
+      checkpoint_every(p ? e : 0), max_checkpoints(std::max(m, size_t{1})){
+      if (latest)
+        this->pin(latest.value(), this->wrld->snapshotOfAcns());
+      if (this->cp)
+        for (uint64_t n : this->cp->listStateCheckpoints())
+          this->checkpoints[n] = nullptr; // opened lazily
+    }
+
+    void onBlkCommitted(const ExecBlk & b) noexcept override{
+      this->pin(b.number, this->wrld->snapshotOfAcns());
+
+      if (this->checkpoint_every == 0 or b.number % this->checkpoint_every != 0)
+        return;
+      if (not this->cp->checkpointState(b.number))
+        return;
+
+      vector<uint64_t> to_remove;
+      {
+        std::unique_lock g(this->lock);
+        this->checkpoints[b.number] = nullptr;
+        while (this->checkpoints.size() > this->max_checkpoints){
+          to_remove.push_back(this->checkpoints.begin()->first);
+          this->checkpoints.erase(this->checkpoints.begin());
+        }
+      }
+      for (uint64_t n : to_remove)
+        this->cp->removeStateCheckpoint(n);
+    }
+
+    shared_ptr<IAcnGettable> acnsAt(optional<uint64_t> n = {}) noexcept override{
+      std::unique_lock g(this->lock);
+      // 1. the latest
+      if (not n){
+        if (this->recent.empty())
+          return this->wrld->snapshotOfAcns(); // 🦜 : nothing committed yet
+        return this->recent.rbegin()->second;
+      }
+
+      // 2. the recent ones
+      if ((not this->recent.empty()) and n.value() > this->recent.rbegin()->first)
+        return nullptr;         // 🦜 : from the future
+      if (auto it = this->recent.find(n.value()); it != this->recent.end())
+        return it->second;
+
+      // 3. the checkpoints
+      auto it = this->checkpoints.upper_bound(n.value());
+      if (it == this->checkpoints.begin()) return nullptr;
+      --it;
+      if (n.value() - it->first > std::max(this->checkpoint_every, uint64_t{1}) * 4)
+        return nullptr;         // 🐢 : too much to replay, it'd be slow
+      if (not it->second)
+        it->second = this->cp->openStateCheckpoint(it->first);
+      if (not it->second) return nullptr;
+      uint64_t c = it->first;
+      shared_ptr<IAcnGettable> base = it->second;
+      g.unlock();
+
+      return replay(base, c, n.value());
+    }
+
+    size_t n_recent() noexcept{
+      std::unique_lock g(this->lock);
+      return this->recent.size();
+    }
+
+  private:
+    std::mutex lock;
+    std::map<uint64_t,shared_ptr<IAcnGettable>> recent;      // <! Blk number -> pinned snapshot
+    std::map<uint64_t,shared_ptr<IAcnGettable>> checkpoints; // <! Blk number -> opened checkpoint (or nullptr)
+
+    void pin(uint64_t n, shared_ptr<IAcnGettable> s) noexcept{
+      std::unique_lock g(this->lock);
+      this->recent[n] = s;
+      while (this->recent.size() > this->max_recent)
+        this->recent.erase(this->recent.begin());
+    }
+
+    /**
+     * @brief Apply the journals of Blks (c, n] on `base`.
+     */
+    shared_ptr<IAcnGettable> replay(shared_ptr<IAcnGettable> base, uint64_t c, uint64_t n) noexcept{
+      if (c == n) return base;
+      vector<string> ks;
+      for (uint64_t i = c + 1; i <= n; i++)
+        ks.push_back("/blk/" + std::to_string(i));
+
+      auto o = make_shared<OverlaidAcns>(base);
+      vector<optional<string>> vs = this->chain->getManyFromChainDB(ks);
+      for (size_t i = 0; i < vs.size(); i++){
+        ExecBlk b;
+        if ((not vs[i]) or (not b.fromString(vs[i].value()))){
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Failed to load %s for replay" S_NOR) % ks[i];
+          return nullptr;
+        }
+        for (const vector<StateChange> & j : b.stateChanges)
+          o->apply(j);
+      }
+      return o;
+    }
+  };
+
+  /**
+   * @brief The IAcnGettableAt without versions: only the latest state, read
+   * from the live `wrld`. Used in the RAM mode, where snapshots are copies.
+   */
+  class LiveAcns: public virtual IAcnGettableAt{
+  public:
+    IAcnGettable * const wrld;
+    LiveAcns(IAcnGettable * const w): wrld(w){}
+
+    shared_ptr<IAcnGettable> acnsAt(optional<uint64_t> n = {}) noexcept override{
+      if (n) return nullptr;
+      return shared_ptr<IAcnGettable>(shared_ptr<IAcnGettable>(), this->wrld); // 🦜 : not owned
+    }
+  };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "core.hpp"
+#include "blkLog.hpp"
 #include <cassert>
 #include <unordered_map>
 #include <map>
@@ -7,7 +8,18 @@
 #include <rocksdb/convenience.h> // grab db.h,status.h,table.h (BlockBasedTableOptions)
 #include <rocksdb/slice_transform.h> // NewCappedPrefixTransform
 #include <rocksdb/filter_policy.h> // NewBloomFilterPolicy
+#include <rocksdb/utilities/checkpoint.h> // Checkpoint
+#include <rocksdb/cache.h> // NewLRUCache
+#include <rocksdb/rate_limiter.h> // NewGenericRateLimiter
+#include <rocksdb/statistics.h> // CreateDBStatistics
+#include <rocksdb/listener.h> // EventListener
 
+#include <charconv> // from_chars
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
 #include <filesystem>
 namespace filesystem = std::filesystem;
 using rocksdb::NewCappedPrefixTransform;
@@ -27,7 +39,129 @@ using std::map;
 
 namespace weak {
 
-  
+  /**
+   * @brief The decoded contract codes shared by the Acns, keyed by the codehash.
+   *
+   * <2024-07-22 Mon> 🦜 : Many Acns (e.g. the clones made by a factory) have the
+   * same code, so we keep one buffer per codehash. It's a LRU bounded by the
+   * total bytes, just like BlkCache.
+   */
+  class CodeCache{
+  public:
+    const size_t max_bytes;
+    std::atomic<uint64_t> n_hit{0};
+    std::atomic<uint64_t> n_miss{0};
+
+    CodeCache(size_t m = 32 << 20 /*32MB*/): max_bytes(m){}
+
+    shared_ptr<const bytes> get(const string & k) noexcept{
+      std::unique_lock g(this->lock);
+      auto it = this->m.find(k);
+      if (it == this->m.end()){
+        this->n_miss++;
+        return nullptr;
+      }
+      this->n_hit++;
+      this->l.splice(this->l.begin(), this->l, it->second);
+      return std::get<1>(*(it->second));
+    }
+
+    void put(const string & k, shared_ptr<const bytes> c) noexcept{
+      if (c->size() > this->max_bytes) return;
+      std::unique_lock g(this->lock);
+      if (this->m.contains(k)) return; // 🦜 : content-addressed, so it's the same thing
+      this->n_bytes += c->size();
+      this->l.emplace_front(k, std::move(c));
+      this->m[k] = this->l.begin();
+      while (this->n_bytes > this->max_bytes){
+        auto & [k0, c0] = this->l.back();
+        this->n_bytes -= c0->size();
+        this->m.erase(k0);
+        this->l.pop_back();
+      }
+    }
+
+  private:
+    std::mutex lock;
+    size_t n_bytes{0};
+    std::list<tuple<string,shared_ptr<const bytes>>> l; // <! front = most recently used
+    unordered_map<string,std::list<tuple<string,shared_ptr<const bytes>>>::iterator> m;
+  };
+
+  /**
+   * @brief How the two rocksdbs of WorldStorage are tuned, see
+   * WorldStorage::getInitOptions().
+   *
+   * <2024-07-26 Fri> 🦜 : A node that mostly writes (a sealer on a busy chain),
+   * one that mostly reads (serving the Rpc) and one on a small box want
+   * different things from rocksdb, so there're a few named profiles:
+   *
+   *  - `default` : what we always did (IncreaseParallelism(),
+   *    OptimizeLevelStyleCompaction(), a bloom filter for the chainDB only).
+   *  - `write-heavy` : big memtables, more background jobs, light compression
+   *    and the flushes/compactions rate-limited (auto-tuned) so that they don't
+   *    come in bursts.
+   *  - `read-heavy` : a big block cache holding the index and filter blocks
+   *    too, and LZ4 on every level from L2 so more of the data fits in it.
+   *  - `low-memory` : small memtables, a small block cache that also bounds the
+   *    index and filter blocks, and LZ4HC at the bottom.
+   *
+   * 🐢 : Our rocksdb is built with LZ4 only (see build.sh), so that's what the
+   * profiles use.
+   */
+  struct StorageProfile{
+    string name{"default"};
+    size_t block_cache_mb = 0;   // <! shared by the two DBs, 0 ⇒ rocksdb's default (one small cache per DB)
+    bool cache_index_and_filter = false; // <! put the index and filter blocks in the block cache
+    size_t write_buffer_mb = 0;  // <! 0 ⇒ OptimizeLevelStyleCompaction()'s
+    int max_write_buffer_number = 0; // <! 0 ⇒ rocksdb's default
+    int max_background_jobs = 0; // <! 0 ⇒ IncreaseParallelism()'s
+    size_t rate_limit_mb = 0;    // <! MB/s for the flushes and compactions, 0 ⇒ unlimited
+    vector<rocksdb::CompressionType> compression_per_level; // <! empty ⇒ OptimizeLevelStyleCompaction()'s
+    int max_open_files = -1;
+    bool statistics = false;     // <! collect the tickers (a few % slower), see WorldStorage::stats()
+    bool state_wal = true;       // <! false ⇒ write the stateDB without WAL, see stateCommit.hpp
+    rocksdb::Env * env = nullptr; // <! null ⇒ rocksdb's default. (The tests use one that loses the unsynced writes.)
+
+    static optional<StorageProfile> fromName(const string & n) noexcept{
+      const rocksdb::CompressionType N = rocksdb::kNoCompression, L = rocksdb::kLZ4Compression,
+        H = rocksdb::kLZ4HCCompression;
+      const size_t ncpu = std::max(std::thread::hardware_concurrency(), 1u);
+      StorageProfile p;
+      p.name = n;
+      if (n == "default")
+        return p;
+      if (n == "write-heavy"){
+        p.block_cache_mb = 64;
+        p.write_buffer_mb = 128;
+        p.max_write_buffer_number = 6;
+        p.max_background_jobs = static_cast<int>(std::max(ncpu, size_t{4}));
+        p.rate_limit_mb = 256;
+        p.compression_per_level = {N, N, L, L, L, L, L};
+        return p;
+      }
+      if (n == "read-heavy"){
+        p.block_cache_mb = 512;
+        p.cache_index_and_filter = true;
+        p.write_buffer_mb = 64;
+        p.max_background_jobs = static_cast<int>(std::clamp(ncpu / 2, size_t{2}, size_t{8}));
+        p.compression_per_level = {N, N, L, L, L, L, L};
+        return p;
+      }
+      if (n == "low-memory"){
+        p.block_cache_mb = 8;
+        p.cache_index_and_filter = true;
+        p.write_buffer_mb = 8;
+        p.max_write_buffer_number = 2;
+        p.max_background_jobs = 2;
+        p.rate_limit_mb = 32;
+        p.compression_per_level = {N, L, L, L, L, L, H};
+        p.max_open_files = 256;
+        return p;
+      }
+      return {};
+    }
+  };
 
   /**
    * @brief The core storage.
@@ -39,14 +173,46 @@ namespace weak {
    */
   class WorldStorage: public virtual IWorldChainStateSettable,
                       public virtual IAcnGettable,
-                      public virtual IChainDBGettable2
+                      public virtual IChainDBGettable2,
+                      public virtual IAcnSnapshotable,
+                      public virtual IStateCheckpointable,
+                      public virtual IAcnIterable,
+                      public virtual IStateDurable
   {
   public:
     rocksdb::DB* chainDB;
     rocksdb::DB* stateDB;
+    const filesystem::path checkpointDir; // <! where the checkpoints of stateDB go
+    mutable CodeCache code_cache;         // <! the codes in `code/<codehash>`
+    unique_ptr<BlkLog> blk_log;           // <! optional, where the "/blk/<n>" go, see blkLog.hpp
+    /*
+      🦜 : Some "/blk/<n>" are in the chainDB although we have a BlkLog (the
+      log couldn't take them, see setInChainDB()). Those win over the log.
+     */
+    std::atomic<bool> blks_in_chainDB{false};
+    const StorageProfile profile;
+
+    /*
+      <2024-07-22 Mon> 🦜 : Codes at least this long are kept in `code/<codehash>`
+      of the stateDB, and the Acn only keeps the hash (`Acn::code_ref`). Shorter
+      ones aren't worth an extra read.
+     */
+    static constexpr size_t CODE_REF_MIN = 64;
 
+    /**
+     * @param d The data dir.
+     * @param with_blk_log <2024-07-23 Tue> 🦜 : Put the ExecBlks ("/blk/<n>") in
+     * a BlkLog at `d/blkLog` instead of the chainDB. The ones already in the
+     * chainDB are moved there on the first start (see migrateBlksToLog()). If
+     * that fails, the BlkLog isn't used this time.
+     * @param sync_every Flush the BlkLog every this many Blks.
+     * @param p How the rocksdbs are tuned, see StorageProfile.
+     */
     WorldStorage(filesystem::path d =
-                 filesystem::current_path()) {
+                 filesystem::current_path(),
+                 bool with_blk_log = false, size_t sync_every = 16,
+                 StorageProfile p = {}): checkpointDir(d / "stateCheckpoints"),
+                                         profile(std::move(p)) {
 
       // The DB-dir
       filesystem::path chainDir = d / "chainDB",
@@ -68,15 +234,61 @@ namespace weak {
       // removeDirIfExist(chainDir);
       // removeDirIfExist(stateDir);
 
+      // 🐢 : one block cache and one rate limiter for both DBs
+      if (this->profile.block_cache_mb > 0)
+        this->block_cache = rocksdb::NewLRUCache(this->profile.block_cache_mb << 20);
+      if (this->profile.rate_limit_mb > 0)
+        this->rate_limiter.reset(rocksdb::NewGenericRateLimiter(static_cast<int64_t>(this->profile.rate_limit_mb << 20),
+                                                                100'000 /*refill every 100ms*/, 10 /*fairness*/,
+                                                                rocksdb::RateLimiter::Mode::kWritesOnly,
+                                                                true /*auto-tuned*/));
+      BOOST_LOG_TRIVIAL(info) << format("🌍 Storage profile: " S_CYAN "%s" S_NOR) % this->profile.name;
+
       openChainDB(chainDir);
       openStateDB(stateDir);
+      if (with_blk_log){
+        filesystem::path l = d / "blkLog";
+        if (filesystem::exists(l) or this->migrateBlksToLog(l)){
+          this->blk_log = make_unique<BlkLog>(l, 64 << 20, sync_every);
+          if (tryGetKvString(this->chainDB, BLKS_MOVING))
+            this->dropBlksMovedToLog();
+          this->blks_in_chainDB = hasKeyWithPrefix(this->chainDB, "/blk/");
+        }else
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ The Blks stay in the chainDB, will try again next time" S_NOR);
+      }
+
+      /*
+        <2024-07-26 Fri> 🦜 : Without the WAL of the stateDB, we need to know
+        from where to replay. If there's no mark yet, the state so far was
+        written with the WAL (or there's nothing), so it starts at the latest
+        Blk.
+
+        <2024-07-28 Sun> 🦜 : At the latest Blk, not right after it: a Blk is
+        put on the chain before its state is written (see
+        BlkExecutor::commitBlk()), so a crash in between leaves the latest
+        Blk's state unwritten. Redoing it is harmless, so we do that with the
+        WAL too (the replay then removes the mark).
+       */
+      if (not this->stateReplayFrom()){
+        optional<uint64_t> n = this->latestBlkNumber();
+        if ((not this->profile.state_wal) or n)
+          this->markStateDurable(n ? n.value() : 0);
+      }
       BOOST_LOG_TRIVIAL(debug) << format("🌍 WorldStorage ctor done.");
     };
 
     ~WorldStorage(){
       BOOST_LOG_TRIVIAL(info) << format("❄ Closing WorldStorage");
-      delete chainDB;
+      // 🐢 : A clean close, so nothing is lost and nothing to replay next time
+      if (not this->profile.state_wal){
+        optional<uint64_t> n = this->latestBlkNumber();
+        this->markStateDurable(n ? n.value() + 1 : 0);
+      }
+      // 🦜 : the stateDB first, its flushes sync the chain (see ChainSyncer)
       delete stateDB;
+      this->stateDB = nullptr;
+      this->blk_log.reset();
+      delete chainDB;
 }
 
     vector<string> getKeysStartWith(string_view prefix) const override{
@@ -93,7 +305,20 @@ namespace weak {
       return ks;
     }
 
+    static bool hasKeyWithPrefix(rocksdb::DB * db, string_view p){
+      unique_ptr<rocksdb::Iterator> it{db->NewIterator(rocksdb::ReadOptions())};
+      it->Seek(rocksdb::Slice{p});
+      return it->Valid() and it->key().starts_with(rocksdb::Slice{p});
+    }
+
     bool setInChainDB(const string k, const string v) override{
+      if (optional<uint64_t> n = this->blkNumberInLog(k)){
+        if (this->blk_log->append(n.value(), v))
+          return true;
+        BOOST_LOG_TRIVIAL(warning) << format(S_MAGENTA "⚠️ Putting %s in the chainDB instead" S_NOR) % k;
+        // 🦜 : From now on the chainDB is asked first, the log may have an old one
+        this->blks_in_chainDB = true;
+      }
       BOOST_LOG_TRIVIAL(debug) << format("Setting chainDB\n\t" S_CYAN "k=%s\n\tv=%s" S_NOR)
         % k % pure::get_data_for_log(v);
       rocksdb::Status s = this->chainDB->Put(rocksdb::WriteOptions(), k, v);
@@ -101,31 +326,381 @@ namespace weak {
     };
 
     optional<string> getFromChainDB(const string k) const override{
+      if (optional<uint64_t> n = this->blkNumberInLog(k)){
+        if (this->blks_in_chainDB)
+          if (optional<string> v = tryGetKvString(this->chainDB,k))
+            return v;
+        if (optional<string_view> v = this->blk_log->get(n.value()))
+          return string(v.value());
+        if (this->blks_in_chainDB) return {}; // 🦜 : already asked
+      }
+      // 🦜 : Not in the log ⇒ maybe an old one in the chainDB
       BOOST_LOG_TRIVIAL(debug) << format("Getting chainDB\n\t" S_CYAN "k=%s" S_NOR)
         % k;
       return tryGetKvString(this->chainDB,k);
     };
 
-    bool applyJournalStateDB(const vector<StateChange> & j) override{
+    /**
+     * @brief If `k` is "/blk/<n>" and we have a BlkLog, return `n`.
+     */
+    optional<uint64_t> blkNumberInLog(string_view k) const noexcept{
+      if ((not this->blk_log) or (not k.starts_with("/blk/"))) return {};
+      k.remove_prefix(5);
+      uint64_t n;
+      auto [p, ec] = std::from_chars(k.data(), k.data() + k.size(), n);
+      if (ec != std::errc() or p != k.data() + k.size()) return {};
+      return n;
+    }
+
+    /*
+      🦜 : Set while the Blks are being moved to the BlkLog, see
+      migrateBlksToLog().
+     */
+    static constexpr const char * BLKS_MOVING = "/other/blks_moving_to_log";
+
+    /**
+     * @brief Move the ExecBlks in the chainDB ("/blk/<n>") to a new BlkLog at `l`.
+     *
+     * 🐢 : This is done once, when a data dir made without the BlkLog is
+     * opened with it. The Blks are appended in order, 0 (or the first one
+     * found) to "/other/blk_number", and it's all or nothing:
+     *
+     *   1. the Blks go to a BlkLog at `l.tmp`, which is synced and closed,
+     *   2. BLKS_MOVING is put in the chainDB (with `sync`),
+     *   3. `l.tmp` is renamed to `l`,
+     *   4. the "/blk/..." are deleted from the chainDB, and so is BLKS_MOVING.
+     *
+     * 🦜 : And if we crash in between ?
+     *
+     * 🐢 : Before 3, there's no `l`, so it's all done again next time (`l.tmp`
+     * is thrown away). After 3, BLKS_MOVING is still there, so next time 4 is
+     * done by dropBlksMovedToLog().
+     *
+     * @return false if the Blks couldn't be moved, then they're all still in
+     * the chainDB and there should be no BlkLog.
+     */
+    bool migrateBlksToLog(const filesystem::path & l) noexcept{
+      std::error_code ec;
+      optional<string> rN = tryGetKvString(this->chainDB, "/other/blk_number");
+      if (not rN) return true;  // 🦜 : nothing to move
+      optional<uint64_t> N = parseU64(rN.value());
+      if (not N) return false;
+
+      filesystem::path t = l;
+      t += ".tmp";
+      filesystem::remove_all(t, ec);
+      if (ec) return false;
+
+      BOOST_LOG_TRIVIAL(info) << format("📜 Moving " S_CYAN "%d" S_NOR " Blks from the chainDB to the BlkLog") % (N.value() + 1);
+      size_t moved = 0;
+      bool ok = true;
+      try {
+        BlkLog tl{t};
+        const uint64_t step = 256;
+        for (uint64_t i = 0; ok and i <= N.value(); i += step){
+          vector<string> ks;
+          for (uint64_t j = i; j <= std::min(N.value(), i + step - 1); j++)
+            ks.push_back("/blk/" + std::to_string(j));
+          vector<rocksdb::Slice> sks(ks.begin(), ks.end());
+          vector<string> vs;
+          vector<rocksdb::Status> ss = this->chainDB->MultiGet(rocksdb::ReadOptions(), sks, &vs);
+          for (size_t j = 0; ok and j < ks.size(); j++){
+            if (ss[j].IsNotFound() and moved == 0) continue; // 🦜 : the chain may not start at 0
+            if ((not ss[j].ok()) or (not tl.append(i + j, vs[j]))){
+              BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Failed to move %s to the BlkLog" S_NOR) % ks[j];
+              ok = false;
+            }else
+              moved++;
+          }
+        }
+        if (ok) tl.sync();
+      }catch (const std::exception & e){
+        BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Failed to open the BlkLog at %s: %s" S_NOR) % t % e.what();
+        ok = false;
+      }
+
+      rocksdb::WriteOptions o;
+      o.sync = true;
+      if (ok)
+        ok = checkStatus(this->chainDB->Put(o, BLKS_MOVING, "1"), "", false/*not fatal*/);
+      if (ok){
+        filesystem::rename(t, l, ec);
+        if (ec){
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Failed to rename %s: %s" S_NOR) % t % ec.message();
+          ok = false;
+        }
+      }
+      if (not ok){
+        filesystem::remove_all(t, ec);
+        return false;
+      }
+      BOOST_LOG_TRIVIAL(info) << format("📜 Moved " S_CYAN "%d" S_NOR " Blk%s") % moved % pluralizeOn(moved);
+
+      // 🦜 : '0' comes right after '/', so this is all the "/blk/..."
+      rocksdb::Status s = this->chainDB->DeleteRange(rocksdb::WriteOptions(), this->chainDB->DefaultColumnFamily(),
+                                                     "/blk/", "/blk0");
+      if (checkStatus(s, "", false/*not fatal*/)){
+        rocksdb::Slice b{"/blk/"}, e{"/blk0"};
+        this->chainDB->CompactRange(rocksdb::CompactRangeOptions(), &b, &e);
+        checkStatus(this->chainDB->Delete(rocksdb::WriteOptions(), BLKS_MOVING), "", false);
+      }
+      return true;              // 🐢 : the log is complete, the rest can wait
+    }
+
+    /**
+     * @brief Step 4 of migrateBlksToLog(), after a crash: delete the
+     * "/blk/<n>" in the chainDB that are the same as in the BlkLog, then
+     * BLKS_MOVING.
+     *
+     * 🐢 : Not a DeleteRange() this time: the BlkLog has been in use, so a
+     * "/blk/<n>" that's different is one the log couldn't take (see
+     * setInChainDB()), and must stay.
+     */
+    bool dropBlksMovedToLog() noexcept{
+      BOOST_LOG_TRIVIAL(info) << format("📜 Finishing moving the Blks to the BlkLog");
       rocksdb::WriteBatch b;
-      for (const StateChange & i : j){
-        bool ok;
-        if (i.del){
-          BOOST_LOG_TRIVIAL(info) << format("Adding 🚮️ Deletion " S_MAGENTA "k=%s" S_NOR) % i.k;
-          b.Delete(i.k);
-        }else{
-          // <2024-03-15 Fri> 🦜 : Only log the content if not with pb
-          BOOST_LOG_TRIVIAL(debug) << format("Adding ⚙️ Insertion "
-                                             S_CYAN "(k,v) = (%s,%s)" S_NOR) % i.k
-            /*% i.v;*/ % pure::get_data_for_log(i.v); // <- 🦜 : considers pb
-          b.Put(i.k,i.v);
+      {
+        unique_ptr<rocksdb::Iterator> it{this->chainDB->NewIterator(rocksdb::ReadOptions())};
+        rocksdb::Slice p{"/blk/"};
+        for (it->Seek(p); it->Valid() and it->key().starts_with(p); it->Next()){
+          optional<uint64_t> n = this->blkNumberInLog(string_view(it->key().data(), it->key().size()));
+          if (not n) continue;
+          if (optional<string_view> v = this->blk_log->get(n.value());
+              v and v.value() == string_view(it->value().data(), it->value().size()))
+            b.Delete(it->key());
         }
       }
-      BOOST_LOG_TRIVIAL(info) << format("Applying batch");
-      rocksdb::Status s = this->stateDB->Write(rocksdb::WriteOptions(),&b);
-      return checkStatus(s,"Failed to apply journal batch to StateDB");
+      b.Delete(BLKS_MOVING);
+      return checkStatus(this->chainDB->Write(rocksdb::WriteOptions(), &b), "", false/*not fatal*/);
+    }
+
+    /**
+     * @brief Get many keys in one go with RocksDB's MultiGet(), which batches
+     * the lookups of the memtable and the block cache.
+     */
+    vector<optional<string>> getManyFromChainDB(const vector<string> & ks) const override{
+      BOOST_LOG_TRIVIAL(debug) << format("Getting %d keys from chainDB") % ks.size();
+      vector<optional<string>> o(ks.size());
+
+      /*
+        🦜 : The Blks in the BlkLog first, the rest go to MultiGet(). Unless
+        some Blks are in the chainDB (blks_in_chainDB), then it's the other
+        way round, like getFromChainDB().
+       */
+      const bool log_first = not this->blks_in_chainDB;
+      vector<size_t> is;
+      vector<rocksdb::Slice> sks;
+      for (size_t i = 0; i < ks.size(); i++){
+        if (log_first)
+          if (optional<uint64_t> n = this->blkNumberInLog(ks[i]))
+            if (optional<string_view> v = this->blk_log->get(n.value())){
+              o[i] = string(v.value());
+              continue;
+            }
+        is.push_back(i);
+        sks.push_back(ks[i]);
+      }
+      if (sks.empty()) return o;
+
+      vector<string> vs;
+      vector<rocksdb::Status> ss = this->chainDB->MultiGet(rocksdb::ReadOptions(), sks, &vs);
+      for (size_t j = 0; j < is.size(); j++){
+        if (ss[j].IsNotFound()){
+          if (not log_first)
+            if (optional<uint64_t> n = this->blkNumberInLog(ks[is[j]]))
+              if (optional<string_view> v = this->blk_log->get(n.value()))
+                o[is[j]] = string(v.value());
+          continue;
+        }
+        if (checkStatus(ss[j],"",false/*not fatal*/))
+          o[is[j]] = std::move(vs[j]);
+      }
+      return o;
+    }
+
+    bool applyJournalStateDB(const vector<StateChange> & j) override{
+      rocksdb::WriteBatch b;
+      NewCodes n;
+      this->addToBatch(j, b, n);
+      return this->writeStateBatch(b, n);
+    };
+
+    /**
+     * @brief Apply the journals of a Blk in one WriteBatch.
+     *
+     * <2024-07-26 Fri> 🦜 : Only the last change of each key goes in the batch,
+     * so a hot Acn is parsed (moveCodeOut()) and written once per Blk instead
+     * of once per Tx.
+     */
+    bool applyJournalsStateDB(const vector<vector<StateChange>> & J) override{
+      rocksdb::WriteBatch b;
+      NewCodes n;
+      for (const StateChange * c : lastChangeOfEachKey(J))
+        this->addToBatch(*c, b, n);
+      return this->writeStateBatch(b, n);
+    }
+
+    static constexpr const char * STATE_REPLAY_FROM = "/other/state_replay_from";
+
+    optional<uint64_t> stateReplayFrom() const noexcept override{
+      optional<string> v = tryGetKvString(this->chainDB, STATE_REPLAY_FROM);
+      if (not v) return {};
+      return parseU64(v.value());
+    }
+
+    /**
+     * @brief Flush the stateDB's memtables (and the chainDB's WAL, the
+     * BlkLog), then save the mark in the chainDB with `sync`.
+     *
+     * 🐢 : This is the fsync of the group commit, see StateGroupCommitter.
+     */
+    bool markStateDurable(optional<uint64_t> n) noexcept override{
+      rocksdb::WriteOptions o;
+      o.sync = true;
+      if (not n)
+        return checkStatus(this->chainDB->Delete(o, STATE_REPLAY_FROM), "", false);
+
+      rocksdb::FlushOptions f;
+      f.wait = true;
+      if (not checkStatus(this->stateDB->Flush(f), "Failed to flush stateDB", false))
+        return false;
+      if (not this->syncChain())
+        return false;
+      BOOST_LOG_TRIVIAL(debug) << format("💾 State durable, replay from Blk-%d") % n.value();
+      return checkStatus(this->chainDB->Put(o, STATE_REPLAY_FROM, std::to_string(n.value())), "", false);
+    }
+
+    /**
+     * @brief Make what's written to the chain so far durable: sync the BlkLog
+     * and the chainDB's WAL.
+     */
+    bool syncChain() noexcept{
+      if (this->blk_log) this->blk_log->sync();
+      return checkStatus(this->chainDB->FlushWAL(true /*sync*/), "Failed to sync chainDB", false);
+    }
+
+  private:
+    /*
+      <2024-07-28 Sun> 🦜 : Without the WAL, the stateDB is durable as soon as a
+      memtable is flushed, and rocksdb does that on its own whenever one is
+      full, not only in markStateDurable(). If the chain of those Blks is
+      still in the page cache, a power cut leaves a stateDB that is ahead of
+      the chain, and replay() can't fix that. So right before each flush of
+      the stateDB, we sync the chain. (A Blk is put on the chain before its
+      state is written, see BlkExecutor::commitBlk().)
+     */
+    class ChainSyncer: public rocksdb::EventListener{
+    public:
+      WorldStorage * const w;
+      ChainSyncer(WorldStorage * ww): w(ww){}
+      void OnFlushBegin(rocksdb::DB *, const rocksdb::FlushJobInfo &) override{
+        BOOST_LOG_TRIVIAL(debug) << format("💾 Syncing the chain before flushing the stateDB");
+        this->w->syncChain();
+      }
     };
 
+    /// "/other/blk_number" in the chainDB
+    optional<uint64_t> latestBlkNumber() const noexcept{
+      optional<string> v = tryGetKvString(this->chainDB, "/other/blk_number");
+      if (not v) return {};
+      return parseU64(v.value());
+    }
+
+    static optional<uint64_t> parseU64(string_view s) noexcept{
+      uint64_t x;
+      auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), x);
+      if (ec != std::errc() or p != s.data() + s.size()) return {};
+      return x;
+    }
+
+    /*
+      <2024-07-28 Sun> 🦜 : The codes put in a batch by moveCodeOut(). They go
+      in the code_cache only once the batch is written, so that whatever is in
+      the cache is in the stateDB.
+     */
+    using NewCodes = vector<tuple<string,shared_ptr<const bytes>>>;
+
+    bool writeStateBatch(rocksdb::WriteBatch & b, const NewCodes & n = {}){
+      BOOST_LOG_TRIVIAL(info) << format("Applying batch");
+      rocksdb::WriteOptions o;
+      o.disableWAL = not this->profile.state_wal;
+      rocksdb::Status s = this->stateDB->Write(o,&b);
+      if (not checkStatus(s,"Failed to apply journal batch to StateDB"))
+        return false;
+      for (const auto & [k, c] : n)
+        this->code_cache.put(k, c);
+      return true;
+    }
+
+    void addToBatch(const vector<StateChange> & j, rocksdb::WriteBatch & b, NewCodes & n) const{
+      for (const StateChange & i : j)
+        this->addToBatch(i, b, n);
+    }
+
+    void addToBatch(const StateChange & i, rocksdb::WriteBatch & b, NewCodes & n) const{
+      if (i.del){
+        BOOST_LOG_TRIVIAL(info) << format("Adding 🚮️ Deletion " S_MAGENTA "k=%s" S_NOR) % i.k;
+        b.Delete(i.k);
+      }else{
+        // <2024-03-15 Fri> 🦜 : Only log the content if not with pb
+        BOOST_LOG_TRIVIAL(debug) << format("Adding ⚙️ Insertion "
+                                           S_CYAN "(k,v) = (%s,%s)" S_NOR) % i.k
+          /*% i.v;*/ % pure::get_data_for_log(i.v); // <- 🦜 : considers pb
+        optional<string> v = this->moveCodeOut(i.v, b, n);
+        b.Put(i.k, v ? v.value() : i.v);
+      }
+    }
+
+  public:
+
+
+    /**
+     * @brief Move the code of the Acn `v` to `code/<codehash>` (in batch `b`).
+     *
+     * @param n Gets the code if it's put in `b`, for the code_cache once `b`
+     * is written (see writeStateBatch()).
+     * @return The Acn with only the `code_ref`, or {} if `v` should be stored
+     * as it is.
+     *
+     * 🐢 : The `code/..` entries are never deleted, other Acns may still use
+     * them. So a code in the code_cache is in the stateDB, and needn't be put
+     * again.
+     */
+    optional<string> moveCodeOut(const string & v, rocksdb::WriteBatch & b, NewCodes & n) const noexcept{
+      Acn a;
+      if ((not a.fromString(v)) or a.code.size() < CODE_REF_MIN)
+        return {};
+
+      hash256 h = a.codehash();
+      string k = codeKey(h);
+      if (not this->code_cache.get(k)){
+        auto c = make_shared<const bytes>(std::move(a.code));
+        b.Put(k, weak::toString(*c)); // 🦜 : content-addressed, so putting it twice is harmless
+        n.emplace_back(k, std::move(c));
+      }
+      a.code.clear();
+      a.code_ref = h;
+      return a.toString();
+    }
+
+    static string codeKey(const hash256 & h) noexcept{
+      return "code/" + hashToString(h);
+    }
+
+    /**
+     * @brief Walk the Acns in the stateDB.
+     *
+     * 🐢 : The codes are not loaded, Acn::codehash() works without them.
+     */
+    void forEachAcn(function<void(const string &, const Acn &)> f) const override{
+      unique_ptr<rocksdb::Iterator> it{this->stateDB->NewIterator(rocksdb::ReadOptions())};
+      for (it->SeekToFirst(); it->Valid(); it->Next()){
+        if (it->key().starts_with("code/")) continue;
+        Acn a;
+        if (a.fromString(string_view(it->value().data(), it->value().size())))
+          f(it->key().ToString(), a);
+      }
+    }
 
     /**
      * @brief Get the serialized Acn from the stateDB.
@@ -135,7 +710,203 @@ namespace weak {
       string k = addressToString(addr);
       BOOST_LOG_TRIVIAL(debug) << format("Getting Acn\n\t" S_CYAN "k=%s" S_NOR) % k;
 
-      optional<string> v = tryGetKvString(this->stateDB,k);
+      return loadAcn(this->stateDB, k, rocksdb::ReadOptions());
+    };
+
+    shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+      return loadCode(this->stateDB, h, rocksdb::ReadOptions(), &this->code_cache);
+    }
+
+    /**
+     * @brief Get many Acns with one MultiGet().
+     */
+    vector<optional<Acn>> getManyAcns(const vector<evmc::address> & as) const noexcept override{
+      BOOST_LOG_TRIVIAL(debug) << format("Getting %d Acn%s") % as.size() % pluralizeOn(as.size());
+      vector<string> ks;
+      ks.reserve(as.size());
+      for (const evmc::address & a : as)
+        ks.push_back(addressToString(a));
+      return loadAcns(this->stateDB, ks, rocksdb::ReadOptions());
+    }
+
+    /**
+     * @brief The Acns seen through a RocksDB snapshot of the stateDB.
+     *
+     * 🐢 : The snapshot is released when the last holder lets it go, so it
+     * must not outlive the WorldStorage.
+     */
+    class AcnSnapshot: public virtual IAcnGettable{
+    public:
+      rocksdb::DB * const db;
+      const rocksdb::Snapshot * const snapshot;
+      CodeCache * const cache;
+      AcnSnapshot(rocksdb::DB * const d, CodeCache * const c):
+        db(d), snapshot(d->GetSnapshot()), cache(c){}
+      ~AcnSnapshot(){ this->db->ReleaseSnapshot(this->snapshot); }
+
+      optional<Acn> getAcn(evmc::address addr) const noexcept override{
+        rocksdb::ReadOptions o;
+        o.snapshot = this->snapshot;
+        return loadAcn(this->db, addressToString(addr), o);
+      }
+      shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+        rocksdb::ReadOptions o;
+        o.snapshot = this->snapshot;
+        return loadCode(this->db, h, o, this->cache);
+      }
+    };
+
+    shared_ptr<IAcnGettable> snapshotOfAcns() const override{
+      return make_shared<AcnSnapshot>(this->stateDB, &this->code_cache);
+    }
+
+    /**
+     * @brief A stateDB opened read-only, used for the checkpoints.
+     */
+    class ReadOnlyAcns: public virtual IAcnGettable{
+    public:
+      rocksdb::DB * db;
+      CodeCache * const cache;
+      ReadOnlyAcns(rocksdb::DB * d, CodeCache * const c): db(d), cache(c){}
+      ~ReadOnlyAcns(){ delete this->db; }
+      optional<Acn> getAcn(evmc::address addr) const noexcept override{
+        return loadAcn(this->db, addressToString(addr), rocksdb::ReadOptions());
+      }
+      shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+        return loadCode(this->db, h, rocksdb::ReadOptions(), this->cache);
+      }
+    };
+
+    /**
+     * @brief Save the stateDB as it is now into `checkpointDir/<n>`.
+     *
+     * 🐢 : RocksDB hard-links the SST files, so this is cheap as long as the
+     * checkpoints are on the same filesystem as the stateDB.
+     */
+    bool checkpointState(uint64_t n) noexcept override{
+      filesystem::path p = this->checkpointDir / std::to_string(n);
+      BOOST_LOG_TRIVIAL(info) << format("📸 Checkpointing stateDB at " S_CYAN "%s" S_NOR) % p.string();
+      try{
+        filesystem::create_directories(this->checkpointDir);
+        if (filesystem::exists(p)) return true; // 🦜 : already there
+        rocksdb::Checkpoint * c;
+        if (not checkStatus(rocksdb::Checkpoint::Create(this->stateDB, &c),
+                            "Failed to create Checkpoint object", false))
+          return false;
+        unique_ptr<rocksdb::Checkpoint> g{c};
+        return checkStatus(c->CreateCheckpoint(p.string()),
+                           "Failed to checkpoint stateDB at " + p.string(), false);
+      }catch(std::exception & e){
+        BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ Error checkpointing: %s" S_NOR) % e.what();
+        return false;
+      }
+    }
+
+    bool removeStateCheckpoint(uint64_t n) noexcept override{
+      std::error_code ec;
+      filesystem::remove_all(this->checkpointDir / std::to_string(n), ec);
+      return not ec;
+    }
+
+    vector<uint64_t> listStateCheckpoints() const noexcept override{
+      vector<uint64_t> o;
+      std::error_code ec;
+      if (not filesystem::is_directory(this->checkpointDir, ec)) return o;
+      for (const auto & e : filesystem::directory_iterator(this->checkpointDir, ec)){
+        string f = e.path().filename().string();
+        uint64_t n;
+        auto [p, err] = std::from_chars(f.data(), f.data() + f.size(), n);
+        if (err == std::errc() and p == f.data() + f.size())
+          o.push_back(n);
+      }
+      std::sort(o.begin(), o.end());
+      return o;
+    }
+
+    shared_ptr<IAcnGettable> openStateCheckpoint(uint64_t n) const noexcept override{
+      filesystem::path p = this->checkpointDir / std::to_string(n);
+      rocksdb::DB * db;
+      rocksdb::Status s = rocksdb::DB::OpenForReadOnly(this->stateDBOptions(), p.string(), &db);
+      if (not checkStatus(s, "Failed to open checkpoint at " + p.string(), false))
+        return nullptr;
+      return make_shared<ReadOnlyAcns>(db, &this->code_cache);
+    }
+
+    /**
+     * @brief What rocksdb says about the two DBs, for `/get_storage_stats`.
+     *
+     * <2024-07-26 Fri> 🦜 : For each DB: the `rocksdb.stats` text (compaction
+     * and stall stats), some integer properties, the number of files at each
+     * level and, with StorageProfile::statistics, the non-zero tickers. (We only
+     * use the default column family, so these are the per-CF numbers too.)
+     */
+    json::object stats() const noexcept{
+      json::object o;
+      o["profile"] = this->profile.name;
+      o["chainDB"] = dbStats(this->chainDB, this->chain_stats.get());
+      o["stateDB"] = dbStats(this->stateDB, this->state_stats.get());
+      if (this->block_cache){
+        json::object c;
+        c["capacity"] = this->block_cache->GetCapacity();
+        c["usage"] = this->block_cache->GetUsage();
+        c["pinned_usage"] = this->block_cache->GetPinnedUsage();
+        o["block_cache"] = c;
+      }
+      o["code_cache"] = json::object{{"hit", this->code_cache.n_hit.load()},
+                                     {"miss", this->code_cache.n_miss.load()}};
+      return o;
+    }
+
+  private:
+    shared_ptr<rocksdb::Cache> block_cache;         // <! null ⇒ per-DB default
+    shared_ptr<rocksdb::RateLimiter> rate_limiter;  // <! null ⇒ unlimited
+    shared_ptr<rocksdb::Statistics> chain_stats, state_stats; // <! null unless StorageProfile::statistics
+
+    static json::object dbStats(rocksdb::DB * const db, rocksdb::Statistics * const st) noexcept{
+      json::object o;
+      string v;
+      if (db->GetProperty("rocksdb.stats", &v))
+        o["stats"] = v;
+
+      json::object ps;
+      for (const char * k : {"rocksdb.estimate-num-keys", "rocksdb.total-sst-files-size",
+                             "rocksdb.live-sst-files-size", "rocksdb.cur-size-all-mem-tables",
+                             "rocksdb.estimate-table-readers-mem", "rocksdb.estimate-pending-compaction-bytes",
+                             "rocksdb.num-running-compactions", "rocksdb.num-running-flushes",
+                             "rocksdb.block-cache-usage", "rocksdb.block-cache-pinned-usage",
+                             "rocksdb.background-errors", "rocksdb.actual-delayed-write-rate",
+                             "rocksdb.is-write-stopped"}){
+        uint64_t x;
+        if (db->GetIntProperty(k, &x))
+          ps[k] = x;
+      }
+      o["properties"] = ps;
+
+      json::array ls;
+      for (int l = 0; l < db->NumberLevels(); l++)
+        if (db->GetProperty("rocksdb.num-files-at-level" + std::to_string(l), &v))
+          ls.emplace_back(std::stoull(v));
+      o["files_at_level"] = ls;
+
+      if (st){
+        json::object ts;
+        for (const auto & [t, n] : rocksdb::TickersNameMap)
+          if (uint64_t x = st->getTickerCount(t))
+            ts[n] = x;
+        o["tickers"] = ts;
+      }
+      return o;
+    }
+
+    /**
+     * @brief Load the Acn at `k` of `db`.
+     *
+     * <2024-07-28 Sun> 🦜 : If the Acn only has the `code_ref`, the code is
+     * not read, whoever needs it asks getCode() (see IAcnGettable::codeOf()).
+     */
+    static optional<Acn> loadAcn(rocksdb::DB * const db, const string & k,
+                                 const rocksdb::ReadOptions & o) noexcept{
+      optional<string> v = tryGetKvString(db,k,o);
       if (not v) return {}; // 🦜: Already have debugging msg in tryGetKvString()
 
       // Make the Acn
@@ -146,15 +917,56 @@ namespace weak {
                                             S_NOR);
         return {};
       }
-
       return a;
-    };
+    }
 
-  private:
+    /**
+     * @brief loadAcn() for many keys, with MultiGet().
+     */
+    static vector<optional<Acn>> loadAcns(rocksdb::DB * const db, const vector<string> & ks,
+                                          const rocksdb::ReadOptions & o) noexcept{
+      vector<optional<Acn>> r(ks.size());
+      if (ks.empty()) return r;
+
+      vector<rocksdb::Slice> sks(ks.begin(), ks.end());
+      vector<string> vs;
+      vector<rocksdb::Status> ss = db->MultiGet(o, sks, &vs);
+      for (size_t i = 0; i < ks.size(); i++){
+        if (ss[i].IsNotFound() or not checkStatus(ss[i], "", false /*not fatal*/))
+          continue;
+        Acn a;
+        if (not a.fromString(vs[i])){
+          BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Invalid Acn string format in stateDB for %s" S_NOR) % ks[i];
+          continue;
+        }
+        r[i] = std::move(a);
+      }
+      return r;
+    }
+
+    /**
+     * @brief Load the code `h` from `c`, or from `code/<h>` of `db` (and put
+     * it in `c`).
+     */
+    static shared_ptr<const bytes> loadCode(rocksdb::DB * const db, const hash256 & h,
+                                            const rocksdb::ReadOptions & o, CodeCache * const c) noexcept{
+      string ck = codeKey(h);
+      if (shared_ptr<const bytes> code = c->get(ck))
+        return code;
+      optional<string> cv = tryGetKvString(db,ck,o);
+      if (not cv){
+        BOOST_LOG_TRIVIAL(error) << format( S_RED "❌️ Missing code %s" S_NOR) % ck;
+        return nullptr;
+      }
+      auto code = make_shared<const bytes>(weak::bytesFromString(cv.value()));
+      c->put(ck, code);
+      return code;
+    }
 
-    static optional<string> tryGetKvString(rocksdb::DB * const db, const string & k) {
+    static optional<string> tryGetKvString(rocksdb::DB * const db, const string & k,
+                                           const rocksdb::ReadOptions & o = rocksdb::ReadOptions()) {
       string v;
-      rocksdb::Status s = db->Get(rocksdb::ReadOptions(), k, &v);
+      rocksdb::Status s = db->Get(o, k, &v);
       if (s.IsNotFound()){
         BOOST_LOG_TRIVIAL(debug) << format("key not found: " S_MAGENTA "%s" S_NOR)
           % k;
@@ -170,7 +982,9 @@ namespace weak {
      */
     void openChainDB(const filesystem::path chainDir){
       BOOST_LOG_TRIVIAL(info) << format("Opening " S_CYAN "chain DB" S_NOR);
-      auto o = getInitOptions();
+      auto o = getInitOptions(true, this->profile, this->block_cache, this->rate_limiter);
+      if (this->profile.statistics)
+        o.statistics = this->chain_stats = rocksdb::CreateDBStatistics();
       rocksdb::Status s = rocksdb::DB::Open(o, chainDir.string() , &chainDB);
       checkStatus(s,"Failed to open chainDB at" +  chainDir.string());
       // 🦜 : the conversion from filesystem::path to std::string is only available in POSIX.
@@ -181,11 +995,19 @@ namespace weak {
      */
     void openStateDB(const filesystem::path stateDir){
       BOOST_LOG_TRIVIAL(info) << format("Opening " S_CYAN "state DB" S_NOR);
-      auto o = getInitOptions(false /*prefix mode*/);
+      auto o = this->stateDBOptions();
+      if (this->profile.statistics)
+        o.statistics = this->state_stats = rocksdb::CreateDBStatistics();
+      if (not this->profile.state_wal)
+        o.listeners.push_back(std::make_shared<ChainSyncer>(this));
       rocksdb::Status s = rocksdb::DB::Open(o, stateDir.string() , &stateDB);
       checkStatus(s,"Failed to open stateDB at" + stateDir.string());
     }
 
+    rocksdb::Options stateDBOptions() const{
+      return getInitOptions(false /*prefix mode*/, this->profile, this->block_cache, this->rate_limiter);
+    }
+
     /**
      * @brief check the return value of an rocksdb::Status.
      * @param s The status to be checked
@@ -213,18 +1035,39 @@ namespace weak {
      *
      * @param with_prefix_mode Whether enable the prefix bloom filter for the
      * Db.
+     * @param p The profile, see StorageProfile.
+     * @param c The block cache shared by the DBs, null ⇒ rocksdb's default.
+     * @param r The rate limiter shared by the DBs, null ⇒ unlimited.
      */
-    static inline rocksdb::Options getInitOptions(bool with_prefix_mode=true){
+    static inline rocksdb::Options getInitOptions(bool with_prefix_mode=true,
+                                                  const StorageProfile & p = {},
+                                                  shared_ptr<rocksdb::Cache> c = nullptr,
+                                                  shared_ptr<rocksdb::RateLimiter> r = nullptr){
       rocksdb::Options options;
-      options.IncreaseParallelism();
-      options.OptimizeLevelStyleCompaction();
+      options.IncreaseParallelism(p.max_background_jobs > 0 ? p.max_background_jobs : 16);
+      if (p.write_buffer_mb > 0)
+        options.OptimizeLevelStyleCompaction(p.write_buffer_mb << 20);
+      else
+        options.OptimizeLevelStyleCompaction();
       options.create_if_missing = true;
+      if (p.max_write_buffer_number > 0) options.max_write_buffer_number = p.max_write_buffer_number;
+      if (not p.compression_per_level.empty()) options.compression_per_level = p.compression_per_level;
+      options.max_open_files = p.max_open_files;
+      options.rate_limiter = std::move(r);
+      if (p.env) options.env = p.env;
+
+      rocksdb::BlockBasedTableOptions table_options;
+      if (c) table_options.block_cache = std::move(c);
+      if (p.cache_index_and_filter){
+        table_options.cache_index_and_filter_blocks = true;
+        table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+      }
+
       if (with_prefix_mode){
         /*
           🦜 : Set up the bloom filter to use the first 4 bytes of key's prefix.
           This is just what the official github Wiki did.
          */
-        rocksdb::BlockBasedTableOptions table_options;
         table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
         table_options.whole_key_filtering = true;
         // If you also need Get() to use whole key filters, leave it to true.
@@ -233,6 +1076,20 @@ namespace weak {
 
         // Define a prefix. In this way, a fixed length prefix extractor. A recommended one to use.
         options.prefix_extractor.reset(NewCappedPrefixTransform(4)); // use first 4 bytes as prefix
+      }else if (p.name != "default"){
+        /*
+          <2024-07-26 Fri> 🐢 : The stateDB is read by whole keys (Acn address,
+          `code/<codehash>`), so a whole-key bloom filter (in the memtable
+          too) saves the reads of the missing Acns. No prefix extractor here:
+          forEachAcn() and the checkpoints walk it in total order.
+         */
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+        table_options.whole_key_filtering = true;
+        options.memtable_whole_key_filtering = true;
+        options.memtable_prefix_bloom_size_ratio = 0.02;
+        options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+      }else if (c or p.cache_index_and_filter){
+        options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
       }
       return options;
     }
@@ -269,20 +1126,111 @@ namespace weak {
    */
   class InRamWorldStorage: public virtual IWorldChainStateSettable,
                       public virtual IAcnGettable,
-                      public virtual IChainDBGettable2{
+                      public virtual IChainDBGettable2,
+                      public virtual IAcnSnapshotable,
+                      public virtual IAcnIterable{
   public:
     map<string /*address hex*/
                   ,string> stateDB;
     map<string,string> chainDB;
+
+    class Snapshot;
+    /*
+      <2024-07-28 Sun> 🦜 : The stateDB is read by the Rpc threads (snapshots,
+      `/get_acn`) while the BlkExecutor applies journals to it, so reads take
+      the shared lock and writes take the unique one.
+
+      <2024-07-29 Mon> 🦜 : The lock is shared with the snapshots, which read
+      the stateDB through it, and may outlive us (see ~InRamWorldStorage()).
+     */
+    struct Shared{
+      std::shared_mutex lock;
+      const InRamWorldStorage * w; // <! nulled when the storage is gone
+      vector<std::weak_ptr<Snapshot>> snapshots; // <! the live snapshots
+      Shared(const InRamWorldStorage * ww): w(ww){}
+    };
+    const shared_ptr<Shared> shared = make_shared<Shared>(this);
+    /*
+      <2024-07-28 Sun> 🦜 : The long codes seen in the journals, keyed by the
+      codehash. An Acn that was read without its code and written back only
+      has the `code_ref` (see Acn::toPb()), so its code is found here.
+     */
+    unordered_map<string,shared_ptr<const bytes>> codes;
+
+    /**
+     * @brief A snapshot of the stateDB.
+     *
+     * <2024-07-29 Mon> 🦜 : It doesn't copy the stateDB. It reads the live
+     * one, except for the keys changed since it's taken, whose old values are
+     * copied here by applyJournalStateDB(). So taking one is O(1), and it only
+     * costs a copy of each Acn changed while it's alive.
+     */
+    class Snapshot: public virtual IAcnGettable{
+    public:
+      const shared_ptr<Shared> shared;
+      /*
+        🐢 : The old value of each key changed since, {} if there was none.
+        Guarded by `shared->lock`. When the storage is gone, this has all the
+        keys, and `codes` has the codes.
+       */
+      unordered_map<string,optional<string>> before;
+      unordered_map<string,shared_ptr<const bytes>> codes;
+
+      Snapshot(shared_ptr<Shared> s): shared(s){}
+
+      optional<string> valueOf(const string & k) const noexcept{
+        std::shared_lock g(this->shared->lock);
+        if (auto it = this->before.find(k); it != this->before.end())
+          return it->second;
+        if (not this->shared->w) return {};
+        auto it = this->shared->w->stateDB.find(k);
+        if (it == this->shared->w->stateDB.end()) return {};
+        return it->second;
+      }
+
+      optional<Acn> getAcn(evmc::address addr) const noexcept override{
+        optional<string> v = this->valueOf(addressToString(addr));
+        Acn a;
+        if ((not v) or (not a.fromString(v.value())))
+          return {};
+        return a;
+      }
+
+      shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+        std::shared_lock g(this->shared->lock);
+        const auto & cs = this->shared->w ? this->shared->w->codes : this->codes;
+        auto it = cs.find(hashToString(h));
+        return it == cs.end() ? nullptr : it->second;
+      }
+    };
+
+    InRamWorldStorage() = default;
+    InRamWorldStorage(const InRamWorldStorage &) = delete;
+
+    /**
+     * @brief Hand the live snapshots what they still read from us.
+     */
+    ~InRamWorldStorage(){
+      std::unique_lock g(this->shared->lock);
+      for (auto & x : this->shared->snapshots)
+        if (auto s = x.lock()){
+          for (const auto & [k, v] : this->stateDB)
+            s->before.try_emplace(k, v);
+          s->codes = this->codes;
+        }
+      this->shared->w = nullptr;
+    }
+
     std::optional<Acn> getAcn(evmc::address addr)
       const noexcept override{
       string k = addressToString(addr);
-      if (not stateDB.contains(k))
+      std::shared_lock g(this->shared->lock);
+      auto it = this->stateDB.find(k);
+      if (it == this->stateDB.end())
         return {};
 
-      string v = this->stateDB.at(k);
       Acn a;
-      if (not a.fromString(v))
+      if (not a.fromString(it->second))
         return {};
       return a;
     }
@@ -298,7 +1246,21 @@ namespace weak {
       return {};
     }
 
+    shared_ptr<const bytes> getCode(const hash256 & h) const noexcept override{
+      std::shared_lock g(this->shared->lock);
+      auto it = this->codes.find(hashToString(h));
+      return it == this->codes.end() ? nullptr : it->second;
+    }
+
     bool applyJournalStateDB(const vector<StateChange> & j) override{
+      std::unique_lock g(this->shared->lock);
+      // 🦜 : first keep the codes, and refuse the journal if it needs one we don't have
+      for (const StateChange & c : j)
+        if ((not c.del) and (not this->keepCode(c.v))){
+          BOOST_LOG_TRIVIAL(error) << format(S_RED "❌️ The Acn at %s only has the code_ref of a code we don't have" S_NOR) % c.k;
+          return false;
+        }
+      this->keepForSnapshots(j);
       for (const StateChange & c : j){
         BOOST_LOG_TRIVIAL(debug) << S_CYAN <<
           format("Applying state-change %s on addr %s")
@@ -314,6 +1276,61 @@ namespace weak {
       return true;
     }
 
+    /**
+     * @brief 🦜 : In RAM, the snapshot is copy-on-write, see Snapshot.
+     */
+    shared_ptr<IAcnGettable> snapshotOfAcns() const override{
+      auto s = make_shared<Snapshot>(this->shared);
+      std::unique_lock g(this->shared->lock); // 🦜 : unique, since we add it to the list
+      std::erase_if(this->shared->snapshots, [](const std::weak_ptr<Snapshot> & x){return x.expired();});
+      this->shared->snapshots.push_back(s);
+      return s;
+    }
+
+    /**
+     * @brief Copy the old values of the keys in `j` to the live snapshots
+     * that don't have them yet (🐢 : called with the unique lock).
+     */
+    void keepForSnapshots(const vector<StateChange> & j){
+      std::erase_if(this->shared->snapshots, [](const std::weak_ptr<Snapshot> & x){return x.expired();});
+      for (auto & x : this->shared->snapshots){
+        shared_ptr<Snapshot> s = x.lock();
+        if (not s) continue;
+        for (const StateChange & c : j){
+          if (s->before.contains(c.k)) continue;
+          auto it = this->stateDB.find(c.k);
+          s->before.emplace(c.k, it == this->stateDB.end() ? optional<string>() : optional<string>(it->second));
+        }
+      }
+    }
+
+    /**
+     * @brief Keep the long code of the Acn `v` in `codes` (🐢 : called with
+     * the unique lock).
+     *
+     * @return false if `v` only has the `code_ref` of a code we don't have.
+     */
+    bool keepCode(const string & v){
+      Acn a;
+      if (not a.fromString(v)) return true; // 🦜 : not an Acn, stored as it is
+      if (a.code.empty() and a.code_ref)
+        return this->codes.contains(hashToString(a.code_ref.value()));
+      if (a.code.size() >= WorldStorage::CODE_REF_MIN){
+        string h = hashToString(a.codehash());
+        if (not this->codes.contains(h))
+          this->codes.emplace(h, make_shared<const bytes>(std::move(a.code)));
+      }
+      return true;
+    }
+
+    void forEachAcn(function<void(const string &, const Acn &)> f) const override{
+      std::shared_lock g(this->shared->lock);
+      for (const auto & [k, v] : this->stateDB){
+        Acn a;
+        if (a.fromString(v)) f(k, a);
+      }
+    }
+
     vector<string> getKeysStartWith(string_view prefix)const override{
       vector<string> o;
       for (const auto &[k, v]: this->chainDB){
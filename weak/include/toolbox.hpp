@@ -7,6 +7,7 @@
 #pragma once
 
 #include "net/pure-netAsstn.hpp" // for ssl stuff
+#include "net/pure-compressingMsgMgr.hpp" // for train-net-dict
 #include "core.hpp"
 
 using std::endl;
@@ -62,6 +63,7 @@ Usage :
    wch toolbox do-verify <pk.pem> <msg.txt> <sig.bin>
    wch toolbox tx-sign <tx.json> <sk.pem> <crt.sig> <out-tx.json>
    wch toolbox tx-sign-no-crt <tx.json> <sk.pem> <out-tx.json>
+   wch toolbox train-net-dict <out-dict.bin> <sample1> [<sample2> ...]
 
 🦜 : No argument is optional, and all arguments in <...> are paths. The args
 starting with `out-` are generated files, otherwise the file must exist.
@@ -191,6 +193,20 @@ starting with `out-` are generated files, otherwise the file must exist.
       }
     }
 
+    /**
+     * @brief Train a dictionary for `--net-compress-dict` from some sample payloads.
+     *
+     * 🦜 : The samples can be, for example, some Blks fetched with `/get_blk`.
+     */
+    static void train_net_dict(path out_dict_p, const vector<path> & sample_ps){
+      vector<string> samples;
+      for (const path & p : sample_ps)
+        samples.push_back(read_file(p.string()));
+      string d = pure::CompressingMsgMgr::train_dict(samples);
+      cout << "📗️ Writing dictionary of size " << d.size() << " to " << out_dict_p << endl;
+      pure::writeToFile(out_dict_p, d, true /* binary*/);
+    }
+
 #define ARGV_SHIFT()  { argc--; argv++; }
     static int run(int argc, char* argv[]){
       try{
@@ -229,6 +245,9 @@ starting with `out-` are generated files, otherwise the file must exist.
         }else if (!strcmp("tx-sign-no-crt", argv[0])){
           BOOST_ASSERT_MSG(argc == 4, "tx-sign-no-crt requires 3 arguments: <tx.json> <sk.pem> <out-tx.json>");
           tx_sign(argv[1], argv[2], std::nullopt, argv[3]);
+        }else if (!strcmp("train-net-dict", argv[0])){
+          BOOST_ASSERT_MSG(argc >= 3, "train-net-dict requires at least 2 arguments: <out-dict.bin> <sample1> ...");
+          train_net_dict(argv[1], vector<path>(argv + 2, argv + argc));
         }else{
           cout << "Unknown command: " << argv[0] << endl;
         }
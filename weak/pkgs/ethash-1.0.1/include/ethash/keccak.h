@@ -22,6 +22,16 @@ union ethash_hash256 ethash_keccak256_32(const uint8_t data[32]) noexcept;
 union ethash_hash512 ethash_keccak512(const uint8_t* data, size_t size) noexcept;
 union ethash_hash512 ethash_keccak512_64(const uint8_t data[64]) noexcept;
 
+/**
+ * Keccak-256 of n messages at once: out[i] = keccak256(data[i], size[i]).
+ *
+ * On x86-64 CPUs with AVX2 (AVX-512) the messages are hashed 4 (8) at a time, one per SIMD
+ * lane. Runs of messages with the same number of 136-byte blocks go together, so the batch
+ * is the fastest when the messages are about the same size (e.g. the nodes of a Merkle tree).
+ */
+void ethash_keccak256_batch(union ethash_hash256* out, const uint8_t* const* data,
+    const size_t* size, size_t n) noexcept;
+
 #ifdef __cplusplus
 }
 #endif
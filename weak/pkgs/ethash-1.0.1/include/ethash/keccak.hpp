@@ -29,6 +29,12 @@ inline hash512 keccak512(const hash512& input) noexcept
     return ethash_keccak512_64(input.bytes);
 }
 
+inline void keccak256_batch(
+    hash256* out, const uint8_t* const* data, const size_t* size, size_t n) noexcept
+{
+    ethash_keccak256_batch(out, data, size, n);
+}
+
 static constexpr auto keccak256_32 = ethash_keccak256_32;
 static constexpr auto keccak512_64 = ethash_keccak512_64;
 
@@ -380,3 +380,89 @@ union ethash_hash512 ethash_keccak512_64(const uint8_t data[64])
     keccak(hash.word64s, 512, data, 64);
     return hash;
 }
+
+
+#if !defined(_MSC_VER) && defined(__x86_64__) && __has_attribute(target) && \
+    __has_attribute(vector_size)
+#define KECCAK_HAVE_LANES 1
+
+/// The rotation offsets and the lane positions of the Rho and Pi steps,
+/// in the order of the compact implementation in keccak_lanes.h.
+static const unsigned keccak_rho[24] = {
+    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+static const size_t keccak_pi[24] = {
+    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+typedef uint64_t keccak_lanes4 __attribute__((vector_size(32)));
+typedef uint64_t keccak_lanes8 __attribute__((vector_size(64)));
+
+#define KECCAK_LANES 4
+#define KECCAK_LANES_T keccak_lanes4
+#define KECCAK_LANES_FN keccak256_x4_avx2
+#define KECCAK_LANES_ISA "avx2"
+#include "keccak_lanes.h"
+
+#define KECCAK_LANES 8
+#define KECCAK_LANES_T keccak_lanes8
+#define KECCAK_LANES_FN keccak256_x8_avx512
+#define KECCAK_LANES_ISA "avx512f"
+#include "keccak_lanes.h"
+
+/// The best multi-buffer Keccak-256 and the number of messages it takes,
+/// selected during runtime initialization. NULL if the CPU has neither AVX2 nor AVX-512.
+static void (*keccak256_lanes_best)(union ethash_hash256*, const uint8_t* const*, const size_t*,
+    size_t) = NULL;
+static size_t keccak256_lanes_width = 1;
+
+__attribute__((constructor)) static void select_keccak256_lanes_implementation(void)
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        keccak256_lanes_best = keccak256_x8_avx512;
+        keccak256_lanes_width = 8;
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        keccak256_lanes_best = keccak256_x4_avx2;
+        keccak256_lanes_width = 4;
+    }
+}
+#endif
+
+void ethash_keccak256_batch(
+    union ethash_hash256* out, const uint8_t* const* data, const size_t* size, size_t n)
+{
+    static const size_t block_size = 136;
+    size_t i = 0;
+
+#ifdef KECCAK_HAVE_LANES
+    if (keccak256_lanes_best != NULL)
+    {
+        const size_t k = keccak256_lanes_width;
+        while (i + k <= n)
+        {
+            // The next k messages go together only if they have the same number of blocks.
+            const size_t n_blocks = size[i] / block_size + 1;
+            size_t j = 1;
+            while (j < k && size[i + j] / block_size + 1 == n_blocks)
+                ++j;
+
+            if (j == k)
+            {
+                keccak256_lanes_best(out + i, data + i, size + i, n_blocks);
+                i += k;
+            }
+            else
+            {
+                keccak(out[i].word64s, 256, data[i], size[i]);
+                ++i;
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i)
+        keccak(out[i].word64s, 256, data[i], size[i]);
+}
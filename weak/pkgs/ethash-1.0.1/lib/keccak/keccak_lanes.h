@@ -0,0 +1,119 @@
+// ethash: C/C++ implementation of Ethash, the Ethereum Proof of Work algorithm.
+// Copyright 2018 Pawel Bylica.
+// SPDX-License-Identifier: Apache-2.0
+
+/// Keccak-256 of several messages at once, one message per SIMD lane.
+///
+/// This file is included by keccak.c once per vector width, with:
+/// - KECCAK_LANES      the number of messages (lanes),
+/// - KECCAK_LANES_T    a GCC vector type of KECCAK_LANES 64-bit words,
+/// - KECCAK_LANES_FN   the name of the function to define,
+/// - KECCAK_LANES_ISA  the target attribute of the function (e.g. "avx2").
+///
+/// The messages must have the same number of blocks (size / 136 + 1), so they
+/// go through the same number of permutations. The permutation is the compact
+/// (rolled) form of Keccak-f[1600], the compiler unrolls it and turns the
+/// rotations of the lanes into vector shifts (or VPROLQ on AVX-512).
+
+#if !defined(KECCAK_LANES) || !defined(KECCAK_LANES_T) || !defined(KECCAK_LANES_FN) || \
+    !defined(KECCAK_LANES_ISA)
+#error "define KECCAK_LANES, KECCAK_LANES_T, KECCAK_LANES_FN and KECCAK_LANES_ISA first"
+#endif
+
+__attribute__((target(KECCAK_LANES_ISA))) static void KECCAK_LANES_FN(
+    union ethash_hash256* out, const uint8_t* const* data, const size_t* size, size_t n_blocks)
+{
+    static const size_t block_size = 136;
+    static const size_t block_words = 136 / 8;
+
+    KECCAK_LANES_T A[25];
+    KECCAK_LANES_T B[5];
+    KECCAK_LANES_T t;
+    uint64_t w[KECCAK_LANES];
+    uint8_t last[KECCAK_LANES][136];
+    size_t l, b, i, x, y;
+    unsigned r;
+
+    // The last block of each message, padded.
+    for (l = 0; l < KECCAK_LANES; ++l)
+    {
+        const size_t rest = size[l] - (n_blocks - 1) * block_size;
+        __builtin_memset(last[l], 0, block_size);
+        if (rest > 0)
+            __builtin_memcpy(last[l], data[l] + (n_blocks - 1) * block_size, rest);
+        last[l][rest] ^= 0x01;
+        last[l][block_size - 1] ^= 0x80;
+    }
+
+    __builtin_memset(A, 0, sizeof(A));
+
+    for (b = 0; b < n_blocks; ++b)
+    {
+        // Absorb: lane l of word i is the i-th word of the l-th message.
+        for (i = 0; i < block_words; ++i)
+        {
+            for (l = 0; l < KECCAK_LANES; ++l)
+            {
+                const uint8_t* p = (b + 1 < n_blocks) ? data[l] + b * block_size : last[l];
+                w[l] = load_le(p + i * 8);
+            }
+            __builtin_memcpy(&t, w, sizeof(t));
+            A[i] ^= t;
+        }
+
+        for (r = 0; r < 24; ++r)
+        {
+            // Theta
+#pragma GCC unroll 5
+            for (x = 0; x < 5; ++x)
+                B[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
+#pragma GCC unroll 5
+            for (x = 0; x < 5; ++x)
+            {
+                t = B[(x + 4) % 5] ^ ((B[(x + 1) % 5] << 1) | (B[(x + 1) % 5] >> 63));
+#pragma GCC unroll 5
+                for (y = 0; y < 25; y += 5)
+                    A[y + x] ^= t;
+            }
+
+            // Rho and Pi
+            t = A[1];
+#pragma GCC unroll 24
+            for (i = 0; i < 24; ++i)
+            {
+                const size_t j = keccak_pi[i];
+                const unsigned s = keccak_rho[i];
+                B[0] = A[j];
+                A[j] = (t << s) | (t >> (64 - s));
+                t = B[0];
+            }
+
+            // Chi
+#pragma GCC unroll 5
+            for (y = 0; y < 25; y += 5)
+            {
+#pragma GCC unroll 5
+                for (x = 0; x < 5; ++x)
+                    B[x] = A[y + x];
+#pragma GCC unroll 5
+                for (x = 0; x < 5; ++x)
+                    A[y + x] = B[x] ^ (~B[(x + 1) % 5] & B[(x + 2) % 5]);
+            }
+
+            // Iota
+            A[0] ^= round_constants[r];
+        }
+    }
+
+    for (i = 0; i < 4; ++i)
+    {
+        __builtin_memcpy(w, &A[i], sizeof(w));
+        for (l = 0; l < KECCAK_LANES; ++l)
+            out[l].word64s[i] = to_le64(w[l]);
+    }
+}
+
+#undef KECCAK_LANES
+#undef KECCAK_LANES_T
+#undef KECCAK_LANES_FN
+#undef KECCAK_LANES_ISA
@@ -8,6 +8,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 using namespace ethash;
 
 struct keccak_test_case
@@ -247,6 +249,41 @@ TEST(keccak, hpp_aliases)
     EXPECT_EQ(keccak512_64(data).word64s[1], ethash_keccak512_64(data).word64s[1]);
 }
 
+TEST(keccak, batch)
+{
+    const uint8_t* const data = reinterpret_cast<const uint8_t*>(test_text);
+
+    // All the test cases in one batch: they go through the lanes in runs of the same number of
+    // blocks and the rest falls back to the one-by-one hashing.
+    std::vector<const uint8_t*> ptrs;
+    std::vector<size_t> sizes;
+    for (auto& t : test_cases)
+    {
+        ptrs.push_back(data);
+        sizes.push_back(t.input_size);
+    }
+    std::vector<hash256> out(ptrs.size());
+    keccak256_batch(out.data(), ptrs.data(), sizes.data(), ptrs.size());
+    for (size_t i = 0; i < out.size(); ++i)
+        ASSERT_EQ(to_hex(out[i]), test_cases[i].expected_hash256) << test_cases[i].input_size;
+
+    // Many messages of the same size, each at a different offset.
+    for (const size_t size : {0, 64, 135, 136, 137, 147})
+    {
+        ptrs.clear();
+        sizes.clear();
+        for (size_t i = 0; i < 19; ++i)
+        {
+            ptrs.push_back(data + i);
+            sizes.push_back(size);
+        }
+        out.assign(ptrs.size(), hash256{});
+        keccak256_batch(out.data(), ptrs.data(), sizes.data(), ptrs.size());
+        for (size_t i = 0; i < out.size(); ++i)
+            ASSERT_EQ(out[i], keccak256(ptrs[i], size)) << size << " " << i;
+    }
+}
+
 TEST(helpers, to_hex)
 {
     hash256 h = {};
@@ -0,0 +1,134 @@
+#include "h.hpp"
+
+#include "acnPrefetcher.hpp"
+#include "storageManager.hpp"
+#include "execManager.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace weak;
+
+/**
+ * @brief The Acns in RAM, counting the reads. getManyAcns() can be held, to
+ * make a Blk commit while a prefetch is in flight.
+ */
+struct CountingAcns: public virtual IAcnGettable{
+  InRamWorldStorage w;
+  mutable std::atomic<int> n_get{0}, n_get_many{0};
+  std::atomic_flag hold;       // <! while set, getManyAcns() waits (after it read)
+  mutable std::atomic_flag reading; // <! set when getManyAcns() has read
+
+  optional<Acn> getAcn(evmc::address addr) const noexcept override{
+    n_get++;
+    return w.getAcn(addr);
+  }
+
+  vector<optional<Acn>> getManyAcns(const vector<evmc::address> & as) const noexcept override{
+    n_get_many++;
+    vector<optional<Acn>> o;
+    for (const evmc::address & a : as) o.push_back(w.getAcn(a));
+    reading.test_and_set();
+    while (hold.test())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return o;
+  }
+};
+
+vector<StateChange> set_acn(int i, uint64_t n){
+  Acn a{n, bytes{}};
+  return {StateChange{false, addressToString(makeAddress(i)), a.toString()}};
+}
+
+ExecBlk blk_with(uint64_t n, vector<vector<StateChange>> J){
+  return ExecBlk{Blk{n, hash256{}, vector<Tx>{}}, J, vector<TxReceipt>{}};
+}
+
+BOOST_AUTO_TEST_SUITE(test_acnPrefetcher);
+
+BOOST_AUTO_TEST_CASE(test_acns_touched){
+  Tx t1{makeAddress(1), makeAddress(2), bytes{}, 0 /*nonce*/};
+  Tx t2{makeAddress(2), makeAddress(1), bytes{}, 1};
+  Tx t3{makeAddress(1), evmc::address{}, bytes{}, 2}; // 🦜 : CREATE
+  vector<evmc::address> as = AcnPrefetcher::acnsTouchedBy({t1, t2, t3});
+  BOOST_REQUIRE_EQUAL(as.size(), 3);
+  BOOST_CHECK(as[0] == makeAddress(1));
+  BOOST_CHECK(as[1] == makeAddress(2));
+  BOOST_CHECK(as[2] == Tx::getContractDeployAddress(t3));
+}
+
+BOOST_AUTO_TEST_CASE(test_prefetch_then_hit){
+  CountingAcns c;
+  for (int i = 1; i <= 3; i++)
+    c.w.applyJournalStateDB(set_acn(i, i));
+  AcnPrefetcher p{&c};
+
+  p.prefetchAcnsOf({Tx{makeAddress(1), makeAddress(2), bytes{}, 0},
+                    Tx{makeAddress(3), makeAddress(4), bytes{}, 1}});
+  // 🐢 : getAcn() waits for the batch, so no point-read
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(2)).value().nonce, 2);
+  BOOST_CHECK(not p.getAcn(makeAddress(4)));
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(3)).value().nonce, 3);
+  BOOST_CHECK_EQUAL(c.n_get_many.load(), 1);
+  BOOST_CHECK_EQUAL(c.n_get.load(), 0);
+  BOOST_CHECK_EQUAL(p.n_hit.load(), 3);
+
+  // the second time, nothing to read
+  p.prefetchAcnsOf({Tx{makeAddress(1), makeAddress(2), bytes{}, 2}});
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(1)).value().nonce, 1);
+  BOOST_CHECK_EQUAL(c.n_get_many.load(), 1);
+
+  // a miss goes to the base
+  BOOST_CHECK(not p.getAcn(makeAddress(5)));
+  BOOST_CHECK_EQUAL(c.n_get.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_commit_drops_written){
+  CountingAcns c;
+  c.w.applyJournalStateDB(set_acn(1, 1));
+  c.w.applyJournalStateDB(set_acn(2, 1));
+  AcnPrefetcher p{&c};
+  p.prefetchAcnsOf({Tx{makeAddress(1), makeAddress(2), bytes{}, 0}});
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(1)).value().nonce, 1);
+
+  // 🦜 : Blk-0 writes Acn 1, Acn 2 is still good
+  c.w.applyJournalStateDB(set_acn(1, 7));
+  p.onBlkCommitted(blk_with(0, {set_acn(1, 7)}));
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(1)).value().nonce, 7);
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(2)).value().nonce, 1);
+  BOOST_CHECK_EQUAL(p.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_commit_while_reading){
+  CountingAcns c;
+  c.w.applyJournalStateDB(set_acn(1, 1));
+  c.hold.test_and_set();
+  AcnPrefetcher p{&c};
+  p.prefetchAcnsOf({Tx{makeAddress(1), makeAddress(2), bytes{}, 0}});
+  while (not c.reading.test())
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // 🦜 : The worker has read nonce=1, now Blk-0 writes Acn 1
+  c.w.applyJournalStateDB(set_acn(1, 2));
+  p.onBlkCommitted(blk_with(0, {set_acn(1, 2)}));
+  c.hold.clear();
+
+  // 🐢 : the read in flight is not kept
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(1)).value().nonce, 2);
+  BOOST_CHECK_EQUAL(c.n_get.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_in_blkExecutor){
+  InRamWorldStorage w;
+  w.applyJournalStateDB(set_acn(1, 1));
+  AcnPrefetcher p{dynamic_cast<IAcnGettable*>(&w)};
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+  exe.prefetcher = &p;
+  exe.committedListeners.push_back(&p);
+
+  p.prefetchAcnsOf({Tx{makeAddress(1), makeAddress(2), bytes{}, 0}});
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(1)).value().nonce, 1);
+  BOOST_REQUIRE(exe.commitBlk(blk_with(0, {set_acn(1, 3)})));
+  BOOST_CHECK_EQUAL(p.getAcn(makeAddress(1)).value().nonce, 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
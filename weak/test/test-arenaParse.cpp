@@ -0,0 +1,119 @@
+#include "h.hpp"
+
+#include "forPostExec.hpp"
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace weak;
+
+/*
+  🦜 : Count the allocations of the whole test. (That's why this is a test of
+  its own.)
+ */
+static std::atomic<size_t> n_new{0};
+void * operator new(size_t n){
+  n_new++;
+  if (void * p = std::malloc(n)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void * p) noexcept{ std::free(p); }
+void operator delete(void * p, size_t) noexcept{ std::free(p); }
+
+/// What /add_txs_pb gets: n Txs, as a client would send them.
+string txs_pbString_of(size_t n){
+  hiPb::Txs pb;
+  for (uint64_t i = 0; i < n; i++){
+    hiPb::Tx * t = pb.add_txs();
+    t->set_type(hiPb::TxType::EVM);
+    t->set_from_addr(toByteString<address>(makeAddress(i % 97)));
+    t->set_to_addr(toByteString<address>(makeAddress(1000)));
+    t->set_data(string(100, 'x'));
+    t->set_nonce(i);
+  }
+  return pb.SerializeAsString();
+}
+
+/// The median and the 99th percentile of `f()`, in ms.
+template<typename F>
+tuple<double,double,size_t> time_it(F f, int n = 50){
+  using namespace std::chrono;
+  vector<double> ts;
+  size_t n0 = n_new.load();
+  for (int i = 0; i < n; i++){
+    auto start = steady_clock::now();
+    f();
+    ts.push_back(duration<double, std::milli>(steady_clock::now() - start).count());
+  }
+  size_t a = (n_new.load() - n0) / n;
+  std::sort(ts.begin(), ts.end());
+  return make_tuple(ts[n / 2], ts[n * 99 / 100], a);
+}
+
+BOOST_AUTO_TEST_SUITE(test_arenaParse);
+
+BOOST_AUTO_TEST_CASE(test_parse_txs_pb){
+  string s = txs_pbString_of(3);
+  auto r = Tx::parse_txs_pbString_for_rpc(s);
+  BOOST_REQUIRE(r);
+  auto [rpl, txs] = std::move(r.value());
+  BOOST_REQUIRE_EQUAL(txs.size(), 3);
+  BOOST_CHECK_EQUAL(txs[2].nonce, 2);
+  BOOST_CHECK(txs[1].from == makeAddress(1));
+  BOOST_CHECK_EQUAL(txs[0].data.size(), 100);
+
+  hiPb::AddTxsReply p;
+  BOOST_REQUIRE(p.ParseFromString(rpl));
+  BOOST_CHECK_EQUAL(p.txs_size(), 3);
+
+  // 🦜 : garbage is still refused
+  BOOST_CHECK(not Tx::parse_txs_pbString_for_rpc("\xff\xff\xff"));
+}
+
+BOOST_AUTO_TEST_CASE(test_execBlk_pb_roundtrip){
+  vector<Tx> txs{Tx{makeAddress(1), makeAddress(2), bytes{}, 0}};
+  ExecBlk b{Blk{1, hash256{}, txs},
+            {{StateChange{false, addressToString(makeAddress(1)), Acn{1, bytes{}}.toString()}}},
+            {TxReceipt(true)}};
+  ExecBlk b1;
+  BOOST_REQUIRE(b1.fromPbString(b.toPbString()));
+  BOOST_CHECK_EQUAL(b1.toJsonString(), b.toJsonString());
+  BOOST_CHECK(not b1.fromPbString("\xff\xff\xff"));
+}
+
+BOOST_AUTO_TEST_CASE(test_small_pb_not_on_arena){
+  // <2024-07-28 Sun> 🦜 : below PB_ARENA_MIN, it's the plain heap pb
+  Tx t{makeAddress(1), makeAddress(2), bytes(size_t{10}, uint8_t{0xab}), 7};
+  string s = t.toPbString();
+  BOOST_REQUIRE_LT(s.size(), PB_ARENA_MIN);
+  Tx t1;
+  BOOST_REQUIRE(t1.fromPbString(s));
+  BOOST_CHECK_EQUAL(t1.toJsonString(), t.toJsonString());
+  BOOST_CHECK(not t1.fromPbString("\xff\xff\xff"));
+}
+
+/*
+  🦜 : A 10k-Tx /add_txs_pb, parsed on a heap pb (what we used to do) vs on an
+  Arena (parse_txs_pbString_for_rpc()).
+ */
+BOOST_AUTO_TEST_CASE(bench_add_txs_pb_10k){
+  string s = txs_pbString_of(10'000);
+
+  auto [h50, h99, h_new] = time_it([&]{
+    hiPb::Txs pb;
+    BOOST_REQUIRE(pb.ParseFromArray(s.data(), static_cast<int>(s.size())));
+    BOOST_REQUIRE(Tx::parse_txs_pb_for_rpc(pb));
+  });
+  auto [a50, a99, a_new] = time_it([&]{
+    BOOST_REQUIRE(Tx::parse_txs_pbString_for_rpc(s));
+  });
+
+  BOOST_TEST_MESSAGE((format("📦 /add_txs_pb of 10k Txs (%d bytes):\n"
+                             "\theap : %6d news, p50 %6.2f ms, p99 %6.2f ms\n"
+                             "\tarena: %6d news, p50 %6.2f ms, p99 %6.2f ms")
+                      % s.size() % h_new % h50 % h99 % a_new % a50 % a99).str());
+  BOOST_CHECK_LT(a_new, h_new);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
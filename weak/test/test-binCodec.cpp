@@ -0,0 +1,181 @@
+#include "h.hpp"
+
+#include "forPostExec.hpp"
+#include <chrono>
+
+using namespace weak;
+
+Tx tx_of(uint64_t i){
+  Tx t{makeAddress(i % 97), i % 5 ? makeAddress(1000 + i) : address{},
+       bytes(size_t{100}, static_cast<uint8_t>(i)), i /*nonce*/};
+  if (i % 3 == 0) t.type = Tx::Type::python;
+  if (i % 7 == 0) t.signature = bytes(size_t{64}, uint8_t{0xab});
+  return t;
+}
+
+Blk blk_of(size_t n){
+  vector<Tx> txs;
+  for (uint64_t i = 0; i < n; i++) txs.push_back(tx_of(i));
+  hash256 h{};
+  h.bytes[0] = 0xaa;
+  return Blk{3, h, txs};
+}
+
+/// Each Tx sets one slot of a hot Acn and the Acn of its sender.
+ExecBlk execBlk_of(size_t n){
+  Blk b = blk_of(n);
+  vector<vector<StateChange>> J;
+  vector<TxReceipt> R;
+  Acn hot{0, bytes{}};
+  for (uint64_t i = 0; i < n; i++){
+    hot.nonce = i;
+    hot.storage[bytes32{i % 64}] = bytes32{i};
+    J.push_back({{false, addressToString(makeAddress(1)), hot.toString()},
+                 {false, addressToString(b.txs[i].from), Acn{i, bytes{}}.toString()}});
+    if (i % 11 == 0)
+      J.back().push_back({true, addressToString(makeAddress(2000 + i)), ""});
+    if (i % 13 == 0)
+      R.push_back(TxReceipt(false));
+    else
+      R.push_back(TxReceipt(bytes(size_t{32}, uint8_t{0x01})));
+  }
+  ExecBlk e{b, J, R};
+  e.stateRoot = hash256{};
+  return e;
+}
+
+BOOST_AUTO_TEST_SUITE(test_binCodec);
+
+BOOST_AUTO_TEST_CASE(test_tx_roundtrip){
+  for (uint64_t i : {0, 1, 3, 7}){
+    Tx t = tx_of(i), t1;
+    string s = t.toBinString();
+    BOOST_CHECK_EQUAL(static_cast<uint8_t>(s[0]), bin::MAGIC);
+    BOOST_REQUIRE(t1.fromBinString(s));
+    BOOST_CHECK_EQUAL(t1.toJsonString(), t.toJsonString());
+    BOOST_CHECK(t1.signature == t.signature);
+    BOOST_CHECK(t1.type == t.type);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_txs_roundtrip){
+  vector<Tx> txs{tx_of(1), tx_of(2), tx_of(3)};
+  vector<Tx> txs1 = Tx::parse_to_array(Tx::serialize_from_array(txs));
+  BOOST_REQUIRE_EQUAL(txs1.size(), 3);
+  for (size_t i = 0; i < 3; i++)
+    BOOST_CHECK_EQUAL(txs1[i].toJsonString(), txs[i].toJsonString());
+}
+
+BOOST_AUTO_TEST_CASE(test_blk_roundtrip){
+  Blk b = blk_of(50), b1;
+  BOOST_REQUIRE(b1.fromBinString(b.toBinString()));
+  BOOST_CHECK_EQUAL(b1.toJsonString(), b.toJsonString());
+  BOOST_CHECK(b1.hash() == b.hash());
+
+  // 🦜 : the views point into the input
+  string s = b.toBinString();
+  bin::BlkView v = bin::parse<bin::BlkView>(s, bin::Kind::blk);
+  BOOST_REQUIRE_EQUAL(v.txs.size(), 50);
+  BOOST_CHECK(v.txs[1].data.data() >= s.data() and v.txs[1].data.data() < s.data() + s.size());
+  BOOST_CHECK(v.txs[49].from == b.txs[49].from);
+}
+
+BOOST_AUTO_TEST_CASE(test_execBlk_roundtrip){
+  ExecBlk b = execBlk_of(100), b1;
+  string s = b.toBinString();
+  BOOST_REQUIRE(b1.fromBinString(s));
+  BOOST_CHECK_EQUAL(b1.toJsonString(), b.toJsonString());
+  BOOST_REQUIRE(b1.stateRoot);
+
+  // the hot Acn is stored as deltas
+  bin::ExecBlkView v = bin::parse<bin::ExecBlkView>(s, bin::Kind::execBlk);
+  BOOST_CHECK(v.stateChanges[0][0].flag == bin::Change::put);
+  BOOST_CHECK(v.stateChanges[1][0].flag == bin::Change::delta);
+  BOOST_CHECK(v.stateChanges[0][2].flag == bin::Change::del);
+}
+
+BOOST_AUTO_TEST_CASE(test_acn_deltas_follow_edits){
+  // <2024-07-28 Sun> 🦜 : the deltas are worked out on each call, so an edit in place shows
+  ExecBlk b = execBlk_of(100);
+  BOOST_CHECK(ExecBlk::acnDeltasOf(b.stateChanges).at(1).at(0));
+  string s0 = b.toBinString(), p0 = b.toPbString();
+
+  Acn a;
+  BOOST_REQUIRE(a.fromString(b.stateChanges[1][0].v));
+  a.storage[bytes32{12345}] = bytes32{1};
+  b.stateChanges[1][0].v = a.toString();
+  BOOST_CHECK_NE(b.toBinString(), s0);
+  BOOST_CHECK_NE(b.toPbString(), p0);
+
+  ExecBlk b1, b2;
+  BOOST_REQUIRE(b1.fromBinString(b.toBinString()));
+  BOOST_CHECK_EQUAL(b1.toJsonString(), b.toJsonString());
+  BOOST_REQUIRE(b2.fromPbString(b.toPbString()));
+  BOOST_CHECK_EQUAL(b2.toJsonString(), b.toJsonString());
+}
+
+BOOST_AUTO_TEST_CASE(test_rpc_pb_has_whole_acns){
+  // 🐢 : the clients of the Rpc never see a delta
+  ExecBlk b = execBlk_of(100);
+  hiPb::ExecBlk pb;
+  BOOST_REQUIRE(pb.ParseFromString(b.toRpcPbString()));
+  bool any_delta = false;
+  for (const hiPb::StateChanges & cs : pb.statechanges())
+    for (const hiPb::StateChange & c : cs.changes())
+      any_delta = any_delta or c.delta();
+  BOOST_CHECK(not any_delta);
+  BOOST_CHECK_EQUAL(pb.statechanges(1).changes(0).v(), b.stateChanges[1][0].v);
+
+  ExecBlk b1;
+  BOOST_REQUIRE(b1.fromPbString(b.toRpcPbString()));
+  BOOST_CHECK_EQUAL(b1.toJsonString(), b.toJsonString());
+}
+
+BOOST_AUTO_TEST_CASE(test_bad_input){
+  string s = execBlk_of(10).toBinString();
+  ExecBlk b;
+  for (size_t n : {size_t{0}, size_t{2}, size_t{10}, s.size() / 2, s.size() - 1})
+    BOOST_CHECK(not b.fromBinString(string_view(s).substr(0, n)));
+  BOOST_CHECK(not b.fromBinString(s + "x"));
+
+  string s1 = s;
+  s1[1] = bin::VERSION + 1;     // 🦜 : a later version
+  BOOST_CHECK(not b.fromBinString(s1));
+
+  Blk b1;                       // 🦜 : not a Blk
+  BOOST_CHECK(not b1.fromBinString(s));
+}
+
+/*
+  🦜 : bin vs pb vs JSON on a Blk and an ExecBlk of 10k Txs. Nothing is
+  checked, it just prints the numbers.
+ */
+BOOST_AUTO_TEST_CASE(bench_10k_txs){
+  using namespace std::chrono;
+  auto ms = [](auto f){
+    auto start = high_resolution_clock::now();
+    for (int i = 0; i < 5; i++) f();
+    return duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 5000.0;
+  };
+
+  auto bench = [&](const char * name, const auto & b){
+    using B = std::remove_cvref_t<decltype(b)>;
+    string sb = b.toBinString(), sp = b.toPbString(), sj = b.toJsonString();
+    double eb = ms([&]{ sb = b.toBinString(); });
+    double ep = ms([&]{ sp = b.toPbString(); });
+    double ej = ms([&]{ sj = b.toJsonString(); });
+    double db = ms([&]{ B x; BOOST_REQUIRE(x.fromBinString(sb)); });
+    double dp = ms([&]{ B x; BOOST_REQUIRE(x.fromPbString(sp)); });
+    double dj = ms([&]{ B x; BOOST_REQUIRE(x.fromJsonString(sj)); });
+    BOOST_TEST_MESSAGE((format("📦 %s of 10k Txs:\n"
+                               "\tbin : %8d bytes, encode %7.2f ms, decode %7.2f ms\n"
+                               "\tpb  : %8d bytes, encode %7.2f ms, decode %7.2f ms\n"
+                               "\tjson: %8d bytes, encode %7.2f ms, decode %7.2f ms")
+                        % name % sb.size() % eb % db % sp.size() % ep % dp % sj.size() % ej % dj).str());
+  };
+
+  bench("Blk", blk_of(10'000));
+  bench("ExecBlk", execBlk_of(10'000));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,171 @@
+#include "h.hpp"
+
+#include "blkLog.hpp"
+#include "storageManager.hpp"
+
+using namespace weak;
+
+/**
+ * @brief A fresh dir under the temp dir, removed afterwards.
+ */
+struct TmpDir{
+  filesystem::path p{filesystem::temp_directory_path() / "test-blkLog"};
+  TmpDir(){ filesystem::remove_all(p); }
+  ~TmpDir(){ filesystem::remove_all(p); }
+};
+
+string blk_of(uint64_t n){
+  return string(100 + n, 'a' + n % 26);
+}
+
+BOOST_AUTO_TEST_SUITE(test_blkLog);
+
+BOOST_FIXTURE_TEST_CASE(test_append_and_get, TmpDir){
+  BlkLog l{p, 4096 /*small segments*/, 2};
+  BOOST_CHECK(not l.last());
+  for (uint64_t i = 1; i <= 100; i++)
+    BOOST_REQUIRE(l.append(i, blk_of(i)));
+
+  BOOST_CHECK(l.n_segments() > 1);
+  BOOST_CHECK_EQUAL(l.first().value(), 1);
+  BOOST_CHECK_EQUAL(l.last().value(), 100);
+  BOOST_CHECK_EQUAL(l.get(50).value(), blk_of(50));
+  BOOST_CHECK(not l.get(0));
+  BOOST_CHECK(not l.get(101));
+  BOOST_CHECK(not l.append(200, "x")); // 🦜 : not the next one
+}
+
+BOOST_FIXTURE_TEST_CASE(test_reopen, TmpDir){
+  {
+    BlkLog l{p, 4096, 2};
+    for (uint64_t i = 1; i <= 100; i++)
+      BOOST_REQUIRE(l.append(i, blk_of(i)));
+  }
+  BlkLog l{p, 4096, 2};
+  BOOST_CHECK_EQUAL(l.first().value(), 1);
+  BOOST_CHECK_EQUAL(l.last().value(), 100);
+  for (uint64_t i = 1; i <= 100; i++)
+    BOOST_CHECK_EQUAL(l.get(i).value(), blk_of(i));
+
+  // 🦜 : rewrite the last one
+  BOOST_REQUIRE(l.append(101, "hi"));
+  BOOST_REQUIRE(l.append(100, "re"));
+  BOOST_CHECK_EQUAL(l.last().value(), 100);
+  BOOST_CHECK_EQUAL(l.get(100).value(), "re");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_torn_tail, TmpDir){
+  {
+    BlkLog l{p, 4096, 2};
+    for (uint64_t i = 1; i <= 10; i++)
+      BOOST_REQUIRE(l.append(i, blk_of(i)));
+  }
+  // 🦜 : cut the last record in half
+  filesystem::path s = BlkLog::segmentPath(p, 1);
+  filesystem::resize_file(s, filesystem::file_size(s) - 10);
+
+  {
+    BlkLog l{p, 4096, 2};
+    BOOST_CHECK_EQUAL(l.last().value(), 9);
+    BOOST_REQUIRE(l.append(10, "again"));
+  }
+  BlkLog l{p};
+  BOOST_CHECK_EQUAL(l.get(10).value(), "again");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_worldStorage_with_blkLog, TmpDir){
+  // 1. without the log
+  {
+    WorldStorage w{p};
+    for (uint64_t i = 0; i <= 3; i++)
+      BOOST_REQUIRE(w.setInChainDB("/blk/" + std::to_string(i), blk_of(i)));
+    BOOST_REQUIRE(w.setInChainDB("/other/blk_number", "3"));
+  }
+
+  // 2. with the log: the Blks are moved
+  {
+    WorldStorage w{p, true};
+    BOOST_REQUIRE(w.blk_log);
+    BOOST_CHECK_EQUAL(w.blk_log->last().value(), 3);
+    BOOST_CHECK(not WorldStorage::tryGetKvString(w.chainDB, "/blk/2"));
+    BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/2").value(), blk_of(2));
+
+    BOOST_REQUIRE(w.setInChainDB("/blk/4", blk_of(4)));
+    BOOST_REQUIRE(w.setInChainDB("/other/blk_number", "4"));
+    BOOST_CHECK(not WorldStorage::tryGetKvString(w.chainDB, "/blk/4"));
+
+    vector<optional<string>> vs = w.getManyFromChainDB({"/blk/4", "/other/blk_number", "/blk/5"});
+    BOOST_CHECK_EQUAL(vs[0].value(), blk_of(4));
+    BOOST_CHECK_EQUAL(vs[1].value(), "4");
+    BOOST_CHECK(not vs[2]);
+  }
+
+  // 3. reopened
+  WorldStorage w{p, true};
+  BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/0").value(), blk_of(0));
+  BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/4").value(), blk_of(4));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_blk_in_sealed_segment_goes_to_chainDB, TmpDir){
+  WorldStorage w{p, true};
+  // 🦜 : small segments, so that the first ones get sealed
+  w.blk_log.reset();
+  w.blk_log = make_unique<BlkLog>(p / "blkLog", 4096, 1);
+  for (uint64_t i = 0; i <= 100; i++)
+    BOOST_REQUIRE(w.setInChainDB("/blk/" + std::to_string(i), blk_of(i)));
+  BOOST_REQUIRE(w.blk_log->n_segments() > 1);
+  BOOST_CHECK(not w.blks_in_chainDB);
+
+  // 🐢 : Blk 1 can't be rewritten in the log, so it goes to the chainDB and wins
+  BOOST_REQUIRE(w.setInChainDB("/blk/1", "new"));
+  BOOST_CHECK(w.blks_in_chainDB);
+  BOOST_CHECK_EQUAL(w.blk_log->get(1).value(), blk_of(1));
+  BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/1").value(), "new");
+  BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/2").value(), blk_of(2));
+  BOOST_CHECK(not w.getFromChainDB("/blk/101"));
+
+  vector<optional<string>> vs = w.getManyFromChainDB({"/blk/1", "/blk/2", "/blk/101"});
+  BOOST_CHECK_EQUAL(vs[0].value(), "new");
+  BOOST_CHECK_EQUAL(vs[1].value(), blk_of(2));
+  BOOST_CHECK(not vs[2]);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_migration_all_or_nothing, TmpDir){
+  {
+    WorldStorage w{p};
+    for (uint64_t i = 0; i <= 3; i++)
+      BOOST_REQUIRE(w.setInChainDB("/blk/" + std::to_string(i), blk_of(i)));
+    BOOST_REQUIRE(w.setInChainDB("/other/blk_number", "3"));
+  }
+  // 🦜 : a half-done move (crashed before the rename) is thrown away
+  {
+    BlkLog l{p / "blkLog.tmp"};
+    BOOST_REQUIRE(l.append(0, "junk"));
+  }
+  {
+    WorldStorage w{p, true};
+    BOOST_REQUIRE(w.blk_log);
+    BOOST_CHECK(not filesystem::exists(p / "blkLog.tmp"));
+    BOOST_CHECK_EQUAL(w.blk_log->last().value(), 3);
+    BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/0").value(), blk_of(0));
+    BOOST_CHECK(not w.blks_in_chainDB);
+
+    /*
+      🐢 : crashed after the rename: the chainDB still has the Blks. Blk 3
+      was since put in the chainDB (the log couldn't take it), that one stays.
+     */
+    BOOST_REQUIRE(w.setInChainDB(WorldStorage::BLKS_MOVING, "1"));
+    w.blk_log.reset();
+    BOOST_REQUIRE(w.setInChainDB("/blk/2", blk_of(2)));
+    BOOST_REQUIRE(w.setInChainDB("/blk/3", "new"));
+  }
+  WorldStorage w{p, true};
+  BOOST_REQUIRE(w.blk_log);
+  BOOST_CHECK(not WorldStorage::tryGetKvString(w.chainDB, "/blk/2"));
+  BOOST_CHECK(not WorldStorage::tryGetKvString(w.chainDB, WorldStorage::BLKS_MOVING));
+  BOOST_CHECK(w.blks_in_chainDB);
+  BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/2").value(), blk_of(2));
+  BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/3").value(), "new");
+}
+
+BOOST_AUTO_TEST_SUITE_END();
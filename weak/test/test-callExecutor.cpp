@@ -0,0 +1,133 @@
+#include "h.hpp"
+
+#include "callExecutor.hpp"
+#include "storageManager.hpp"
+
+using namespace weak;
+
+/*
+  🦜 : The contract compiled by solc that exposes set(uint256) and get() ->
+  uint256. (The same one used in test-executeEvmTx.cpp)
+ */
+const string set_get_hex =
+  "608060405234801561001057600080fd5b50600436106100365760003560e01c806360fe47b11461003b5780636d4ce63c14610057575b600080fd5b610055600480360381019061005091906100c3565b610075565b005b61005f61007f565b60405161006c91906100ff565b60405180910390f35b8060008190555050565b60008054905090565b600080fd5b6000819050919050565b6100a08161008d565b81146100ab57600080fd5b50565b6000813590506100bd81610097565b92915050565b6000602082840312156100d9576100d8610088565b5b60006100e7848285016100ae565b91505092915050565b6100f98161008d565b82525050565b600060208201905061011460008301846100f0565b9291505056fea2646970667358221220271e30d641d99bedebb5450b18efe8b67269cf688a15386162d4c2ff7072a8af64736f6c63430008130033"
+  ;
+
+/**
+ * @brief Put the set/get contract at `a` with the stored value 123.
+ */
+void prepare_set_get(InRamWorldStorage & w, const address & a){
+  Acn acn{0,evmc::from_hex(set_get_hex).value()};
+  acn.storage[bytes32{0}] = bytes32{123};
+  w.applyJournalStateDB({StateChange{false, addressToString(a), acn.toString()}});
+}
+
+int value_of(const bytes & o){
+  BOOST_REQUIRE_EQUAL(o.size(), 32);
+  uint8_t x[32];
+  std::copy_n(o.data(),32,x);
+  return int(intx::be::load<intx::uint256,32>(x));
+}
+
+BOOST_AUTO_TEST_SUITE(test_callExecutor);
+
+BOOST_AUTO_TEST_CASE(test_call_get){
+  InRamWorldStorage w;
+  address a = makeAddress(1);
+  prepare_set_get(w, a);
+
+  CallExecutor c{dynamic_cast<IAcnSnapshotable*>(&w), 1 /*call at a time*/};
+  optional<CallResult> r;
+  std::tie(r, std::ignore) = c.call(makeAddress(2), a, evmc::from_hex("6d4ce63c").value());
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r.value().status, EVMC_SUCCESS);
+  BOOST_CHECK_EQUAL(value_of(r.value().output), 123);
+  BOOST_CHECK(r.value().gas_used > 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_call_changes_nothing){
+  InRamWorldStorage w;
+  address a = makeAddress(1);
+  prepare_set_get(w, a);
+  map<string,string> before = w.stateDB;
+
+  CallExecutor c{dynamic_cast<IAcnSnapshotable*>(&w), 1};
+  // set(7)
+  optional<CallResult> r;
+  std::tie(r, std::ignore) = c.call(makeAddress(2), a,
+                                  evmc::from_hex("60fe47b10000000000000000000000000000000000000000000000000000000000000007").value());
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r.value().status, EVMC_SUCCESS);
+
+  // 🦜 : still 123
+  BOOST_CHECK(w.stateDB == before);
+  std::tie(r, std::ignore) = c.call(makeAddress(2), a, evmc::from_hex("6d4ce63c").value());
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(value_of(r.value().output), 123);
+}
+
+BOOST_AUTO_TEST_CASE(test_call_out_of_gas){
+  InRamWorldStorage w;
+  address a = makeAddress(1);
+  prepare_set_get(w, a);
+
+  CallExecutor c{dynamic_cast<IAcnSnapshotable*>(&w), 1, 1'000 /*max gas*/};
+  // 🦜 : get() costs more than 10
+  optional<CallResult> r;
+  std::tie(r, std::ignore) = c.call(makeAddress(2), a, evmc::from_hex("6d4ce63c").value(), 10);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_NE(r.value().status, EVMC_SUCCESS);
+
+  // 🦜 : asking for more than max_gas gets max_gas
+  std::tie(r, std::ignore) = c.call(makeAddress(2), a, evmc::from_hex("6d4ce63c").value(), 1'000'000);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK(r.value().gas_used <= 1'000);
+}
+
+BOOST_AUTO_TEST_CASE(test_call_no_such_contract){
+  InRamWorldStorage w;
+  CallExecutor c{dynamic_cast<IAcnSnapshotable*>(&w), 1};
+  auto [ok, s] = c.callForRpc(makeAddress(2), makeAddress(3), bytes{}, {}, {});
+  BOOST_REQUIRE(ok);
+  json::object o = json::parse(s).as_object();
+  BOOST_CHECK(not o.at("ok").as_bool());
+}
+
+BOOST_AUTO_TEST_CASE(test_call_async_on_the_pool){
+  InRamWorldStorage w;
+  address a = makeAddress(1);
+  prepare_set_get(w, a);
+
+  CallExecutor c{dynamic_cast<IAcnSnapshotable*>(&w), 1};
+  std::promise<tuple<bool,string>> p;
+  std::thread::id on;
+  c.callForRpcAsync(makeAddress(2), a, evmc::from_hex("6d4ce63c").value(), {}, {},
+                    [&](tuple<bool,string> r){
+                      on = std::this_thread::get_id();
+                      p.set_value(r);
+                    });
+  auto [ok, s] = p.get_future().get();
+  BOOST_REQUIRE(ok);
+  BOOST_CHECK(json::parse(s).at("ok").as_bool());
+  BOOST_CHECK(on != std::this_thread::get_id()); // 🦜 : replied from the pool
+
+  // 🦜 : no room for pending calls => refused right away
+  CallExecutor c0{dynamic_cast<IAcnSnapshotable*>(&w), 1, 10'000'000, 0 /*max pending*/};
+  optional<CallResult> r;
+  std::tie(r, std::ignore) = c0.call(makeAddress(2), a, evmc::from_hex("6d4ce63c").value());
+  BOOST_CHECK(not r);
+  BOOST_CHECK_EQUAL(c0.n_rejected.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_snapshot_doesnt_see_later_changes){
+  InRamWorldStorage w;
+  address a = makeAddress(1);
+  prepare_set_get(w, a);
+
+  shared_ptr<IAcnGettable> s = w.snapshotOfAcns();
+  w.applyJournalStateDB({StateChange{true, addressToString(a), ""}});
+  BOOST_CHECK(not w.getAcn(a));
+  BOOST_CHECK(s->getAcn(a));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -180,6 +180,61 @@ BOOST_AUTO_TEST_CASE(test_makeBlk){
 
 
 
+BOOST_AUTO_TEST_CASE(blk_hash_merkle){
+  // 🦜 : the big Blks are hashed in parallel, it should give the same root
+  vector<Tx> txs;
+  for (uint64_t i = 0; i < Blk::PARALLEL_HASH_MIN + 3; i++)
+    txs.push_back(Tx(makeAddress(1),makeAddress(2),bytes{},i/*nonce*/));
+
+  vector<hash256> hs;
+  for (const Tx & t : txs) hs.push_back(t.hash());
+  hash256 r = MerkleTree::root(hs);
+
+  hash256 p;
+  std::fill(std::begin(p.bytes),std::end(p.bytes),0x00);
+  Blk b = Blk(1,p,txs);
+  BOOST_CHECK_EQUAL(hashToString(b.txRoot()), hashToString(r));
+  BOOST_CHECK_EQUAL(hashToString(b.hash()), hashToString(Blk::hashOf(p, r, txs.size())));
+
+  for (size_t i : {size_t{0}, size_t{1}, hs.size() - 1}){
+    vector<hash256> pf = MerkleTree::proof(hs, i);
+    BOOST_CHECK(MerkleTree::verify(hs[i], i, hs.size(), pf, r));
+    BOOST_CHECK(not MerkleTree::verify(hs[(i + 1) % hs.size()], i, hs.size(), pf, r));
+    BOOST_CHECK(Blk::verifyTx(hs[i], i, hs.size(), pf, p, b.hash()));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_no_second_preimage){
+  vector<hash256> hs;
+  for (uint64_t i = 0; i < 5; i++)
+    hs.push_back(Tx(makeAddress(1),makeAddress(2),bytes{},i/*nonce*/).hash());
+  hash256 r = MerkleTree::root(hs);
+
+  // 🦜 : a level of the tree can't pass as the list
+  vector<hash256> ls = hs;
+  MerkleTree::hashLeaves(ls.data(), ls.size());
+  vector<hash256> up = ls;
+  MerkleTree::hashLevel(up, up.size());
+  up.resize(3);
+  BOOST_CHECK_NE(hashToString(MerkleTree::root(up)), hashToString(r));
+  BOOST_CHECK_EQUAL(hashToString(MerkleTree::rootOfNodes(up)), hashToString(r));
+
+  // 🦜 : [a, b, c] isn't [a, b, c, c]
+  vector<hash256> abc(hs.begin(), hs.begin() + 3), abcc = abc;
+  abcc.push_back(abc[2]);
+  BOOST_CHECK_NE(hashToString(MerkleTree::root(abc)), hashToString(MerkleTree::root(abcc)));
+
+  // 🐢 : a proof of the 5th of 5 is a proof of the 3rd of 3 (the last one goes
+  // up as it is) with the same root, so n must come from the Blk hash.
+  hash256 p{};
+  vector<hash256> pf = MerkleTree::proof(hs, 4);
+  hash256 bh = Blk::hashOf(p, r, hs.size());
+  BOOST_CHECK(Blk::verifyTx(hs[4], 4, 5, pf, p, bh));
+  BOOST_CHECK(not Blk::verifyTx(hs[4], 4, 6, pf, p, bh));
+  BOOST_CHECK(not Blk::verifyTx(hs[4], 2, 3, pf, p, bh));
+  BOOST_CHECK(not Blk::verifyTx(hs[4], 4, 5, pf, r, bh)); // wrong parent
+}
+
 BOOST_AUTO_TEST_CASE(blk_toJson){
   auto [a1,a2,data] = get_example_address_and_data();
 
@@ -157,3 +157,31 @@ BOOST_AUTO_TEST_CASE(test_commit_blk){
   BOOST_REQUIRE(bool{r});
   BOOST_CHECK_EQUAL(r.value(),"1");
 }
+
+namespace mockedAcnPrv{
+  // 🦜 : The in-RAM world that can't write the receipts
+  class F3 : public F{
+  public:
+    bool setInChainDB(const string k, const string v) override{
+      if (k.starts_with("/receipt/")) return false;
+      return F::setInChainDB(k, v);
+    };
+  };
+}
+
+BOOST_AUTO_TEST_CASE(test_commit_blk_index_fails){
+  hash256 h{};
+  Blk b0{1, h, {Tx(makeAddress(1), makeAddress(2), bytes{}, 123/*nonce*/)}};
+  ExecBlk b{b0, {{}}, {TxReceipt(true)}};
+
+  mockedTxExe::A ex;
+  mockedAcnPrv::F3 w;
+  BlkExecutor be(dynamic_cast<IWorldChainStateSettable*>(&w),
+                 dynamic_cast<ITxExecutable*>(&ex),
+                 dynamic_cast<IAcnGettable*>(&w)
+                 );
+  // 🐢 : a failed index write fails the commit, the Blk isn't on the chain
+  BOOST_CHECK(not be.commitBlk(b));
+  BOOST_CHECK(not w.getFromChainDB("/blk/1"));
+  BOOST_CHECK(not w.getFromChainDB("/other/blk_number"));
+}
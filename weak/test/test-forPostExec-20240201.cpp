@@ -91,6 +91,72 @@ BOOST_AUTO_TEST_CASE(test_exec_blk_to_pb){
   BOOST_CHECK_EQUAL(b2.txReceipts[1].ok, false);
 }
 
+/*
+  <2024-07-26 Fri> 🦜 : A hot Acn with a big storage, touched by 50 Txs that
+  each set one slot. In pb, all but the first are deltas, and they come back
+  as the whole Acns.
+ */
+BOOST_AUTO_TEST_CASE(test_exec_blk_pb_delta){
+  Acn a{0, bytes{}};
+  for (uint64_t i = 0; i < 100; i++)
+    a.storage[bytes32{i}] = bytes32{i};
+  const string k = addressToString(makeAddress(1));
+
+  vector<Tx> txs;
+  vector<vector<StateChange>> J;
+  vector<TxReceipt> R;
+  for (uint64_t n = 1; n <= 50; n++){
+    txs.push_back(Tx(makeAddress(2), makeAddress(1), bytes{}, n));
+    a.nonce = n;
+    a.storage[bytes32{n}] = bytes32{1000 + n};
+    J.push_back({{false, k, a.toString()}});
+    R.push_back(TxReceipt(true));
+  }
+  // 🦜 : a slot removed, so no delta for this one
+  a.storage.erase(bytes32{1});
+  txs.push_back(Tx(makeAddress(2), makeAddress(1), bytes{}, 51));
+  J.push_back({{false, k, a.toString()}});
+  R.push_back(TxReceipt(true));
+
+  ExecBlk b{Blk(1, hash256{}, txs), J, R};
+  hiPb::ExecBlk pb = b.toPb0();
+  BOOST_CHECK(not pb.statechanges(0).changes(0).delta());
+  BOOST_CHECK(pb.statechanges(1).changes(0).delta());
+  BOOST_CHECK(not pb.statechanges(50).changes(0).delta());
+
+  size_t n_full = 0;
+  for (auto & j : J) n_full += j[0].v.size();
+  size_t n_pb = 0;
+  for (auto & scs : pb.statechanges()) n_pb += scs.changes(0).v().size();
+  BOOST_TEST_MESSAGE((format("🐸 journals: %d bytes whole, %d bytes with deltas") % n_full % n_pb).str());
+  BOOST_CHECK(n_pb * 5 < n_full);
+
+  ExecBlk b2;
+  b2.fromPb0(pb);
+  BOOST_REQUIRE_EQUAL(b2.stateChanges.size(), J.size());
+  for (size_t i = 0; i < J.size(); i++){
+    Acn x, y;
+    BOOST_REQUIRE(x.fromString(J[i][0].v));
+    BOOST_REQUIRE(y.fromString(b2.stateChanges[i][0].v));
+    BOOST_CHECK_EQUAL(x.nonce, y.nonce);
+    BOOST_CHECK(x.storage == y.storage);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_last_change_of_each_key){
+  vector<vector<StateChange>> J = {
+    {{false, "k1", "v1"}, {false, "k2", "v1"}},
+    {{true, "k1", ""}},
+    {{false, "k2", "v2"}, {false, "k3", "v1"}},
+  };
+  vector<const StateChange*> cs = lastChangeOfEachKey(J);
+  BOOST_REQUIRE_EQUAL(cs.size(), 3);
+  BOOST_CHECK_EQUAL(cs[0]->k, "k1");
+  BOOST_CHECK(cs[0]->del);
+  BOOST_CHECK_EQUAL(cs[1]->v, "v2");
+  BOOST_CHECK_EQUAL(cs[2]->k, "k3");
+}
+
 BOOST_AUTO_TEST_CASE(test_tx_on_blk_info_pb){
   TxOnBlkInfo i{1,2};           // 2nd tx on block 1
   TxOnBlkInfo i2;
@@ -86,6 +86,13 @@ BOOST_AUTO_TEST_CASE(test_signed_Data_fromString){
   check_fromString("aa","b","ccc",b2c(1) + string("aa") + b2c(1) + "b" + "ccc");
 }
 
+BOOST_AUTO_TEST_CASE(test_signed_Data_fromString_truncated){
+  // 🦜 : the lengths claim more than what's there. (This used to read past the end.)
+  SignedData d;
+  BOOST_CHECK(not d.fromString(b2c(3) + string("aa")));
+  BOOST_CHECK(not d.fromString(b2c(1) + string("aa") + b2c(5) + "b"));
+}
+
 
 namespace mockedMsgMgr {
   class A : public virtual IMsgManageable{
@@ -114,3 +114,87 @@ BOOST_FIXTURE_TEST_CASE(test_prefix, TmpWorldStorage){
 
 
 }
+
+BOOST_FIXTURE_TEST_CASE(test_snapshot_while_applying, TmpWorldStorage){
+  /*
+    🦜 : Each journal puts k0..k9 to the same value, so a snapshot taken at any
+    time (under the lock) must see ten equal values.
+   */
+  std::thread t{[&](){
+    for (int i = 0; i < 2000; i++){
+      vector<StateChange> j;
+      for (int k = 0; k < 10; k++)
+        j.push_back({false, "k" + std::to_string(k), std::to_string(i)});
+      w->applyJournalStateDB(j);
+    }
+  }};
+  for (int i = 0; i < 2000; i++){
+    shared_ptr<InRamWorldStorage::Snapshot> s =
+      std::dynamic_pointer_cast<InRamWorldStorage::Snapshot>(w->snapshotOfAcns());
+    BOOST_REQUIRE(s);
+    std::this_thread::yield(); // 🦜 : let some journals come after it
+    optional<string> v0 = s->valueOf("k0");
+    for (int k = 1; k < 10; k++)
+      BOOST_REQUIRE(s->valueOf("k" + std::to_string(k)) == v0);
+  }
+  t.join();
+}
+
+BOOST_FIXTURE_TEST_CASE(test_snapshot_is_copy_on_write, TmpWorldStorage){
+  // <2024-07-29 Mon> 🦜 : a snapshot only copies what's changed after it, and can outlive the storage
+  Acn a1{1, bytes{}};
+  Acn a2{2, bytes{}};
+  BOOST_REQUIRE(w->applyJournalStateDB({
+        {false, addressToString(makeAddress(1)), a1.toString()},
+        {false, addressToString(makeAddress(2)), a2.toString()}
+      }));
+  auto s = std::dynamic_pointer_cast<InRamWorldStorage::Snapshot>(w->snapshotOfAcns());
+  BOOST_REQUIRE(s);
+  BOOST_CHECK(s->before.empty());
+
+  Acn a3{3, bytes{}};
+  BOOST_REQUIRE(w->applyJournalStateDB({
+        {false, addressToString(makeAddress(1)), a2.toString()},
+        {true, addressToString(makeAddress(2)), ""},
+        {false, addressToString(makeAddress(3)), a3.toString()}
+      }));
+  BOOST_CHECK_EQUAL(s->before.size(), 3);
+  BOOST_REQUIRE(s->getAcn(makeAddress(1)));
+  BOOST_CHECK_EQUAL(s->getAcn(makeAddress(1)).value().nonce, 1);
+  BOOST_CHECK(s->getAcn(makeAddress(2)));
+  BOOST_CHECK(not s->getAcn(makeAddress(3)));
+
+  // 🦜 : the storage is gone, the snapshot still reads the same
+  w.reset();
+  BOOST_CHECK_EQUAL(s->getAcn(makeAddress(1)).value().nonce, 1);
+  BOOST_CHECK(s->getAcn(makeAddress(2)));
+  BOOST_CHECK(not s->getAcn(makeAddress(3)));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_code_ref_only_acns, TmpWorldStorage){
+  // <2024-07-28 Sun> 🦜 : an Acn written back without its code only has the code_ref
+  bytes code(size_t{100}, uint8_t{0xaa});
+  Acn a1{1, code};
+  Acn a2{2, bytes{}};
+  a2.code_ref = a1.codehash();
+  BOOST_REQUIRE(w->applyJournalStateDB({
+        {false, addressToString(makeAddress(1)), a1.toString()},
+        {false, addressToString(makeAddress(2)), a2.toString()},
+      }));
+  Acn r = w->getAcn(makeAddress(2)).value();
+  BOOST_CHECK(w->codeOf(r) == bytes_view(code));
+
+  shared_ptr<IAcnGettable> s = w->snapshotOfAcns();
+  Acn r1 = s->getAcn(makeAddress(2)).value();
+  BOOST_CHECK(s->codeOf(r1) == bytes_view(code));
+
+  // 🐢 : a code we don't have is refused, and nothing of the journal is applied
+  Acn a3{3, bytes{}};
+  a3.code_ref = Acn{1, bytes(size_t{100}, uint8_t{0xbb})}.codehash();
+  BOOST_CHECK(not w->applyJournalStateDB({
+        {false, addressToString(makeAddress(4)), Acn{4, bytes{}}.toString()},
+        {false, addressToString(makeAddress(3)), a3.toString()},
+      }));
+  BOOST_CHECK(not w->getAcn(makeAddress(4)));
+  BOOST_CHECK(not w->getAcn(makeAddress(3)));
+}
@@ -188,4 +188,318 @@ BOOST_AUTO_TEST_CASE(test_call_dynamically_registered_handler_with_query_param){
 } // server closed here
 
 
+BOOST_AUTO_TEST_CASE(test_sharded_acceptors_with_handler_pool){
+  const uint16_t PORT = 7781;
+  // 🦜 : 2 acceptors on the same port, 4 io threads, 2 handler threads
+  WeakAsyncTcpHttpServer sr{PORT, 4, 2, 2};
+  BOOST_CHECK_EQUAL(sr.iocs.size(), WeakAsyncTcpHttpServer::can_reuse_port() ? 2 : 1);
+  BOOST_CHECK(sr.handler_pool);
+
+  std::atomic<int> n{0};
+  sr.listenToGet("/aaa",
+                 [&n](string /*from*/
+                      ,uint16_t /*port*/
+                      ,optional<unordered_map<string,string>> /*qparam*/
+                      ) -> tuple<bool,string>{
+                   n++;
+                   return make_tuple(true,"aaa");
+                 });
+  sleep_for(1);
+
+  for (int i = 0; i < 10; i++){
+    auto r = weakHttpClient::get("localhost","/aaa",PORT);
+    BOOST_REQUIRE(r);
+    BOOST_CHECK_EQUAL(r.value(),"aaa");
+  }
+  BOOST_CHECK_EQUAL(n.load(),10);
+} // server closed here
+
+BOOST_AUTO_TEST_CASE(test_slow_handler_does_not_block_io){
+  const uint16_t PORT = 7782;
+  // 🦜 : only one io thread, but handlers are on the pool.
+  WeakAsyncTcpHttpServer sr{PORT, 1, 1, 2};
+  sr.listenToGet("/slow",
+                 [](string,uint16_t,optional<unordered_map<string,string>>) -> tuple<bool,string>{
+                   std::this_thread::sleep_for(std::chrono::seconds(2));
+                   return make_tuple(true,"slow");
+                 });
+  sr.listenToGet("/fast",
+                 [](string,uint16_t,optional<unordered_map<string,string>>) -> tuple<bool,string>{
+                   return make_tuple(true,"fast");
+                 });
+  sleep_for(1);
+
+  std::jthread t([](){weakHttpClient::get("localhost","/slow",PORT);});
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  auto t0 = std::chrono::steady_clock::now();
+  auto r = weakHttpClient::get("localhost","/fast",PORT);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r.value(),"fast");
+  BOOST_CHECK_LT(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count(),
+                 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_streaming_get){
+  const uint16_t PORT = 7783;
+  WeakAsyncTcpHttpServer sr{PORT, 2, 1, 2};
+  sr.listenToGetStream("/stream",
+                       [](string,uint16_t,optional<unordered_map<string,string>> q,
+                          const IHttpServable::chunkWriter_t & write) -> tuple<bool,string>{
+                         if ((not q) or (not q.value().contains("n")))
+                           return make_tuple(false, "n is missing");
+                         int n = std::stoi(q.value().at("n"));
+                         for (int i = 0; i < n; i++)
+                           if (not write(std::to_string(i) + "\n")) return make_tuple(false, "client gone");
+                         return make_tuple(true, "");
+                       });
+  sleep_for(1);
+
+  auto r = weakHttpClient::get("localhost","/stream?n=3",PORT);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r.value(),"0\n1\n2\n");
+
+  // 🦜 : failed before writing anything ⇒ not a 200
+  BOOST_CHECK(not weakHttpClient::get("localhost","/stream",PORT));
+  r = weakHttpClient::get("localhost","/stream?n=0",PORT); // 🦜 : empty body
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r.value(),"");
+
+  // 🦜 : The buffered fallback (no socket) gets the same thing
+  request<http::string_body> req{http::verb::get, "/stream?n=3", 11};
+  auto res = sr.handle_request(std::move(req),"10.0.0.1",1234);
+  BOOST_CHECK_EQUAL(res.body(),"0\n1\n2\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_deferred_get){
+  const uint16_t PORT = 7784;
+  // 🦜 : only one handler thread, the parked requests shouldn't take it.
+  WeakAsyncTcpHttpServer sr{PORT, 2, 1, 1};
+  std::mutex l;
+  vector<shared_ptr<IDeferredReply>> parked;
+  sr.listenToGetDeferred("/wait",
+                         [&](string,uint16_t,optional<unordered_map<string,string>> q,
+                             shared_ptr<IDeferredReply> r){
+                           if (q and q.value().contains("t")){
+                             r->expires_after(std::chrono::milliseconds(std::stoi(q.value().at("t"))),
+                                              [r](){r->reply(make_tuple(true,"timeout"));});
+                             return;
+                           }
+                           std::unique_lock g(l);
+                           parked.push_back(r);
+                         });
+  sr.listenToGet("/fast",
+                 [](string,uint16_t,optional<unordered_map<string,string>>) -> tuple<bool,string>{
+                   return make_tuple(true,"fast");
+                 });
+  sleep_for(1);
+
+  vector<optional<string>> got(3);
+  {
+    vector<std::jthread> ts;
+    for (int i = 0; i < 3; i++)
+      ts.emplace_back([&got, i](){got[i] = weakHttpClient::get("localhost","/wait",PORT);});
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    auto r = weakHttpClient::get("localhost","/fast",PORT);
+    BOOST_REQUIRE(r);
+    BOOST_CHECK_EQUAL(r.value(),"fast");
+
+    std::unique_lock g(l);
+    BOOST_REQUIRE_EQUAL(parked.size(), 3);
+    for (auto & x : parked){
+      BOOST_CHECK(x->reply(make_tuple(true,"done")));
+      BOOST_CHECK(not x->reply(make_tuple(true,"again"))); // 🦜 : only the first one counts
+    }
+  } // joined here
+  for (auto & x : got){
+    BOOST_REQUIRE(x);
+    BOOST_CHECK_EQUAL(x.value(),"done");
+  }
+
+  // 🦜 : not replied in time
+  auto r = weakHttpClient::get("localhost","/wait?t=100",PORT);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r.value(),"timeout");
+
+  // 🦜 : The blocking fallback (no socket) gets the same thing
+  request<http::string_body> req{http::verb::get, "/wait?t=50", 11};
+  auto res = sr.handle_request(std::move(req),"10.0.0.1",1234);
+  BOOST_CHECK_EQUAL(res.body(),"timeout");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(test_admission);
+
+BOOST_AUTO_TEST_CASE(test_token_bucket){
+  using clock = TokenBucket::clock;
+  auto t0 = clock::now();
+  TokenBucket b{2, t0};         // burst = 2
+  BOOST_CHECK(std::get<0>(b.try_take(1, 2, t0)));
+  BOOST_CHECK(std::get<0>(b.try_take(1, 2, t0)));
+  auto [ok, wait] = b.try_take(1, 2, t0);
+  BOOST_CHECK(not ok);
+  BOOST_CHECK_CLOSE(wait, 1.0, 0.01);
+  // 🦜 : one second later, one token is back
+  BOOST_CHECK(std::get<0>(b.try_take(1, 2, t0 + std::chrono::seconds(1))));
+}
+
+BOOST_AUTO_TEST_CASE(test_in_flight_bounded){
+  AdmissionController a{2};
+  auto [v1, r1, t1] = a.try_admit("A");
+  auto [v2, r2, t2] = a.try_admit("B");
+  BOOST_CHECK(v1 == AdmissionController::Verdict::ADMITTED);
+  BOOST_CHECK(v2 == AdmissionController::Verdict::ADMITTED);
+  BOOST_CHECK_EQUAL(a.in_flight.load(), 2);
+  {
+    auto [v3, r3, t3] = a.try_admit("C");
+    BOOST_CHECK(v3 == AdmissionController::Verdict::OVERLOADED);
+    BOOST_CHECK_EQUAL(a.n_rejected_full.load(), 1);
+  }
+  {
+    AdmissionController::Ticket t = std::move(t1); // 🦜 : released when out of scope
+  }
+  BOOST_CHECK_EQUAL(a.in_flight.load(), 1);
+  auto [v4, r4, t4] = a.try_admit("C");
+  BOOST_CHECK(v4 == AdmissionController::Verdict::ADMITTED);
+}
+
+BOOST_AUTO_TEST_CASE(test_guarded_post_rejected){
+  WeakHttpServerBase srv;
+  AdmissionController a{0 /*unbounded*/, 1 /*1 per sec*/, 1 /*burst*/};
+  srv.listenToPost("/add_txs",[](string,uint16_t,string_view) -> tuple<bool,string>{
+    return make_tuple(true,"ok");
+  });
+  srv.guardPost("/add_txs",&a);
+
+  auto make_req = [](){
+    request<http::string_body> req{http::verb::post, "/add_txs", 11};
+    req.body() = "[]";
+    req.prepare_payload();
+    return req;
+  };
+
+  BOOST_CHECK(srv.handle_request(make_req(),"10.0.0.1",1234).result() == http::status::ok);
+  auto res = srv.handle_request(make_req(),"10.0.0.1",1234);
+  BOOST_CHECK(res.result() == http::status::too_many_requests);
+  BOOST_CHECK_EQUAL(res[http::field::retry_after], "1");
+  // 🦜 : other clients are not affected
+  BOOST_CHECK(srv.handle_request(make_req(),"10.0.0.2",1234).result() == http::status::ok);
+  BOOST_CHECK_EQUAL(a.n_rejected_rate.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_overloaded_takes_no_token){
+  AdmissionController a{1, 1 /*1 per sec*/, 1 /*burst*/};
+  auto [v1, r1, t1] = a.try_admit("A");
+  BOOST_REQUIRE(v1 == AdmissionController::Verdict::ADMITTED);
+  {
+    auto [v2, r2, t2] = a.try_admit("B"); // 🦜 : full
+    BOOST_CHECK(v2 == AdmissionController::Verdict::OVERLOADED);
+  }
+  { AdmissionController::Ticket t = std::move(t1); }
+  // 🦜 : B still has its token
+  auto [v3, r3, t3] = a.try_admit("B");
+  BOOST_CHECK(v3 == AdmissionController::Verdict::ADMITTED);
+  // 🦜 : and a 429 doesn't hold a slot
+  { AdmissionController::Ticket t = std::move(t3); }
+  auto [v4, r4, t4] = a.try_admit("B");
+  BOOST_CHECK(v4 == AdmissionController::Verdict::RATE_LIMITED);
+  BOOST_CHECK_EQUAL(a.in_flight.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_queued_requests_are_in_flight){
+  /*
+    🦜 : One handler thread, busy with a slow guarded request. The next one
+    waits in the queue and counts as in flight, so the third gets 503 right
+    away.
+   */
+  const uint16_t PORT = 7784;
+  WeakAsyncTcpHttpServer sr{PORT, 2, 1, 1 /*handler thread*/};
+  AdmissionController a{2};
+  sr.listenToPost("/add_txs",[](string,uint16_t,string_view) -> tuple<bool,string>{
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    return make_tuple(true,"ok");
+  });
+  sr.guardPost("/add_txs",&a);
+  sleep_for(1);
+
+  std::thread t1{[](){ weakHttpClient::post("localhost","/add_txs",PORT,"[]"); }};
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::thread t2{[](){ weakHttpClient::post("localhost","/add_txs",PORT,"[]"); }};
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  BOOST_CHECK_EQUAL(a.in_flight.load(), 2);
+  auto r = weakHttpClient::post("localhost","/add_txs",PORT,"[]");
+  BOOST_CHECK(not r);
+  BOOST_CHECK_EQUAL(a.n_rejected_full.load(), 1);
+  t1.join(); t2.join();
+  BOOST_CHECK_EQUAL(a.in_flight.load(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_CASE(test_accept_protobuf){
+  WeakHttpServerBase srv;
+  srv.listenToGet("/aaa",[](string,uint16_t,optional<unordered_map<string,string>>) -> tuple<bool,string>{
+    return make_tuple(true,"json");
+  });
+  srv.listenToGet("/aaa_pb",[](string,uint16_t,optional<unordered_map<string,string>> q) -> tuple<bool,string>{
+    return make_tuple(true,"pb:" + (q ? q.value().at("x") : string{}));
+  });
+  srv.listenToGet("/bbb",[](string,uint16_t,optional<unordered_map<string,string>>) -> tuple<bool,string>{
+    return make_tuple(true,"json");
+  });
+
+  request<http::string_body> req{http::verb::get, "/aaa?x=1", 11};
+  req.set(http::field::accept, "application/x-protobuf");
+  auto res = srv.handle_request(request<http::string_body>(req),"10.0.0.1",1234);
+  BOOST_REQUIRE(res.result() == http::status::ok);
+  BOOST_CHECK_EQUAL(res.body(), "pb:1");
+  BOOST_CHECK_EQUAL(res[http::field::content_type], "application/x-protobuf");
+
+  // 🦜 : no pb version => json
+  req.target("/bbb");
+  res = srv.handle_request(request<http::string_body>(req),"10.0.0.1",1234);
+  BOOST_CHECK_EQUAL(res.body(), "json");
+  BOOST_CHECK_EQUAL(res[http::field::content_type], "application/json");
+
+  // 🦜 : no Accept => json
+  request<http::string_body> req1{http::verb::get, "/aaa", 11};
+  res = srv.handle_request(std::move(req1),"10.0.0.1",1234);
+  BOOST_CHECK_EQUAL(res.body(), "json");
+}
+
+BOOST_AUTO_TEST_CASE(test_get_with_etag){
+  WeakHttpServerBase srv;
+  srv.listenToGet("/aaa",[](string,uint16_t,optional<unordered_map<string,string>>) -> tuple<bool,string>{
+    return make_tuple(true,"aaa");
+  });
+
+  request<http::string_body> req{http::verb::get, "/aaa", 11};
+  auto res = srv.handle_request(request<http::string_body>(req),"10.0.0.1",1234);
+  BOOST_REQUIRE(res.result() == http::status::ok);
+  string tag = string(res[http::field::etag]);
+  BOOST_CHECK_EQUAL(tag, WeakHttpServerBase::etag_of("aaa"));
+
+  // 🦜 : The client already has it
+  req.set(http::field::if_none_match, tag);
+  res = srv.handle_request(request<http::string_body>(req),"10.0.0.1",1234);
+  BOOST_CHECK(res.result() == http::status::not_modified);
+  BOOST_CHECK(res.body().empty());
+
+  // 🦜 : The client has an old one
+  req.set(http::field::if_none_match, WeakHttpServerBase::etag_of("bbb"));
+  res = srv.handle_request(request<http::string_body>(req),"10.0.0.1",1234);
+  BOOST_CHECK(res.result() == http::status::ok);
+  BOOST_CHECK_EQUAL(res.body(), "aaa");
+
+  // 🦜 : a list, weak tags and `*` (RFC 9110)
+  for (string h : {WeakHttpServerBase::etag_of("bbb") + ", " + tag, "W/" + tag,
+                   WeakHttpServerBase::etag_of("bbb") + ",W/" + tag + " ", string("*")}){
+    req.set(http::field::if_none_match, h);
+    res = srv.handle_request(request<http::string_body>(req),"10.0.0.1",1234);
+    BOOST_CHECK(res.result() == http::status::not_modified);
+  }
+  BOOST_CHECK(not WeakHttpServerBase::none_match("", tag));
+  BOOST_CHECK(not WeakHttpServerBase::none_match(" , ", tag));
+}
@@ -0,0 +1,85 @@
+#include "h.hpp"
+#include "net/pure-compressingMsgMgr.hpp"
+
+using namespace pure;
+
+struct F {
+  NaiveMsgMgr * mh;
+  IMsgManageable * m;
+  string p;                     // a repetitive payload
+  F() {
+    this->mh = new NaiveMsgMgr("N0");
+    this->m = dynamic_cast<IMsgManageable*>(this->mh);
+    for (int i = 0; i < 50; i++)
+      this->p += R"({"from":"0x0000000000000000000000000000000000000001","data":"6080604052348015"})";
+  }
+  ~F() {
+    delete this->mh;
+  }
+};
+
+BOOST_AUTO_TEST_SUITE(test_compressingMsgMgr);
+
+BOOST_FIXTURE_TEST_CASE(test_round_trip,F){
+  CompressingMsgMgr c{m, 64};
+  string msg = c.prepare_msg(string(p));
+  BOOST_CHECK_LT(msg.size(), p.size());
+
+  optional<tuple<string,string>> r = c.tear_msg_open(msg);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(std::get<0>(r.value()),"N0");
+  BOOST_CHECK_EQUAL(std::get<1>(r.value()),p);
+
+  BOOST_CHECK_EQUAL(c.stats.n_sent.load(),1);
+  BOOST_CHECK_EQUAL(c.stats.n_compressed.load(),1);
+  BOOST_CHECK_GT(c.stats.ratio(),1.0);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_small_payload_sent_raw,F){
+  CompressingMsgMgr c{m, 64};
+  string msg = c.prepare_msg("aaa");
+  optional<tuple<string,string>> r = c.tear_msg_open(msg);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(std::get<1>(r.value()),"aaa");
+  BOOST_CHECK_EQUAL(c.stats.n_compressed.load(),0);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_with_dict,F){
+  string d = CompressingMsgMgr::train_dict({p, p});
+  BOOST_CHECK(not d.empty());
+
+  CompressingMsgMgr c{m, 64, d};
+  CompressingMsgMgr c0{m, 64};
+  string msg = c.prepare_msg(string(p));
+  BOOST_CHECK_LT(msg.size(), c0.prepare_msg(string(p)).size());
+
+  optional<tuple<string,string>> r = c.tear_msg_open(msg);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(std::get<1>(r.value()),p);
+
+  // 🦜 : the one without the dictionary cannot open it
+  BOOST_CHECK(not c0.tear_msg_open(msg));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_reject_ill_formed,F){
+  CompressingMsgMgr c{m, 64};
+  BOOST_CHECK(not c.tear_msg_open(m->prepare_msg("Xaaa")));
+  // 🦜 : claims to be huge
+  BOOST_CHECK(not c.tear_msg_open(m->prepare_msg(string("abc" "\0\0\0\0\xff\xff\xff\xff" "Z",12))));
+  BOOST_CHECK(not c.tear_msg_open(m->prepare_msg("Z")));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_raw_frame_is_payload_plus_tag,F){
+  CompressingMsgMgr c{m, 64};
+  BOOST_CHECK_EQUAL(c.compress("aaa"), "aaaR");
+  BOOST_CHECK_EQUAL(c.decompress("aaaR").value(), "aaa");
+
+  // 🦜 : the CPU cost is there too
+  BOOST_CHECK(c.decompress(c.compress(string(p))).value() == p);
+  json::object o = json::parse(c.stats.toJsonString()).as_object();
+  BOOST_CHECK(o.contains("ns_per_byte_out"));
+  BOOST_CHECK(o.contains("ns_per_byte_in"));
+  BOOST_CHECK_GT(o.at("ratio").as_double(), 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -1,6 +1,8 @@
 #include "h.hpp"
 #include "rpc.hpp"
 #include <fstream>
+#include <thread>
+#include <google/protobuf/io/coded_stream.h>
 #include "execManager.hpp"
 #include "mock.hpp"
 
@@ -55,8 +57,32 @@ namespace mockedRpcNetworkable{
       return this->getMap.insert({target,h}).second;
     }
   };
+
+  // The server that can park (deferred handlers)
+  class C : public B{
+  public:
+    unordered_map<string,deferredGetHandler_t> deferredMap;
+    unordered_map<string,deferredPostHandler_t> deferredPostMap;
+    bool listenToGetDeferred(string target,deferredGetHandler_t h)noexcept override{
+      return this->deferredMap.insert({target,h}).second;
+    }
+    bool listenToPostDeferred(string target,deferredPostHandler_t h)noexcept override{
+      return this->deferredPostMap.insert({target,h}).second;
+    }
+  };
 }
 
+// 🦜 : A reply that just keeps what it got, and never times out.
+struct KeptReply: public virtual ::pure::IDeferredReply{
+  optional<tuple<bool,string>> r;
+  bool reply(tuple<bool,string> x) noexcept override{
+    if (r) return false;
+    r = std::move(x);
+    return true;
+  }
+  void expires_after(std::chrono::milliseconds, function<void()>) noexcept override{}
+};
+
 BOOST_AUTO_TEST_CASE(test_empty_server){
   mockedRpcNetworkable::A nh;   // network host
   IForRpcNetworkable * n = dynamic_cast<IForRpcNetworkable*>(&nh);
@@ -448,6 +474,428 @@ BOOST_AUTO_TEST_CASE(test_handle_get_receipt_ok){
   BOOST_REQUIRE(not ok);
 }
 
+BOOST_AUTO_TEST_CASE(test_get_receipt_and_tx_direct_index){
+  /*
+    🦜 : commitBlk() should write the direct index, and the Rpc should still
+    work for chains without it (written before the index existed).
+  */
+  mockedRpcNetworkable::A nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr,
+          dynamic_cast<IChainDBGettable*>(&wh), nullptr};
+
+  auto [b,txs] = prepare_ExecBlk();
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&wh), nullptr, nullptr};
+  BOOST_REQUIRE(exe.commitBlk(b));
+
+  for (const Tx & t : txs){
+    string h = hashToString(t.hash());
+    BOOST_REQUIRE(wh.chainDB.contains("/receipt/" + h));
+    BOOST_REQUIRE(wh.chainDB.contains("/txdata/" + h));
+  }
+
+  string h = hashToString(txs[0].hash());
+  auto [ok, s0] = rpc.handle_get_receipt(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok);
+  auto [ok1, t0] = rpc.handle_get_tx(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok1);
+
+  // 🦜 : Now drop the index, we should get the same thing the long way.
+  std::erase_if(wh.chainDB, [](const auto & kv){
+    return kv.first.starts_with("/receipt/") or kv.first.starts_with("/txdata/");
+  });
+  auto [ok2, s1] = rpc.handle_get_receipt(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok2);
+  BOOST_CHECK_EQUAL(s0, s1);
+  auto [ok3, t1] = rpc.handle_get_tx(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok3);
+  BOOST_CHECK_EQUAL(t0, t1);
+}
+
+BOOST_AUTO_TEST_CASE(test_get_tx_proof){
+  mockedRpcNetworkable::A nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr,
+          dynamic_cast<IChainDBGettable*>(&wh), nullptr};
+
+  auto [b,txs] = prepare_ExecBlk();
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&wh), nullptr, nullptr};
+  BOOST_REQUIRE(exe.commitBlk(b));
+
+  for (size_t i = 0; i < txs.size(); i++){
+    auto [ok, s] = rpc.handle_get_tx_proof(unordered_map<string,string>({{"hash",hashToString(txs[i].hash())}}));
+    BOOST_REQUIRE(ok);
+    json::object o = json::parse(s).as_object();
+    BOOST_CHECK_EQUAL(value_to<size_t>(o.at("index")), i);
+    BOOST_CHECK_EQUAL(value_to<string>(o.at("blkHash")), hashToString(b.hash()));
+
+    // 🦜 : check it like a light client
+    vector<hash256> p;
+    for (auto & x : o.at("proof").as_array())
+      p.push_back(evmc::from_hex<hash256>(value_to<string>(x)).value());
+    hash256 r = evmc::from_hex<hash256>(value_to<string>(o.at("txRoot"))).value();
+    BOOST_CHECK(MerkleTree::verify(txs[i].hash(), i, txs.size(), p, r));
+    BOOST_CHECK(not MerkleTree::verify(txs[i].hash(), i, txs.size() + 1, p, r));
+
+    // 🐢 : only the Blk hash is trusted, n_txs and parentHash are checked by it
+    size_t n = value_to<size_t>(o.at("n_txs"));
+    hash256 ph = evmc::from_hex<hash256>(value_to<string>(o.at("parentHash"))).value();
+    BOOST_CHECK(Blk::verifyTx(txs[i].hash(), i, n, p, ph, b.hash()));
+    BOOST_CHECK(not Blk::verifyTx(txs[i].hash(), i, n + 1, p, ph, b.hash()));
+  }
+
+  auto [ok, s] = rpc.handle_get_tx_proof(unordered_map<string,string>({{"hash",string(32*2,'f')}}));
+  BOOST_CHECK(not ok);
+}
+
+BOOST_AUTO_TEST_CASE(test_export_blks){
+  mockedRpcNetworkable::A nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr,
+          dynamic_cast<IChainDBGettable*>(&wh), nullptr};
+
+  auto [b,txs] = prepare_ExecBlk();
+  const int N = 100;            // 🦜 : more than a page
+  for (int i = 0; i < N; i++)
+    BOOST_REQUIRE(wh.setInChainDB("/blk/" + lexical_cast<string>(i), b.toString()));
+  BOOST_REQUIRE(wh.setInChainDB("/other/blk_number",lexical_cast<string>(N - 1)));
+
+  int n_chunks;
+  string o;
+  auto w = [&](string_view c){ n_chunks++; o.append(c); return true;};
+  auto export_them = [&](unordered_map<string,string> q, bool pb = false){
+    n_chunks = 0; o.clear();
+    return std::get<0>(pb ? rpc.handle_export_blks_pb(q, w) : rpc.handle_export_blks(q, w));
+  };
+
+  // 1. ndjson, all of them
+  BOOST_REQUIRE(export_them({}));
+  BOOST_CHECK_EQUAL(n_chunks, (N + Rpc::EXPORT_PAGE - 1) / Rpc::EXPORT_PAGE);
+  vector<string> lines;
+  boost::split(lines, o, boost::is_any_of("\n"));
+  BOOST_REQUIRE_EQUAL(lines.size(), N + 1); // 🦜 : the last one is empty
+  BOOST_CHECK_EQUAL(json::value_to<ExecBlk>(json::parse(lines[0])).hash(), b.hash());
+
+  // 2. a range with limit
+  BOOST_REQUIRE(export_them({{"from","10"},{"to","20"},{"limit","5"}}));
+  BOOST_CHECK_EQUAL(std::count(o.begin(), o.end(), '\n'), 5);
+
+  // 3. pb: varint length + ExecBlk
+  BOOST_REQUIRE(export_them({{"from","98"}}, true));
+  google::protobuf::io::CodedInputStream in(reinterpret_cast<const uint8_t*>(o.data()), o.size());
+  int n = 0;
+  uint32_t sz;
+  while (in.ReadVarint32(&sz)){
+    string x;
+    BOOST_REQUIRE(in.ReadString(&x, sz));
+    ExecBlk b1;
+    BOOST_REQUIRE(b1.fromPbString(x));
+    BOOST_CHECK_EQUAL(b1.hash(), b.hash());
+    n++;
+  }
+  BOOST_CHECK_EQUAL(n, 2);
+
+  // 4. nothing to send
+  BOOST_REQUIRE(export_them({{"from","200"}}));
+  BOOST_CHECK(o.empty());
+
+  // bad cases
+  BOOST_CHECK(not export_them({{"from","abc"}}));
+  BOOST_CHECK(o.empty());       // 🦜 : said before anything is written (⇒ 400)
+  BOOST_CHECK(not std::get<0>(rpc.handle_export_blks({}, [](string_view){return false;}))); // client gone
+}
+
+BOOST_AUTO_TEST_CASE(test_pb_getters){
+  mockedRpcNetworkable::B nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr,
+          dynamic_cast<IChainDBGettable*>(&wh), nullptr};
+  for (string t : {"/get_latest_Blk_pb","/get_blk_pb","/get_receipt_pb","/get_tx_pb","/get_pool_status_pb"})
+    BOOST_CHECK(nh.getMap.contains(t));
+
+  auto [b,txs] = prepare_ExecBlk();   // 🦜 : this is Blk-1
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&wh), nullptr, nullptr};
+  BOOST_REQUIRE(exe.commitBlk(b));
+  BOOST_REQUIRE(wh.setInChainDB("/blk/0", b.toString())); // a fake Blk-0
+
+  // 1. Blks --------------------------------------------------
+  auto [ok, s] = rpc.handle_get_latest_Blk_pb(unordered_map<string,string>({{"n","5"}}));
+  BOOST_REQUIRE(ok);
+  hiPb::ExecBlks bs;
+  BOOST_REQUIRE(bs.ParseFromString(s));
+  BOOST_REQUIRE_EQUAL(bs.blks_size(), 2);
+  ExecBlk b1;
+  BOOST_REQUIRE(b1.fromPbString(bs.blks(0).SerializeAsString()));
+  BOOST_CHECK_EQUAL(b1.hash(), b.hash());
+
+  std::tie(ok, s) = rpc.handle_get_Blk_pb(unordered_map<string,string>({{"n","1"}}));
+  BOOST_REQUIRE(ok);
+  BOOST_REQUIRE(b1.fromPbString(s));
+  BOOST_CHECK_EQUAL(b1.hash(), b.hash());
+
+  std::tie(ok, s) = rpc.handle_get_Blk_pb({});  // the latest, in ExecBlks
+  BOOST_REQUIRE(ok);
+  BOOST_REQUIRE(bs.ParseFromString(s));
+  BOOST_CHECK_EQUAL(bs.blks_size(), 1);
+
+  // 2. receipt and tx --------------------------------------------------
+  string h = hashToString(txs[0].hash());
+  std::tie(ok, s) = rpc.handle_get_receipt_pb(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok);
+  TxReceipt r;
+  BOOST_REQUIRE(r.fromPbString(s));
+  BOOST_CHECK(r.ok);
+
+  std::tie(ok, s) = rpc.handle_get_tx_pb(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok);
+  Tx t;
+  BOOST_REQUIRE(t.fromPbString(s));
+  BOOST_CHECK_EQUAL(t.nonce, txs[0].nonce);
+
+  // bad cases
+  std::tie(ok, s) = rpc.handle_get_tx_pb(unordered_map<string,string>({{"hash",string(32*2,'f')}}));
+  BOOST_REQUIRE(not ok);
+  std::tie(ok, s) = rpc.handle_get_receipt_pb({});
+  BOOST_REQUIRE(not ok);
+  std::tie(ok, s) = rpc.handle_get_Blk_pb(unordered_map<string,string>({{"n","9"}}));
+  BOOST_REQUIRE(not ok);
+}
+
+BOOST_AUTO_TEST_CASE(test_batched_getters){
+  mockedRpcNetworkable::A nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr,
+          dynamic_cast<IChainDBGettable*>(&wh), nullptr};
+
+  auto [b,txs] = prepare_ExecBlk();
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&wh), nullptr, nullptr};
+  BOOST_REQUIRE(exe.commitBlk(b));
+
+  string h0 = hashToString(txs[0].hash()), h1 = hashToString(txs[1].hash());
+  string missing(32*2,'f');
+
+  // 1. json --------------------------------------------------
+  json::array a{h0, missing, h1, "bad-hash"};
+  auto [ok, s] = rpc.handle_get_receipts(json::serialize(a));
+  BOOST_REQUIRE(ok);
+  json::array r = json::parse(s).as_array();
+  BOOST_REQUIRE_EQUAL(r.size(), 4);
+  BOOST_CHECK(not r[0].is_null());
+  BOOST_CHECK(r[1].is_null());
+  BOOST_CHECK(not r[2].is_null());
+  BOOST_CHECK(r[3].is_null());
+  auto [ok0, s0] = rpc.handle_get_receipt(unordered_map<string,string>({{"hash",h0}}));
+  BOOST_REQUIRE(ok0);
+  BOOST_CHECK_EQUAL(json::serialize(r[0]), s0);
+
+  std::tie(ok, s) = rpc.handle_get_txs(json::serialize(a));
+  BOOST_REQUIRE(ok);
+  r = json::parse(s).as_array();
+  BOOST_REQUIRE_EQUAL(r.size(), 4);
+  BOOST_CHECK_EQUAL(json::value_to<string>(r[2].at("hash")), h1);
+  BOOST_CHECK(r[1].is_null());
+
+  std::tie(ok, s) = rpc.handle_get_blks("[1,0]");
+  BOOST_REQUIRE(ok);
+  r = json::parse(s).as_array();
+  BOOST_REQUIRE_EQUAL(r.size(), 2);
+  BOOST_CHECK_EQUAL(json::value_to<ExecBlk>(r[0]).hash(), b.hash());
+  BOOST_CHECK(r[1].is_null());
+
+  // 2. pb --------------------------------------------------
+  hiPb::TxHashes in;
+  in.add_hashes(weak::toByteString<hash256>(txs[0].hash()));
+  in.add_hashes(string(32,'\xff'));
+  std::tie(ok, s) = rpc.handle_get_receipts_pb(in.SerializeAsString());
+  BOOST_REQUIRE(ok);
+  hiPb::TxReceiptsReply rr;
+  BOOST_REQUIRE(rr.ParseFromString(s));
+  BOOST_REQUIRE_EQUAL(rr.receipts_size(), 2);
+  BOOST_CHECK(rr.receipts(0).has_receipt());
+  BOOST_CHECK(not rr.receipts(1).has_receipt());
+
+  std::tie(ok, s) = rpc.handle_get_txs_pb(in.SerializeAsString());
+  BOOST_REQUIRE(ok);
+  hiPb::TxsReply tr;
+  BOOST_REQUIRE(tr.ParseFromString(s));
+  BOOST_REQUIRE_EQUAL(tr.txs_size(), 2);
+  BOOST_CHECK(tr.txs(0).has_tx());
+
+  hiPb::BlkNumbers bn;
+  bn.add_numbers(1);
+  std::tie(ok, s) = rpc.handle_get_blks_pb(bn.SerializeAsString());
+  BOOST_REQUIRE(ok);
+  hiPb::ExecBlksReply br;
+  BOOST_REQUIRE(br.ParseFromString(s));
+  BOOST_REQUIRE_EQUAL(br.blks_size(), 1);
+  BOOST_CHECK(br.blks(0).has_blk());
+
+  // bad cases
+  std::tie(ok, s) = rpc.handle_get_receipts("not json");
+  BOOST_REQUIRE(not ok);
+  std::tie(ok, s) = rpc.handle_get_blks("[\"a\"]");
+  BOOST_REQUIRE(not ok);
+  json::array too_many(Rpc::MAX_BATCH + 1, json::value(h0));
+  std::tie(ok, s) = rpc.handle_get_txs(json::serialize(too_many));
+  BOOST_REQUIRE(not ok);
+  json::array too_many_blks(Rpc::MAX_BLK_BATCH + 1, json::value(0));
+  std::tie(ok, s) = rpc.handle_get_blks(json::serialize(too_many_blks));
+  BOOST_REQUIRE(not ok);
+  hiPb::BlkNumbers bn1;
+  for (size_t i = 0; i <= Rpc::MAX_BLK_BATCH; i++) bn1.add_numbers(0);
+  std::tie(ok, s) = rpc.handle_get_blks_pb(bn1.SerializeAsString());
+  BOOST_REQUIRE(not ok);
+
+  // 3. the long way, both Txs from the one Blk --------------------------------------------------
+  std::tie(ok, s) = rpc.handle_get_receipts(json::serialize(a));
+  BOOST_REQUIRE(ok);
+  std::erase_if(wh.chainDB, [](const auto & kv){
+    return kv.first.starts_with("/receipt/") or kv.first.starts_with("/txdata/");
+  });
+  auto [ok1, s1] = rpc.handle_get_receipts(json::serialize(a));
+  BOOST_REQUIRE(ok1);
+  BOOST_CHECK_EQUAL(s1, s);
+  json::array a1{h1, h0, h1};
+  std::tie(ok, s) = rpc.handle_get_txs(json::serialize(a1));
+  BOOST_REQUIRE(ok);
+  r = json::parse(s).as_array();
+  BOOST_REQUIRE_EQUAL(r.size(), 3);
+  BOOST_CHECK_EQUAL(json::value_to<string>(r[0].at("hash")), h1);
+  BOOST_CHECK_EQUAL(json::value_to<string>(r[1].at("hash")), h0);
+  BOOST_CHECK_EQUAL(json::serialize(r[2]), json::serialize(r[0]));
+}
+
+BOOST_AUTO_TEST_CASE(test_handle_subscribe_receipt_and_blks){
+  /*
+    🦜 : The subscriber waits in another thread, the BlkExecutor commits the
+    Blk, the feed should wake it up.
+  */
+  mockedRpcNetworkable::B nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  BlkFeed feed;
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh) /*the server*/
+          ,nullptr /*cnsss*/
+          ,dynamic_cast<IChainDBGettable*>(&wh) /*wrld*/
+          ,nullptr/*pool info*/
+          ,nullptr/*verifier*/
+          ,&feed};
+  BOOST_CHECK(nh.getMap.contains("/subscribe_blks"));
+  BOOST_CHECK(nh.getMap.contains("/subscribe_receipt"));
+
+  auto [b,txs] = prepare_ExecBlk();
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&wh),
+                  nullptr /*ITxExecutable*/,
+                  nullptr /*IAcnGettable*/};
+  exe.committedListeners.push_back(&feed);
+
+  // 1. nothing yet => pending
+  string h = hashToString(txs[0].hash());
+  auto [ok, s] = rpc.handle_subscribe_receipt(unordered_map<string,string>({{"hash",h},{"timeout","10"}}));
+  BOOST_REQUIRE(ok);
+  BOOST_CHECK_EQUAL(s, R"({"status":"pending"})");
+
+  // 2. wait while the Blk is committed
+  bool committed = false;
+  std::thread t{[&](){
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    committed = exe.commitBlk(b);
+  }};
+
+  std::tie(ok,s) = rpc.handle_subscribe_blks(unordered_map<string,string>({{"timeout","5000"}}));
+  BOOST_REQUIRE(ok);
+  BOOST_TEST_MESSAGE((format("GOT:%s") % s).str());
+  json::value v = json::parse(s);
+  BOOST_CHECK_EQUAL(v.at("latest").to_number<uint64_t>(), b.number);
+  BOOST_REQUIRE_EQUAL(v.at("blks").as_array().size(), 1);
+  BOOST_CHECK_EQUAL(v.at("blks").as_array()[0].at("tx_hashes").as_array().size(), txs.size());
+  t.join();
+  BOOST_REQUIRE(committed);
+
+  // 3. now it's there (from the feed or from the chain, same thing)
+  std::tie(ok,s) = rpc.handle_subscribe_receipt(unordered_map<string,string>({{"hash",h}}));
+  BOOST_REQUIRE(ok);
+  v = json::parse(s);
+  BOOST_CHECK_EQUAL(v.at("status").as_string(), "committed");
+  TxReceipt tr;
+  BOOST_REQUIRE(tr.fromJsonString(json::serialize(v.at("receipt"))));
+
+  // 4. caught up => times out with no Blks
+  std::tie(ok,s) = rpc.handle_subscribe_blks(unordered_map<string,string>({{"after",std::to_string(b.number)},{"timeout","10"}}));
+  BOOST_REQUIRE(ok);
+  BOOST_CHECK(json::parse(s).at("blks").as_array().empty());
+
+  // bad cases
+  std::tie(ok,s) = rpc.handle_subscribe_receipt({});
+  BOOST_REQUIRE(not ok);
+  std::tie(ok,s) = rpc.handle_subscribe_receipt(unordered_map<string,string>({{"hash","invalidHash"}}));
+  BOOST_REQUIRE(not ok);
+  std::tie(ok,s) = rpc.handle_subscribe_blks(unordered_map<string,string>({{"after","abc"}}));
+  BOOST_REQUIRE(not ok);
+}
+
+BOOST_AUTO_TEST_CASE(test_subscribe_parked){
+  /*
+    <2024-07-29 Mon> 🦜 : With a server that can park, the subscribers wait in
+    the BlkFeed without a thread, and are replied when the Blk is committed.
+  */
+  mockedRpcNetworkable::C nh;   // network host
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  BlkFeed feed;
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh) /*the server*/
+          ,nullptr /*cnsss*/
+          ,dynamic_cast<IChainDBGettable*>(&wh) /*wrld*/
+          ,nullptr/*pool info*/
+          ,nullptr/*verifier*/
+          ,&feed};
+  BOOST_CHECK(nh.deferredMap.contains("/subscribe_blks"));
+  BOOST_CHECK(nh.deferredMap.contains("/subscribe_receipt"));
+  BOOST_CHECK(not nh.getMap.contains("/subscribe_blks"));
+
+  auto [b,txs] = prepare_ExecBlk();
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&wh),
+                  nullptr /*ITxExecutable*/,
+                  nullptr /*IAcnGettable*/};
+  exe.committedListeners.push_back(&feed);
+
+  // 1. timed out => pending, and the waiter is gone
+  string h = hashToString(txs[0].hash());
+  auto [ok, s] = ::pure::WeakHttpServerBase::BlockingReply::run([&](shared_ptr<::pure::IDeferredReply> r){
+    rpc.handle_subscribe_receipt_deferred(unordered_map<string,string>({{"hash",h},{"timeout","10"}}), r);
+  });
+  BOOST_REQUIRE(ok);
+  BOOST_CHECK_EQUAL(s, R"({"status":"pending"})");
+  BOOST_CHECK_EQUAL(feed.n_waiting(), 0);
+
+  // 2. parked, the hash is given as 0x + upper case
+  string H = boost::algorithm::to_upper_copy(h);
+  auto rb = std::make_shared<KeptReply>();
+  auto rr = std::make_shared<KeptReply>();
+  rpc.handle_subscribe_blks_deferred({}, rb);
+  rpc.handle_subscribe_receipt_deferred(unordered_map<string,string>({{"hash","0x" + H}}), rr);
+  BOOST_CHECK_EQUAL(feed.n_waiting(), 2);
+  BOOST_CHECK(not rb->r);
+
+  BOOST_REQUIRE(exe.commitBlk(b));
+  BOOST_CHECK_EQUAL(feed.n_waiting(), 0);
+  BOOST_REQUIRE(rb->r);
+  json::value v = json::parse(std::get<1>(rb->r.value()));
+  BOOST_CHECK_EQUAL(v.at("latest").to_number<uint64_t>(), b.number);
+  BOOST_REQUIRE_EQUAL(v.at("blks").as_array().size(), 1);
+  BOOST_REQUIRE(rr->r);
+  BOOST_CHECK_EQUAL(json::parse(std::get<1>(rr->r.value())).at("status").as_string(), "committed");
+
+  // 3. the same Tx again: on the chain, replied right away
+  auto r3 = std::make_shared<KeptReply>();
+  rpc.handle_subscribe_receipt_deferred(unordered_map<string,string>({{"hash","0x" + H}}), r3);
+  BOOST_REQUIRE(r3->r);
+  BOOST_CHECK_EQUAL(json::parse(std::get<1>(r3->r.value())).at("status").as_string(), "committed");
+
+  // 4. too many waiters
+  BlkFeed small{{}, 64, 1};
+  BOOST_CHECK(small.park_for_blks({}, [](optional<string>){}));
+  BOOST_CHECK(not small.park_for_blks({}, [](optional<string>){}));
+}
+
 BOOST_AUTO_TEST_CASE(test_get_latest_blk){
   /*
     🦜 : Oh, what do we need to test the `get_latest_blk`?
@@ -546,6 +994,46 @@ BOOST_AUTO_TEST_CASE(test_get_latest_blk){
   BOOST_REQUIRE(not ok);
 }
 
+BOOST_AUTO_TEST_CASE(test_get_latest_blk_with_cache){
+  mockedAcnPrv::F2 wh;           // the in-RAM rocksDB
+  auto [b,txs] = prepare_ExecBlk();
+  string bs = b.toString();
+  for (int i = 0; i < 3; i++)
+    BOOST_REQUIRE(wh.setInChainDB("/blk/" + lexical_cast<string>(i), bs));
+  BOOST_REQUIRE(wh.setInChainDB("/other/blk_number",lexical_cast<string>(2)));
+  IChainDBGettable * w = dynamic_cast<IChainDBGettable*>(&wh);
+
+  BlkCache c;
+  auto [ok0, s0] = Rpc::get_latest_Blk(w,3);
+  auto [ok1, s1] = Rpc::get_latest_Blk(w,3,&c); // fills the cache
+  BOOST_REQUIRE(ok0 and ok1);
+  BOOST_CHECK_EQUAL(s0, s1);
+  BOOST_CHECK_EQUAL(c.size(), 3);
+  BOOST_CHECK_EQUAL(c.n_miss.load(), 3);
+
+  // 🦜 : Now the chainDB is not even touched
+  wh.chainDB.erase("/blk/1");
+  auto [ok2, s2] = Rpc::get_latest_Blk(w,3,&c);
+  BOOST_REQUIRE(ok2);
+  BOOST_CHECK_EQUAL(s0, s2);
+  BOOST_CHECK_EQUAL(c.n_hit.load(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_blk_cache_bounded){
+  BlkCache c{10};               // 10 bytes
+  c.put(0, "aaaa");
+  c.put(1, "bbbb");
+  BOOST_CHECK(c.get(0));        // 🦜 : now 1 is the least recently used
+  c.put(2, "cccc");
+  BOOST_CHECK(c.get(0));
+  BOOST_CHECK(not c.get(1));
+  BOOST_CHECK(c.get(2));
+  BOOST_CHECK_EQUAL(c.size_in_bytes(), 8);
+
+  c.put(3, string(11,'d'));     // 🦜 : too big
+  BOOST_CHECK(not c.get(3));
+}
+
 BOOST_AUTO_TEST_CASE(test_handle_get_latest_Blk){
   /* 🦜 : Okay here, we test handle_get_latest_Blk. This essentially parse te
      "n" in query_param. The preparation should be similar*/
@@ -628,3 +1116,147 @@ BOOST_AUTO_TEST_CASE(test_handle_get_latest_Blk){
 BOOST_AUTO_TEST_SUITE_END();
 
 
+
+namespace mockedRpcCallable{
+  // 🦜 : records the last call and returns a fixed result
+  class A : public virtual IForRpcCallable{
+  public:
+    address from, to;
+    bytes data;
+    optional<int64_t> gas;
+    optional<uint64_t> n;
+    bool busy = false;
+    tuple<bool,string> callForRpc(const address & f, const address & t, bytes d,
+                                  optional<int64_t> g, optional<uint64_t> nn) noexcept override{
+      if (busy) return make_tuple(false, "busy");
+      from = f; to = t; data = d; gas = g; n = nn;
+      return make_tuple(true, R"({"ok":true})");
+    }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(test_rpc_call);
+BOOST_AUTO_TEST_CASE(test_handle_call){
+  mockedRpcNetworkable::B nh;
+  mockedRpcCallable::A ch;
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr, nullptr, nullptr, nullptr,
+          nullptr, nullptr, dynamic_cast<IForRpcCallable*>(&ch)};
+  BOOST_REQUIRE(nh.postMap.contains("/call"));
+
+  auto [ok, s] = rpc.handle_call(R"({"from":"02","to":"01","data":"6d4ce63c","gas":1000})");
+  BOOST_REQUIRE(ok);
+  BOOST_CHECK_EQUAL(s, R"({"ok":true})");
+  BOOST_CHECK_EQUAL(ch.from, makeAddress(2));
+  BOOST_CHECK_EQUAL(ch.to, makeAddress(1));
+  BOOST_CHECK(ch.data == evmc::from_hex("6d4ce63c").value());
+  BOOST_CHECK_EQUAL(ch.gas.value(), 1000);
+  BOOST_CHECK(not ch.n);
+
+  std::tie(ok, std::ignore) = rpc.handle_call(R"({"to":"01","n":3})");
+  BOOST_REQUIRE(ok);
+  BOOST_CHECK_EQUAL(ch.n.value(), 3);
+
+  // bad inputs
+  for (string_view d : {"not json", R"({"data":"00"})", R"({"to":"00"})",
+                        R"({"to":"01","data":"xyz"})", R"({"to":"01","gas":-1})"}){
+    std::tie(ok, std::ignore) = rpc.handle_call(d);
+    BOOST_CHECK(not ok);
+  }
+
+  // busy
+  ch.busy = true;
+  std::tie(ok, std::ignore) = rpc.handle_call(R"({"to":"01"})");
+  BOOST_CHECK(not ok);
+}
+
+BOOST_AUTO_TEST_CASE(test_handle_call_deferred){
+  // <2024-07-29 Mon> 🦜 : With a server that can park, `/call` is replied by the IForRpcCallable
+  mockedRpcNetworkable::C nh;
+  mockedRpcCallable::A ch;
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr, nullptr, nullptr, nullptr,
+          nullptr, nullptr, dynamic_cast<IForRpcCallable*>(&ch)};
+  BOOST_REQUIRE(nh.deferredPostMap.contains("/call"));
+  BOOST_CHECK(not nh.postMap.contains("/call"));
+
+  auto r = std::make_shared<KeptReply>();
+  rpc.handle_call_deferred(R"({"to":"01","data":"6d4ce63c"})", r);
+  BOOST_REQUIRE(r->r);
+  BOOST_CHECK(std::get<0>(r->r.value()));
+  BOOST_CHECK_EQUAL(std::get<1>(r->r.value()), R"({"ok":true})");
+  BOOST_CHECK(ch.data == evmc::from_hex("6d4ce63c").value());
+
+  r = std::make_shared<KeptReply>();
+  rpc.handle_call_deferred("not json", r);
+  BOOST_REQUIRE(r->r);
+  BOOST_CHECK(not std::get<0>(r->r.value()));
+}
+BOOST_AUTO_TEST_SUITE_END();
+
+namespace mockedAcnsAt{
+  // 🦜 : Only knows the state as of Blk 1 (which is also the latest)
+  class A : public virtual IAcnGettableAt{
+  public:
+    shared_ptr<mockedAcnPrv::E> w = make_shared<mockedAcnPrv::E>();
+    shared_ptr<IAcnGettable> acnsAt(optional<uint64_t> n = {}) noexcept override{
+      if (n and n.value() != 1) return nullptr;
+      return w;
+    }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(test_rpc_acn);
+BOOST_AUTO_TEST_CASE(test_get_acn_and_storage){
+  mockedRpcNetworkable::B nh;
+  mockedAcnsAt::A ah;
+  Rpc rpc{dynamic_cast<IForRpcNetworkable*>(&nh), nullptr, nullptr, nullptr, nullptr,
+          nullptr, nullptr, nullptr, dynamic_cast<IAcnGettableAt*>(&ah)};
+  BOOST_REQUIRE(nh.getMap.contains("/get_acn"));
+  BOOST_REQUIRE(nh.getMap.contains("/get_storage"));
+
+  Acn acn{7, evmc::from_hex("00112233").value()};
+  for (int i = 0; i < 5; i++)
+    acn.storage[bytes32(static_cast<uint64_t>(i))] = bytes32(static_cast<uint64_t>(100 + i));
+  string a = addressToString(makeAddress(1));
+  ah.w->accounts[a] = acn;
+
+  // 1. /get_acn --------------------------------------------------
+  auto [ok, s] = rpc.handle_get_acn(unordered_map<string,string>({{"addr", a}}));
+  BOOST_REQUIRE(ok);
+  json::object o = json::parse(s).as_object();
+  BOOST_CHECK_EQUAL(o.at("nonce").as_uint64(), 7);
+  BOOST_CHECK_EQUAL(o.at("code_size").as_uint64(), 4);
+  BOOST_CHECK_EQUAL(o.at("storage_size").as_uint64(), 5);
+  BOOST_CHECK_EQUAL(json::value_to<string>(o.at("codehash")), hashToString(acn.codehash()));
+  BOOST_CHECK(not o.contains("code"));
+
+  std::tie(ok, std::ignore) = rpc.handle_get_acn(unordered_map<string,string>({{"addr", a}, {"n", "1"}}));
+  BOOST_CHECK(ok);
+  std::tie(ok, std::ignore) = rpc.handle_get_acn(unordered_map<string,string>({{"addr", a}, {"n", "2"}}));
+  BOOST_CHECK(not ok);        // 🦜 : state not kept
+  std::tie(ok, std::ignore) = rpc.handle_get_acn(unordered_map<string,string>({{"addr", addressToString(makeAddress(2))}}));
+  BOOST_CHECK(not ok);        // 🦜 : no such Acn
+  std::tie(ok, std::ignore) = rpc.handle_get_acn({});
+  BOOST_CHECK(not ok);
+
+  // 2. /get_storage, in pages of 2 --------------------------------------------------
+  vector<bytes32> got;
+  optional<string> from;
+  for (int p = 0; p < 10; p++){
+    unordered_map<string,string> q{{"addr", a}, {"limit", "2"}};
+    if (from) q["from"] = from.value();
+    std::tie(ok, s) = rpc.handle_get_storage(q);
+    BOOST_REQUIRE(ok);
+    o = json::parse(s).as_object();
+    json::array sl = o.at("slots").as_array();
+    BOOST_CHECK(sl.size() <= 2);
+    for (auto & x : sl){
+      got.push_back(evmc::from_hex<bytes32>(json::value_to<string>(x.at("v"))).value());
+    }
+    if (o.at("next").is_null()) break;
+    from = json::value_to<string>(o.at("next"));
+  }
+  BOOST_REQUIRE_EQUAL(got.size(), 5);
+  for (int i = 0; i < 5; i++)
+    BOOST_CHECK(got[i] == bytes32(static_cast<uint64_t>(100 + i)));
+}
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,117 @@
+#include "h.hpp"
+
+#include "core0.hpp"
+#include <chrono>
+#include <random>
+
+using namespace weak;
+
+bytes random_bytes(size_t n, std::mt19937 & g){
+  bytes b(n, uint8_t{0});
+  for (uint8_t & x : b) x = static_cast<uint8_t>(g());
+  return b;
+}
+
+/// All the implementations this CPU can run.
+vector<hex::Impl> impls(){
+  vector<hex::Impl> o{{"scalar", hex::scalar::encode, hex::scalar::decode}};
+#if defined(WEAK_HEX_X86)
+  if (__builtin_cpu_supports("ssse3")) o.push_back({"ssse3", hex::ssse3::encode, hex::ssse3::decode});
+  if (__builtin_cpu_supports("avx2")) o.push_back({"avx2", hex::avx2::encode, hex::avx2::decode});
+#endif
+  return o;
+}
+
+BOOST_AUTO_TEST_SUITE(test_simdHex);
+
+BOOST_AUTO_TEST_CASE(test_same_as_evmc){
+  std::mt19937 g{1};
+  BOOST_TEST_MESSAGE((format("🐸 hex impl: %s") % hex::impl().name).str());
+  // 🦜 : every length up to a few blocks, so that all the tails are hit
+  for (size_t n = 0; n < 100; n++){
+    bytes b = random_bytes(n, g);
+    string s = evmc::hex(b);
+    string S = s;
+    for (char & c : S) if (g() % 2) c = static_cast<char>(std::toupper(c));
+
+    for (const hex::Impl & i : impls()){
+      string o(2 * n, '\0');
+      i.encode(b.data(), n, o.data());
+      BOOST_CHECK_EQUAL(o, s);
+      bytes b1(n, uint8_t{0});
+      BOOST_CHECK(i.decode(S.data(), n, b1.data()));
+      BOOST_CHECK(b1 == b);
+    }
+
+    BOOST_CHECK_EQUAL(hex::encode(b), s);
+    BOOST_CHECK(hex::decode(S) == evmc::from_hex(S));
+    BOOST_CHECK(hex::decode("0x" + S) == evmc::from_hex("0x" + S));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_bad_chars){
+  std::mt19937 g{2};
+  for (char c : {'g', 'G', '/', ':', '@', '`', ' ', '\x80', '\0'})
+    for (size_t n : {1, 15, 16, 17, 31, 32, 33, 70}){
+      string s = evmc::hex(random_bytes(n, g));
+      s[g() % s.size()] = c;
+      for (const hex::Impl & i : impls()){
+        bytes b(n, uint8_t{0});
+        BOOST_CHECK(not i.decode(s.data(), n, b.data()));
+      }
+      BOOST_CHECK(not hex::decode(s));
+    }
+  BOOST_CHECK(not hex::decode("abc"));      // odd
+  BOOST_CHECK(hex::decode("0x").value().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_decode_fixed){
+  // 🦜 : short ones are padded on the left, like evmc::from_hex<T>()
+  for (const string & s : vector<string>{"", "0x", "01", "0x0102", string(40, 'a'), string(42, 'a'), "abc"}){
+    optional<address> a = hex::decode<address>(s), b = evmc::from_hex<address>(s);
+    BOOST_REQUIRE_EQUAL(bool(a), bool(b));
+    if (a) BOOST_CHECK(a.value() == b.value());
+  }
+  hash256 h = ethash::keccak256(reinterpret_cast<const uint8_t*>("hi"), 2);
+  BOOST_CHECK(hex::decode<hash256>(hashToString(h)).value() == h);
+}
+
+/*
+  🦜 : What the JSON paths do: a lot of hashes and addresses, and some big
+  calldata. Nothing is checked, it just prints the numbers.
+ */
+BOOST_AUTO_TEST_CASE(bench_hex){
+  using namespace std::chrono;
+  std::mt19937 g{3};
+  auto mbps = [](size_t n, auto f){
+    auto start = steady_clock::now();
+    f();
+    return n / 1e6 / duration<double>(steady_clock::now() - start).count();
+  };
+
+  vector<bytes> hashes;
+  for (int i = 0; i < 100'000; i++) hashes.push_back(random_bytes(32, g));
+  bytes big = random_bytes(size_t{1} << 20, g);
+  string big_s = evmc::hex(big);
+
+  size_t sink = 0;
+  auto line = [&](const char * what, size_t n, auto f_evmc, auto f_simd){
+    double a = mbps(n, f_evmc), b = mbps(n, f_simd);
+    BOOST_TEST_MESSAGE((format("\t%-24s evmc %8.1f MB/s, %s %8.1f MB/s (%.1fx)")
+                        % what % a % hex::impl().name % b % (b / a)).str());
+  };
+
+  BOOST_TEST_MESSAGE("📦 hex:");
+  line("encode 100k hashes", 32 * hashes.size(),
+       [&]{ for (const bytes & h : hashes) sink += evmc::hex(h).size(); },
+       [&]{ for (const bytes & h : hashes) sink += hex::encode(h).size(); });
+  line("encode 1 MB", 10 * big.size(),
+       [&]{ for (int i = 0; i < 10; i++) sink += evmc::hex(big).size(); },
+       [&]{ for (int i = 0; i < 10; i++) sink += hex::encode(big).size(); });
+  line("decode 1 MB", 10 * big.size(),
+       [&]{ for (int i = 0; i < 10; i++) sink += evmc::from_hex(big_s).value().size(); },
+       [&]{ for (int i = 0; i < 10; i++) sink += hex::decode(big_s).value().size(); });
+  BOOST_CHECK(sink > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,264 @@
+#include "h.hpp"
+
+#include "stateCommit.hpp"
+#include "stateRoot.hpp"
+#include "execManager.hpp"
+#include "storageManager.hpp"
+
+#include <rocksdb/file_system.h>
+#include <rocksdb/env.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace weak;
+
+struct TmpDir{
+  filesystem::path p{filesystem::temp_directory_path() / "test-stateCommit"};
+  TmpDir(){ filesystem::remove_all(p); }
+  ~TmpDir(){ filesystem::remove_all(p); }
+};
+
+/**
+ * @brief The n-th Blk: three Txs, each sets an Acn to nonce `n`, and every
+ * few Blks one Acn is deleted.
+ */
+ExecBlk blk_of(uint64_t n){
+  vector<Tx> txs;
+  vector<vector<StateChange>> J;
+  vector<TxReceipt> R;
+  for (uint64_t i = 0; i < 3; i++){
+    txs.push_back(Tx{makeAddress(1000), makeAddress(1001), bytes{}, n * 3 + i /*nonce*/});
+    Acn a{n, bytes{}};
+    a.storage[bytes32{i}] = bytes32{n};
+    J.push_back({StateChange{false, addressToString(makeAddress(static_cast<int>((n * 3 + i) % 13))), a.toString()}});
+    R.push_back(TxReceipt(true));
+  }
+  if (n % 4 == 3)
+    J.back().push_back(StateChange{true, addressToString(makeAddress(static_cast<int>(n % 13))), ""});
+  return ExecBlk{Blk{n, hash256{}, txs}, J, R};
+}
+
+/// What the state is, compared by the leaf hashes of StateRoot.
+map<string,string> dump(const IAcnIterable & w){
+  map<string,string> m;
+  w.forEachAcn([&](const string & k, const Acn & a){
+    m[k] = hashToString(StateRoot::leafHash(k, a));
+  });
+  return m;
+}
+
+map<string,string> expected_after(uint64_t n){
+  InRamWorldStorage r;
+  for (uint64_t i = 0; i < n; i++)
+    r.applyJournalsStateDB(blk_of(i).stateChanges);
+  return dump(r);
+}
+
+StorageProfile without_wal(){
+  StorageProfile p;
+  p.state_wal = false;
+  return p;
+}
+
+/*
+  <2024-07-28 Sun> 🦜 : A file system that keeps what's written to a file in
+  RAM until it's synced (or closed). So an _exit() loses the unsynced tail,
+  like a power cut does. (A plain _exit() doesn't: the page cache survives
+  it.)
+ */
+class UnsyncedFile: public rocksdb::FSWritableFileOwnerWrapper{
+  string buf;
+  rocksdb::IOStatus drain(const rocksdb::IOOptions & o, rocksdb::IODebugContext * d){
+    if (buf.empty()) return rocksdb::IOStatus::OK();
+    rocksdb::IOStatus s = this->target()->Append(buf, o, d);
+    buf.clear();
+    return s;
+  }
+public:
+  using rocksdb::FSWritableFileOwnerWrapper::FSWritableFileOwnerWrapper;
+  rocksdb::IOStatus Append(const rocksdb::Slice & x, const rocksdb::IOOptions &,
+                           rocksdb::IODebugContext *) override{
+    buf.append(x.data(), x.size());
+    return rocksdb::IOStatus::OK();
+  }
+  rocksdb::IOStatus Append(const rocksdb::Slice & x, const rocksdb::IOOptions & o,
+                           const rocksdb::DataVerificationInfo &, rocksdb::IODebugContext * d) override{
+    return this->Append(x, o, d);
+  }
+  rocksdb::IOStatus Flush(const rocksdb::IOOptions &, rocksdb::IODebugContext *) override{
+    return rocksdb::IOStatus::OK(); // 🦜 : still not on the disk
+  }
+  rocksdb::IOStatus RangeSync(uint64_t, uint64_t, const rocksdb::IOOptions &,
+                              rocksdb::IODebugContext *) override{
+    return rocksdb::IOStatus::OK(); // 🦜 : just a hint
+  }
+  rocksdb::IOStatus Sync(const rocksdb::IOOptions & o, rocksdb::IODebugContext * d) override{
+    rocksdb::IOStatus s = this->drain(o, d);
+    return s.ok() ? this->target()->Sync(o, d) : s;
+  }
+  rocksdb::IOStatus Fsync(const rocksdb::IOOptions & o, rocksdb::IODebugContext * d) override{
+    rocksdb::IOStatus s = this->drain(o, d);
+    return s.ok() ? this->target()->Fsync(o, d) : s;
+  }
+  rocksdb::IOStatus Truncate(uint64_t n, const rocksdb::IOOptions & o, rocksdb::IODebugContext * d) override{
+    rocksdb::IOStatus s = this->drain(o, d);
+    return s.ok() ? this->target()->Truncate(n, o, d) : s;
+  }
+  rocksdb::IOStatus Close(const rocksdb::IOOptions & o, rocksdb::IODebugContext * d) override{
+    rocksdb::IOStatus s = this->drain(o, d);
+    return s.ok() ? this->target()->Close(o, d) : s;
+  }
+  uint64_t GetFileSize(const rocksdb::IOOptions & o, rocksdb::IODebugContext * d) override{
+    return this->target()->GetFileSize(o, d) + buf.size();
+  }
+};
+
+class LoseUnsyncedFS: public rocksdb::FileSystemWrapper{
+public:
+  using rocksdb::FileSystemWrapper::FileSystemWrapper;
+  const char * Name() const override {return "LoseUnsyncedFS";}
+  rocksdb::IOStatus NewWritableFile(const std::string & f, const rocksdb::FileOptions & o,
+                                    std::unique_ptr<rocksdb::FSWritableFile> * r,
+                                    rocksdb::IODebugContext * d) override{
+    std::unique_ptr<rocksdb::FSWritableFile> t;
+    rocksdb::IOStatus s = this->target()->NewWritableFile(f, o, &t, d);
+    if (s.ok()) r->reset(new UnsyncedFile(std::move(t)));
+    return s;
+  }
+  rocksdb::IOStatus ReopenWritableFile(const std::string & f, const rocksdb::FileOptions & o,
+                                       std::unique_ptr<rocksdb::FSWritableFile> * r,
+                                       rocksdb::IODebugContext * d) override{
+    std::unique_ptr<rocksdb::FSWritableFile> t;
+    rocksdb::IOStatus s = this->target()->ReopenWritableFile(f, o, &t, d);
+    if (s.ok()) r->reset(new UnsyncedFile(std::move(t)));
+    return s;
+  }
+};
+
+/**
+ * @brief Commit Blk-0 ... Blk-(n-1) in a child process (group commit every
+ * `k`) and kill it without closing anything.
+ */
+void commit_then_crash(const filesystem::path & p, uint64_t n, uint64_t k){
+  pid_t pid = fork();
+  BOOST_REQUIRE(pid >= 0);
+  if (pid == 0){
+    // 🦜 : the child, nothing from Boost.Test here
+    auto * w = new WorldStorage{p, false, 16, without_wal()};
+    BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(w), nullptr, nullptr};
+    StateGroupCommitter g{w, k};
+    exe.committedListeners.push_back(&g);
+    for (uint64_t i = 0; i < n; i++)
+      if (not exe.commitBlk(blk_of(i))) _exit(1);
+    _exit(0);                   // 💥 : no dtor, the memtables are gone
+  }
+  int status;
+  BOOST_REQUIRE(waitpid(pid, &status, 0) == pid);
+  BOOST_REQUIRE(WIFEXITED(status));
+  BOOST_REQUIRE_EQUAL(WEXITSTATUS(status), 0);
+}
+
+/**
+ * @brief Like commit_then_crash(), but the unsynced writes are lost too, and
+ * the stateDB flushes on its own (as when a memtable is full) after Blk-(m-1).
+ */
+void commit_then_lose_power(const filesystem::path & p, uint64_t n, uint64_t m){
+  pid_t pid = fork();
+  BOOST_REQUIRE(pid >= 0);
+  if (pid == 0){
+    std::unique_ptr<rocksdb::Env> env =
+      rocksdb::NewCompositeEnv(std::make_shared<LoseUnsyncedFS>(rocksdb::FileSystem::Default()));
+    StorageProfile f = without_wal();
+    f.env = env.get();
+    auto * w = new WorldStorage{p, false, 16, f};
+    BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(w), nullptr, nullptr};
+    StateGroupCommitter g{w, 1'000 /*no mark in this test*/};
+    exe.committedListeners.push_back(&g);
+    for (uint64_t i = 0; i < n; i++){
+      if (not exe.commitBlk(blk_of(i))) _exit(1);
+      if (i + 1 == m and not w->stateDB->Flush(rocksdb::FlushOptions()).ok()) _exit(2);
+    }
+    _exit(0);                   // 💥 : the memtables and the unsynced tail are gone
+  }
+  int status;
+  BOOST_REQUIRE(waitpid(pid, &status, 0) == pid);
+  BOOST_REQUIRE(WIFEXITED(status));
+  BOOST_REQUIRE_EQUAL(WEXITSTATUS(status), 0);
+}
+
+BOOST_AUTO_TEST_SUITE(test_stateCommit);
+
+BOOST_FIXTURE_TEST_CASE(test_state_never_ahead_of_chain, TmpDir){
+  /*
+    🦜 : The stateDB has Blk-0..5 on disk after the flush. Then the chain
+    must have them too, even if its unsynced writes are lost.
+   */
+  const uint64_t n = 9, m = 6;
+  commit_then_lose_power(p, n, m);
+
+  WorldStorage w{p, false, 16, without_wal()};
+  optional<string> s = w.getFromChainDB("/other/blk_number");
+  BOOST_REQUIRE(s);
+  uint64_t l = boost::lexical_cast<uint64_t>(s.value());
+  BOOST_CHECK_GE(l + 1, m);
+  BOOST_CHECK_LE(l + 1, n);
+
+  StateGroupCommitter::replay(&w, &w, true);
+  BOOST_CHECK(dump(w) == expected_after(l + 1));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_fresh_mark, TmpDir){
+  {
+    WorldStorage w{p, false, 16, without_wal()};
+    BOOST_CHECK_EQUAL(w.stateReplayFrom().value(), 0);
+  }
+  // 🦜 : with the WAL, a replay removes the mark
+  WorldStorage w{p};
+  BOOST_CHECK_EQUAL(StateGroupCommitter::replay(&w, &w, false), 0);
+  BOOST_CHECK(not w.stateReplayFrom());
+  BOOST_CHECK_EQUAL(StateGroupCommitter::replay(&w, &w, false), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_crash_then_replay, TmpDir){
+  const uint64_t k = 4;
+  for (uint64_t n : {1, 3, 4, 5, 9, 12, 14}){
+    BOOST_TEST_MESSAGE((format("💥 crash after %d Blks") % n).str());
+    filesystem::remove_all(p);
+    commit_then_crash(p, n, k);
+
+    WorldStorage w{p, false, 16, without_wal()};
+    BOOST_CHECK_EQUAL(w.stateReplayFrom().value(), n / k * k);
+
+    // 1. the Blks after the mark are lost...
+    if (n % k)
+      BOOST_CHECK(dump(w) != expected_after(n));
+
+    // 2. ...but they're replayed from the chain
+    BOOST_CHECK_EQUAL(StateGroupCommitter::replay(&w, &w, true), n - n / k * k);
+    BOOST_CHECK(dump(w) == expected_after(n));
+    BOOST_CHECK_EQUAL(w.stateReplayFrom().value(), n);
+
+    // 3. and we can go on
+    BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+    StateGroupCommitter g{&w, k};
+    exe.committedListeners.push_back(&g);
+    for (uint64_t i = n; i < n + 3; i++)
+      BOOST_REQUIRE(exe.commitBlk(blk_of(i)));
+    BOOST_CHECK(dump(w) == expected_after(n + 3));
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_clean_close_needs_no_replay, TmpDir){
+  {
+    WorldStorage w{p, false, 16, without_wal()};
+    BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+    for (uint64_t i = 0; i < 6; i++)
+      BOOST_REQUIRE(exe.commitBlk(blk_of(i)));
+  }
+  WorldStorage w{p, false, 16, without_wal()};
+  BOOST_CHECK_EQUAL(w.stateReplayFrom().value(), 6);
+  BOOST_CHECK_EQUAL(StateGroupCommitter::replay(&w, &w, true), 0);
+  BOOST_CHECK(dump(w) == expected_after(6));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
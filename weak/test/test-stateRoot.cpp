@@ -0,0 +1,114 @@
+#include "h.hpp"
+
+#include "stateRoot.hpp"
+#include "execManager.hpp"
+#include "storageManager.hpp"
+#include <chrono>
+
+using namespace weak;
+
+/**
+ * @brief The journal that sets the Acn at `makeAddress(i)`, with nonce `n`.
+ */
+vector<StateChange> set_acn(int i, uint64_t n){
+  Acn a{n, bytes{}};
+  a.storage[bytes32{1}] = bytes32{n};
+  return {StateChange{false, addressToString(makeAddress(i)), a.toString()}};
+}
+
+vector<StateChange> del_acn(int i){
+  return {StateChange{true, addressToString(makeAddress(i)), ""}};
+}
+
+BOOST_AUTO_TEST_SUITE(test_stateRoot);
+
+BOOST_AUTO_TEST_CASE(test_empty_and_back){
+  StateRoot r{1, 4};
+  hash256 z = r.root();
+  BOOST_CHECK_EQUAL(hashToString(z), hashToString(hash256{}));
+
+  hash256 h = r.updateStateRoot({set_acn(1, 1)});
+  BOOST_CHECK_NE(hashToString(h), hashToString(z));
+  BOOST_CHECK_NE(hashToString(r.updateStateRoot({set_acn(1, 2)})), hashToString(h));
+
+  // 🦜 : deleting it brings us back to the empty state
+  BOOST_CHECK_EQUAL(hashToString(r.updateStateRoot({del_acn(1)})), hashToString(z));
+}
+
+BOOST_AUTO_TEST_CASE(test_incremental_is_rebuild){
+  InRamWorldStorage w;
+  StateRoot r{2, 6};
+
+  for (uint64_t b = 1; b <= 5; b++){
+    vector<vector<StateChange>> J;
+    for (int i = 1; i <= 20; i++)
+      J.push_back(set_acn(i * b % 37, b));
+    J.push_back(del_acn(b));
+    for (auto & j : J) w.applyJournalStateDB(j);
+    r.updateStateRoot(J);
+  }
+
+  StateRoot r1{2, 6};
+  r1.rebuild(dynamic_cast<IAcnIterable*>(&w));
+  BOOST_CHECK_EQUAL(hashToString(r.root()), hashToString(r1.root()));
+}
+
+BOOST_AUTO_TEST_CASE(test_last_change_wins){
+  StateRoot r{1, 4}, r1{1, 4};
+  r.updateStateRoot({set_acn(1, 1), set_acn(1, 5)});
+  r1.updateStateRoot({set_acn(1, 5)});
+  BOOST_CHECK_EQUAL(hashToString(r.root()), hashToString(r1.root()));
+}
+
+BOOST_AUTO_TEST_CASE(test_leaf_ignores_code_ref){
+  // 🦜 : the code inline or only its hash, it's the same Acn
+  Acn a{1, bytes(size_t{100}, uint8_t{0xbb})};
+  Acn a1{1, bytes{}};
+  a1.code_ref = a.codehash();
+  BOOST_CHECK_EQUAL(hashToString(StateRoot::leafHash("k", a)),
+                    hashToString(StateRoot::leafHash("k", a1)));
+}
+
+BOOST_AUTO_TEST_CASE(test_root_in_execBlk){
+  InRamWorldStorage w;
+  StateRoot r{1, 4};
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+  exe.stateRoot = &r;
+
+  hash256 h;
+  std::fill(std::begin(h.bytes),std::end(h.bytes),0x00);
+  Tx t{makeAddress(2), makeAddress(1), bytes{}, 0 /*nonce*/};
+  ExecBlk b{Blk{1, h, {t}}, {set_acn(1, 1)}, {TxReceipt(true)}};
+  BOOST_REQUIRE(exe.commitBlk(b));
+
+  ExecBlk b1;
+  BOOST_REQUIRE(b1.fromString(w.getFromChainDB("/blk/1").value()));
+  BOOST_REQUIRE(b1.stateRoot);
+  BOOST_CHECK_EQUAL(hashToString(b1.stateRoot.value()), hashToString(r.root()));
+}
+
+/*
+  🦜 : The cost of a Blk against its size (the number of Acns it changes), on
+  a state of 10k Acns. Nothing is checked, it just prints the numbers.
+ */
+BOOST_AUTO_TEST_CASE(bench_update_vs_blk_size){
+  using namespace std::chrono;
+  StateRoot r{4};
+  {
+    vector<vector<StateChange>> J;
+    for (int i = 0; i < 10'000; i++) J.push_back(set_acn(i, 0));
+    r.updateStateRoot(J);
+  }
+
+  for (int n : {1, 10, 100, 1'000, 10'000}){
+    vector<vector<StateChange>> J;
+    for (int i = 0; i < n; i++) J.push_back(set_acn(i * 7 % 10'000, 1 + n));
+
+    auto start = high_resolution_clock::now();
+    r.updateStateRoot(J);
+    auto us = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+    BOOST_TEST_MESSAGE((format("🌲 %5d Acns changed: %8d us (%.2f us/Acn)") % n % us % (double(us) / n)).str());
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
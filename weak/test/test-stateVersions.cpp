@@ -0,0 +1,117 @@
+#include "h.hpp"
+
+#include "stateVersions.hpp"
+#include "execManager.hpp"
+#include "storageManager.hpp"
+
+using namespace weak;
+
+namespace mockedCheckpointer{
+  // 🦜 : keeps the copies of an InRamWorldStorage's stateDB
+  class A: public virtual IStateCheckpointable{
+  public:
+    InRamWorldStorage * const w;
+    std::map<uint64_t,map<string,string>> saved;
+    A(InRamWorldStorage * ww): w(ww){}
+
+    bool checkpointState(uint64_t n) noexcept override{
+      saved[n] = w->stateDB;
+      return true;
+    }
+    bool removeStateCheckpoint(uint64_t n) noexcept override{
+      return saved.erase(n) > 0;
+    }
+    vector<uint64_t> listStateCheckpoints() const noexcept override{
+      vector<uint64_t> o;
+      for (auto & [n, _] : saved) o.push_back(n);
+      return o;
+    }
+    shared_ptr<IAcnGettable> openStateCheckpoint(uint64_t n) const noexcept override{
+      if (not saved.contains(n)) return nullptr;
+      auto s = make_shared<InRamWorldStorage>();
+      s->stateDB = saved.at(n);
+      return s;
+    }
+  };
+}
+
+/**
+ * @brief Make the Blk `n` with one Tx that sets the nonce of Acn 0x01 to `n`.
+ */
+ExecBlk make_blk(uint64_t n){
+  hash256 h;
+  std::fill(std::begin(h.bytes),std::end(h.bytes),0x00);
+  Tx t{makeAddress(2), makeAddress(1), bytes{}, n /*nonce*/};
+  Blk b{n, h, {t}};
+  Acn a{n, bytes{}};
+  vector<vector<StateChange>> j = {{{false, addressToString(makeAddress(1)), a.toString()}}};
+  return ExecBlk{b, j, {TxReceipt(true)}};
+}
+
+uint64_t nonce_at(IAcnGettableAt & v, optional<uint64_t> n){
+  optional<Acn> a = v.getAcnAt(makeAddress(1), n);
+  BOOST_REQUIRE(a);
+  return a.value().nonce;
+}
+
+BOOST_AUTO_TEST_SUITE(test_stateVersions);
+
+BOOST_AUTO_TEST_CASE(test_recent_versions){
+  InRamWorldStorage w;
+  StateVersions v{dynamic_cast<IAcnSnapshotable*>(&w), dynamic_cast<IChainDBGettable*>(&w),
+                  {}, 2 /*recent*/};
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+  exe.committedListeners.push_back(&v);
+
+  for (uint64_t i = 1; i <= 3; i++)
+    BOOST_REQUIRE(exe.commitBlk(make_blk(i)));
+
+  BOOST_CHECK_EQUAL(v.n_recent(), 2);
+  BOOST_CHECK_EQUAL(nonce_at(v, {}), 3);
+  BOOST_CHECK_EQUAL(nonce_at(v, 3), 3);
+  BOOST_CHECK_EQUAL(nonce_at(v, 2), 2);
+  BOOST_CHECK(not v.acnsAt(1));   // 🦜 : forgotten
+  BOOST_CHECK(not v.acnsAt(4));   // 🦜 : not yet
+
+  // 🦜 : The pinned version doesn't change with the live state.
+  shared_ptr<IAcnGettable> s = v.acnsAt();
+  w.applyJournalStateDB({StateChange{true, addressToString(makeAddress(1)), ""}});
+  BOOST_CHECK(s->getAcn(makeAddress(1)));
+  BOOST_CHECK(not w.getAcn(makeAddress(1)));
+}
+
+BOOST_AUTO_TEST_CASE(test_versions_from_checkpoints){
+  InRamWorldStorage w;
+  mockedCheckpointer::A cp{&w};
+  StateVersions v{dynamic_cast<IAcnSnapshotable*>(&w), dynamic_cast<IChainDBGettable*>(&w),
+                  {}, 1 /*recent*/,
+                  dynamic_cast<IStateCheckpointable*>(&cp), 4 /*every*/, 2 /*max checkpoints*/};
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+  exe.committedListeners.push_back(&v);
+
+  for (uint64_t i = 1; i <= 13; i++)
+    BOOST_REQUIRE(exe.commitBlk(make_blk(i)));
+
+  // checkpoints at 8 and 12 (4 is removed)
+  BOOST_CHECK((cp.listStateCheckpoints() == vector<uint64_t>{8, 12}));
+
+  BOOST_CHECK_EQUAL(nonce_at(v, 13), 13); // pinned
+  BOOST_CHECK_EQUAL(nonce_at(v, 12), 12); // checkpoint
+  BOOST_CHECK_EQUAL(nonce_at(v, 10), 10); // checkpoint 8 + replay of 9, 10
+  BOOST_CHECK(not v.acnsAt(7));           // before the oldest checkpoint
+}
+
+BOOST_AUTO_TEST_CASE(test_live_acns){
+  // 🦜 : what the RAM mode uses: only the latest, and nothing is copied
+  InRamWorldStorage w;
+  LiveAcns v{dynamic_cast<IAcnGettable*>(&w)};
+  BlkExecutor exe{dynamic_cast<IWorldChainStateSettable*>(&w), nullptr, nullptr};
+  for (uint64_t i = 1; i <= 3; i++)
+    BOOST_REQUIRE(exe.commitBlk(make_blk(i)));
+
+  BOOST_CHECK_EQUAL(nonce_at(v, {}), 3);
+  BOOST_CHECK(not v.acnsAt(2));
+  BOOST_CHECK(v.acnsAt().get() == dynamic_cast<IAcnGettable*>(&w));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -421,6 +421,110 @@ BOOST_FIXTURE_TEST_CASE(test_get_nonexisting_Acn,TmpWorldStorage){
   BOOST_REQUIRE(not w->getAcn(makeAddress(123)));
 }
 
+BOOST_FIXTURE_TEST_CASE(test_code_stored_once,TmpWorldStorage){
+  // <2024-07-22 Mon> 🦜 : two Acns with the same (long) code
+  bytes code(size_t{100},uint8_t{0xaa});
+  Acn a1{1,code}, a2{2,code};
+  BOOST_REQUIRE(w->applyJournalStateDB({
+        {false, addressToString(makeAddress(1)), a1.toString()},
+        {false, addressToString(makeAddress(2)), a2.toString()},
+      }));
+
+  // 1. the code is stored once, under its hash
+  string k = WorldStorage::codeKey(a1.codehash()), v;
+  BOOST_REQUIRE(w->stateDB->Get(rocksdb::ReadOptions(), k, &v).ok());
+  BOOST_CHECK(weak::bytesFromString(v) == code);
+
+  // 2. the Acns only keep the hash
+  BOOST_REQUIRE(w->stateDB->Get(rocksdb::ReadOptions(), addressToString(makeAddress(1)), &v).ok());
+  Acn b;
+  BOOST_REQUIRE(b.fromString(v));
+  BOOST_CHECK(b.code.empty());
+  BOOST_REQUIRE(b.code_ref);
+  BOOST_CHECK(b.codehash() == a1.codehash());
+
+  // 3. getAcn() doesn't read the code, codeOf() does (from the cache on the
+  // second go), and the Acns share it
+  for (int i = 0; i < 2; i++){
+    optional<Acn> r = w->getAcn(makeAddress(2));
+    BOOST_REQUIRE(r);
+    BOOST_CHECK_EQUAL(r.value().nonce, 2);
+    BOOST_CHECK(r.value().codeView().empty());
+    BOOST_CHECK(w->codeOf(r.value()) == bytes_view(code));
+    BOOST_CHECK(r.value().codeView() == bytes_view(code));
+
+    shared_ptr<IAcnGettable> s = w->snapshotOfAcns();
+    Acn r1 = s->getAcn(makeAddress(1)).value();
+    BOOST_CHECK(s->codeOf(r1) == bytes_view(code));
+    BOOST_CHECK(r1.shared_code == r.value().shared_code);
+  }
+  BOOST_CHECK(w->code_cache.n_hit > 0);
+
+  // 3.5 a loaded code still goes with the Acn when it's written back
+  optional<Acn> r = w->getAcn(makeAddress(1));
+  w->codeOf(r.value());
+  r.value().nonce++;
+  BOOST_REQUIRE(b.fromString(r.value().toString()));
+  BOOST_CHECK(b.code == code);
+
+  // 4. short codes stay in the Acn
+  Acn a3{3, evmc::from_hex("0011").value()};
+  BOOST_REQUIRE(w->applyJournalStateDB({{false, addressToString(makeAddress(3)), a3.toString()}}));
+  BOOST_REQUIRE(w->stateDB->Get(rocksdb::ReadOptions(), addressToString(makeAddress(3)), &v).ok());
+  BOOST_REQUIRE(b.fromString(v));
+  BOOST_CHECK(not b.code_ref);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getManyAcns,TmpWorldStorage){
+  // <2024-07-27 Sat> 🦜 : a long code (moved out), a short one, and a missing Acn
+  bytes code(size_t{100},uint8_t{0xaa});
+  Acn a1{1,code}, a2{2,evmc::from_hex("0011").value()};
+  BOOST_REQUIRE(w->applyJournalStateDB({
+        {false, addressToString(makeAddress(1)), a1.toString()},
+        {false, addressToString(makeAddress(2)), a2.toString()},
+      }));
+
+  // 🐢 : reopen it, so that the code is not in the CodeCache
+  delete w;
+  w = new WorldStorage{p};
+
+  vector<evmc::address> as{makeAddress(1), makeAddress(3), makeAddress(2), makeAddress(1)};
+  vector<optional<Acn>> r = w->getManyAcns(as);
+  BOOST_REQUIRE_EQUAL(r.size(), 4);
+  BOOST_REQUIRE(r[0] and r[2] and r[3]);
+  BOOST_CHECK(not r[1]);
+  BOOST_CHECK_EQUAL(r[0]->nonce, 1);
+  BOOST_CHECK(w->codeOf(r[0].value()) == bytes_view(code));
+  BOOST_CHECK(w->codeOf(r[3].value()) == bytes_view(code));
+  BOOST_CHECK(r[2]->code == a2.code);
+  for (size_t i : {0, 2}){
+    Acn x = w->getAcn(as[i]).value();
+    w->codeOf(x);
+    BOOST_CHECK_EQUAL(r[i]->toJsonString(), x.toJsonString());
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_state_checkpoint,TmpWorldStorage){
+  Acn a{1, bytes(size_t{100},uint8_t{0xbb})};
+  BOOST_REQUIRE(w->applyJournalStateDB({{false, addressToString(makeAddress(1)), a.toString()}}));
+  BOOST_REQUIRE(w->checkpointState(5));
+  BOOST_REQUIRE(w->applyJournalStateDB({{true, addressToString(makeAddress(1)), ""}}));
+
+  BOOST_CHECK((w->listStateCheckpoints() == vector<uint64_t>{5}));
+  {
+    shared_ptr<IAcnGettable> c = w->openStateCheckpoint(5);
+    BOOST_REQUIRE(c);
+    optional<Acn> r = c->getAcn(makeAddress(1));
+    BOOST_REQUIRE(r);
+    BOOST_CHECK(c->codeOf(r.value()) == bytes_view(a.code));
+  }
+  BOOST_CHECK(not w->getAcn(makeAddress(1)));
+
+  BOOST_CHECK(w->removeStateCheckpoint(5));
+  BOOST_CHECK(w->listStateCheckpoints().empty());
+  filesystem::remove_all(w->checkpointDir);
+}
+
 
 // BOOST_FIXTURE_TEST_CASE(TPS_test_storage, TmpWorldStorage, MY_TEST_THIS){
 
@@ -499,4 +603,37 @@ BOOST_FIXTURE_TEST_CASE(test_prefix, TmpWorldStorage){
   // get keys
 }
 
+BOOST_AUTO_TEST_CASE(test_storage_profiles){
+  BOOST_CHECK(not StorageProfile::fromName("fast"));
+  filesystem::path p = filesystem::temp_directory_path() / "test-storageProfile";
+
+  for (const string n : {"default", "write-heavy", "read-heavy", "low-memory"}){
+    BOOST_TEST_MESSAGE("🐸 profile: " + n);
+    filesystem::remove_all(p);
+    StorageProfile sp = StorageProfile::fromName(n).value();
+    sp.statistics = true;
+    {
+      WorldStorage w{p, false, 16, sp};
+      Acn a{1, bytes{}};
+      string k = addressToString(makeAddress(1));
+      BOOST_REQUIRE(w.applyJournalStateDB({{false, k, a.toString()}}));
+      BOOST_REQUIRE(w.setInChainDB("/blk/0", "abc"));
+      BOOST_CHECK_EQUAL(w.getFromChainDB("/blk/0").value(), "abc");
+      BOOST_CHECK(w.getAcn(makeAddress(1)));
+      BOOST_CHECK(not w.getAcn(makeAddress(2)));
+
+      // 🦜 : the stateDB can still be walked in order
+      size_t m = 0;
+      w.forEachAcn([&](const string &, const Acn &){m++;});
+      BOOST_CHECK_EQUAL(m, 1);
+
+      json::object o = w.stats();
+      BOOST_CHECK_EQUAL(o["profile"].as_string(), n);
+      BOOST_CHECK(o["stateDB"].as_object()["properties"].as_object().contains("rocksdb.estimate-num-keys"));
+      BOOST_CHECK(o["chainDB"].as_object().contains("tickers"));
+    }
+  }
+  filesystem::remove_all(p);
+}
+
 BOOST_AUTO_TEST_SUITE_END(); // WorldStorage